@@ -0,0 +1,48 @@
+QT += core gui multimedia testlib
+CONFIG += c++11 console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = bench
+
+# 热点路径微基准（QtTest QBENCHMARK），输入全是固定种子生成的合成数据
+# 基准数字只看优化版本
+CONFIG -= debug debug_and_release
+CONFIG += release
+
+# 机器可读输出用 QtTest 自带格式，例如：
+#   ./bench -o bench.xml,xml          每个数据行一条 BenchmarkResult
+#   ./bench -o bench.csv,csv
+#   ./bench serverMix                 只跑一个用例
+# 计时默认墙钟，Linux 上可加 -perf（CPU 周期）或 -callgrind
+
+# 被测代码直接用客户端的源文件（服务器 common 里的 protocol/annot/audiodsp/deltacodec 与之相同）
+CLIENT_DIR = $$PWD/../client
+INCLUDEPATH += $$CLIENT_DIR/Headers
+INCLUDEPATH += $$CLIENT_DIR/Headers/comm
+
+# 服务器混音直接编进来跑真实的 AudioMixer::push/tick（它依赖的 audiodsp 用上面客户端那份）
+SERVER_DIR = $$PWD/../server
+INCLUDEPATH += $$SERVER_DIR/src
+
+SOURCES += \
+    src/hotpathbench.cpp \
+    $$CLIENT_DIR/Sources/protocol.cpp \
+    $$CLIENT_DIR/Sources/comm/annot.cpp \
+    $$CLIENT_DIR/Sources/comm/audiocodec.cpp \
+    $$CLIENT_DIR/Sources/comm/audiodsp.cpp \
+    $$CLIENT_DIR/Sources/comm/audioproc.cpp \
+    $$CLIENT_DIR/Sources/comm/deltacodec.cpp \
+    $$CLIENT_DIR/Sources/comm/resampler.cpp \
+    $$CLIENT_DIR/Sources/comm/yuvconvert.cpp \
+    $$SERVER_DIR/src/audiomixer.cpp
+
+HEADERS += \
+    $$CLIENT_DIR/Headers/protocol.h \
+    $$CLIENT_DIR/Headers/comm/annot.h \
+    $$CLIENT_DIR/Headers/comm/audiocodec.h \
+    $$CLIENT_DIR/Headers/comm/audiodsp.h \
+    $$CLIENT_DIR/Headers/comm/audioproc.h \
+    $$CLIENT_DIR/Headers/comm/deltacodec.h \
+    $$CLIENT_DIR/Headers/comm/resampler.h \
+    $$CLIENT_DIR/Headers/comm/yuvconvert.h \
+    $$SERVER_DIR/src/audiomixer.h
@@ -0,0 +1,640 @@
+#include <QtTest>
+#include <QtGui>
+#include <QVideoFrame>
+#include <algorithm>
+#include <cmath>
+#include "protocol.h"
+#include "annot.h"
+#include "audiocodec.h"
+#include "audiodsp.h"
+#include "audiomixer.h"
+#include "audioproc.h"
+#include "deltacodec.h"
+#include "yuvconvert.h"
+
+// 热点路径微基准：协议打包/拆包、DS01 增量编解码、µ-law 与混音内核、语音前处理、标注、摄像头帧转换
+// 每个数据行的输入在循环外用固定种子生成，循环内只有被测调用；结果写进 sink_ 防止被优化掉
+// 音频内核用例（ulawEncode/ulawDecode/applyGain/mixAdd）不走 QBENCHMARK，自己计时后
+// 用 setBenchmarkResult 直接报 样本/秒（QtTest 的单位名叫 frames per second，这里一帧即一个样本）
+
+namespace {
+const quint32 kSeed       = 20240601;
+const int     kUlawRate   = 8000;
+const int     kUlawFrame  = kUlawRate * 20 / 1000;
+const int     kTcpSegment = 1460;       // 拆包按典型 MSS 分段喂入，和 RoomHub::onReadyRead 一样边收边拆
+const int     kStreamPackets = 64;
+const QSize   kScreenSize(1280, 720);
+const QSize   kCanvasSize(1280, 720);
+const qint64  kRateMinNs  = 200 * 1000 * 1000;  // 样本/秒用例至少跑这么久再算
+
+QVector<qint16> makeSpeech(int n, int rate, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QVector<qint16> pcm(n);
+    for (int i = 0; i < n; ++i) {
+        const double t = double(i) / rate;
+        const double env = 0.6 + 0.4 * std::sin(2.0 * M_PI * 4.0 * t);
+        const double v = 6000.0 * env * std::sin(2.0 * M_PI * 220.0 * t)
+                       + 2000.0 * std::sin(2.0 * M_PI * 1330.0 * t)
+                       + (rng.generateDouble() - 0.5) * 600.0;
+        pcm[i] = qint16(qBound(-32768.0, v, 32767.0));
+    }
+    return pcm;
+}
+
+QByteArray makeBytes(int n, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QByteArray b(n, Qt::Uninitialized);
+    for (int i = 0; i < n; ++i) b[i] = char(rng.bounded(256));
+    return b;
+}
+
+// 文档/代码类屏幕：白底、深色“文字”块
+QImage makeScreen(const QSize& size, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QImage img(size, QImage::Format_RGB32);
+    img.fill(Qt::white);
+    QPainter p(&img);
+    p.fillRect(0, 0, size.width(), 28, QColor(45, 45, 48));
+    for (int y = 40; y + 18 < size.height(); y += 18) {
+        int x = 16;
+        while (x < size.width() - 40) {
+            const int word = 12 + int(rng.bounded(60));
+            p.fillRect(x, y + 4, word, 9, QColor(30, 30, 30 + int(rng.bounded(120))));
+            x += word + 8;
+            if (rng.bounded(12) == 0) break;
+        }
+    }
+    return img;
+}
+
+// 在 area 里重画一块（打字、切换窗口等）
+QImage editScreen(const QImage& base, const QRect& area, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QImage img = base.copy();
+    QPainter p(&img);
+    p.fillRect(area, QColor(250, 250, 240));
+    for (int y = area.top() + 2; y + 12 < area.bottom(); y += 14) {
+        const int w = qMin(area.width() - 4, 20 + int(rng.bounded(quint32(qMax(1, area.width() - 24)))));
+        p.fillRect(area.left() + 2, y, w, 8, QColor(20, 20, 120));
+    }
+    return img;
+}
+
+struct DeltaCase { QImage prev; QImage curr; };
+
+DeltaCase deltaCase(const QString& kind)
+{
+    DeltaCase c;
+    c.prev = makeScreen(kScreenSize, kSeed);
+    if (kind == "unchanged")      c.curr = c.prev.copy();
+    else if (kind == "typing")    c.curr = editScreen(c.prev, QRect(200, 300, 96, 20), kSeed + 1);
+    else if (kind == "window")    c.curr = editScreen(c.prev, QRect(320, 160, 480, 320), kSeed + 2);
+    else                          c.curr = editScreen(c.prev, QRect(0, 0, 1280, 720), kSeed + 3);
+    return c;
+}
+
+QVideoFrame makeVideoFrame(QVideoFrame::PixelFormat fmt, const QSize& size)
+{
+    const int w = size.width(), h = size.height();
+    int bpl = w, bytes = 0;
+    switch (fmt) {
+    case QVideoFrame::Format_YUYV:
+        bpl = w * 2; bytes = bpl * h; break;
+    case QVideoFrame::Format_NV12:
+        bytes = w * h * 3 / 2; break;
+    default:
+        bpl = w * 4; bytes = bpl * h; break;
+    }
+    QVideoFrame f(bytes, size, bpl, fmt);
+    if (f.map(QAbstractVideoBuffer::WriteOnly)) {
+        QRandomGenerator rng(kSeed);
+        uchar* d = f.bits();
+        for (int i = 0; i < bytes; ++i) d[i] = uchar(16 + ((i / 7) & 0x7F) + rng.bounded(32));
+        f.unmap();
+    }
+    return f;
+}
+
+// 一笔：begin 一个点 + updates 次 update（每次 4 点）+ end
+QVector<QPair<QJsonObject, QByteArray>> makeStroke(const QString& id, AnnotModel::Tool tool, int updates,
+                                                   bool binary, QRandomGenerator& rng)
+{
+    static const char* kTools[] = {"pen", "rect", "ellipse", "arrow", "text"};
+    QVector<QPair<QJsonObject, QByteArray>> evs;
+    QPointF pen(0.2 + 0.6 * rng.generateDouble(), 0.2 + 0.6 * rng.generateDouble());
+    auto withPoints = [binary](QJsonObject e, const QVector<QPointF>& pts) {
+        if (binary) {
+            e["enc"] = "q16v";
+            return qMakePair(e, AnnotModel::encodePoints(pts));
+        }
+        QJsonArray arr;
+        for (const QPointF& p : pts) arr.append(QJsonArray{p.x(), p.y()});
+        e["pts"] = arr;
+        return qMakePair(e, QByteArray());
+    };
+    QJsonObject begin{{"op", "begin"}, {"id", id}, {"sender", "bench"}, {"tool", kTools[tool]},
+                      {"color", "#FF0000"}, {"width", 3}};
+    evs.push_back(withPoints(begin, {pen}));
+    for (int u = 0; u < updates; ++u) {
+        QVector<QPointF> pts;
+        for (int k = 0; k < 4; ++k) {
+            pen += QPointF((rng.generateDouble() - 0.5) * 0.02, (rng.generateDouble() - 0.5) * 0.02);
+            pen = QPointF(qBound(0.0, pen.x(), 1.0), qBound(0.0, pen.y(), 1.0));
+            pts.push_back(pen);
+        }
+        evs.push_back(withPoints(QJsonObject{{"op", "update"}, {"id", id}}, pts));
+    }
+    evs.push_back(qMakePair(QJsonObject{{"op", "end"}, {"id", id}}, QByteArray()));
+    return evs;
+}
+
+// 反复调用 fn（每次处理 samples 个样本）直到累计够 kRateMinNs，返回 样本/秒
+template <typename Fn>
+qreal samplesPerSec(int samples, Fn fn)
+{
+    fn();   // 预热：查表、缓存
+    qint64 calls = 0;
+    QElapsedTimer t;
+    t.start();
+    do {
+        for (int i = 0; i < 64; ++i) fn();
+        calls += 64;
+    } while (t.nsecsElapsed() < kRateMinNs);
+    return qreal(calls) * samples * 1e9 / qreal(t.nsecsElapsed());
+}
+
+// strokes 笔已完成（工具轮换，不含需要字体的文字）+ 1 笔进行中
+AnnotModel makeAnnotModel(int strokes)
+{
+    QRandomGenerator rng(kSeed);
+    AnnotModel m;
+    for (int s = 0; s <= strokes; ++s) {
+        auto evs = makeStroke(QStringLiteral("s%1").arg(s), AnnotModel::Tool(s % 4), 10, true, rng);
+        if (s == strokes) evs.removeLast();
+        for (const auto& e : evs) m.applyEvent(e.first, e.second);
+    }
+    return m;
+}
+}
+
+class HotPathBench : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void buildPacket_data();
+    void buildPacket();
+    void drainPackets_data();
+    void drainPackets();
+
+    void deltaEncode_data();
+    void deltaEncode();
+    void deltaDecode_data();
+    void deltaDecode();
+
+    void ulawEncode();
+    void ulawDecode();
+    void applyGain();
+    void mixAdd();
+    void mulawCodec_data();
+    void mulawCodec();
+    void clientMix_data();
+    void clientMix();
+    void serverMix_data();
+    void serverMix();
+    void voiceProcess_data();
+    void voiceProcess();
+
+    void annotApplyEvent_data();
+    void annotApplyEvent();
+    void annotPaint_data();
+    void annotPaint();
+
+    void frameToImage_data();
+    void frameToImage();
+    void convertScaled_data();
+    void convertScaled();
+    void yuvRow_data();
+    void yuvRow();
+
+private:
+    void packetSizes();
+
+    qint64 sink_ = 0;
+};
+
+void HotPathBench::initTestCase()
+{
+    qInfo() << "[bench] AudioDsp backend:" << AudioDsp::backend();
+}
+
+/* ---------- 协议 ---------- */
+void HotPathBench::packetSizes()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("binBytes");
+    QTest::newRow("control")     << int(MSG_CONTROL)     << 0;
+    QTest::newRow("audio-160")   << int(MSG_AUDIO_FRAME) << 160;
+    QTest::newRow("camera-12k")  << int(MSG_VIDEO_FRAME) << 12 * 1024;
+    QTest::newRow("screen-200k") << int(MSG_VIDEO_FRAME) << 200 * 1024;
+}
+
+void HotPathBench::buildPacket_data() { packetSizes(); }
+
+void HotPathBench::buildPacket()
+{
+    QFETCH(int, type);
+    QFETCH(int, binBytes);
+    const QJsonObject j{{"roomId", "bench-room"}, {"sender", "bench-user"}, {"media", "camera"},
+                        {"seq", 12345}, {"ts", 1700000000000.0}, {"w", 640}, {"h", 480}};
+    const QByteArray bin = makeBytes(binBytes, kSeed);
+    QBENCHMARK {
+        sink_ += ::buildPacket(quint16(type), j, bin).size();
+    }
+}
+
+void HotPathBench::drainPackets_data() { packetSizes(); }
+
+void HotPathBench::drainPackets()
+{
+    QFETCH(int, type);
+    QFETCH(int, binBytes);
+    const QJsonObject j{{"roomId", "bench-room"}, {"sender", "bench-user"}, {"media", "camera"},
+                        {"seq", 12345}, {"ts", 1700000000000.0}, {"w", 640}, {"h", 480}};
+    QByteArray stream;
+    for (int i = 0; i < kStreamPackets; ++i)
+        stream += ::buildPacket(quint16(type), j, makeBytes(binBytes, kSeed + i));
+
+    QBENCHMARK {
+        QByteArray buf;
+        QVector<Packet> out;
+        out.reserve(kStreamPackets);
+        for (int off = 0; off < stream.size(); off += kTcpSegment) {
+            buf.append(stream.constData() + off, qMin(kTcpSegment, stream.size() - off));
+            ::drainPackets(buf, out);
+        }
+        if (out.size() != kStreamPackets) QFAIL("packet count mismatch");
+        sink_ += out.size();
+    }
+}
+
+/* ---------- DS01 增量（ScreenShare 编码 / RecorderRoom、MainWindow 解码） ---------- */
+void HotPathBench::deltaEncode_data()
+{
+    QTest::addColumn<QString>("kind");
+    QTest::newRow("unchanged") << "unchanged";
+    QTest::newRow("typing")    << "typing";
+    QTest::newRow("window")    << "window";
+    QTest::newRow("full")      << "full";     // 超过块数上限，应返回空
+}
+
+void HotPathBench::deltaEncode()
+{
+    QFETCH(QString, kind);
+    const DeltaCase c = deltaCase(kind);
+    QBENCHMARK {
+        sink_ += DeltaCodec::encode(c.prev, c.curr, 32).size();
+    }
+}
+
+void HotPathBench::deltaDecode_data()
+{
+    QTest::addColumn<QString>("kind");
+    QTest::newRow("unchanged") << "unchanged";
+    QTest::newRow("typing")    << "typing";
+    QTest::newRow("window")    << "window";
+}
+
+void HotPathBench::deltaDecode()
+{
+    QFETCH(QString, kind);
+    const DeltaCase c = deltaCase(kind);
+    const QByteArray blob = DeltaCodec::encode(c.prev, c.curr, 32);
+    QVERIFY(!blob.isEmpty());
+    QImage back = c.prev.copy();
+    QVERIFY(DeltaCodec::applyInto(back, blob));
+    QCOMPARE(back, c.curr);
+    QBENCHMARK {
+        DeltaCodec::applyInto(back, blob);
+    }
+}
+
+/* ---------- 音频内核（样本/秒） ---------- */
+void HotPathBench::ulawEncode()
+{
+    const QVector<qint16> pcm = makeSpeech(kUlawRate, kUlawRate, kSeed);
+    QByteArray out(pcm.size(), Qt::Uninitialized);
+    QTest::setBenchmarkResult(samplesPerSec(pcm.size(), [&] {
+        AudioDsp::encodeUlaw(pcm.constData(), reinterpret_cast<quint8*>(out.data()), pcm.size());
+    }), QTest::FramesPerSecond);
+    sink_ += out.at(0);
+}
+
+void HotPathBench::ulawDecode()
+{
+    const QVector<qint16> pcm = makeSpeech(kUlawRate, kUlawRate, kSeed);
+    QByteArray ulaw(pcm.size(), Qt::Uninitialized);
+    AudioDsp::encodeUlaw(pcm.constData(), reinterpret_cast<quint8*>(ulaw.data()), pcm.size());
+    QVector<qint16> out(pcm.size());
+    QTest::setBenchmarkResult(samplesPerSec(out.size(), [&] {
+        AudioDsp::decodeUlaw(reinterpret_cast<const quint8*>(ulaw.constData()), out.data(), out.size());
+    }), QTest::FramesPerSecond);
+    sink_ += out.at(0);
+}
+
+void HotPathBench::applyGain()
+{
+    QVector<qint16> pcm = makeSpeech(kUlawRate, kUlawRate, kSeed);
+    const int g = AudioDsp::gainQ14(1.3f);
+    QTest::setBenchmarkResult(samplesPerSec(pcm.size(), [&] {
+        AudioDsp::applyGain(pcm.data(), pcm.size(), g);
+    }), QTest::FramesPerSecond);
+    sink_ += pcm.at(0);
+}
+
+void HotPathBench::mixAdd()
+{
+    const QVector<qint16> in = makeSpeech(kUlawRate, kUlawRate, kSeed);
+    QVector<qint16> acc = makeSpeech(kUlawRate, kUlawRate, kSeed + 1);
+    QTest::setBenchmarkResult(samplesPerSec(acc.size(), [&] {
+        AudioDsp::mixAdd(acc.data(), in.constData(), acc.size());
+    }), QTest::FramesPerSecond);
+    sink_ += acc.at(0);
+}
+
+// AudioChat 发/收一帧 µ-law（含 16k↔8k 重采样）
+void HotPathBench::mulawCodec_data()
+{
+    QTest::addColumn<bool>("encode");
+    QTest::newRow("encode-20ms") << true;
+    QTest::newRow("decode-20ms") << false;
+}
+
+void HotPathBench::mulawCodec()
+{
+    QFETCH(bool, encode);
+    const QVector<qint16> pcm = makeSpeech(AudioCodec::kFrameSamples, AudioCodec::kSampleRate, kSeed);
+    QScopedPointer<AudioEncoder> enc(AudioEncoder::create(QStringLiteral("mulaw")));
+    QVERIFY(enc);
+    const QByteArray payload = enc->encode(pcm.constData());
+    QScopedPointer<AudioDecoder> dec(AudioDecoder::create(QStringLiteral("mulaw"), enc->wireRate()));
+    QVERIFY(dec);
+    QVector<qint16> out(AudioCodec::kFrameSamples);
+    QBENCHMARK {
+        if (encode) sink_ += enc->encode(pcm.constData()).size();
+        else        sink_ += dec->decode(payload, out.data());
+    }
+}
+
+// 客户端播放混音：每路 µ-law 解码到 16k + 按增益叠加，最后整体增益（AudioEngine::mixFrame 的工作量）
+void HotPathBench::clientMix_data()
+{
+    QTest::addColumn<int>("peers");
+    QTest::newRow("1 peer")   << 1;
+    QTest::newRow("3 peers")  << 3;
+    QTest::newRow("10 peers") << 10;
+}
+
+void HotPathBench::clientMix()
+{
+    QFETCH(int, peers);
+    QScopedPointer<AudioEncoder> enc(AudioEncoder::create(QStringLiteral("mulaw")));
+    QVERIFY(enc);
+    QVector<QByteArray> payloads;
+    QVector<QSharedPointer<AudioDecoder>> decs;
+    for (int i = 0; i < peers; ++i) {
+        const QVector<qint16> pcm = makeSpeech(AudioCodec::kFrameSamples, AudioCodec::kSampleRate, kSeed + i);
+        payloads.push_back(enc->encode(pcm.constData()));
+        decs.push_back(QSharedPointer<AudioDecoder>(AudioDecoder::create(QStringLiteral("mulaw"), enc->wireRate())));
+    }
+    QVector<qint16> mix(AudioCodec::kFrameSamples), peerBuf(AudioCodec::kFrameSamples);
+    const int g = AudioDsp::gainQ14(0.8f);
+    QBENCHMARK {
+        std::fill(mix.begin(), mix.end(), qint16(0));
+        for (int i = 0; i < peers; ++i) {
+            decs[i]->decode(payloads[i], peerBuf.data());
+            AudioDsp::mixAddGain(mix.data(), peerBuf.constData(), mix.size(), g);
+        }
+        AudioDsp::applyGain(mix.data(), mix.size(), AudioDsp::kUnityGain);
+    }
+    sink_ += mix.at(0);
+}
+
+// 服务器混音一个 20ms 节拍：每个发言者 push 一帧真实 µ-law（解码入队），再跑一次 AudioMixer::tick
+// （累加、每个发言者“总和减自己”各编一份、旁听者共用一份、逐个发 mixed 信号）
+void HotPathBench::serverMix_data()
+{
+    QTest::addColumn<int>("speakers");
+    QTest::addColumn<int>("listeners");
+    QTest::newRow("10 speakers")              << 10 << 0;
+    QTest::newRow("20 speakers")              << 20 << 0;
+    QTest::newRow("50 speakers")              << 50 << 0;
+    QTest::newRow("3 speakers + 47 listeners") << 3 << 47;
+}
+
+void HotPathBench::serverMix()
+{
+    QFETCH(int, speakers);
+    QFETCH(int, listeners);
+    const QString room = QStringLiteral("bench");
+    const QString codec = QStringLiteral("mulaw");
+    QStringList members;
+    QVector<QByteArray> payloads;
+    for (int i = 0; i < speakers; ++i) {
+        members << QStringLiteral("s%1").arg(i);
+        const QVector<qint16> pcm = makeSpeech(kUlawFrame, kUlawRate, kSeed + i);
+        QByteArray ulaw(kUlawFrame, Qt::Uninitialized);
+        AudioDsp::encodeUlaw(pcm.constData(), reinterpret_cast<quint8*>(ulaw.data()), kUlawFrame);
+        payloads.push_back(ulaw);
+    }
+    for (int i = 0; i < listeners; ++i) members << QStringLiteral("l%1").arg(i);
+
+    AudioMixer mixer;
+    mixer.setMinMembers(1);
+    QVERIFY(mixer.setMembers(room, members));
+    connect(&mixer, &AudioMixer::mixed, this,
+            [this](const QString&, const QString&, quint32, qint64, const QByteArray& payload) {
+        sink_ += payload.size();
+    });
+
+    // 先攒够预缓冲，之后每拍进一帧出一帧，队列深度不变
+    quint32 seq = 0;
+    for (int k = 0; k < 2; ++k, ++seq) {
+        for (int i = 0; i < speakers; ++i) QVERIFY(mixer.push(room, members[i], codec, kUlawRate, seq, payloads[i]));
+    }
+    mixer.tick();
+    QBENCHMARK {
+        for (int i = 0; i < speakers; ++i) mixer.push(room, members[i], codec, kUlawRate, seq, payloads[i]);
+        ++seq;
+        mixer.tick();
+    }
+}
+
+// 麦克风前处理一帧（20ms，16k）：远端参考 + 近端处理
+void HotPathBench::voiceProcess_data()
+{
+    QTest::addColumn<bool>("enabled");
+    QTest::newRow("bypass")     << false;
+    QTest::newRow("aec+ns+agc") << true;
+}
+
+void HotPathBench::voiceProcess()
+{
+    QFETCH(bool, enabled);
+    VoiceProcessor::Config cfg;
+    cfg.aec = cfg.ns = cfg.agc = enabled;
+    QScopedPointer<VoiceProcessor> proc(VoiceProcessor::create(cfg));
+    const int n = AudioCodec::kFrameSamples;
+    const QVector<qint16> far = makeSpeech(AudioCodec::kSampleRate, AudioCodec::kSampleRate, kSeed);
+    const QVector<qint16> near = makeSpeech(AudioCodec::kSampleRate, AudioCodec::kSampleRate, kSeed + 1);
+    const int frames = far.size() / n;
+    QVector<qint16> buf(n);
+    int k = 0;
+    QBENCHMARK {
+        proc->farEnd(far.constData() + k * n, n);
+        std::copy(near.constData() + k * n, near.constData() + (k + 1) * n, buf.begin());
+        proc->process(buf.data(), n);
+        k = (k + 1) % frames;
+    }
+    sink_ += buf.at(0);
+}
+
+/* ---------- 标注 ---------- */
+void HotPathBench::annotApplyEvent_data()
+{
+    QTest::addColumn<bool>("binary");
+    QTest::newRow("q16v") << true;
+    QTest::newRow("json") << false;
+}
+
+// 一笔 begin + 50 次 update + end
+void HotPathBench::annotApplyEvent()
+{
+    QFETCH(bool, binary);
+    QRandomGenerator rng(kSeed);
+    const auto evs = makeStroke(QStringLiteral("s0"), AnnotModel::Pen, 50, binary, rng);
+    QBENCHMARK {
+        AnnotModel m;
+        for (const auto& e : evs) sink_ += m.applyEvent(e.first, e.second);
+    }
+}
+
+void HotPathBench::annotPaint_data()
+{
+    QTest::addColumn<int>("strokes");
+    QTest::addColumn<bool>("cached");
+    QTest::newRow("10 strokes cached")    << 10   << true;
+    QTest::newRow("100 strokes cached")   << 100  << true;
+    QTest::newRow("500 strokes cached")   << 500  << true;
+    QTest::newRow("2000 strokes cached")  << 2000 << true;
+    QTest::newRow("5000 strokes cached")  << 5000 << true;
+    QTest::newRow("100 strokes rebuild")  << 100  << false;
+    QTest::newRow("2000 strokes rebuild") << 2000 << false;
+    QTest::newRow("5000 strokes rebuild") << 5000 << false;
+}
+
+// cached：完成笔画的透明层已建好，只画进行中的一笔；rebuild：每次从无缓存的副本开始
+void HotPathBench::annotPaint()
+{
+    QFETCH(int, strokes);
+    QFETCH(bool, cached);
+    const AnnotModel base = makeAnnotModel(strokes);
+    QImage canvas(kCanvasSize, QImage::Format_ARGB32_Premultiplied);
+    if (cached) {
+        QPainter warm(&canvas);
+        base.paint(warm, canvas.size());
+    }
+    QBENCHMARK {
+        canvas.fill(Qt::transparent);
+        QPainter p(&canvas);
+        if (cached) {
+            base.paint(p, canvas.size());
+        } else {
+            const AnnotModel m = base;
+            m.paint(p, canvas.size());
+        }
+    }
+    sink_ += canvas.pixel(0, 0);
+}
+
+/* ---------- 摄像头帧 ---------- */
+void HotPathBench::frameToImage_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::newRow("RGB32 1280x720") << int(QVideoFrame::Format_RGB32);
+    QTest::newRow("YUYV 1280x720")  << int(QVideoFrame::Format_YUYV);
+}
+
+// 原 MainWindow::makeImageFromFrame：整帧不缩放
+void HotPathBench::frameToImage()
+{
+    QFETCH(int, format);
+    const QVideoFrame f = makeVideoFrame(QVideoFrame::PixelFormat(format), QSize(1280, 720));
+    QVERIFY(f.isValid());
+    QVERIFY(!YuvConvert::frameToImage(f).isNull());
+    QBENCHMARK {
+        sink_ += YuvConvert::frameToImage(f).width();
+    }
+}
+
+// MainWindow::onVideoFrame 的正常路径：一次 map 出三层发送 + 一个预览
+void HotPathBench::convertScaled_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("YUYV 1280x720")  << int(QVideoFrame::Format_YUYV) << QSize(1280, 720);
+    QTest::newRow("NV12 1280x720")  << int(QVideoFrame::Format_NV12) << QSize(1280, 720);
+    QTest::newRow("NV12 1920x1080") << int(QVideoFrame::Format_NV12) << QSize(1920, 1080);
+}
+
+void HotPathBench::convertScaled()
+{
+    QFETCH(int, format);
+    QFETCH(QSize, size);
+    QVideoFrame f = makeVideoFrame(QVideoFrame::PixelFormat(format), size);
+    QVERIFY(f.map(QAbstractVideoBuffer::ReadOnly));
+    YuvConvert::FrameView view;
+    QVERIFY(YuvConvert::viewFromMappedFrame(f, &view));
+    const QSize sizes[] = {
+        YuvConvert::fitSize(size, QSize(1280, 720)),
+        YuvConvert::fitSize(size, QSize(320, 240)),
+        YuvConvert::fitSize(size, QSize(160, 120)),
+        YuvConvert::fitSize(size, QSize(640, 360)),
+    };
+    QImage outs[4];
+    QBENCHMARK {
+        YuvConvert::convertScaled(view, sizes, outs, 4);
+    }
+    f.unmap();
+    sink_ += outs[0].width();
+}
+
+void HotPathBench::yuvRow_data()
+{
+    QTest::addColumn<bool>("simd");
+    QTest::newRow("simd 1280px")   << true;
+    QTest::newRow("scalar 1280px") << false;
+}
+
+void HotPathBench::yuvRow()
+{
+    QFETCH(bool, simd);
+    const int n = 1280;
+    const QByteArray y = makeBytes(n, kSeed), u = makeBytes(n, kSeed + 1), v = makeBytes(n, kSeed + 2);
+    auto p = [](const QByteArray& b) { return reinterpret_cast<const uchar*>(b.constData()); };
+    QVector<quint32> out(n);
+    // 同一个 QBENCHMARK 里分支，数据行之间只差被测函数
+    QBENCHMARK {
+        if (simd) YuvConvert::yuvRowToRgb32(p(y), p(u), p(v), out.data(), n);
+        else      YuvConvert::yuvRowToRgb32Scalar(p(y), p(u), p(v), out.data(), n);
+    }
+    sink_ += out.at(0);
+}
+
+QTEST_GUILESS_MAIN(HotPathBench)
+#include "hotpathbench.moc"
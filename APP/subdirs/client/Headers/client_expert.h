@@ -18,6 +18,7 @@ struct OrderInfo {
 
 class KnowledgePanel;  // 企业知识库
 class DevicePanel;     // 设备管理
+class OrderSync;       // 工单列表增量同步
 
 class ClientExpert : public QWidget
 {
@@ -44,8 +45,11 @@ private:
 
     KnowledgePanel* kbPanel_    = nullptr; // 企业知识库页（嵌入）
     DevicePanel*    devicePanel_ = nullptr; // 设备管理页（嵌入）
+    OrderSync*      orderSync_   = nullptr;
 
     void refreshOrders();
+    void pullOrderChanges();
+    void renderOrders(bool keepSelection);
     void updateTabEnabled();
     void sendUpdateOrder(int orderId, const QString& status);
 };
@@ -13,6 +13,7 @@ QT_END_NAMESPACE
 
 class DevicePanel;     // 设备管理
 class KnowledgePanel;  // 企业知识库
+class OrderSync;       // 工单列表增量同步
 
 class ClientFactory : public QWidget
 {
@@ -37,6 +38,8 @@ private:
     bool deletingOrder = false;
 
     void refreshOrders();
+    void pullOrderChanges();
+    void renderOrders(bool keepSelection);
     void updateTabEnabled();
     void sendCreateOrder(const QString& title, const QString& desc);
 
@@ -46,6 +49,7 @@ private:
     CommWidget*    commWidget_   = nullptr;
     DevicePanel*   devicePanel_  = nullptr;
     KnowledgePanel* kbPanel_     = nullptr;
+    OrderSync*     orderSync_    = nullptr;
 };
 
 #endif // CLIENT_FACTORY_H
@@ -19,21 +19,51 @@ public:
 
     static Tool toolFromString(const QString& s);
 
-    bool applyEvent(const QJsonObject& e);
+    // e["enc"]=="q16v" 时点坐标取自 bin（见 encodePoints），否则取 e["pts"]
+    bool applyEvent(const QJsonObject& e, const QByteArray& bin = QByteArray());
 
+    // 点序列紧凑编码 "q16v"：varint 点数；每点 x、y 量化到 0..65535，
+    // 与前一点做差后 zigzag + varint（首点相对 (0,0)）
+    static QByteArray encodePoints(const QVector<QPointF>& pts);
+    static bool decodePoints(const QByteArray& bin, QVector<QPointF>* out);
+
+    // 已完成的笔画缓存成透明层（按输出尺寸各一份），只有进行中的笔画实时绘制
     void paint(QPainter& p, const QSize& size) const;
 
     void clear();
 
     bool undoLastByOwner(const QString& owner);
 
+    // 内容每变一次加一，供绘制缓存判断是否失效
+    quint64 revision() const { return rev_; }
+
     static inline QPointF denorm(const QPointF& n, const QSize& size) {
         return QPointF(n.x() * size.width(), n.y() * size.height());
     }
 
 private:
+    struct Layer {
+        QSize  size;
+        qreal  dpr = 1.0;
+        QImage img;
+        quint64 structRev = 0;      // 与 structRev_ 不一致则整层重建
+        QSet<QString> ids;          // 已画进层的笔画
+        int    lastPos = -1;        // 层内最后一笔在 order_ 中的位置
+        quint64 lastUse = 0;
+    };
+    static constexpr int kMaxLayers = 3;
+
     static void drawArrow(QPainter& p, const QPointF& a, const QPointF& b, int width, const QColor& color);
+    static void paintStroke(QPainter& p, const Stroke& s, const QSize& size);
+    static bool readPoints(const QJsonObject& e, const QByteArray& bin, QVector<QPointF>* out);
+    const QImage& layerFor(const QSize& size, qreal dpr) const;
+    void rebuildLayer(Layer& l) const;
 
     QHash<QString, Stroke> strokes_;
     QStringList order_;
+    quint64 rev_ = 0;
+    quint64 structRev_ = 1;         // 已完成笔画被删除/改动（撤销、清空、重画同 id）时加一
+    int finishedCount_ = 0;
+    mutable QVector<Layer> layers_;
+    mutable quint64 useTick_ = 0;
 };
\ No newline at end of file
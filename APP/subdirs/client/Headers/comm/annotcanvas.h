@@ -19,7 +19,8 @@ public:
     void setTargetKey(const QString& k) { targetKey_ = k; }
 
 signals:
-    void annotateEvent(const QJsonObject& ev);
+    // begin/update 的点坐标以 "q16v" 编码放在 bin 中（见 AnnotModel::encodePoints）
+    void annotateEvent(const QJsonObject& ev, const QByteArray& bin);
 
 protected:
     void paintEvent(QPaintEvent*) override;
@@ -31,6 +32,7 @@ private:
     void emitBegin(const QPointF& npt);
     void emitUpdate(const QVector<QPointF>& npts);
     void emitEnd();
+    void flushPending();
 
     QPointF normFromPos(const QPoint& pos) const;
 
@@ -41,6 +43,8 @@ private:
     int penWidth_{3};
     QString currentId_;
     QVector<QPointF> livePts_;
+    QVector<QPointF> pendingPts_;   // 尚未发出的移动点，按帧间隔合并成一条 update
+    QTimer flushTimer_;
     QString targetKey_;
     quint64 seq_{1};
 };
\ No newline at end of file
@@ -3,68 +3,98 @@
 #include <QtMultimedia>
 #include "clientconn.h"
 #include "protocol.h"
+#include "audioengine.h"
+#include "udpmedia.h"
 
+// 语音：内部 16kHz 单声道，20ms 一帧
+// 编码协商：入房后广播 MSG_CONTROL{kind:"audio_caps", codecs:[...], udp}，收到新成员的能力时回一次；
+// 房间内其他成员都支持的最高优先级编码用于发送（opus > mulaw），有成员未声明能力时回退 mulaw
+// 传输：本端 UDP 通（服务器回执注册）且其他成员都声明 udp 时走 UDP 中继，否则走 TCP
+// 服务器混音：收到 MSG_SERVER_EVENT{kind:"audio_mix", on:true} 后只发 mulaw（服务器不解 Opus），
+// 本端 UDP 通即走 UDP；下行只有一路发送者 "__mix__"，按普通对端进抖动缓冲
+// DTX：VAD 判为静音时不发语音帧，每 160ms 发一个舒适噪声帧（codec "cn"）；每帧带电平 lvl/vad，
+// 服务器据此只转发最活跃的几路并通知 active_speaker
+// 线程：采集/编码/抖动缓冲/混音/播放都在 AudioEngine 的实时线程里，本类留在 GUI 线程只管协商和收发包
 class AudioChat : public QObject {
     Q_OBJECT
 public:
     explicit AudioChat(ClientConn* conn, QObject* parent = nullptr);
 
     void setIdentity(const QString& roomId, const QString& sender);
+    // 房间成员（含自己），用于编码协商
+    void setRoomMembers(const QStringList& members);
+    QString currentCodec() const { return codec_; }
+
+    void setUdpClient(UdpMediaClient* udp);
+    bool isSendingUdp() const { return useUdp_; }
+    bool isServerMixed() const { return serverMix_; }
 
     void setEnabled(bool on);
     bool isEnabled() const { return enabled_; }
 
-    void setPlaybackGain(float g) { playbackGain_ = qBound(0.0f, g, 2.0f); }
+    void setDtxEnabled(bool on) { dtx_ = on; engine_->setDtx(on); }
+    bool isDtxEnabled() const { return dtx_; }
+    bool isSpeaking() const { return speaking_; }
+
+    void setPlaybackGain(float g) { playbackGain_ = qBound(0.0f, g, 2.0f); engine_->setPlaybackGain(playbackGain_); }
     float playbackGain() const { return playbackGain_; }
 
-    void setMicGain(float g) { micGain_ = qBound(0.0f, g, 2.0f); }
+    void setMicGain(float g) { micGain_ = qBound(0.0f, g, 2.0f); engine_->setMicGain(micGain_); }
     float micGain() const { return micGain_; }
 
-    void setPeerGain(const QString& sender, float g) { peerGain_[sender] = qBound(0.0f, g, 2.0f); }
+    void setPeerGain(const QString& sender, float g) { peerGain_[sender] = qBound(0.0f, g, 2.0f); engine_->setPeerGain(sender, peerGain_[sender]); }
     float peerGain(const QString& sender) const { return peerGain_.value(sender, 1.0f); }
-    void dropPeer(const QString& sender) { rxQueues_.remove(sender); peerGain_.remove(sender); }
+    void dropPeer(const QString& sender) { engine_->dropPeer(sender); peerGain_.remove(sender); peerCaps_.remove(sender); renegotiate(); }
+
+    // 麦克风前处理（回声消除/降噪/自动增益），全关即旁路
+    void setVoiceProcessing(const VoiceProcessor::Config& cfg) { voiceProc_ = cfg; engine_->setVoiceProcessing(cfg); }
+    VoiceProcessor::Config voiceProcessing() const { return voiceProc_; }
+
+    // 各发送者的抖动缓冲统计（深度/目标/抖动/口到耳时延等），引擎每 5 秒刷新一次
+    QHash<QString, JitterBuffer::Stats> rxStats() const { return engine_->rxStats(); }
+    // 实时线程的欠载/溢出计数
+    AudioEngine::Counters engineCounters() const { return engine_->counters(); }
 
 public slots:
     void onPacket(Packet p);
 
 signals:
     void micStateChanged(bool on);
+    void localSpeakingChanged(bool on);
 
 private:
-    static constexpr int   kSampleRate      = 8000;
     static constexpr int   kChannels        = 1;
-    static constexpr int   kFrameMs         = 20;
-    static constexpr int   kFrameSamples    = kSampleRate * kFrameMs / 1000;
-    static constexpr int   kPcmBytesPerFrm  = kFrameSamples * 2;
-    static constexpr int   kUlawBytesPerFrm = kFrameSamples;
-    static constexpr int   kMaxQueueFrames  = 50;
 
-    static quint8  linearToUlaw(qint16 pcm);
-    static qint16  ulawToLinear(quint8 ul);
+    struct PeerCaps {
+        QStringList codecs;
+        bool udp = false;
+    };
 
-    void startInput();
-    void stopInput();
-    void ensureOutput();
-    void onMicReadyRead();
-    void mixTick();
+    void setSpeaking(bool on);
+    void onTxReady();
+    void onUdpAudio(const QString& sender, const QString& codec, int sr,
+                    quint32 seq, qint64 ts, const QByteArray& payload);
 
-    void shrinkQueueIfNeeded(QByteArray& q);
+    void announceCaps();
+    void renegotiate();
 
     ClientConn* conn_ = nullptr;
+    UdpMediaClient* udp_ = nullptr;
+    AudioEngine* engine_ = nullptr;
+    bool useUdp_ = false;
+    bool serverMix_ = false;
+    QString mixSender_;
     QString roomId_;
     QString sender_;
-    quint32 seq_ = 0;
-    QAudioInput*  audioIn_  = nullptr;
-    QIODevice*    inDev_    = nullptr;
-    QAudioFormat  inFmt_;
-    QByteArray    inBuf_;
-    QAudioOutput* audioOut_ = nullptr;
-    QIODevice*    outDev_   = nullptr;
-    QAudioFormat  outFmt_;
-    QTimer        mixTimer_;
-    QHash<QString, QByteArray> rxQueues_;
+    QString codec_;                 // 发送编码：协商结果，引擎切换成功后回报
+    QString wantCodec_;             // 最近一次交给引擎的协商结果
+    QStringList   members_;
+    QHash<QString, PeerCaps> peerCaps_;
     bool  enabled_       = false;
+    bool  dtx_           = true;
+    bool  speaking_      = false;
     float playbackGain_  = 1.0f;
     float micGain_       = 1.0f;
     QHash<QString, float> peerGain_;
+    VoiceProcessor::Config voiceProc_;
 };
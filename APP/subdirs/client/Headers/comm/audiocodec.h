@@ -0,0 +1,50 @@
+#pragma once
+#include <QtCore>
+
+// 音频编解码。内部统一 16kHz 单声道 PCM16、20ms 一帧
+// - "opus"：16kHz 宽带，24kbit/s，带内 FEC + 解码器 PLC；仅 HAVE_OPUS（client.pro 检测到 opus）时可用
+// - "mulaw"：G.711 8kHz，所有版本都支持，作为协商回退；编解码时在 8k/16k 间重采样
+// - "pcm16"：旧版调试用，只收不发
+// - "cn"：静音期间的舒适噪声帧（DTX），payload 1 字节噪声电平 -dBov，接收端据此生成噪声
+namespace AudioCodec {
+const int kSampleRate   = 16000;
+const int kFrameMs      = 20;
+const int kFrameSamples = kSampleRate * kFrameMs / 1000;
+
+// 本端可发送的编码，按优先级
+QStringList supported();
+
+quint8 linearToUlaw(qint16 pcm);
+qint16 ulawToLinear(quint8 ul);
+
+inline QByteArray comfortNoisePayload(int noiseDbov) { return QByteArray(1, char(qBound(0, noiseDbov, 127))); }
+}
+
+class AudioEncoder {
+public:
+    virtual ~AudioEncoder() = default;
+
+    virtual QString name() const = 0;
+    virtual int wireRate() const = 0;               // 包里的 sr 字段
+
+    // pcm：kFrameSamples 个 16kHz 样本；失败返回空
+    virtual QByteArray encode(const qint16* pcm) = 0;
+
+    static AudioEncoder* create(const QString& codec);   // 不支持返回 nullptr
+};
+
+class AudioDecoder {
+public:
+    virtual ~AudioDecoder() = default;
+
+    // 解出 kFrameSamples 个 16kHz 样本
+    virtual bool decode(const QByteArray& payload, qint16* out) = 0;
+    // 用下一帧携带的冗余恢复丢失的本帧（Opus 带内 FEC）
+    virtual bool decodeFec(const QByteArray& next, qint16* out) { Q_UNUSED(next); Q_UNUSED(out); return false; }
+    // 无数据时由解码器外推（Opus PLC）；不支持时由抖动缓冲重复上一帧
+    virtual bool conceal(qint16* out) { Q_UNUSED(out); return false; }
+    // 舒适噪声：抖动缓冲在两个 CN 帧之间持续调 conceal 出噪声，不按丢包处理
+    virtual bool isComfortNoise() const { return false; }
+
+    static AudioDecoder* create(const QString& codec, int wireRate);
+};
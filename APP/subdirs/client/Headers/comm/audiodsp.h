@@ -0,0 +1,36 @@
+#pragma once
+#include <QtCore>
+
+// 音频样本级内核（客户端与服务器 common 各一份，内容相同）
+// - µ-law：编码查 64KB 表（按 16 位样本直接索引），解码查 256 项表；与 G.711 逐位一致
+// - 混音/增益：16 位饱和加、Q14 定点增益（0..2 倍，mulhrs 后饱和翻倍）
+// - 服务器混音：int32 累加总和，再减去自己并饱和收窄
+// 按编译目标选路径：AVX2 > SSSE3 > SSE2 > NEON > 标量，各路径结果逐位一致；
+// x86-64 默认只有 SSE2，要用 AVX2/SSSE3 需在 .pro 里加对应的 -m 选项
+namespace AudioDsp {
+
+quint8 linearToUlaw(qint16 pcm);
+qint16 ulawToLinear(quint8 u);
+void encodeUlaw(const qint16* in, quint8* out, int n);
+void decodeUlaw(const quint8* in, qint16* out, int n);
+
+// 增益转 Q14（0..2 倍）；kUnityGain 表示 1.0
+const int kUnityGain = 1 << 14;
+int gainQ14(float gain);
+
+// buf = sat(buf * g)
+void applyGain(qint16* buf, int n, int gQ14);
+// acc = sat(acc + in)
+void mixAdd(qint16* acc, const qint16* in, int n);
+// acc = sat(acc + sat(in * g))
+void mixAddGain(qint16* acc, const qint16* in, int n, int gQ14);
+
+// acc += in（int32，不会溢出）
+void accumulate(qint32* acc, const qint16* in, int n);
+// out = sat16(acc - own)，own 为空时就是 sat16(acc)
+void mixMinus(const qint32* acc, const qint16* own, qint16* out, int n);
+
+// 当前编译进来的 SIMD 路径名，日志/基准用
+const char* backend();
+
+}
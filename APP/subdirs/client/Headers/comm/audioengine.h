@@ -0,0 +1,146 @@
+#pragma once
+#include <QtCore>
+#include <QtMultimedia>
+#include "audiocodec.h"
+#include "audiodsp.h"
+#include "audioproc.h"
+#include "jitterbuffer.h"
+#include "resampler.h"
+#include "spscring.h"
+#include "vad.h"
+
+// 语音实时线程：采集 → 前处理（AEC/NS/AGC）→ 增益/VAD → 编码，收包 → 抖动缓冲 → 混音 → 播放，全部在这条高优先级线程里跑，
+// GUI 线程卡住（图表重绘、JPEG 解码）不再导致断音
+// - 与 GUI 线程只经两个 SPSC 无锁环交换媒体：rx（GUI 收到的语音帧 → 引擎），tx（引擎编好的帧 → GUI 发出）
+// - 播放为拉模式：声卡要数据时才从各抖动缓冲取帧混音，设备里最多排 kOutQueueFrames 帧；
+//   混好的帧同时交给前处理当回声参考（同一线程，不用加锁）
+// - 增益/DTX 用原子量，编码切换、对端增益等通过排队调用进引擎线程；统计在引擎线程生成快照
+// - 网络收发仍在 GUI 线程：语音和视频共用 UdpMediaClient 的一个端口，中继按 房间/用户 只记一个地址；
+//   GUI 卡住时包在 socket 缓冲里排队，到达时刻（postRx 填）随之推迟，抖动缓冲会按更大的抖动加深
+class AudioEngine : public QObject {
+    Q_OBJECT
+public:
+    struct RxFrame {
+        QString sender;
+        QString codec;
+        int     sr = 0;
+        quint32 seq = 0;
+        qint64  ts = 0;
+        qint64  arrival = 0;        // GUI 线程收到的时刻，抖动估计用；postRx 填
+        QByteArray payload;
+    };
+
+    struct TxFrame {
+        QString codec;
+        int     sr = 0;
+        quint32 seq = 0;
+        qint64  ts = 0;
+        int     level = 127;        // -dBov
+        bool    voiced = false;
+        QByteArray payload;
+    };
+
+    struct Counters {
+        int outUnderruns = 0;       // 两次供数间隔超过设备缓冲时长，声卡放空
+        int inOverruns = 0;         // 采集缓冲读出时已满，期间的样本被设备丢掉
+        int rxOverruns = 0;         // 收包环满，帧被丢
+        int txOverruns = 0;         // 发包环满（GUI 线程长时间没取），帧被丢
+        int procAvgUs = 0;          // 前处理每帧耗时，本统计周期（5s）内
+        int procMaxUs = 0;
+    };
+
+    explicit AudioEngine(QObject* parent = nullptr);
+    ~AudioEngine() override;
+
+    // 以下在 GUI 线程调用
+    bool postRx(const RxFrame& f);
+    bool takeTx(TxFrame& f);
+
+    void setCapture(bool on);
+    void setCodec(const QString& codec);
+    void setDtx(bool on) { dtx_.storeRelease(on ? 1 : 0); }
+    void setMicGain(float g) { micGain_.storeRelease(AudioDsp::gainQ14(g)); }
+    void setPlaybackGain(float g) { playGain_.storeRelease(AudioDsp::gainQ14(g)); }
+    void setPeerGain(const QString& sender, float g);
+    void setVoiceProcessing(const VoiceProcessor::Config& cfg);
+    void dropPeer(const QString& sender);
+
+    bool hasOutput() const { return outputOk_.loadAcquire() != 0; }
+    QHash<QString, JitterBuffer::Stats> rxStats() const;
+    Counters counters() const;
+
+signals:
+    // 在引擎线程发出，接收方按 AutoConnection 回到自己线程
+    void txReady();                 // 有新帧；GUI 收到后用 takeTx 取到空为止
+    void speakingChanged(bool on);
+    void codecChanged(const QString& codec);
+
+private:
+    static constexpr int kFrameMs        = AudioCodec::kFrameMs;
+    static constexpr int kFrameSamples   = AudioCodec::kFrameSamples;
+    static constexpr int kOutQueueFrames = 3;
+    static constexpr int kCnIntervalFrames = 8;     // DTX 期间舒适噪声帧间隔（160ms）
+    static constexpr int kStatsLogMs     = 5000;
+
+    struct Peer {
+        JitterBuffer jb{AudioCodec::kFrameSamples, AudioCodec::kFrameMs};
+        QHash<QString, QSharedPointer<AudioDecoder>> decoders;   // "codec/sr" -> 解码器
+    };
+
+    // 以下只在引擎线程执行
+    void init();
+    void shutdown();
+    void startInput();
+    void stopInput();
+    void ensureOutput();
+    void onMicReadyRead();
+    void encodeFrame(qint16* s);
+    void drainRx();
+    void mixFrame(qint16* out, qint64 playoutMs);
+    qint64 fillOutput(char* data, qint64 maxlen);
+    void logStats();
+
+    QThread  thread_;
+    QObject* worker_{nullptr};      // 引擎线程上下文，设备对象都挂在它下面
+
+    SpscRing<RxFrame> rx_{512};
+    SpscRing<TxFrame> tx_{64};
+
+    QAtomicInt micGain_{AudioDsp::kUnityGain};
+    QAtomicInt playGain_{AudioDsp::kUnityGain};
+    QAtomicInt dtx_{1};
+    QAtomicInt outputOk_{0};
+    QAtomicInt txPending_{0};       // 已发 txReady、GUI 还没来取
+    QAtomicInt outUnderruns_{0}, inOverruns_{0}, rxOverruns_{0}, txOverruns_{0};
+    QAtomicInt procUsSum_{0}, procFrames_{0}, procUsMax_{0};
+
+    mutable QMutex statsMu_;
+    QHash<QString, JitterBuffer::Stats> statsSnap_;
+
+    // 引擎线程状态
+    QAudioInput*  audioIn_  = nullptr;
+    QIODevice*    inDev_    = nullptr;
+    QAudioFormat  inFmt_;
+    Resampler     inResampler_;
+    QVector<qint16> inMono_;
+    QVector<qint16> inBuf_;         // 16kHz，攒够一帧就编码
+    QAudioOutput* audioOut_ = nullptr;
+    QIODevice*    pull_     = nullptr;
+    QAudioFormat  outFmt_;
+    Resampler     outResampler_;
+    QVector<qint16> outBuf_;
+    QVector<qint16> mixBuf_;
+    QVector<qint16> peerBuf_;
+    QByteArray    outPending_;      // 已转成设备格式、还没被设备取走的字节
+    int           outQueueMs_ = 0;  // 上次供数后，最新混出的帧离出声还有多久（设备缓冲 + outPending_）
+    QElapsedTimer lastFill_;
+    QTimer*       statsTimer_ = nullptr;
+    QHash<QString, Peer> peers_;
+    QHash<QString, int>  peerGain_; // Q14
+    QScopedPointer<AudioEncoder> encoder_;
+    QScopedPointer<VoiceProcessor> proc_;
+    VoiceActivityDetector vad_;
+    int     dtxRun_ = 0;
+    bool    speaking_ = false;
+    quint32 seq_ = 0;
+};
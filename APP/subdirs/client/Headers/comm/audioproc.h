@@ -0,0 +1,36 @@
+#pragma once
+#include <QtCore>
+
+// 麦克风前处理：回声消除（AEC）→ 稳态噪声抑制 + 残余回声抑制（NS）→ 自动增益（AGC）
+// 都在语音实时线程里跑，输入输出都是 16kHz 单声道、20ms 一帧
+// - AEC：分块频域 NLMS（64 点一块、128 点 FFT、64 个分块 = 256ms 回声尾长），步长按回声估计/误差比收放，
+//   双讲时自动放慢；参考信号是混音线程刚送去播放的帧，按样本数对齐，队列越界时重新对齐；
+//   对齐时延取 AudioEngine 实测的播放+采集排队（一段时间内的最小值）减去余量，让参考总是领先回声
+// - NS：320 点 sqrt-Hann、10ms 跳、512 点 FFT，最小值跟踪噪声谱 + 判决引导维纳增益，最多压 20dB；
+//   AEC 的回声估计按泄漏系数计入“噪声”，顺带压掉残余回声；开 NS/AEC 时多 10ms 延迟
+// - AGC：只在像语音的帧上估电平，慢升快降到 -20dBFS，峰值限幅
+// 每帧约 0.5 Mflop，单核远低于 20ms 帧预算；实际耗时由 AudioEngine 统计到 [audio-engine] 日志
+// 接口留给外部实现（如 WebRTC APM）替换；Config 全关即旁路
+class VoiceProcessor {
+public:
+    struct Config {
+        bool aec = true;
+        bool ns  = true;
+        bool agc = true;
+        bool isBypass() const { return !aec && !ns && !agc; }
+    };
+
+    virtual ~VoiceProcessor() = default;
+
+    virtual QString name() const = 0;
+    // 刚送去播放的远端帧（16kHz，AEC 参考）
+    virtual void farEnd(const qint16* pcm, int n) = 0;
+    // 下一帧近端开头到最新参考的大致时延（播放排队 + 采集排队），每帧 process 之前给
+    virtual void setEchoDelay(int ms) = 0;
+    // 近端一帧（kFrameSamples 个 16kHz 样本），原地处理
+    virtual void process(qint16* pcm, int n) = 0;
+    // 重新开始（开麦时）：清状态并重新对齐参考
+    virtual void reset() = 0;
+
+    static VoiceProcessor* create(const Config& cfg);
+};
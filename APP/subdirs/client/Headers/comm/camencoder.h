@@ -0,0 +1,54 @@
+#pragma once
+#include <QtCore>
+#include <QtGui>
+
+// 摄像头 JPEG 编码线程
+// 队列深度 1：编码中再来帧只保留最新一帧，旧的待编码帧直接丢弃
+// 一帧可带多个分辨率层（simulcast），同一帧的各层共用一个 seq，整组编码、整组丢弃
+// 编码耗时滑动平均超过帧预算时自动降质量，富余时慢慢回升到基准质量
+class CameraEncoder : public QObject {
+    Q_OBJECT
+public:
+    struct Stats {
+        double  encodeMsAvg = 0;   // 编码耗时 EMA
+        int     quality = 0;       // 当前实际质量
+        quint64 encoded = 0;
+        quint64 dropped = 0;       // 被更新帧顶替掉的帧
+    };
+
+    explicit CameraEncoder(QObject* parent = nullptr);
+    ~CameraEncoder() override;
+
+    // 上层给出的目标质量与每帧时间预算（1000/fps）
+    void setBaseQuality(int q);
+    void setFrameBudgetMs(int ms);
+
+    // GUI 线程调用；layers[i] 为第 i 层，空图表示该层本帧不产出（0 层必须有）
+    // meta 原样随 encoded 带回，另加 layer 与 seq
+    void submit(const QVector<QImage>& layers, const QJsonObject& meta);
+
+    Stats stats() const;
+
+signals:
+    // 在编码线程发出，接收方按 AutoConnection 回到自己线程
+    void encoded(QByteArray jpeg, QJsonObject meta, QSize wh);
+
+private:
+    void drain();                       // 编码线程内执行
+    void adaptQuality(double costMs);   // 编码线程内执行
+
+    QThread  thread_;
+    QObject* worker_{nullptr};          // 仅作 invokeMethod 的线程上下文
+
+    mutable QMutex mu_;
+    QVector<QImage> pending_;
+    QJsonObject pendingMeta_;
+    bool        busy_{false};           // 已投递 drain 且尚未排空
+    quint32     seq_{0};                // 实际编出的帧序号，仅编码线程使用
+    Stats       stats_;
+
+    QAtomicInt baseQuality_{60};
+    QAtomicInt quality_{60};
+    QAtomicInt budgetMs_{83};
+    qint64     lastAdaptMs_{0};
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <QtCore>
+#include <QtGui>
+#include <functional>
+
+// 远端视频帧解码调度
+// - 每个 (发送者, media) 只保留最新一帧压缩数据，来不及解的旧帧直接覆盖
+// - 按显示刷新节拍统一派发，只解当前可见的画面，解码尺寸取画面实际显示尺寸
+//   （QImageReader::setScaledSize 让 JPEG 插件在 DCT 阶段按 1/2、1/4、1/8 缩小）
+// - 解码在线程池完成，结果回到 GUI 线程经 frameDecoded 发出
+// - 每个画面同时最多一个解码任务；drop/forget/clear 时在途任务的槽位留到结果回来，
+//   按代号丢掉旧结果，重开后的新帧不会被旧画面顶掉，也不会并发乱序
+class DecodeScheduler : public QObject {
+    Q_OBJECT
+public:
+    // 返回该画面当前需要的显示尺寸（物理像素）；空尺寸表示不可见，暂不解码
+    using TargetFn = std::function<QSize(const QString& sender, const QString& media)>;
+
+    explicit DecodeScheduler(TargetFn target, QObject* parent = nullptr);
+    ~DecodeScheduler() override;
+
+    void setIntervalMs(int ms);
+
+    void submit(const QString& sender, const QString& media, const QByteArray& jpeg);
+
+    // 布局/可见性变化后调用，让搁置的帧重新参与派发
+    void kick();
+
+    // 丢弃待解帧与在途结果（如对端关闭摄像头/共享）
+    void drop(const QString& sender, const QString& media);
+    void forget(const QString& sender);
+    void clear();
+
+signals:
+    void frameDecoded(const QString& sender, const QString& media, const QImage& img);
+
+private slots:
+    void onTick();
+
+private:
+    struct Slot {
+        QByteArray jpeg;        // 待解的最新一帧，解出后清空
+        bool inFlight = false;
+        quint32 gen = 0;        // drop 时 +1，在途结果代号不符即丢弃
+    };
+
+    static QString slotKey(const QString& sender, const QString& media) { return sender + QLatin1Char('\n') + media; }
+    QHash<QString, Slot>::iterator dropSlot(QHash<QString, Slot>::iterator it);
+    void onDecoded(const QString& key, quint32 gen, const QImage& img);
+
+    TargetFn target_;
+    QTimer timer_;
+    QThreadPool pool_;
+    QHash<QString, Slot> slots_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <QtCore>
+#include "audiocodec.h"
+
+// 单个发送者的音频抖动缓冲（存压缩帧，出队时才解码，定长 PCM16 输出）
+// - 按 seq 重组乱序，已过播放点的迟到帧丢弃
+// - 目标深度 = 最近一段相对时延（到达时刻 - 发送 ts，减去窗口最小值）的 95 分位 + 一帧，随抖动自适应
+// - 深度持续超出目标时把两帧交叉淡化成一帧（压缩一帧时长）；严重积压直接丢到目标深度
+// - 缺帧先用下一帧的 FEC 恢复，其次解码器 PLC，最后上一帧衰减重复；连续若干帧后转静音，
+//   缓冲空且补帧用完时回到预缓冲（讲话停顿）
+// - 对端 DTX：上一帧是舒适噪声（CN）时，缓冲空或下一段话还没攒够目标深度就继续出噪声，不计丢包；
+//   CN 也断了（对端离开）约 1s 后转静音
+// - 端到端时延 = 预计出声时刻 - 发送 ts；跨机器时均值含两端时钟差，标准差不受影响
+class JitterBuffer {
+public:
+    enum Result { Silence, Played, Concealed };
+
+    struct Stats {
+        int    depthMs = 0;
+        int    targetMs = 0;
+        double jitterMs = 0;        // RFC 3550 到达间隔抖动
+        double delayMeanMs = 0;     // 端到端（口到耳）
+        double delayStdMs = 0;
+        int    received = 0;
+        int    late = 0;            // 到得太晚被丢弃
+        int    missing = 0;         // 播放时缺帧
+        int    concealed = 0;
+        int    fec = 0;             // 其中靠 FEC 恢复的
+        int    compressed = 0;      // 两帧并一帧
+        int    dropped = 0;         // 积压丢弃
+    };
+
+    explicit JitterBuffer(int frameSamples = 160, int frameMs = 20);
+
+    // dec：解这一帧用的解码器（同一发送者中途换编码时帧间可不同）
+    void push(quint32 seq, qint64 sendTs, const QByteArray& payload,
+              const QSharedPointer<AudioDecoder>& dec, qint64 nowMs);
+
+    // 取一帧（frameSamples 个样本）写入 out；playoutMs 为这帧预计真正出声的时刻
+    Result pop(qint16* out, qint64 playoutMs);
+
+    int  depthMs() const;
+    Stats stats() const;
+    void resetStats();
+    void reset();
+
+private:
+    struct Frame {
+        QByteArray payload;
+        QSharedPointer<AudioDecoder> dec;
+        qint64 sendTs = 0;
+    };
+
+    void updateTarget();
+    void conceal(qint16* out);
+    void repeatLast(qint16* out);
+    void noteDelay(qint64 sendTs, qint64 playoutMs);
+
+    int frameSamples_;
+    int frameMs_;
+
+    QMap<qint64, Frame> frames_;    // 展开后的 seq -> 帧
+    bool   haveSeq_ = false;
+    qint64 maxSeq_ = 0;
+    qint64 nextSeq_ = 0;            // 下一帧应播放的 seq
+    bool   started_ = false;        // 预缓冲完成
+
+    QVector<qint64> transit_;       // 到达时刻 - 发送 ts 的环形窗口
+    int    transitPos_ = 0;
+    int    pushesSinceTarget_ = 0;
+    qint64 lastTransit_ = 0;
+    bool   haveTransit_ = false;
+    double jitter_ = 0;
+    int    targetMs_ = 60;
+
+    QVector<qint16> last_;          // 最近输出的一帧，解码器不能补帧时重复它
+    QVector<qint16> tmp_;
+    QSharedPointer<AudioDecoder> lastDec_;
+    int    lossRun_ = 0;
+    int    overRun_ = 0;
+    int    cngRun_ = 0;
+
+    // 统计（resetStats 清零）
+    int    received_ = 0, late_ = 0, missing_ = 0, concealed_ = 0, fec_ = 0, compressed_ = 0, dropped_ = 0;
+    qint64 delayN_ = 0;
+    double delayMean_ = 0, delayM2_ = 0;
+};
@@ -1,24 +1,29 @@
 #pragma once
 #include <QtCore>
 #include <QtNetwork>
+#include "control_client.h"
 
 class KbClient {
 public:
-    // 同步调用，返回 {"ok":bool, ...}
-    static QJsonObject call(const QHostAddress& host, quint16 port, const QJsonObject& req, int msTimeout = 3000);
+    using Callback = ControlClient::Callback;
 
-    static QJsonObject getRecordings(const QHostAddress& host, quint16 port,
-                                     const QString& roomId = QString()) {
+    // 异步调用（共享常驻连接），回调收到 {"ok":bool, ...}；context 销毁后不回调
+    static void call(const QHostAddress& host, quint16 port, const QJsonObject& req,
+                     QObject* context, Callback cb, int msTimeout = 3000);
+
+    static void getRecordings(const QHostAddress& host, quint16 port, const QString& roomId,
+                              QObject* context, Callback cb) {
         QJsonObject req{{"action","get_recordings"}};
         if (!roomId.isEmpty()) req["room_id"] = roomId;
-        return call(host, port, req);
+        call(host, port, req, context, std::move(cb));
     }
 
-    static QJsonObject getRecordingFiles(const QHostAddress& host, quint16 port,
-                                         int recordingId = 0, const QString& roomId = QString()) {
+    static void getRecordingFiles(const QHostAddress& host, quint16 port,
+                                  int recordingId, const QString& roomId,
+                                  QObject* context, Callback cb) {
         QJsonObject req{{"action","get_recording_files"}};
         if (recordingId > 0) req["recording_id"] = recordingId;
         if (!roomId.isEmpty()) req["room_id"] = roomId;
-        return call(host, port, req);
+        call(host, port, req, context, std::move(cb));
     }
 };
@@ -2,11 +2,17 @@
 
 #include <QWidget>
 #include <QHostAddress>
+#include <QImage>
+#include <QJsonObject>
+#include <QModelIndex>
 
 class QLineEdit;
 class QSpinBox;
 class QPushButton;
-class QTableWidget;
+class QTableView;
+class QComboBox;
+class QLabel;
+class RecordingLibraryModel;
 
 class KnowledgePanel : public QWidget
 {
@@ -27,17 +33,23 @@ public:
 public slots:
     void refresh();
 
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
 private:
     // UI
     QLineEdit*    hostEdit_{nullptr};
     QSpinBox*     portSpin_{nullptr};
     QLineEdit*    roomEdit_{nullptr};
+    QComboBox*    rangeCombo_{nullptr};     // 时间范围：全部/今天/近7天/近30天
     QPushButton*  refreshBtn_{nullptr};
-    QTableWidget* table_{nullptr};
+    QTableView*   table_{nullptr};
+    RecordingLibraryModel* model_{nullptr};
+    QLabel*       previewLabel_{nullptr};   // 录制雪碧图预览，点击跳转播放
 
     // helpers
     void setBusy(bool on);
-    void playFile(const QString& filePath) const;
+    void playFile(const QString& filePath, qint64 startMs = 0) const;
     QString findFfplay() const;
 
     // 路径解析增强
@@ -47,8 +59,20 @@ private:
     bool isValidKnowledgeRoot(const QString& root) const;          // root/knowledge 必须存在
 
     // events
-    void onTableDoubleClicked(int row, int col);
+    void onTableDoubleClicked(const QModelIndex& index);
+    void onCurrentRowChanged();
+
+    // 预览：按所选行加载 <base>.sprite.jpg / <base>.index.json
+    void showPreviewForRow(int row);
+    void clearPreview();
+    qint64 seekTimeForPreviewPos(const QPoint& pos) const;
+
+    QString      previewVideo_;
+    QImage       previewSprite_;
+    QJsonObject  previewIndex_;
 
     // cache
     mutable QString rootCache_;
+
+    bool busy_ = false;
 };
@@ -15,6 +15,10 @@
 #include "clientconn.h"
 #include "audiochat.h"
 #include "screenshare.h"
+#include "camencoder.h"
+#include "ratecontrol.h"
+#include "decodesched.h"
+#include "tilecompositor.h"
 
 class AnnotCanvas;
 class QComboBox;
@@ -105,9 +109,17 @@ private:
     void configureCamera(QCamera* cam);
     void hookCameraLogs(QCamera* cam);
 
-    QImage makeImageFromFrame(const QVideoFrame &frame);
+    QSize localPreviewSize(const QSize& frameSize) const;
+    bool localPreviewVisible() const;
+    int previewIntervalMs() const;
+    int localPreviewIntervalMs() const;
     void updateLocalPreview(const QImage& img);
-    void sendImage(const QImage& img);
+    QVector<QSize> cameraLayerSizes(const QSize& full) const;
+    void sendCameraLayers(const QVector<QImage>& layers);
+    void scheduleLayerPrefs();
+    QSize decodeTargetFor(const QString& sender, const QString& media) const;
+    void onRemoteFrameDecoded(const QString& sender, const QString& media, const QImage& img);
+    void sendLayerPrefs();
 
     enum class ViewMode { Grid, Focus };
     ViewMode currentMode() const;
@@ -115,6 +127,7 @@ private:
     void refreshGridOnly();
     void refreshFocusThumbs();
     void setMainKey(const QString& key);
+    void applyActiveSpeakers(const QStringList& speakers);
     void updateMainFromTile(VideoTile* t);
     void updateMainFitted();
 
@@ -126,11 +139,10 @@ private:
 
     void bindVolumeButton(VideoTile* t, bool isLocal);
 
-    static QImage composeTileImage(const VideoTile* t, const QSize& target);
     void refreshTilePixmap(VideoTile* t);
     void togglePiP(VideoTile* t);
 
-    void applyAdaptiveByMembers(int members);
+    void applyCameraRung(const CamRateController::Rung& r);
 
     void applyShareQualityPreset();
 
@@ -144,6 +156,8 @@ private:
     QPushButton *btnCamera_{};
     QPushButton *btnMic_{};
     QPushButton *btnShare_{};
+    QPushButton *btnFollowSpeaker_{};   // 主画面跟随主讲人
+    QPushButton *btnVoiceProc_{};       // 麦克风前处理（回声消除/降噪/自动增益）开关
     QComboBox  *cbShareQ_{};
     QPushButton *btnLeave_{};  // 新增：退出房间按钮
 
@@ -176,6 +190,17 @@ private:
     int jpegQuality_{60};
     QSize sendSize_{640, 480};
     QElapsedTimer lastSend_;
+    CameraEncoder* camEncoder_{nullptr};
+    CamRateController* camRate_{nullptr};
+    CamRxReporter* camRx_{nullptr};
+    QList<int> camLayers_{0};       // 服务器告知有人订阅的层（0 层始终产出）
+    QStringList activeSpeakers_;    // 服务器通知的发言者，第一个为主讲
+    QTimer* layerPrefTimer_{nullptr};
+    DecodeScheduler* decoder_{nullptr};
+    TileCompositor compositor_;     // 各画面控件的常驻合成缓冲
+    QHash<QString, int> layerPrefsSent_;
+    QElapsedTimer lastPreview_;     // 本地预览节流，见 localPreviewIntervalMs
+    bool inRoom_{false};            // 已发入会且未离开/断线；不在房间时摄像头帧不做发送转换
     QVideoFrame::PixelFormat lastLoggedFormat_{QVideoFrame::Format_Invalid};
 
     QHash<QString, QImage> screenBack_;
@@ -0,0 +1,108 @@
+#pragma once
+#include <QtCore>
+#include "clientconn.h"
+
+// 摄像头码率控制：按实际上行能力在 分辨率/帧率/质量 档位间升降
+// 拥塞信号：
+//   - ClientConn::bytesToWrite() 持续增长或积压超过 ~0.5s 的目标码率
+//   - MSG_ECHO 往返时延比基线高出 kRttSlackMs（排队延迟）
+//   - 接收端 rx_report 报告的丢帧率（服务器积压丢帧 + 链路问题）
+// 拥塞时目标码率按实测发送速率乘性下降，空闲时小步加性上升；升档有冷却，降档立即
+class CamRateController : public QObject {
+    Q_OBJECT
+public:
+    struct Rung {
+        QSize size;
+        int   fps = 0;
+        int   quality = 0;
+    };
+
+    explicit CamRateController(ClientConn* conn, QObject* parent = nullptr);
+
+    // 摄像头采集分辨率按最高档配置，降档只改变转换输出尺寸
+    static QSize captureSize();
+
+    void start();
+    void stop();
+    bool isRunning() const { return timer_.isActive(); }
+
+    // 人数只决定档位上限（人多时每个画面都小）
+    void setMemberCount(int n);
+
+    // 各层都计入发送速率；只有 0 层用于修正档位码率估计
+    void onFrameQueued(int bytes, int layer);
+    void onEcho(const QJsonObject& json);
+    void onRxReport(int recv, int lost);
+
+    const Rung& current() const;
+    int targetKbps() const { return int(targetKbps_); }
+
+signals:
+    void rungChanged(const CamRateController::Rung& r);
+
+private slots:
+    void onTick();
+
+private:
+    double rungKbps(int idx) const;
+    void   decide(qint64 now, bool congested);
+    void   setRung(int idx, qint64 now);
+
+    ClientConn* conn_{nullptr};
+    QTimer timer_;
+    QElapsedTimer clock_;
+
+    int    rung_{0};
+    int    maxRung_{0};
+    double targetKbps_{0};
+    double complexity_{1.0};     // 实际帧大小 / 名义帧大小 的 EMA
+    double layerFactor_{1.0};    // 全部层字节 / 0 层字节 的 EMA（simulcast 额外开销）
+
+    qint64 windowStartMs_{0};
+    qint64 windowBytes_{0};
+    qint64 windowBase_{0};       // 窗口内 0 层字节
+    double sendKbps_{0};
+
+    qint64 lastBacklog_{0};
+    int    growTicks_{0};
+
+    int    srttMs_{-1};
+    int    minRttMs_{-1};
+    qint64 minRttResetMs_{0};
+    qint64 lastEchoMs_{0};
+
+    double lossRatio_{0};        // 自上次决策以来各接收端报告的最大丢帧率
+
+    qint64 lastDecreaseMs_{0};
+    qint64 lastRungChangeMs_{0};
+    qint64 lastDecideMs_{0};
+};
+
+// 接收端：按发送者统计摄像头帧 seq 的空洞，定期以 MSG_CONTROL{kind:"rx_report"} 回报
+class CamRxReporter : public QObject {
+    Q_OBJECT
+public:
+    explicit CamRxReporter(ClientConn* conn, QObject* parent = nullptr);
+
+    void setIdentity(const QString& roomId, const QString& user);
+    void onFrame(const QString& sender, const QJsonObject& json);
+    void forget(const QString& sender) { stats_.remove(sender); }
+    void clear() { stats_.clear(); }
+
+private slots:
+    void flush();
+
+private:
+    struct Stat {
+        int    layer = 0;           // 服务器切层后 seq 不连续，重新计
+        qint64 lastSeq = -1;
+        int    recv = 0;
+        int    lost = 0;
+    };
+
+    ClientConn* conn_{nullptr};
+    QTimer timer_;
+    QString roomId_;
+    QString user_;
+    QHash<QString, Stat> stats_;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHostAddress>
+#include <QVector>
+#include <QJsonObject>
+
+// 知识库录制列表：get_recording_library 分页异步加载，视图滚到底时 fetchMore 取下一页
+class RecordingLibraryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    // 路径列上挂的预览产物
+    static const int ThumbPathRole = Qt::UserRole + 1;
+    static const int IndexPathRole = Qt::UserRole + 2;
+
+    struct Row {
+        int     recordingId = 0;
+        QString roomId;
+        QString user;
+        QString filePath;
+        QString kind;
+        QString title;
+        QString started;
+        QString ended;
+        QString thumbPath;
+        QString indexPath;
+    };
+
+    explicit RecordingLibraryModel(QObject* parent = nullptr);
+
+    // 清空并按新条件加载第一页；fromMs/toMs 为 0 表示不限
+    void reload(const QHostAddress& host, quint16 port, const QString& roomId,
+                qint64 fromMs = 0, qint64 toMs = 0);
+
+    const Row* rowAt(int row) const;
+    bool isLoading() const { return loading_; }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+signals:
+    void loadingChanged(bool loading);
+    void loadFailed(const QString& msg);
+
+private:
+    void requestPage();
+    void setLoading(bool on);
+    static QString formatTime(const QJsonValue& v);
+
+    QVector<Row> rows_;
+
+    QHostAddress host_;
+    quint16 port_ = 0;
+    QString roomId_;
+    qint64 fromMs_ = 0;
+    qint64 toMs_ = 0;
+
+    int  afterRecId_ = 0;
+    int  afterFileId_ = 0;
+    bool hasMore_ = false;
+    bool loading_ = false;
+    int  gen_ = 0;          // reload 后旧页应答丢弃
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <QtCore>
+#include <QtMultimedia>
+
+// 单声道 PCM16 流式重采样
+// 线性插值；降采样时先做 round(in/out) 点滑动平均低通，抑制混叠。跨块保持相位和滤波状态连续
+class Resampler {
+public:
+    explicit Resampler(int inRate = 16000, int outRate = 16000);
+
+    void setRates(int inRate, int outRate);
+    int  inRate() const { return inRate_; }
+    int  outRate() const { return outRate_; }
+    bool isPassthrough() const { return inRate_ == outRate_; }
+
+    // 结果追加到 out
+    void process(const qint16* in, int n, QVector<qint16>& out);
+    void reset();
+
+private:
+    int    inRate_;
+    int    outRate_;
+    double step_ = 1.0;         // 每个输出样本前进的输入样本数
+    double pos_ = 0.0;          // 下一个输出在当前块中的位置，-1 表示上一块最后一个样本
+    qint16 prev_ = 0;
+    int    taps_ = 1;
+    QVector<qint16> hist_;      // 低通滤波历史（taps_-1 个）
+    int    histSum_ = 0;
+    QVector<qint16> filtered_;
+};
+
+// 设备格式 <-> 内部单声道 PCM16
+// 支持 8 位无符号、16 位有符号、32 位浮点（小端）；多声道输入取平均，输出复制到各声道
+namespace AudioFormatConv {
+bool isSupported(const QAudioFormat& f);
+int  bytesPerMs(const QAudioFormat& f);
+void toMono16(const QByteArray& raw, const QAudioFormat& f, QVector<qint16>& out);
+QByteArray fromMono16(const qint16* s, int n, const QAudioFormat& f);
+}
@@ -31,7 +31,6 @@ private:
     void sendControl(const char* state);
     void scheduleNext();
     QSize clampMin720p(const QSize& in) const;
-    QByteArray buildDeltaBlob(const QImage& prev, const QImage& curr, int block) const;
 
     ClientConn*     conn_{};
     UdpMediaClient* udp_{nullptr};
@@ -0,0 +1,52 @@
+#pragma once
+#include <QtCore>
+#include <utility>
+#include <vector>
+
+// 单生产者单消费者无锁环形队列：固定一个线程 push、另一个线程 pop
+// 容量向上取 2 的幂；满了 push 返回 false（调用方计溢出），不阻塞也不分配
+// 元素按值拷入、移出后槽位复位，QByteArray/QString 的引用计数本身是原子的，跨线程传递安全
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(int capacity = 256)
+        : slots_(roundUp(capacity)), mask_(quint32(slots_.size() - 1)) {}
+
+    // 生产者线程
+    bool push(const T& v) {
+        const quint32 h = head_.loadAcquire();
+        if (h - tail_.loadAcquire() > mask_) return false;
+        slots_[h & mask_] = v;
+        head_.storeRelease(h + 1);
+        return true;
+    }
+
+    // 消费者线程
+    bool pop(T& out) {
+        const quint32 t = tail_.loadAcquire();
+        if (t == head_.loadAcquire()) return false;
+        T& slot = slots_[t & mask_];
+        out = std::move(slot);
+        slot = T();
+        tail_.storeRelease(t + 1);
+        return true;
+    }
+
+    // 任一线程可调，结果只是瞬时值
+    int  size() const { return int(head_.loadAcquire() - tail_.loadAcquire()); }
+    bool isEmpty() const { return size() == 0; }
+    int  capacity() const { return int(mask_ + 1); }
+
+private:
+    static int roundUp(int n) {
+        int c = 2;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    std::vector<T> slots_;
+    const quint32  mask_;
+    // 头尾分开放在不同缓存行，避免两个线程互相踢
+    alignas(64) QAtomicInteger<quint32> head_{0};
+    alignas(64) QAtomicInteger<quint32> tail_{0};
+};
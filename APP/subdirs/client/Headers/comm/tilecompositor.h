@@ -0,0 +1,40 @@
+#pragma once
+#include <QtCore>
+#include <QtGui>
+
+class QLabel;
+class AnnotModel;
+
+// 视频画面合成（纯 CPU）
+// 每个输出控件一份常驻画布；源图按 cacheKey + 目标尺寸缓存缩放结果，只缩放一次直接到显示尺寸；
+// 缩略图上的标注单独缓存成透明层，按 AnnotModel::revision() 失效。
+// 源、尺寸、标注都没变时不重画也不重设 pixmap。
+class TileCompositor {
+public:
+    // 返回 false 表示没有可显示的源（调用方自行显示等待文字）或尺寸过小
+    bool render(QLabel* label, const QImage& cam, const QImage& screen,
+                bool camPrimary, const AnnotModel* overlay);
+
+    void forget(const QLabel* label) { surfaces_.remove(label); }
+    void clear() { surfaces_.clear(); }
+
+private:
+    struct Scaled {
+        qint64 key = 0;
+        QSize  size;
+        QImage img;
+    };
+    struct Surface {
+        QImage canvas;
+        Scaled big;
+        Scaled small;
+        QImage annot;
+        const AnnotModel* annotModel = nullptr;
+        quint64 annotRev = 0;
+        qint64 pixmapKey = 0;       // 设到 label 上的 pixmap，被别处替换/清掉后需重设
+    };
+
+    static const QImage& scaledSource(Scaled& cache, const QImage& src, const QSize& size);
+
+    QHash<const QLabel*, Surface> surfaces_;
+};
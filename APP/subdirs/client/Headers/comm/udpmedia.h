@@ -7,6 +7,10 @@ class UdpMediaClient : public QObject {
     Q_OBJECT
 public:
     enum Codec : quint8 { JPEG = 0, DELTA = 1 };
+    enum AudioCodecId : quint8 { AudioMulaw = 0, AudioOpus = 1, AudioPcm16 = 2, AudioCn = 3 };
+    // 语音包头 reserved 字段：bit15 表示带电平，bit7 为 VAD 语音标记，低 7 位为 -dBov；旧版填 0
+    static constexpr quint16 kAudioLevelPresent = 0x8000;
+    static constexpr quint16 kAudioVoiced       = 0x0080;
 
     explicit UdpMediaClient(QObject* parent=nullptr);
 
@@ -17,9 +21,18 @@ public:
     void sendScreenJpeg(const QByteArray& jpeg, int w, int h, qint64 tsMs = 0);
     void sendScreenDelta(const QByteArray& blob, int w, int h, qint64 tsMs = 0);
 
+    // 语音：单个数据报，不分片不重传；过期由接收端抖动缓冲丢弃
+    // 服务器对注册回执（type 4），kAckTimeoutMs 内收到过才认为 UDP 可用
+    bool isAudioReady() const { return udpOk_; }
+    // level：-dBov（0..127），<0 表示不带；服务器据此挑选主讲人
+    bool sendAudio(const QString& codec, int sr, quint32 seq, qint64 tsMs, const QByteArray& payload,
+                   int level = -1, bool voiced = true);
+
 signals:
     void udpScreenFrame(const QString& sender, QByteArray jpeg, int w, int h, qint64 ts);
     void udpScreenDeltaFrame(const QString& sender, QByteArray blob, int w, int h, qint64 ts);
+    void udpAudioFrame(const QString& sender, const QString& codec, int sr, quint32 seq, qint64 ts, QByteArray payload);
+    void udpStateChanged(bool ok);
 
 private slots:
     void onReadyRead();
@@ -38,6 +51,7 @@ private:
     };
 
     void sendRegister();
+    void setUdpOk(bool ok);
     void parseDatagram(const QByteArray& dgram, const QHostAddress& from, quint16 port);
 
     static QByteArray buildRegister(const QString& roomId, const QString& user);
@@ -45,6 +59,9 @@ private:
                                       quint32 frameId, quint16 idx, quint16 cnt,
                                       quint8 codec, int w, int h, qint64 ts,
                                       const char* payload, int len);
+    static QByteArray buildAudio(const QString& roomId, const QString& sender,
+                                 quint32 seq, qint64 ts, quint8 codec, int sr,
+                                 const QByteArray& payload, quint16 levelBits);
 
     QUdpSocket sock_;
     QHostAddress serverAddr_{QHostAddress::LocalHost};
@@ -55,6 +72,8 @@ private:
     QTimer cleanup_;
     quint32 frameSeq_{0};
     QHash<QString, Assembly> reassem_;
-    enum { kChunkPayload = 1200 };
+    qint64 lastAckMs_{0};
+    bool   udpOk_{false};
+    enum { kChunkPayload = 1200, kAckTimeoutMs = 10000 };
     static constexpr quint32 kMagic = 0x55444D31;
 };
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include <QtCore>
+
+// 发送端语音活动检测（每 20ms 一帧）
+// - 能量：帧 dBov 高于自适应噪声底若干 dB；噪声底静音时快速跟随、讲话时缓慢上漂
+// - 过零率：只比噪声底略高的帧还要求过零率落在人声范围内，压掉风扇/机器的高频稳态噪声
+// - 拖尾：判为语音后保持若干帧，避免吞掉句尾和字间停顿
+class VoiceActivityDetector {
+public:
+    struct Result {
+        bool speech = false;
+        int  levelDbov = 127;       // 本帧电平，-dBov（0 最响，127 无声），与 RFC 6464 一致
+        int  noiseDbov = 127;       // 噪声底，舒适噪声按它生成
+    };
+
+    Result process(const qint16* pcm, int n);
+    void reset();
+
+private:
+    double noiseDb_ = -70.0;
+    bool   haveNoise_ = false;
+    int    hang_ = 0;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <QtCore>
+#include <QImage>
+#include <QVideoFrame>
+
+// 摄像头帧 -> RGB32：采样（缩放）与色彩转换一次完成，不产生原尺寸中间图
+// 每个输出行：先按目标尺寸从源平面取 Y/U/V（gather），再整行 SIMD 转 RGB（convert）
+// 系数为 6 位定点 BT.601 limited range，SSE2 / NEON / 标量三条路径结果逐位一致
+namespace YuvConvert {
+
+enum class Layout { Invalid, YUYV, UYVY, NV12, NV21, I420, YV12, RGB32 };
+
+struct FrameView {
+    Layout layout = Layout::Invalid;
+    int width = 0;
+    int height = 0;
+    const uchar* plane[3] = {nullptr, nullptr, nullptr};
+    int stride[3] = {0, 0, 0};
+};
+
+// 帧必须已 map；不支持的像素格式返回 false（调用方退回 QImage 路径）
+bool viewFromMappedFrame(const QVideoFrame& mapped, FrameView* out);
+
+// src 缩放进 box 保持宽高比（与 QSize::scaled(KeepAspectRatio) 一致）
+QSize fitSize(const QSize& src, const QSize& box);
+
+// 一次 map 输出多个尺寸，outs[i] 尺寸为 sizes[i]，格式 RGB32
+void convertScaled(const FrameView& src, const QSize* sizes, QImage* outs, int count);
+
+inline QImage convertScaled(const FrameView& src, const QSize& size) {
+    QImage out;
+    convertScaled(src, &size, &out, 1);
+    return out;
+}
+
+// 整帧转 QImage（原尺寸）：Qt 能直接映射的格式拷贝一份，YUYV 逐像素转；其它格式返回空图
+// 只给 viewFromMappedFrame 不认的格式兜底，正常路径走 convertScaled
+QImage frameToImage(const QVideoFrame& frame);
+
+// 单行转换（8 像素一组 SIMD，尾部标量），对外暴露便于基准测试
+void yuvRowToRgb32(const uchar* y, const uchar* u, const uchar* v, quint32* dst, int n);
+void yuvRowToRgb32Scalar(const uchar* y, const uchar* u, const uchar* v, quint32* dst, int n);
+
+}
@@ -0,0 +1,87 @@
+#ifndef CONTROL_CLIENT_H
+#define CONTROL_CLIENT_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include <QPointer>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <functional>
+
+// 到 5555 控制端口的常驻连接（按 host:port 共享一条）
+// - 每个请求带 rid，应答按 rid 回调，可同时有多个请求在途
+// - 服务端并发执行读请求，应答可能乱序；写请求（register/new_order/update_order/delete_order）按发出顺序生效
+// - 断线自动重连（退避），在途请求以失败回调结束，未发出的请求连上后补发
+// - 无 rid 且带 event 的行视为服务端推送
+class ControlClient : public QObject
+{
+    Q_OBJECT
+public:
+    // 传输失败时 reply = {"ok":false, "msg":..., "net_error":true}
+    using Callback = std::function<void(const QJsonObject& reply)>;
+
+    static ControlClient* shared(const QString& host, quint16 port);
+
+    // context 被销毁后回调丢弃；context 为空时总会回调
+    void call(const QJsonObject& req, QObject* context, Callback cb, int timeoutMs = 5000);
+
+    // 每次（重）连上后自动补发，例如 subscribe_orders
+    void addStandingRequest(const QJsonObject& req, QObject* context, Callback cb);
+
+    bool isConnected() const { return sock_.state() == QAbstractSocket::ConnectedState; }
+
+signals:
+    void event(const QJsonObject& ev);
+    void connectionChanged(bool connected);
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void onDisconnected();
+    void onTick();
+
+private:
+    ControlClient(const QString& host, quint16 port, QObject* parent);
+
+    struct Pending {
+        QJsonObject req;
+        QPointer<QObject> ctx;
+        bool hasCtx = false;
+        Callback cb;
+        qint64 deadline = 0;   // clock_ 毫秒
+        bool sent = false;
+    };
+    struct Standing {
+        QJsonObject req;
+        QPointer<QObject> ctx;
+        bool hasCtx = false;
+        Callback cb;
+    };
+
+    void ensureConnected();
+    void enqueue(const QJsonObject& req, QObject* context, Callback cb, int timeoutMs);
+    void flush();
+    void finish(quint64 rid, const QJsonObject& reply);
+    static QJsonObject netError(const QString& msg);
+
+    QString host_;
+    quint16 port_;
+    QTcpSocket sock_;
+    QByteArray rbuf_;
+
+    quint64 nextRid_ = 1;
+    QHash<quint64, Pending> pending_;
+    QVector<quint64> unsent_;          // 保持提交顺序
+    QVector<Standing> standing_;
+
+    QTimer tick_;                      // 超时扫描 + 重连
+    QElapsedTimer clock_;
+    qint64 reconnectAt_ = -1;
+    int backoffMs_ = 500;
+    bool up_ = false;
+};
+
+#endif // CONTROL_CLIENT_H
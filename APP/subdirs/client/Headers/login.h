@@ -31,7 +31,6 @@ private slots:
     void on_btnToReg_clicked();
 
 private:
-    bool sendRequest(const QJsonObject &obj, QJsonObject &reply, QString *errMsg = nullptr);
     QString selectedRole() const; // "expert" | "factory" | ""
 
 private:
@@ -0,0 +1,67 @@
+#ifndef ORDER_SYNC_H
+#define ORDER_SYNC_H
+
+#include <QObject>
+#include <QVector>
+#include <QJsonObject>
+#include <functional>
+
+#include "client_expert.h"     // OrderInfo
+
+class ControlClient;
+
+// 工单列表本地副本（走共享的常驻控制连接，全部异步）：
+// - reload()：按 id 游标分页全量拉取；第一页到达即回调，其余页在后台续拉，每页合并后发 updated()
+// - pullChanges()：按 since_version 只拉变更/删除并合并，完成后发 updated()
+// - 订阅 orders_changed 推送，版本超过本地时自动 pullChanges()
+class OrderSync : public QObject
+{
+    Q_OBJECT
+public:
+    using Done = std::function<void(bool ok, const QString& err)>;
+
+    OrderSync(const QString& host, quint16 port,
+              const QString& role, const QString& username,
+              QObject* parent = nullptr);
+
+    void setUsername(const QString& username) { username_ = username; }
+    void setFilter(const QString& keyword, const QString& status);
+
+    void reload(Done done = Done());
+    void pullChanges();
+
+    const QVector<OrderInfo>& orders() const { return orders_; }
+    qint64 version() const { return version_; }
+
+    // 开始订阅（断线重连后自动补订）
+    void subscribe();
+
+signals:
+    // 增量合并完成，或 reload 的后续页已追加（第一页通过回调返回）
+    void updated();
+
+private:
+    QJsonObject baseRequest() const;
+    void fetchPage(int gen, qint64 afterId, qint64 baseVersion, Done done);
+    void onRemoteVersion(qint64 v);
+    void upsert(const OrderInfo& od);
+    void removeId(int id);
+    void runQueuedPull();
+
+    ControlClient* conn_ = nullptr;
+    QString role_;
+    QString username_;
+    QString keyword_;
+    QString status_;
+
+    QVector<OrderInfo> orders_;   // 按 id 升序
+    qint64 version_ = 0;
+    bool   loaded_ = false;
+    bool   subscribed_ = false;
+
+    int  gen_ = 0;                // reload 代数：旧请求的应答直接丢弃
+    bool busy_ = false;
+    bool pullQueued_ = false;
+};
+
+#endif // ORDER_SYNC_H
@@ -30,7 +30,6 @@ private slots:
     void on_btnBack_clicked();
 
 private:
-    bool sendRequest(const QJsonObject &obj, QJsonObject &reply, QString *errMsg = nullptr);
     QString selectedRole() const; // "expert" | "factory" | ""
 
 private:
@@ -1,18 +1,18 @@
 #include "client_expert.h"
 #include "ui_client_expert.h"
 
-#include <QTcpSocket>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QMessageBox>
 #include <QTimer>
 #include <QString>
-#include <QElapsedTimer>
 
 #include "comm/commwidget.h"
 #include "comm/devicepanel.h"
 #include "comm/knowledge_panel.h"
+#include "order_sync.h"
+#include "control_client.h"
 #include <QTabWidget>
 #include <QTabBar>
 
@@ -42,25 +42,6 @@ QString g_expertUsername;
 static const char*  SERVER_HOST = "127.0.0.1";
 static const quint16 SERVER_PORT = 5555;
 
-// 可靠读取“以换行分隔”的一条 JSON（带超时聚合，避免半包）
-static QJsonDocument readJsonLine(QTcpSocket& sock, int timeoutMs = 5000) {
-    QByteArray buf;
-    QElapsedTimer et; et.start();
-    while (et.elapsed() < timeoutMs) {
-        if (!sock.bytesAvailable())
-            sock.waitForReadyRead(qMax(1, timeoutMs - int(et.elapsed())));
-        buf += sock.readAll();
-        int nl = buf.indexOf('\n');
-        if (nl >= 0) {
-            QByteArray line = buf.left(nl);
-            if (!line.isEmpty() && line.endsWith('\r')) line.chop(1);
-            return QJsonDocument::fromJson(line);
-        }
-    }
-    // 超时也尝试解析（容错）
-    return QJsonDocument::fromJson(buf);
-}
-
 ClientExpert::ClientExpert(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::ClientExpert)
@@ -145,7 +126,13 @@ ClientExpert::ClientExpert(QWidget *parent) :
     ui->comboBoxStatus->addItem("已接受");
     ui->comboBoxStatus->addItem("已拒绝");
 
+    // 工单列表：首次全量拉取，之后靠服务端推送做增量合并
+    orderSync_ = new OrderSync(QString::fromLatin1(SERVER_HOST), SERVER_PORT,
+                               QStringLiteral("expert"), g_expertUsername, this);
+    connect(orderSync_, &OrderSync::updated, this, [this](){ renderOrders(true); });
+
     refreshOrders();
+    orderSync_->subscribe();
     updateTabEnabled();
 }
 
@@ -172,43 +159,46 @@ void ClientExpert::updateTabEnabled()
 
 void ClientExpert::refreshOrders()
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
-    QJsonObject req{
-        {"action", "get_orders"},
-        {"role", "expert"},
-        {"username", g_expertUsername}
-    };
-    QString keyword = ui->lineEditKeyword->text().trimmed();
-    if (!keyword.isEmpty()) req["keyword"] = keyword;
-    QString status = ui->comboBoxStatus->currentText();
-    if (status != "全部") req["status"] = status;
+    orderSync_->setUsername(g_expertUsername);
+    orderSync_->setFilter(ui->lineEditKeyword->text().trimmed(), ui->comboBoxStatus->currentText());
+    orderSync_->reload([this](bool ok, const QString& err){
+        if (!ok) {
+            QMessageBox::warning(this, "提示", err);
+            return;
+        }
+        renderOrders(false);
+
+        // 如果当前在“实时通讯”页，刷新后确保房间上下文
+        if (ui->tabWidget->currentWidget() == ui->tabRealtime) {
+            if (ui->tableOrders->currentRow() < 0 && ui->tableOrders->rowCount() > 0) {
+                ui->tableOrders->setCurrentCell(0, 0);
+            }
+            int row = ui->tableOrders->currentRow();
+            if (row >= 0 && row < orders.size()) {
+                const QString room = QString::number(orders[row].id);
+                commWidget_->mainWindow()->setJoinedContext(g_expertUsername, room);
+                QMetaObject::invokeMethod(commWidget_->mainWindow(), "onJoin");
+            }
+        }
+    });
+}
 
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
+// 推送或本端操作后只拉变更，完成后 updated() 里重绘并保留选中行（不触发重新入会）
+void ClientExpert::pullOrderChanges()
+{
+    orderSync_->pullChanges();
+}
 
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-        return;
-    }
+void ClientExpert::renderOrders(bool keepSelection)
+{
+    int selectedId = -1;
+    const int curRow = ui->tableOrders->currentRow();
+    if (keepSelection && curRow >= 0 && curRow < orders.size()) selectedId = orders[curRow].id;
 
-    orders.clear();
-    QJsonArray arr = doc.object().value("orders").toArray();
-    orders.reserve(arr.size());
-    for (const QJsonValue& v : arr) {
-        QJsonObject o = v.toObject();
-        orders.append(OrderInfo{
-            o.value("id").toInt(), o.value("title").toString(),
-            o.value("desc").toString(), o.value("status").toString()
-        });
-    }
+    orders = orderSync_->orders();
 
     auto* tbl = ui->tableOrders;
+    const QSignalBlocker blocker(tbl);
     bool wasSorting = tbl->isSortingEnabled();
     tbl->setSortingEnabled(false);
     tbl->clearContents();
@@ -218,6 +208,7 @@ void ClientExpert::refreshOrders()
     QStringList headers{"工单号", "标题", "描述", "状态"};
     tbl->setHorizontalHeaderLabels(headers);
 
+    int selectRow = -1;
     tbl->setRowCount(orders.size());
     for (int i = 0; i < orders.size(); ++i) {
         const auto& od = orders[i];
@@ -225,23 +216,12 @@ void ClientExpert::refreshOrders()
         tbl->setItem(i, 1, new QTableWidgetItem(od.title));
         tbl->setItem(i, 2, new QTableWidgetItem(od.desc));
         tbl->setItem(i, 3, new QTableWidgetItem(od.status));
+        if (od.id == selectedId) selectRow = i;
     }
     tbl->resizeColumnsToContents();
     tbl->clearSelection();
+    if (selectRow >= 0) tbl->setCurrentCell(selectRow, 0);
     tbl->setSortingEnabled(wasSorting);
-
-    // 如果当前在“实时通讯”页，刷新后确保房间上下文
-    if (ui->tabWidget->currentWidget() == ui->tabRealtime) {
-        if (ui->tableOrders->currentRow() < 0 && ui->tableOrders->rowCount() > 0) {
-            ui->tableOrders->setCurrentCell(0, 0);
-        }
-        int row = ui->tableOrders->currentRow();
-        if (row >= 0 && row < orders.size()) {
-            const QString room = QString::number(orders[row].id);
-            commWidget_->mainWindow()->setJoinedContext(g_expertUsername, room);
-            QMetaObject::invokeMethod(commWidget_->mainWindow(), "onJoin");
-        }
-    }
 }
 
 void ClientExpert::on_btnAccept_clicked()
@@ -274,8 +254,6 @@ void ClientExpert::on_btnAccept_clicked()
     QMessageBox::information(this, tr("提示"),
         tr("已接受工单，可前往设备详情页面/实时通讯页面处理工单"));
 
-    // 刷新工单列表
-    refreshOrders();
 }
 
 void ClientExpert::on_btnReject_clicked()
@@ -289,30 +267,25 @@ void ClientExpert::on_btnReject_clicked()
 
     sendUpdateOrder(id, "已拒绝");
     setJoinedOrder(false);
-
-    refreshOrders();
 }
 
 void ClientExpert::sendUpdateOrder(int orderId, const QString& status)
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
     QJsonObject req{
         {"action", "update_order"},
         {"id", orderId},
         {"status", status}
     };
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-    }
+    // 成功后只拉本次变更
+    ControlClient::shared(QString::fromLatin1(SERVER_HOST), SERVER_PORT)
+        ->call(req, this, [this](const QJsonObject& rep){
+            if (!rep.value("ok").toBool()) {
+                QMessageBox::warning(this, "提示", rep.value("net_error").toBool()
+                                     ? rep.value("msg").toString() : QStringLiteral("服务器响应异常"));
+                return;
+            }
+            pullOrderChanges();
+        });
 }
 
 void ClientExpert::on_tabChanged(int idx)
@@ -1,7 +1,6 @@
 #include "client_factory.h"
 #include "ui_client_factory.h"
 
-#include <QTcpSocket>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -14,11 +13,12 @@
 #include <QLineEdit>
 #include <QTextEdit>
 #include <QDialogButtonBox>
-#include <QElapsedTimer>
 
 #include "comm/commwidget.h"
 #include "comm/devicepanel.h"
 #include "comm/knowledge_panel.h"
+#include "order_sync.h"
+#include "control_client.h"
 #include <QTabWidget>
 #include <QTabBar>
 
@@ -46,24 +46,6 @@ static const quint16 SERVER_PORT = 5555;
 
 extern QString g_factoryUsername;
 
-// 可靠读取“以换行分隔”的一条 JSON
-static QJsonDocument readJsonLine(QTcpSocket& sock, int timeoutMs = 5000) {
-    QByteArray buf;
-    QElapsedTimer et; et.start();
-    while (et.elapsed() < timeoutMs) {
-        if (!sock.bytesAvailable())
-            sock.waitForReadyRead(qMax(1, timeoutMs - int(et.elapsed())));
-        buf += sock.readAll();
-        int nl = buf.indexOf('\n');
-        if (nl >= 0) {
-            QByteArray line = buf.left(nl);
-            if (!line.isEmpty() && line.endsWith('\r')) line.chop(1);
-            return QJsonDocument::fromJson(line);
-        }
-    }
-    return QJsonDocument::fromJson(buf);
-}
-
 class NewOrderDialog : public QDialog {
 public:
     QLineEdit*  editTitle;
@@ -177,7 +159,18 @@ ClientFactory::ClientFactory(QWidget *parent) :
     connect(ui->btnRefreshOrderStatus, &QPushButton::clicked, this, &ClientFactory::refreshOrders);
     connect(ui->btnDeleteOrder, &QPushButton::clicked, this, &ClientFactory::on_btnDeleteOrder_clicked);
 
+    // 工单列表：首次全量拉取，之后靠服务端推送做增量合并
+    orderSync_ = new OrderSync(QString::fromLatin1(SERVER_HOST), SERVER_PORT,
+                               QStringLiteral("factory"), g_factoryUsername, this);
+    connect(orderSync_, &OrderSync::updated, this, [this](){
+        renderOrders(true);
+        if (ui->tabWidget->currentWidget() == ui->tabDevice) {
+            ensureDeviceContextFromSelection();
+        }
+    });
+
     refreshOrders();
+    orderSync_->subscribe();
     updateTabEnabled();
 }
 
@@ -204,43 +197,51 @@ void ClientFactory::ensureDeviceContextFromSelection()
 
 void ClientFactory::refreshOrders()
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
-    QJsonObject req{
-        {"action", "get_orders"},
-        {"role", "factory"},
-        {"username", g_factoryUsername}
-    };
-    QString keyword = ui->lineEditKeyword->text().trimmed();
-    if (!keyword.isEmpty()) req["keyword"] = keyword;
-    QString status = ui->comboBoxStatus->currentText();
-    if (status != "全部") req["status"] = status;
+    orderSync_->setUsername(g_factoryUsername);
+    orderSync_->setFilter(ui->lineEditKeyword->text().trimmed(), ui->comboBoxStatus->currentText());
+    orderSync_->reload([this](bool ok, const QString& err){
+        if (!ok) {
+            QMessageBox::warning(this, "提示", err);
+            return;
+        }
+        renderOrders(false);
 
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
+        // 如果当前在“实时通讯”页，刷新后确保房间上下文
+        if (ui->tabWidget->currentWidget() == ui->tabRealtime) {
+            if (ui->tableOrders->currentRow() < 0 && ui->tableOrders->rowCount() > 0) {
+                ui->tableOrders->setCurrentCell(0, 0);
+            }
+            int row = ui->tableOrders->currentRow();
+            if (row >= 0 && row < orders.size()) {
+                const QString room = QString::number(orders[row].id);
+                commWidget_->mainWindow()->setJoinedContext(g_factoryUsername, room);
+                QMetaObject::invokeMethod(commWidget_->mainWindow(), "onJoin");
+            }
+        }
 
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-        return;
-    }
+        // 如果当前就在“设备管理”页，刷新完工单后立即确保上下文（让曲线立刻出现）
+        if (ui->tabWidget->currentWidget() == ui->tabDevice) {
+            ensureDeviceContextFromSelection();
+        }
+    });
+}
 
-    orders.clear();
-    QJsonArray arr = doc.object().value("orders").toArray();
-    orders.reserve(arr.size());
-    for (const QJsonValue& v : arr) {
-        QJsonObject o = v.toObject();
-        orders.append(OrderInfo{
-            o.value("id").toInt(), o.value("title").toString(),
-            o.value("desc").toString(), o.value("status").toString()
-        });
-    }
+// 推送或本端操作后只拉变更，完成后 updated() 里重绘并保留选中行（不触发重新入会）
+void ClientFactory::pullOrderChanges()
+{
+    orderSync_->pullChanges();
+}
+
+void ClientFactory::renderOrders(bool keepSelection)
+{
+    int selectedId = -1;
+    const int curRow = ui->tableOrders->currentRow();
+    if (keepSelection && curRow >= 0 && curRow < orders.size()) selectedId = orders[curRow].id;
+
+    orders = orderSync_->orders();
 
     auto* tbl = ui->tableOrders;
+    const QSignalBlocker blocker(tbl);
     bool wasSorting = tbl->isSortingEnabled();
     tbl->setSortingEnabled(false);
     tbl->clearContents();
@@ -250,6 +251,7 @@ void ClientFactory::refreshOrders()
     QStringList headers{"工单号", "标题", "描述", "状态"};
     tbl->setHorizontalHeaderLabels(headers);
 
+    int selectRow = -1;
     tbl->setRowCount(orders.size());
     for (int i = 0; i < orders.size(); ++i) {
         const auto& od = orders[i];
@@ -257,28 +259,12 @@ void ClientFactory::refreshOrders()
         tbl->setItem(i, 1, new QTableWidgetItem(od.title));
         tbl->setItem(i, 2, new QTableWidgetItem(od.desc));
         tbl->setItem(i, 3, new QTableWidgetItem(od.status));
+        if (od.id == selectedId) selectRow = i;
     }
     tbl->resizeColumnsToContents();
     tbl->clearSelection();
+    if (selectRow >= 0) tbl->setCurrentCell(selectRow, 0);
     tbl->setSortingEnabled(wasSorting);
-
-    // 如果当前在“实时通讯”页，刷新后确保房间上下文
-    if (ui->tabWidget->currentWidget() == ui->tabRealtime) {
-        if (ui->tableOrders->currentRow() < 0 && ui->tableOrders->rowCount() > 0) {
-            ui->tableOrders->setCurrentCell(0, 0);
-        }
-        int row = ui->tableOrders->currentRow();
-        if (row >= 0 && row < orders.size()) {
-            const QString room = QString::number(orders[row].id);
-            commWidget_->mainWindow()->setJoinedContext(g_factoryUsername, room);
-            QMetaObject::invokeMethod(commWidget_->mainWindow(), "onJoin");
-        }
-    }
-
-    // 如果当前就在“设备管理”页，刷新完工单后立即确保上下文（让曲线立刻出现）
-    if (ui->tabWidget->currentWidget() == ui->tabDevice) {
-        ensureDeviceContextFromSelection();
-    }
 }
 
 void ClientFactory::on_btnNewOrder_clicked()
@@ -292,32 +278,27 @@ void ClientFactory::on_btnNewOrder_clicked()
             return;
         }
         sendCreateOrder(title, desc);
-        // 服务端确认后立即刷新
-        refreshOrders();
     }
 }
 
 void ClientFactory::sendCreateOrder(const QString& title, const QString& desc)
 {
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        return;
-    }
     QJsonObject req{
         {"action", "new_order"},
         {"title", title},
         {"desc",  desc},
         {"factory_user", g_factoryUsername}
     };
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-    }
+    // 服务端确认后只拉本次变更
+    ControlClient::shared(QString::fromLatin1(SERVER_HOST), SERVER_PORT)
+        ->call(req, this, [this](const QJsonObject& rep){
+            if (!rep.value("ok").toBool()) {
+                QMessageBox::warning(this, "提示", rep.value("net_error").toBool()
+                                     ? rep.value("msg").toString() : QStringLiteral("服务器响应异常"));
+                return;
+            }
+            pullOrderChanges();
+        });
 }
 
 void ClientFactory::on_btnDeleteOrder_clicked()
@@ -336,30 +317,22 @@ void ClientFactory::on_btnDeleteOrder_clicked()
         deletingOrder = false;
         return;
     }
-    QTcpSocket sock;
-    sock.connectToHost(SERVER_HOST, SERVER_PORT);
-    if (!sock.waitForConnected(2000)) {
-        QMessageBox::warning(this, "提示", "无法连接服务器");
-        deletingOrder = false;
-        return;
-    }
     QJsonObject req{
         {"action", "delete_order"},
         {"id", id},
         {"username", g_factoryUsername}
     };
-    sock.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
-    sock.flush();
-
-    QJsonDocument doc = readJsonLine(sock);
-    if (!doc.isObject() || !doc.object().value("ok").toBool()) {
-        QMessageBox::warning(this, "提示", "服务器响应异常");
-        deletingOrder = false;
-        return;
-    }
-
-    deletingOrder = false;
-    refreshOrders();
+    // deletingOrder 保持到应答回来，防止重复提交
+    ControlClient::shared(QString::fromLatin1(SERVER_HOST), SERVER_PORT)
+        ->call(req, this, [this](const QJsonObject& rep){
+            deletingOrder = false;
+            if (!rep.value("ok").toBool()) {
+                QMessageBox::warning(this, "提示", rep.value("net_error").toBool()
+                                     ? rep.value("msg").toString() : QStringLiteral("服务器响应异常"));
+                return;
+            }
+            pullOrderChanges();
+        });
 }
 
 void ClientFactory::updateTabEnabled()
@@ -373,7 +346,7 @@ void ClientFactory::on_tabChanged(int idx)
 {
     QWidget* page = ui->tabWidget->widget(idx);
     if (idx == 0) {
-        refreshOrders();
+        pullOrderChanges();
     } else if (page == ui->tabDevice) {
         ensureDeviceContextFromSelection();  // 兜底：进入设备页确保上下文
     } else if (page == ui->tabOther) {
@@ -44,15 +44,90 @@ bool AnnotModel::undoLastByOwner(const QString& owner)
         const QString& id = order_.at(i);
         auto it = strokes_.find(id);
         if (it != strokes_.end() && it->owner == owner) {
+            if (it->finished) { --finishedCount_; ++structRev_; }
             strokes_.erase(it);
             order_.removeAt(i);
+            ++rev_;
             return true;
         }
     }
     return false;
 }
 
-bool AnnotModel::applyEvent(const QJsonObject& e)
+namespace {
+inline void putVarint(QByteArray& out, quint32 v)
+{
+    while (v >= 0x80) { out.append(char((v & 0x7F) | 0x80)); v >>= 7; }
+    out.append(char(v));
+}
+
+inline bool getVarint(const uchar*& p, const uchar* end, quint32* v)
+{
+    quint32 r = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        const uchar b = *p++;
+        r |= quint32(b & 0x7F) << shift;
+        if (!(b & 0x80)) { *v = r; return true; }
+    }
+    return false;
+}
+
+inline quint32 zigzag(qint32 d)   { return (quint32(d) << 1) ^ quint32(d >> 31); }
+inline qint32  unzigzag(quint32 z) { return qint32(z >> 1) ^ -qint32(z & 1); }
+
+inline int quantize(double v) { return qBound(0, qRound(v * 65535.0), 65535); }
+
+const int kMaxPointsPerEvent = 65536;
+}
+
+QByteArray AnnotModel::encodePoints(const QVector<QPointF>& pts)
+{
+    QByteArray out;
+    out.reserve(2 + pts.size() * 4);
+    putVarint(out, quint32(pts.size()));
+    int px = 0, py = 0;
+    for (const QPointF& p : pts) {
+        const int x = quantize(p.x()), y = quantize(p.y());
+        putVarint(out, zigzag(x - px));
+        putVarint(out, zigzag(y - py));
+        px = x; py = y;
+    }
+    return out;
+}
+
+bool AnnotModel::decodePoints(const QByteArray& bin, QVector<QPointF>* out)
+{
+    const uchar* p = reinterpret_cast<const uchar*>(bin.constData());
+    const uchar* end = p + bin.size();
+    quint32 n = 0;
+    if (!getVarint(p, end, &n) || n > quint32(kMaxPointsPerEvent)) return false;
+    // 每点至少 2 字节，点数与长度不符视为坏包
+    if (qint64(n) * 2 > end - p) return false;
+
+    out->reserve(out->size() + int(n));
+    qint32 x = 0, y = 0;
+    for (quint32 i = 0; i < n; ++i) {
+        quint32 dx = 0, dy = 0;
+        if (!getVarint(p, end, &dx) || !getVarint(p, end, &dy)) return false;
+        x += unzigzag(dx);
+        y += unzigzag(dy);
+        if (x < 0 || x > 65535 || y < 0 || y > 65535) return false;
+        out->push_back(QPointF(x / 65535.0, y / 65535.0));
+    }
+    return true;
+}
+
+bool AnnotModel::readPoints(const QJsonObject& e, const QByteArray& bin, QVector<QPointF>* out)
+{
+    if (e.value("enc").toString() == QLatin1String("q16v")) return decodePoints(bin, out);
+    for (auto v : e.value("pts").toArray()) {
+        auto a = v.toArray();
+        if (a.size() >= 2) out->push_back(QPointF(a[0].toDouble(), a[1].toDouble()));
+    }
+    return true;
+}
+
+bool AnnotModel::applyEvent(const QJsonObject& e, const QByteArray& bin)
 {
     const QString op = e.value("op").toString();
     if (op == "clear") {
@@ -75,88 +150,164 @@ bool AnnotModel::applyEvent(const QJsonObject& e)
         s.color = QColor(e.value("color").toString("#FF0000"));
         s.width = qBound(1, e.value("width").toInt(3), 30);
         // 初始点
-        for (auto v : e.value("pts").toArray()) {
-            auto a = v.toArray();
-            if (a.size() >= 2) s.pts << QPointF(a[0].toDouble(), a[1].toDouble());
-        }
+        if (!readPoints(e, bin, &s.pts)) return false;
         s.text = e.value("text").toString();
+        const auto old = strokes_.constFind(id);
+        if (old != strokes_.cend() && old->finished) { --finishedCount_; ++structRev_; }
         strokes_.insert(id, s);
         order_.removeAll(id);
         order_.push_back(id);
+        ++rev_;
         return true;
     } else if (op == "update") {
         auto it = strokes_.find(id);
         if (it == strokes_.end()) return false;
-        for (auto v : e.value("pts").toArray()) {
-            auto a = v.toArray();
-            if (a.size() >= 2) it->pts << QPointF(a[0].toDouble(), a[1].toDouble());
-        }
+        QVector<QPointF> pts;
+        if (!readPoints(e, bin, &pts)) return false;
+        if (it->finished) ++structRev_;
+        it->pts += pts;
+        ++rev_;
         return true;
     } else if (op == "end") {
         auto it = strokes_.find(id);
         if (it == strokes_.end()) return false;
+        if (!it->finished) ++finishedCount_;
         it->finished = true;
+        ++rev_;
         return true;
     }
     return false;
 }
 
+void AnnotModel::paintStroke(QPainter& p, const Stroke& s, const QSize& size)
+{
+    QPen pen(s.color, s.width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+    p.setPen(pen);
+    p.setBrush(Qt::NoBrush);
+    auto D = [&](int i){ return denorm(s.pts[i], size); };
+
+    switch (s.tool) {
+    case Rect:
+        if (s.pts.size() >= 2) {
+            QRectF r; r.setTopLeft(D(0)); r.setBottomRight(D(s.pts.size()-1)); r = r.normalized();
+            p.drawRect(r);
+        }
+        break;
+    case Ellipse:
+        if (s.pts.size() >= 2) {
+            QRectF r; r.setTopLeft(D(0)); r.setBottomRight(D(s.pts.size()-1)); r = r.normalized();
+            p.drawEllipse(r);
+        }
+        break;
+    case Arrow:
+        if (s.pts.size() >= 2) {
+            drawArrow(p, D(0), D(s.pts.size()-1), s.width, s.color);
+        }
+        break;
+    case Pen:
+        if (s.pts.size() >= 2) {
+            QPainterPath path(D(0));
+            for (int i=1;i<s.pts.size();++i) path.lineTo(D(i));
+            p.drawPath(path);
+        }
+        break;
+    case Text:
+        if (!s.pts.isEmpty()) {
+            QFont f = p.font();
+            f.setPointSizeF(qMax(12.0, size.height() * 0.035));
+            p.setFont(f);
+            p.setPen(QPen(s.color, 1));
+            p.drawText(D(0), s.text);
+        }
+        break;
+    }
+}
+
+void AnnotModel::rebuildLayer(Layer& l) const
+{
+    const QSize px(qCeil(l.size.width() * l.dpr), qCeil(l.size.height() * l.dpr));
+    if (l.img.size() != px) l.img = QImage(px, QImage::Format_ARGB32_Premultiplied);
+    l.img.setDevicePixelRatio(l.dpr);
+    l.img.fill(Qt::transparent);
+    l.ids.clear();
+    l.lastPos = -1;
+    l.structRev = structRev_;
+
+    QPainter lp(&l.img);
+    lp.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing, true);
+    for (int i = 0; i < order_.size(); ++i) {
+        const auto it = strokes_.constFind(order_.at(i));
+        if (it == strokes_.cend() || !it->finished) continue;
+        paintStroke(lp, it.value(), l.size);
+        l.ids.insert(it->id);
+        l.lastPos = i;
+    }
+}
+
+const QImage& AnnotModel::layerFor(const QSize& size, qreal dpr) const
+{
+    Layer* l = nullptr;
+    for (Layer& c : layers_) {
+        if (c.size == size && qFuzzyCompare(c.dpr, dpr)) { l = &c; break; }
+    }
+    if (!l) {
+        // 尺寸种类有限（画布、缩略图、录制），超出时淘汰最久未用的一份
+        if (layers_.size() >= kMaxLayers) {
+            int victim = 0;
+            for (int i = 1; i < layers_.size(); ++i)
+                if (layers_[i].lastUse < layers_[victim].lastUse) victim = i;
+            layers_.remove(victim);
+        }
+        layers_.push_back(Layer());
+        l = &layers_.last();
+        l->size = size;
+        l->dpr = dpr;
+        l->structRev = 0;
+    }
+    l->lastUse = ++useTick_;
+
+    if (l->structRev != structRev_) {
+        rebuildLayer(*l);
+    } else if (l->ids.size() != finishedCount_) {
+        // 新完成的笔画都排在层内最后一笔之后时直接叠画，否则层序不对，整层重建
+        QVector<int> add;
+        bool inOrder = true;
+        for (int i = 0; i < order_.size(); ++i) {
+            const auto it = strokes_.constFind(order_.at(i));
+            if (it == strokes_.cend() || !it->finished || l->ids.contains(it->id)) continue;
+            if (i < l->lastPos) { inOrder = false; break; }
+            add << i;
+        }
+        if (!inOrder) {
+            rebuildLayer(*l);
+        } else if (!add.isEmpty()) {
+            QPainter lp(&l->img);
+            lp.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing, true);
+            for (int i : add) {
+                const Stroke& s = strokes_.constFind(order_.at(i)).value();
+                paintStroke(lp, s, size);
+                l->ids.insert(s.id);
+            }
+            l->lastPos = add.last();
+        }
+    }
+    return l->img;
+}
+
 void AnnotModel::paint(QPainter& p, const QSize& size) const
 {
     p.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform, true);
+    if (size.isEmpty()) return;
 
+    if (finishedCount_ > 0) {
+        const qreal dpr = p.device() ? p.device()->devicePixelRatioF() : 1.0;
+        p.drawImage(QPointF(0, 0), layerFor(size, dpr));
+    }
+    // 进行中的笔画每帧都在变，直接画在层之上
     for (const QString& id : order_) {
-        const auto it = strokes_.find(id);
-        if (it == strokes_.end()) continue;
-        const Stroke& s = it.value();
-
-        QPen pen(s.color, s.width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
-        p.setPen(pen);
-        p.setBrush(Qt::NoBrush);
-
-        auto D = [&](int i){ return denorm(s.pts[i], size); };
-
-        switch (s.tool) {
-        case Rect:
-            if (s.pts.size() >= 2) {
-                QRectF r;
-                r.setTopLeft(D(0));
-                r.setBottomRight(D(s.pts.size()-1));
-                r = r.normalized();
-                p.drawRect(r);
-            }
-            break;
-        case Ellipse:
-            if (s.pts.size() >= 2) {
-                QRectF r;
-                r.setTopLeft(D(0));
-                r.setBottomRight(D(s.pts.size()-1));
-                r = r.normalized();
-                p.drawEllipse(r);
-            }
-            break;
-        case Arrow:
-            if (s.pts.size() >= 2) {
-                drawArrow(p, D(0), D(s.pts.size()-1), s.width, s.color);
-            }
-            break;
-        case Pen:
-            if (s.pts.size() >= 2) {
-                QPainterPath path(D(0));
-                for (int i=1;i<s.pts.size();++i) path.lineTo(D(i));
-                p.drawPath(path);
-            }
-            break;
-        case Text:
-            if (!s.pts.isEmpty()) {
-                QFont f = p.font();
-                f.setPointSizeF(qMax(12.0, size.height() * 0.035));
-                p.setFont(f);
-                p.setPen(QPen(s.color, 1));
-                p.drawText(D(0), s.text);
-            }
-            break;
-        }
+        const auto it = strokes_.constFind(id);
+        if (it == strokes_.cend() || it->finished) continue;
+        paintStroke(p, it.value(), size);
     }
 }
 
@@ -164,4 +315,8 @@ void AnnotModel::clear()
 {
     strokes_.clear();
     order_.clear();
+    finishedCount_ = 0;
+    layers_.clear();
+    ++structRev_;
+    ++rev_;
 }
@@ -8,6 +8,11 @@ AnnotCanvas::AnnotCanvas(QWidget* parent) : QWidget(parent)
     setAttribute(Qt::WA_TranslucentBackground, true);
     setAttribute(Qt::WA_TransparentForMouseEvents, true); // 默认不拦截鼠标（未开启绘制）
     setMouseTracking(true);
+
+    // 移动点按约一帧（33ms）合并发送，快速涂画时不再每 2px 一个包
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(33);
+    connect(&flushTimer_, &QTimer::timeout, this, &AnnotCanvas::flushPending);
     hide();
 }
 
@@ -103,38 +108,45 @@ void AnnotCanvas::emitBegin(const QPointF& npt)
             tool_==AnnotModel::Text?"text":"pen"},
         {"color", color_.name(QColor::HexRgb)},
         {"width", penWidth_},
-        {"pts", QJsonArray{ QJsonArray{ npt.x(), npt.y() } }},
+        {"enc", "q16v"},
         {"target", targetKey_},
         {"ts", QDateTime::currentMSecsSinceEpoch()}
     };
-    emit annotateEvent(ev);
+    emit annotateEvent(ev, AnnotModel::encodePoints({ npt }));
 }
 
 void AnnotCanvas::emitUpdate(const QVector<QPointF>& npts)
 {
     if (currentId_.isEmpty() || npts.isEmpty()) return;
-    QJsonArray arr;
-    for (const auto& p : npts) arr.push_back(QJsonArray{ p.x(), p.y() });
     QJsonObject ev{
         {"op","update"},
         {"id", currentId_},
-        {"pts", arr},
-        {"target", targetKey_},
-        {"ts", QDateTime::currentMSecsSinceEpoch()}
+        {"enc", "q16v"},
+        {"target", targetKey_}
     };
-    emit annotateEvent(ev);
+    emit annotateEvent(ev, AnnotModel::encodePoints(npts));
+}
+
+void AnnotCanvas::flushPending()
+{
+    flushTimer_.stop();
+    if (pendingPts_.isEmpty()) return;
+    QVector<QPointF> pts;
+    pts.swap(pendingPts_);
+    emitUpdate(pts);
 }
 
 void AnnotCanvas::emitEnd()
 {
     if (currentId_.isEmpty()) return;
+    flushPending();
     QJsonObject ev{
         {"op","end"},
         {"id", currentId_},
         {"target", targetKey_},
         {"ts", QDateTime::currentMSecsSinceEpoch()}
     };
-    emit annotateEvent(ev);
+    emit annotateEvent(ev, QByteArray());
     currentId_.clear();
 }
 
@@ -157,19 +169,20 @@ void AnnotCanvas::mousePressEvent(QMouseEvent* e)
             {"tool","text"},
             {"color", color_.name(QColor::HexRgb)},
             {"width", penWidth_},
-            {"pts", QJsonArray{ QJsonArray{ np.x(), np.y() } }},
+            {"enc", "q16v"},
             {"text", t},
             {"target", targetKey_},
             {"ts", QDateTime::currentMSecsSinceEpoch()}
         };
-        emit annotateEvent(evBegin);
+        emit annotateEvent(evBegin, AnnotModel::encodePoints({ np }));
         QJsonObject evEnd{{"op","end"},{"id",id},{"target",targetKey_},{"ts",QDateTime::currentMSecsSinceEpoch()}};
-        emit annotateEvent(evEnd);
+        emit annotateEvent(evEnd, QByteArray());
         return;
     }
 
     livePts_.clear();
     livePts_ << np;
+    pendingPts_.clear();
     emitBegin(np);
     update();
 }
@@ -185,23 +198,25 @@ void AnnotCanvas::mouseMoveEvent(QMouseEvent* e)
     if (tool_ == AnnotModel::Pen) {
         if (livePts_.isEmpty()) {
             livePts_.push_back(np);
-            emitUpdate({np});
+            pendingPts_.push_back(np);
         } else {
             const qreal dist = QLineF(pix(livePts_.last()), pix(np)).length();
             if (dist >= 2.0) {
                 livePts_.push_back(np);
-                emitUpdate({np});
+                pendingPts_.push_back(np);
             }
         }
     } else {
         if (livePts_.size() == 1) {
             livePts_.push_back(np);
-            emitUpdate({np});
         } else {
             livePts_.last() = np;
-            emitUpdate({np});
         }
+        // 图形只用首尾两点，合并期内只需发最后一个位置
+        pendingPts_.clear();
+        pendingPts_.push_back(np);
     }
+    if (!pendingPts_.isEmpty() && !flushTimer_.isActive()) flushTimer_.start();
     update();
 }
 
@@ -1,172 +1,157 @@
 #include "audiochat.h"
 
-static inline qint16 clamp16(int v) {
-    if (v > 32767) return 32767;
-    if (v < -32768) return -32768;
-    return static_cast<qint16>(v);
-}
-
-// µ-law 实现（G.711）
-quint8 AudioChat::linearToUlaw(qint16 pcm) {
-    const int BIAS = 0x84;
-    const int CLIP = 32635;
-    int sign = (pcm >> 8) & 0x80;
-    if (sign) pcm = -pcm;
-    if (pcm > CLIP) pcm = CLIP;
-    pcm += BIAS;
-    int exponent = 7;
-    for (int expMask = 0x4000; (pcm & expMask) == 0 && exponent > 0; expMask >>= 1) {
-        --exponent;
-    }
-    int mantissa = (pcm >> (exponent + 3)) & 0x0F;
-    return static_cast<quint8>(~(sign | (exponent << 4) | mantissa));
-}
-
-qint16 AudioChat::ulawToLinear(quint8 u) {
-    u = ~u;
-    int t = ((u & 0x0F) << 3) + 0x84;
-    t <<= ((u & 0x70) >> 4);
-    return (u & 0x80) ? (0x84 - t) : (t - 0x84);
-}
-
 AudioChat::AudioChat(ClientConn* conn, QObject* parent)
     : QObject(parent), conn_(conn)
 {
-    // 混音定时器：按帧长输出
-    mixTimer_.setInterval(kFrameMs);
-    connect(&mixTimer_, &QTimer::timeout, this, &AudioChat::mixTick);
-    mixTimer_.start();
-
-    // 确保输出设备可用
-    ensureOutput();
+    codec_ = wantCodec_ = QStringLiteral("mulaw");
+    engine_ = new AudioEngine(this);
+    connect(engine_, &AudioEngine::txReady, this, &AudioChat::onTxReady);
+    connect(engine_, &AudioEngine::speakingChanged, this, &AudioChat::setSpeaking);
+    connect(engine_, &AudioEngine::codecChanged, this, [this](const QString& c) {
+        codec_ = c;
+        qInfo() << "[audio] send codec ->" << codec_;
+    });
 }
 
 void AudioChat::setIdentity(const QString& roomId, const QString& sender) {
+    const bool changed = roomId != roomId_ || sender != sender_;
     roomId_ = roomId;
     sender_ = sender;
+    if (changed) {
+        peerCaps_.clear();
+        serverMix_ = false;
+        renegotiate();
+        announceCaps();
+    }
 }
 
-void AudioChat::setEnabled(bool on) {
-    if (enabled_ == on) return;
-    enabled_ = on;
-    if (enabled_) startInput();
-    else          stopInput();
-    emit micStateChanged(enabled_);
-}
-
-void AudioChat::startInput() {
-    if (audioIn_) return;
-
-    QAudioFormat fmt;
-    fmt.setSampleRate(kSampleRate);
-    fmt.setChannelCount(kChannels);
-    fmt.setSampleSize(16);
-    fmt.setSampleType(QAudioFormat::SignedInt);
-    fmt.setByteOrder(QAudioFormat::LittleEndian);
-    fmt.setCodec("audio/pcm");
-    inFmt_ = fmt;
-
-    QAudioDeviceInfo devInfo = QAudioDeviceInfo::defaultInputDevice();
-    if (!devInfo.isFormatSupported(fmt)) {
-        inFmt_ = devInfo.nearestFormat(fmt);
-        inFmt_.setCodec("audio/pcm");
+void AudioChat::setRoomMembers(const QStringList& members) {
+    members_ = members;
+    for (auto it = peerCaps_.begin(); it != peerCaps_.end(); ) {
+        if (!members_.contains(it.key())) it = peerCaps_.erase(it);
+        else ++it;
     }
-    audioIn_ = new QAudioInput(devInfo, inFmt_, this);
-    audioIn_->setBufferSize(kPcmBytesPerFrm * 4);
+    renegotiate();
+}
 
-    inDev_ = audioIn_->start();
-    if (!inDev_) {
-        qWarning() << "AudioInput start failed";
-        delete audioIn_; audioIn_ = nullptr;
-        return;
-    }
-    connect(inDev_, &QIODevice::readyRead, this, &AudioChat::onMicReadyRead);
+void AudioChat::setUdpClient(UdpMediaClient* udp) {
+    if (udp_) disconnect(udp_, nullptr, this, nullptr);
+    udp_ = udp;
+    if (!udp_) { renegotiate(); return; }
+    connect(udp_, &UdpMediaClient::udpAudioFrame, this, &AudioChat::onUdpAudio);
+    connect(udp_, &UdpMediaClient::udpStateChanged, this, [this](bool) {
+        // 本端 UDP 通断变化要让其他成员知道（他们据此决定是否发 UDP）
+        announceCaps();
+        renegotiate();
+    });
+    renegotiate();
 }
 
-void AudioChat::stopInput() {
-    if (!audioIn_) return;
-    disconnect(inDev_, &QIODevice::readyRead, this, &AudioChat::onMicReadyRead);
-    audioIn_->stop();
-    audioIn_->deleteLater();
-    audioIn_ = nullptr;
-    inDev_ = nullptr;
-    inBuf_.clear();
+void AudioChat::announceCaps() {
+    if (!conn_ || roomId_.isEmpty() || sender_.isEmpty()) return;
+    QJsonObject j{
+        {"roomId", roomId_},
+        {"sender", sender_},
+        {"kind",   "audio_caps"},
+        {"codecs", QJsonArray::fromStringList(AudioCodec::supported())},
+        {"udp",    udp_ && udp_->isAudioReady()}
+    };
+    conn_->send(MSG_CONTROL, j);
 }
 
-void AudioChat::ensureOutput() {
-    if (audioOut_) return;
-
-    QAudioFormat fmt;
-    fmt.setSampleRate(kSampleRate);
-    fmt.setChannelCount(kChannels);
-    fmt.setSampleSize(16);
-    fmt.setSampleType(QAudioFormat::SignedInt);
-    fmt.setByteOrder(QAudioFormat::LittleEndian);
-    fmt.setCodec("audio/pcm");
-    outFmt_ = fmt;
-
-    QAudioDeviceInfo devInfo = QAudioDeviceInfo::defaultOutputDevice();
-    if (!devInfo.isFormatSupported(fmt)) {
-        outFmt_ = devInfo.nearestFormat(fmt);
-        outFmt_.setCodec("audio/pcm");
+void AudioChat::renegotiate() {
+    // UDP：收不到 UDP 的成员会整段听不到，所以要求所有人都通；服务器混音时只看自己
+    bool udp = udp_ && udp_->isAudioReady() && (serverMix_ || !members_.isEmpty());
+    for (const QString& m : members_) {
+        if (udp && !serverMix_ && m != sender_ && !peerCaps_.value(m).udp) udp = false;
     }
-    audioOut_ = new QAudioOutput(devInfo, outFmt_, this);
-    audioOut_->setBufferSize(kPcmBytesPerFrm * 20);
-    outDev_ = audioOut_->start();
-    if (!outDev_) {
-        qWarning() << "AudioOutput start failed";
-        delete audioOut_; audioOut_ = nullptr;
-        return;
+    if (udp != useUdp_) {
+        useUdp_ = udp;
+        qInfo() << "[audio] send path ->" << (useUdp_ ? "udp" : "tcp");
     }
-}
-
-void AudioChat::onMicReadyRead() {
-    if (!inDev_ || roomId_.isEmpty() || sender_.isEmpty()) { if (inDev_) inDev_->readAll(); return; }
-
-    inBuf_.append(inDev_->readAll());
-
-    // 每帧按 20ms 发送
-    while (inBuf_.size() >= kPcmBytesPerFrm) {
-        QByteArray pcm = inBuf_.left(kPcmBytesPerFrm);
-        inBuf_.remove(0, kPcmBytesPerFrm);
 
-        // 应用本地麦克风增益并限幅（在编码前）
-        qint16* s = reinterpret_cast<qint16*>(pcm.data());
-        if (micGain_ != 1.0f) {
-            for (int i = 0; i < kFrameSamples; ++i) {
-                int v = static_cast<int>(s[i] * micGain_);
-                s[i] = clamp16(v);
-            }
+    // 成员列表到达前不知道对端是谁，先用 mulaw
+    QString pick = QStringLiteral("mulaw");
+    for (const QString& c : AudioCodec::supported()) {
+        if (serverMix_) break;
+        bool all = !members_.isEmpty();
+        for (const QString& m : members_) {
+            if (m == sender_) continue;
+            if (!peerCaps_.value(m).codecs.contains(c)) { all = false; break; }
         }
+        if (all) { pick = c; break; }
+    }
+    if (pick == wantCodec_) return;
+    wantCodec_ = pick;
+    engine_->setCodec(pick);
+}
 
-        // PCM16 -> µ-law
-        QByteArray ulaw; ulaw.resize(kUlawBytesPerFrm);
-        for (int i = 0; i < kFrameSamples; ++i) {
-            ulaw[i] = static_cast<char>(linearToUlaw(s[i]));
-        }
+void AudioChat::setEnabled(bool on) {
+    if (enabled_ == on) return;
+    enabled_ = on;
+    engine_->setCapture(on);
+    if (!enabled_) setSpeaking(false);
+    emit micStateChanged(enabled_);
+}
 
-        // 组包并发送
+// 引擎编好的帧从 tx 环取出发送；还没入房的帧直接丢
+void AudioChat::onTxReady() {
+    AudioEngine::TxFrame f;
+    while (engine_->takeTx(f)) {
+        if (roomId_.isEmpty() || sender_.isEmpty()) continue;
+        if (useUdp_ && udp_ && udp_->sendAudio(f.codec, f.sr, f.seq, f.ts, f.payload, f.level, f.voiced))
+            continue;
+        // UDP 不可用或发送失败：TCP 兜底
         QJsonObject j{
             {"roomId", roomId_},
             {"sender", sender_},
-            {"codec",  "mulaw"},
-            {"sr",     kSampleRate},
+            {"codec",  f.codec},
+            {"sr",     f.sr},
             {"ch",     kChannels},
-            {"seq",    static_cast<int>(seq_++)},
-            {"ts",     QDateTime::currentMSecsSinceEpoch()}
+            {"seq",    static_cast<int>(f.seq)},
+            {"ts",     f.ts},
+            {"lvl",    f.level},
+            {"vad",    f.voiced}
         };
-        if (conn_) conn_->send(MSG_AUDIO_FRAME, j, ulaw);
+        if (conn_) conn_->send(MSG_AUDIO_FRAME, j, f.payload);
     }
 }
 
-void AudioChat::shrinkQueueIfNeeded(QByteArray& q) {
-    const int maxBytes = kMaxQueueFrames * kPcmBytesPerFrm;
-    if (q.size() > maxBytes) {
-        q.remove(0, q.size() - maxBytes);
-    }
+void AudioChat::setSpeaking(bool on) {
+    if (speaking_ == on) return;
+    speaking_ = on;
+    emit localSpeakingChanged(on);
 }
 
 void AudioChat::onPacket(Packet p) {
+    if (p.type == MSG_SERVER_EVENT) {
+        if (p.json.value("kind").toString() != QLatin1String("audio_mix")) return;
+        if (p.json.value("roomId").toString() != roomId_) return;
+        const bool on = p.json.value("on").toBool(false);
+        if (on == serverMix_) return;
+        serverMix_ = on;
+        if (on) mixSender_ = p.json.value("sender").toString(QStringLiteral("__mix__"));
+        else    engine_->dropPeer(mixSender_);
+        qInfo() << "[audio] server mix ->" << (on ? "on" : "off");
+        renegotiate();
+        return;
+    }
+    if (p.type == MSG_CONTROL) {
+        if (p.json.value("kind").toString() != QLatin1String("audio_caps")) return;
+        const QString sender = p.json.value("sender").toString();
+        if (sender.isEmpty() || sender == sender_) return;
+        if (p.json.value("roomId").toString() != roomId_) return;
+
+        PeerCaps caps;
+        for (const QJsonValue v : p.json.value("codecs").toArray()) caps.codecs << v.toString();
+        caps.udp = p.json.value("udp").toBool(false);
+        const bool known = peerCaps_.contains(sender);
+        peerCaps_.insert(sender, caps);
+        // 新来的成员还不知道我们的能力，回一次
+        if (!known) announceCaps();
+        renegotiate();
+        return;
+    }
     if (p.type != MSG_AUDIO_FRAME) return;
 
     const QString roomId = p.json.value("roomId").toString();
@@ -176,71 +161,29 @@ void AudioChat::onPacket(Packet p) {
     if (!sender_.isEmpty() && sender == sender_) return;
 
     const QString codec = p.json.value("codec").toString("mulaw").toLower();
-    const int sr = p.json.value("sr").toInt(kSampleRate);
+    const int sr = p.json.value("sr").toInt(8000);
     const int ch = p.json.value("ch").toInt(kChannels);
-    if (sr != kSampleRate || ch != kChannels) {
-        return;
-    }
-
-    QByteArray& q = rxQueues_[sender];
-    if (codec == "mulaw") {
-        const int n = p.bin.size();
-        if (n <= 0) return;
-        const uchar* u = reinterpret_cast<const uchar*>(p.bin.constData());
-        QByteArray pcm; pcm.resize(n * 2);
-        qint16* d = reinterpret_cast<qint16*>(pcm.data());
-        for (int i = 0; i < n; ++i) d[i] = ulawToLinear(u[i]);
-        q.append(pcm);
-    } else if (codec == "pcm16") {
-        q.append(p.bin);
-    } else {
-        return;
-    }
-    shrinkQueueIfNeeded(q);
+    if (ch != kChannels) return;
+
+    AudioEngine::RxFrame f;
+    f.sender = sender;
+    f.codec = codec;
+    f.sr = sr;
+    f.seq = quint32(p.json.value("seq").toInt());
+    f.ts = qint64(p.json.value("ts").toDouble(QDateTime::currentMSecsSinceEpoch()));
+    f.payload = p.bin;
+    engine_->postRx(f);
 }
 
-void AudioChat::mixTick() {
-    if (!audioOut_ || !outDev_) return;
-
-    int bytesFree = audioOut_->bytesFree();
-    while (bytesFree >= kPcmBytesPerFrm) {
-        QByteArray out; out.resize(kPcmBytesPerFrm);
-        qint16* outS = reinterpret_cast<qint16*>(out.data());
-        for (int i = 0; i < kFrameSamples; ++i) outS[i] = 0;
-
-        // 逐路读取并按各自增益混合
-        for (auto it = rxQueues_.begin(); it != rxQueues_.end(); ++it) {
-            const QString sender = it.key();
-            const float   gain   = peerGain_.value(sender, 1.0f);
-            QByteArray&   q      = it.value();
-
-            if (q.size() >= kPcmBytesPerFrm) {
-                const qint16* inS = reinterpret_cast<const qint16*>(q.constData());
-                if (gain == 1.0f) {
-                    for (int i = 0; i < kFrameSamples; ++i) {
-                        int acc = static_cast<int>(outS[i]) + static_cast<int>(inS[i]);
-                        outS[i] = clamp16(acc);
-                    }
-                } else if (gain > 0.0f) {
-                    for (int i = 0; i < kFrameSamples; ++i) {
-                        int acc = static_cast<int>(outS[i]) + static_cast<int>(inS[i] * gain);
-                        outS[i] = clamp16(acc);
-                    }
-                } // gain==0 静音：跳过
-                q.remove(0, kPcmBytesPerFrm);
-            }
-        }
-
-        // 应用整体播放增益
-        if (playbackGain_ != 1.0f) {
-            for (int i = 0; i < kFrameSamples; ++i) {
-                int v = static_cast<int>(outS[i] * playbackGain_);
-                outS[i] = clamp16(v);
-            }
-        }
-
-        qint64 w = outDev_->write(out);
-        if (w <= 0) break;
-        bytesFree -= static_cast<int>(w);
-    }
+void AudioChat::onUdpAudio(const QString& sender, const QString& codec, int sr,
+                           quint32 seq, qint64 ts, const QByteArray& payload) {
+    if (sender.isEmpty() || sender == sender_) return;
+    AudioEngine::RxFrame f;
+    f.sender = sender;
+    f.codec = codec;
+    f.sr = sr;
+    f.seq = seq;
+    f.ts = ts;
+    f.payload = payload;
+    engine_->postRx(f);
 }
@@ -0,0 +1,211 @@
+#include "audiocodec.h"
+#include "resampler.h"
+#include "audiodsp.h"
+#include <cmath>
+#include <cstring>
+
+#ifdef HAVE_OPUS
+#include <opus.h>
+#endif
+
+namespace AudioCodec {
+
+QStringList supported()
+{
+#ifdef HAVE_OPUS
+    return { QStringLiteral("opus"), QStringLiteral("mulaw") };
+#else
+    return { QStringLiteral("mulaw") };
+#endif
+}
+
+// µ-law 查表实现见 AudioDsp
+quint8 linearToUlaw(qint16 pcm) { return AudioDsp::linearToUlaw(pcm); }
+qint16 ulawToLinear(quint8 u)   { return AudioDsp::ulawToLinear(u); }
+
+}
+
+namespace {
+const int kMulawRate    = 8000;
+const int kMulawSamples = kMulawRate * AudioCodec::kFrameMs / 1000;
+
+class MulawEncoder : public AudioEncoder {
+public:
+    MulawEncoder() : down_(AudioCodec::kSampleRate, kMulawRate) {}
+
+    QString name() const override { return QStringLiteral("mulaw"); }
+    int wireRate() const override { return kMulawRate; }
+
+    QByteArray encode(const qint16* pcm) override {
+        buf_.clear();
+        down_.process(pcm, AudioCodec::kFrameSamples, buf_);
+        // 重采样相位导致偶尔多/少一个样本，补齐或截断到整帧
+        buf_.resize(kMulawSamples);
+        QByteArray out(kMulawSamples, Qt::Uninitialized);
+        AudioDsp::encodeUlaw(buf_.constData(), reinterpret_cast<quint8*>(out.data()), kMulawSamples);
+        return out;
+    }
+
+private:
+    Resampler down_;
+    QVector<qint16> buf_;
+};
+
+// 8kHz 线性 PCM（µ-law 解码后 / 旧版 pcm16）升到内部采样率
+class NarrowbandDecoder : public AudioDecoder {
+public:
+    NarrowbandDecoder(bool mulaw, int rate)
+        : mulaw_(mulaw), samples_(rate * AudioCodec::kFrameMs / 1000), up_(rate, AudioCodec::kSampleRate) {}
+
+    bool decode(const QByteArray& payload, qint16* out) override {
+        narrow_.resize(samples_);
+        if (mulaw_) {
+            if (payload.size() != samples_) return false;
+            AudioDsp::decodeUlaw(reinterpret_cast<const quint8*>(payload.constData()), narrow_.data(), samples_);
+        } else {
+            if (payload.size() != samples_ * 2) return false;
+            std::memcpy(narrow_.data(), payload.constData(), size_t(payload.size()));
+        }
+        wide_.clear();
+        up_.process(narrow_.constData(), samples_, wide_);
+        wide_.resize(AudioCodec::kFrameSamples);
+        std::memcpy(out, wide_.constData(), sizeof(qint16) * AudioCodec::kFrameSamples);
+        return true;
+    }
+
+private:
+    bool mulaw_;
+    int  samples_;
+    Resampler up_;
+    QVector<qint16> narrow_;
+    QVector<qint16> wide_;
+};
+
+// 舒适噪声：按电平生成轻微低通的白噪声，不还原频谱
+class ComfortNoiseDecoder : public AudioDecoder {
+public:
+    bool decode(const QByteArray& payload, qint16* out) override {
+        if (payload.isEmpty()) return false;
+        // 一阶低通 y = (y + x) / 2 把白噪声 RMS 压到 1/√3，均匀分布 RMS 为幅度的 1/√3，合起来幅度取 3 倍 RMS
+        amp_ = 3.0f * 32768.0f * std::pow(10.0f, -float(quint8(payload[0]) & 0x7F) / 20.0f);
+        generate(out);
+        return true;
+    }
+    bool conceal(qint16* out) override { generate(out); return true; }
+    bool isComfortNoise() const override { return true; }
+
+private:
+    void generate(qint16* out) {
+        for (int i = 0; i < AudioCodec::kFrameSamples; ++i) {
+            rng_ = rng_ * 1664525u + 1013904223u;
+            const float x = (float(rng_ >> 8) / float(1 << 24)) * 2.0f - 1.0f;
+            lp_ = 0.5f * lp_ + 0.5f * x;
+            out[i] = qint16(qBound(-32768.0f, lp_ * amp_, 32767.0f));
+        }
+    }
+
+    quint32 rng_ = 0x2545F491u;
+    float lp_  = 0.0f;
+    float amp_ = 0.0f;
+};
+
+#ifdef HAVE_OPUS
+const int kOpusBitrate    = 24000;
+const int kOpusLossPerc   = 10;     // 让编码器按此丢包率分配 FEC 冗余
+const int kOpusMaxPacket  = 400;
+
+class OpusEncoderImpl : public AudioEncoder {
+public:
+    OpusEncoderImpl() {
+        int err = OPUS_OK;
+        enc_ = opus_encoder_create(AudioCodec::kSampleRate, 1, OPUS_APPLICATION_VOIP, &err);
+        if (err != OPUS_OK) { enc_ = nullptr; return; }
+        opus_encoder_ctl(enc_, OPUS_SET_BITRATE(kOpusBitrate));
+        opus_encoder_ctl(enc_, OPUS_SET_INBAND_FEC(1));
+        opus_encoder_ctl(enc_, OPUS_SET_PACKET_LOSS_PERC(kOpusLossPerc));
+        opus_encoder_ctl(enc_, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    }
+    ~OpusEncoderImpl() override { if (enc_) opus_encoder_destroy(enc_); }
+
+    bool isValid() const { return enc_ != nullptr; }
+    QString name() const override { return QStringLiteral("opus"); }
+    int wireRate() const override { return AudioCodec::kSampleRate; }
+
+    QByteArray encode(const qint16* pcm) override {
+        unsigned char buf[kOpusMaxPacket];
+        const int n = opus_encode(enc_, pcm, AudioCodec::kFrameSamples, buf, kOpusMaxPacket);
+        if (n <= 0) return QByteArray();
+        return QByteArray(reinterpret_cast<const char*>(buf), n);
+    }
+
+private:
+    OpusEncoder* enc_ = nullptr;
+};
+
+class OpusDecoderImpl : public AudioDecoder {
+public:
+    OpusDecoderImpl() {
+        int err = OPUS_OK;
+        // 不论对端编码采样率，统一解到内部采样率
+        dec_ = opus_decoder_create(AudioCodec::kSampleRate, 1, &err);
+        if (err != OPUS_OK) dec_ = nullptr;
+    }
+    ~OpusDecoderImpl() override { if (dec_) opus_decoder_destroy(dec_); }
+
+    bool isValid() const { return dec_ != nullptr; }
+
+    bool decode(const QByteArray& payload, qint16* out) override {
+        return run(payload, out, 0);
+    }
+    bool decodeFec(const QByteArray& next, qint16* out) override {
+        return run(next, out, 1);
+    }
+    bool conceal(qint16* out) override {
+        return opus_decode(dec_, nullptr, 0, out, AudioCodec::kFrameSamples, 0) == AudioCodec::kFrameSamples;
+    }
+
+private:
+    bool run(const QByteArray& data, qint16* out, int fec) {
+        if (data.isEmpty()) return false;
+        const int n = opus_decode(dec_, reinterpret_cast<const unsigned char*>(data.constData()), data.size(),
+                                  out, AudioCodec::kFrameSamples, fec);
+        return n == AudioCodec::kFrameSamples;
+    }
+
+    OpusDecoder* dec_ = nullptr;
+};
+#endif
+}
+
+AudioEncoder* AudioEncoder::create(const QString& codec)
+{
+    if (codec == QLatin1String("mulaw")) return new MulawEncoder();
+#ifdef HAVE_OPUS
+    if (codec == QLatin1String("opus")) {
+        auto* e = new OpusEncoderImpl();
+        if (e->isValid()) return e;
+        delete e;
+    }
+#endif
+    return nullptr;
+}
+
+AudioDecoder* AudioDecoder::create(const QString& codec, int wireRate)
+{
+    if (codec == QLatin1String("cn")) return new ComfortNoiseDecoder();
+    if (codec == QLatin1String("mulaw")) {
+        return wireRate == kMulawRate ? new NarrowbandDecoder(true, kMulawRate) : nullptr;
+    }
+    if (codec == QLatin1String("pcm16")) {
+        return (wireRate == kMulawRate || wireRate == AudioCodec::kSampleRate)
+             ? new NarrowbandDecoder(false, wireRate) : nullptr;
+    }
+#ifdef HAVE_OPUS
+    if (codec == QLatin1String("opus")) {
+        auto* d = new OpusDecoderImpl();
+        if (d->isValid()) return d;
+        delete d;
+    }
+#endif
+    return nullptr;
+}
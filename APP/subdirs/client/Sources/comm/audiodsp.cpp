@@ -0,0 +1,289 @@
+#include "audiodsp.h"
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define DSP_AVX2 1
+#endif
+#if defined(__SSSE3__)
+#  include <tmmintrin.h>
+#  define DSP_SSSE3 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define DSP_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define DSP_NEON 1
+#endif
+
+namespace AudioDsp {
+
+namespace {
+
+inline qint16 sat16(int v) { return qint16(v < -32768 ? -32768 : (v > 32767 ? 32767 : v)); }
+
+// Q14 增益：先 Q15 舍入乘（等价 mulhrs，得到 x*g/2），再饱和翻倍
+inline qint16 gainSample(int x, int g) { return sat16(2 * ((x * g + 0x4000) >> 15)); }
+
+// G.711 参考实现，只用来建表
+quint8 ulawEncodeRef(qint16 pcm)
+{
+    const int BIAS = 0x84;
+    const int CLIP = 32635;
+    int sign = (pcm >> 8) & 0x80;
+    int v = pcm;
+    if (sign) v = -v;
+    if (v > CLIP) v = CLIP;
+    v += BIAS;
+    int exponent = 7;
+    for (int expMask = 0x4000; (v & expMask) == 0 && exponent > 0; expMask >>= 1) {
+        --exponent;
+    }
+    int mantissa = (v >> (exponent + 3)) & 0x0F;
+    return static_cast<quint8>(~(sign | (exponent << 4) | mantissa));
+}
+
+qint16 ulawDecodeRef(quint8 u)
+{
+    u = ~u;
+    int t = ((u & 0x0F) << 3) + 0x84;
+    t <<= ((u & 0x70) >> 4);
+    return qint16((u & 0x80) ? (0x84 - t) : (t - 0x84));
+}
+
+struct UlawTables {
+    quint8 enc[65536];      // 以 quint16(pcm) 为下标
+    qint16 dec[256];
+    UlawTables() {
+        for (int i = 0; i < 65536; ++i) enc[i] = ulawEncodeRef(qint16(quint16(i)));
+        for (int i = 0; i < 256; ++i)   dec[i] = ulawDecodeRef(quint8(i));
+    }
+};
+
+const UlawTables& tables()
+{
+    static const UlawTables t;
+    return t;
+}
+
+#if defined(DSP_SSE2)
+// SSE2 没有 mulhrs：拼出 32 位乘积再舍入右移 15
+inline __m128i mulhrs(__m128i x, __m128i g)
+{
+#if defined(DSP_SSSE3)
+    return _mm_mulhrs_epi16(x, g);
+#else
+    const __m128i lo = _mm_mullo_epi16(x, g);
+    const __m128i hi = _mm_mulhi_epi16(x, g);
+    const __m128i rnd = _mm_set1_epi32(0x4000);
+    const __m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), rnd), 15);
+    const __m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), rnd), 15);
+    return _mm_packs_epi32(p0, p1);
+#endif
+}
+
+inline __m128i gain8(__m128i x, __m128i g)
+{
+    const __m128i r = mulhrs(x, g);
+    return _mm_adds_epi16(r, r);
+}
+
+// int16 -> int32 符号扩展：样本放到高半再算术右移
+inline __m128i widenLo(__m128i x) { return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16); }
+inline __m128i widenHi(__m128i x) { return _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16); }
+#endif
+
+#if defined(DSP_AVX2)
+inline __m256i gain16(__m256i x, __m256i g)
+{
+    const __m256i r = _mm256_mulhrs_epi16(x, g);
+    return _mm256_adds_epi16(r, r);
+}
+#endif
+
+}
+
+quint8 linearToUlaw(qint16 pcm) { return tables().enc[quint16(pcm)]; }
+qint16 ulawToLinear(quint8 u)   { return tables().dec[u]; }
+
+// 查表本身就是瓶颈，SIMD gather 收益不大，按标量展开
+void encodeUlaw(const qint16* in, quint8* out, int n)
+{
+    const quint8* t = tables().enc;
+    for (int i = 0; i < n; ++i) out[i] = t[quint16(in[i])];
+}
+
+void decodeUlaw(const quint8* in, qint16* out, int n)
+{
+    const qint16* t = tables().dec;
+    for (int i = 0; i < n; ++i) out[i] = t[in[i]];
+}
+
+int gainQ14(float gain)
+{
+    return qBound(0, int(gain * float(kUnityGain) + 0.5f), 32767);
+}
+
+void applyGain(qint16* buf, int n, int g)
+{
+    if (g == kUnityGain) return;
+    int i = 0;
+#if defined(DSP_AVX2)
+    const __m256i gv = _mm256_set1_epi16(short(g));
+    for (; i + 16 <= n; i += 16) {
+        __m256i* p = reinterpret_cast<__m256i*>(buf + i);
+        _mm256_storeu_si256(p, gain16(_mm256_loadu_si256(p), gv));
+    }
+#endif
+#if defined(DSP_SSE2)
+    const __m128i gx = _mm_set1_epi16(short(g));
+    for (; i + 8 <= n; i += 8) {
+        __m128i* p = reinterpret_cast<__m128i*>(buf + i);
+        _mm_storeu_si128(p, gain8(_mm_loadu_si128(p), gx));
+    }
+#elif defined(DSP_NEON)
+    for (; i + 8 <= n; i += 8) {
+        // vqrdmulh = sat((2xg + 0x8000) >> 16)，与 mulhrs 相同
+        const int16x8_t r = vqrdmulhq_n_s16(vld1q_s16(buf + i), qint16(g));
+        vst1q_s16(buf + i, vqaddq_s16(r, r));
+    }
+#endif
+    for (; i < n; ++i) buf[i] = gainSample(buf[i], g);
+}
+
+void mixAdd(qint16* acc, const qint16* in, int n)
+{
+    int i = 0;
+#if defined(DSP_AVX2)
+    for (; i + 16 <= n; i += 16) {
+        __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(a, _mm256_adds_epi16(_mm256_loadu_si256(a), x));
+    }
+#endif
+#if defined(DSP_SSE2)
+    for (; i + 8 <= n; i += 8) {
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(a, _mm_adds_epi16(_mm_loadu_si128(a), x));
+    }
+#elif defined(DSP_NEON)
+    for (; i + 8 <= n; i += 8) vst1q_s16(acc + i, vqaddq_s16(vld1q_s16(acc + i), vld1q_s16(in + i)));
+#endif
+    for (; i < n; ++i) acc[i] = sat16(acc[i] + in[i]);
+}
+
+void mixAddGain(qint16* acc, const qint16* in, int n, int g)
+{
+    if (g == kUnityGain) { mixAdd(acc, in, n); return; }
+    if (g == 0) return;
+    int i = 0;
+#if defined(DSP_AVX2)
+    const __m256i gv = _mm256_set1_epi16(short(g));
+    for (; i + 16 <= n; i += 16) {
+        __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+        const __m256i x = gain16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), gv);
+        _mm256_storeu_si256(a, _mm256_adds_epi16(_mm256_loadu_si256(a), x));
+    }
+#endif
+#if defined(DSP_SSE2)
+    const __m128i gx = _mm_set1_epi16(short(g));
+    for (; i + 8 <= n; i += 8) {
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        const __m128i x = gain8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), gx);
+        _mm_storeu_si128(a, _mm_adds_epi16(_mm_loadu_si128(a), x));
+    }
+#elif defined(DSP_NEON)
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t r = vqrdmulhq_n_s16(vld1q_s16(in + i), qint16(g));
+        vst1q_s16(acc + i, vqaddq_s16(vld1q_s16(acc + i), vqaddq_s16(r, r)));
+    }
+#endif
+    for (; i < n; ++i) acc[i] = sat16(acc[i] + gainSample(in[i], g));
+}
+
+void accumulate(qint32* acc, const qint16* in, int n)
+{
+    int i = 0;
+#if defined(DSP_AVX2)
+    for (; i + 8 <= n; i += 8) {
+        __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+        const __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), x));
+    }
+#endif
+#if defined(DSP_SSE2)
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(a,     _mm_add_epi32(_mm_loadu_si128(a),     widenLo(x)));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), widenHi(x)));
+    }
+#elif defined(DSP_NEON)
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t x = vld1q_s16(in + i);
+        vst1q_s32(acc + i,     vaddw_s16(vld1q_s32(acc + i),     vget_low_s16(x)));
+        vst1q_s32(acc + i + 4, vaddw_s16(vld1q_s32(acc + i + 4), vget_high_s16(x)));
+    }
+#endif
+    for (; i < n; ++i) acc[i] += in[i];
+}
+
+void mixMinus(const qint32* acc, const qint16* own, qint16* out, int n)
+{
+    int i = 0;
+#if defined(DSP_AVX2)
+    for (; i + 16 <= n; i += 16) {
+        __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i + 8));
+        if (own) {
+            a0 = _mm256_sub_epi32(a0, _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(own + i))));
+            a1 = _mm256_sub_epi32(a1, _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(own + i + 8))));
+        }
+        // packs 按 128 位通道交错，再把 64 位块排回顺序
+        const __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(a0, a1), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), p);
+    }
+#endif
+#if defined(DSP_SSE2)
+    for (; i + 8 <= n; i += 8) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 4));
+        if (own) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(own + i));
+            a0 = _mm_sub_epi32(a0, widenLo(x));
+            a1 = _mm_sub_epi32(a1, widenHi(x));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a0, a1));
+    }
+#elif defined(DSP_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t a0 = vld1q_s32(acc + i);
+        int32x4_t a1 = vld1q_s32(acc + i + 4);
+        if (own) {
+            const int16x8_t x = vld1q_s16(own + i);
+            a0 = vsubw_s16(a0, vget_low_s16(x));
+            a1 = vsubw_s16(a1, vget_high_s16(x));
+        }
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a0), vqmovn_s32(a1)));
+    }
+#endif
+    for (; i < n; ++i) out[i] = sat16(acc[i] - (own ? own[i] : 0));
+}
+
+const char* backend()
+{
+#if defined(DSP_AVX2)
+    return "avx2";
+#elif defined(DSP_SSSE3)
+    return "ssse3";
+#elif defined(DSP_SSE2)
+    return "sse2";
+#elif defined(DSP_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}
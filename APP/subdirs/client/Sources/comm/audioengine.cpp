@@ -0,0 +1,411 @@
+#include "audioengine.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+const int kChannels = 1;
+
+QAudioFormat preferredFormat()
+{
+    QAudioFormat fmt;
+    fmt.setSampleRate(AudioCodec::kSampleRate);
+    fmt.setChannelCount(kChannels);
+    fmt.setSampleSize(16);
+    fmt.setSampleType(QAudioFormat::SignedInt);
+    fmt.setByteOrder(QAudioFormat::LittleEndian);
+    fmt.setCodec("audio/pcm");
+    return fmt;
+}
+
+// 拉模式播放源：声卡要多少就现混多少，永远不返回 0（没人说话就给静音）
+class PullSource : public QIODevice {
+public:
+    using Fill = std::function<qint64(char*, qint64)>;
+    PullSource(Fill fill, QObject* parent) : QIODevice(parent), fill_(std::move(fill)) {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return (qint64(1) << 30) + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override { return fill_(data, maxlen); }
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    Fill fill_;
+};
+}
+
+AudioEngine::AudioEngine(QObject* parent) : QObject(parent)
+{
+    worker_ = new QObject;
+    worker_->moveToThread(&thread_);
+    connect(&thread_, &QThread::finished, worker_, &QObject::deleteLater);
+    thread_.setObjectName(QStringLiteral("AudioEngine"));
+    thread_.start(QThread::TimeCriticalPriority);
+    QMetaObject::invokeMethod(worker_, [this]{ init(); }, Qt::QueuedConnection);
+}
+
+AudioEngine::~AudioEngine()
+{
+    // 设备要在创建它们的线程里停掉
+    QMetaObject::invokeMethod(worker_, [this]{ shutdown(); }, Qt::BlockingQueuedConnection);
+    thread_.quit();
+    thread_.wait();
+}
+
+bool AudioEngine::postRx(const RxFrame& f)
+{
+    if (!hasOutput()) return false;     // 没有输出设备，收了也放不出来
+    RxFrame c = f;
+    c.arrival = QDateTime::currentMSecsSinceEpoch();
+    if (rx_.push(c)) return true;
+    rxOverruns_.ref();
+    return false;
+}
+
+bool AudioEngine::takeTx(TxFrame& f)
+{
+    // 先清标记再取：取完之后引擎再放进来的帧一定会再发一次 txReady
+    txPending_.storeRelease(0);
+    return tx_.pop(f);
+}
+
+void AudioEngine::setCapture(bool on)
+{
+    QMetaObject::invokeMethod(worker_, [this, on] {
+        vad_.reset();
+        dtxRun_ = 0;
+        if (on) {
+            if (proc_) proc_->reset();
+            startInput();
+        } else {
+            stopInput();
+            if (speaking_) { speaking_ = false; emit speakingChanged(false); }
+        }
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::setCodec(const QString& codec)
+{
+    QMetaObject::invokeMethod(worker_, [this, codec] {
+        if (encoder_ && encoder_->name() == codec) return;
+        AudioEncoder* e = AudioEncoder::create(codec);
+        if (!e) e = AudioEncoder::create(QStringLiteral("mulaw"));
+        encoder_.reset(e);
+        emit codecChanged(encoder_ ? encoder_->name() : QString());
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::setPeerGain(const QString& sender, float g)
+{
+    const int q = AudioDsp::gainQ14(g);
+    QMetaObject::invokeMethod(worker_, [this, sender, q] { peerGain_[sender] = q; }, Qt::QueuedConnection);
+}
+
+void AudioEngine::setVoiceProcessing(const VoiceProcessor::Config& cfg)
+{
+    QMetaObject::invokeMethod(worker_, [this, cfg] {
+        proc_.reset(VoiceProcessor::create(cfg));
+        qInfo() << "[audio] voice processing ->" << proc_->name();
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::dropPeer(const QString& sender)
+{
+    QMetaObject::invokeMethod(worker_, [this, sender] {
+        peers_.remove(sender);
+        peerGain_.remove(sender);
+    }, Qt::QueuedConnection);
+}
+
+QHash<QString, JitterBuffer::Stats> AudioEngine::rxStats() const
+{
+    QMutexLocker lk(&statsMu_);
+    return statsSnap_;
+}
+
+AudioEngine::Counters AudioEngine::counters() const
+{
+    Counters c;
+    c.outUnderruns = outUnderruns_.loadAcquire();
+    c.inOverruns   = inOverruns_.loadAcquire();
+    c.rxOverruns   = rxOverruns_.loadAcquire();
+    c.txOverruns   = txOverruns_.loadAcquire();
+    const int frames = procFrames_.loadAcquire();
+    c.procAvgUs    = frames > 0 ? procUsSum_.loadAcquire() / frames : 0;
+    c.procMaxUs    = procUsMax_.loadAcquire();
+    return c;
+}
+
+// ---- 以下在引擎线程 ----
+
+void AudioEngine::init()
+{
+    mixBuf_.resize(kFrameSamples);
+    peerBuf_.resize(kFrameSamples);
+    encoder_.reset(AudioEncoder::create(QStringLiteral("mulaw")));
+    proc_.reset(VoiceProcessor::create(VoiceProcessor::Config()));
+
+    statsTimer_ = new QTimer(worker_);
+    statsTimer_->setInterval(kStatsLogMs);
+    connect(statsTimer_, &QTimer::timeout, worker_, [this]{ logStats(); });
+    statsTimer_->start();
+
+    ensureOutput();
+}
+
+void AudioEngine::shutdown()
+{
+    stopInput();
+    if (audioOut_) {
+        outputOk_.storeRelease(0);
+        audioOut_->stop();
+        delete audioOut_;
+        audioOut_ = nullptr;
+    }
+    delete pull_;
+    pull_ = nullptr;
+    delete statsTimer_;
+    statsTimer_ = nullptr;
+}
+
+void AudioEngine::startInput()
+{
+    if (audioIn_) return;
+
+    const QAudioFormat fmt = preferredFormat();
+    inFmt_ = fmt;
+
+    QAudioDeviceInfo devInfo = QAudioDeviceInfo::defaultInputDevice();
+    if (!devInfo.isFormatSupported(fmt)) {
+        inFmt_ = devInfo.nearestFormat(fmt);
+        inFmt_.setCodec("audio/pcm");
+    }
+    if (!AudioFormatConv::isSupported(inFmt_)) {
+        qWarning() << "AudioInput format unsupported" << inFmt_;
+        return;
+    }
+    // 设备给的采样率/声道与内部不一致时转换
+    inResampler_.setRates(inFmt_.sampleRate(), AudioCodec::kSampleRate);
+    inBuf_.clear();
+
+    audioIn_ = new QAudioInput(devInfo, inFmt_, worker_);
+    audioIn_->setBufferSize(AudioFormatConv::bytesPerMs(inFmt_) * kFrameMs * 4);
+
+    inDev_ = audioIn_->start();
+    if (!inDev_) {
+        qWarning() << "AudioInput start failed";
+        delete audioIn_; audioIn_ = nullptr;
+        return;
+    }
+    connect(inDev_, &QIODevice::readyRead, worker_, [this]{ onMicReadyRead(); });
+}
+
+void AudioEngine::stopInput()
+{
+    if (!audioIn_) return;
+    audioIn_->stop();
+    delete audioIn_;        // 连带 inDev_
+    audioIn_ = nullptr;
+    inDev_ = nullptr;
+    inBuf_.clear();
+}
+
+void AudioEngine::ensureOutput()
+{
+    if (audioOut_) return;
+
+    const QAudioFormat fmt = preferredFormat();
+    outFmt_ = fmt;
+
+    QAudioDeviceInfo devInfo = QAudioDeviceInfo::defaultOutputDevice();
+    if (!devInfo.isFormatSupported(fmt)) {
+        outFmt_ = devInfo.nearestFormat(fmt);
+        outFmt_.setCodec("audio/pcm");
+    }
+    if (!AudioFormatConv::isSupported(outFmt_)) {
+        qWarning() << "AudioOutput format unsupported" << outFmt_;
+        return;
+    }
+    outResampler_.setRates(AudioCodec::kSampleRate, outFmt_.sampleRate());
+    outPending_.clear();
+    outQueueMs_ = 0;
+    lastFill_.invalidate();
+
+    audioOut_ = new QAudioOutput(devInfo, outFmt_, worker_);
+    // 拉模式下设备缓冲就是全部的输出排队，其余都留在抖动缓冲里
+    audioOut_->setBufferSize(AudioFormatConv::bytesPerMs(outFmt_) * kFrameMs * kOutQueueFrames);
+    pull_ = new PullSource([this](char* d, qint64 n) { return fillOutput(d, n); }, worker_);
+    audioOut_->start(pull_);
+    if (audioOut_->error() != QAudio::NoError) {
+        qWarning() << "AudioOutput start failed" << audioOut_->error();
+        delete audioOut_; audioOut_ = nullptr;
+        delete pull_; pull_ = nullptr;
+        return;
+    }
+    outputOk_.storeRelease(1);
+}
+
+void AudioEngine::onMicReadyRead()
+{
+    if (!inDev_) return;
+    const QByteArray raw = inDev_->readAll();
+    // 读出时设备缓冲已满：上次读到现在之间进不来的样本已被设备丢掉
+    if (raw.size() >= audioIn_->bufferSize()) inOverruns_.ref();
+    if (!encoder_) return;
+
+    AudioFormatConv::toMono16(raw, inFmt_, inMono_);
+    inResampler_.process(inMono_.constData(), inMono_.size(), inBuf_);
+
+    // 回声时延 = 最新参考离出声还剩的时间 + 这帧开头录下到现在的时间（后面还排着的样本 + 本帧）
+    const int outMs = audioOut_ && lastFill_.isValid() ? int(qMax<qint64>(0, outQueueMs_ - lastFill_.elapsed())) : 0;
+    int off = 0;
+    while (inBuf_.size() - off >= kFrameSamples) {
+        const int backlogMs = (inBuf_.size() - off - kFrameSamples) / (AudioCodec::kSampleRate / 1000);
+        proc_->setEchoDelay(outMs + backlogMs + kFrameMs);
+        encodeFrame(inBuf_.data() + off);
+        off += kFrameSamples;
+    }
+    inBuf_.remove(0, off);
+}
+
+void AudioEngine::encodeFrame(qint16* s)
+{
+    // 前处理在麦克风增益之前：AEC 看到的回声路径不随用户调音量变化
+    QElapsedTimer t;
+    t.start();
+    proc_->process(s, kFrameSamples);
+    const int us = int(t.nsecsElapsed() / 1000);
+    procUsSum_.fetchAndAddRelaxed(us);
+    procFrames_.ref();
+    if (us > procUsMax_.loadAcquire()) procUsMax_.storeRelease(us);
+
+    // 本地麦克风增益（编码前）
+    AudioDsp::applyGain(s, kFrameSamples, micGain_.loadAcquire());
+
+    // VAD/DTX：静音时只每 kCnIntervalFrames 帧发一个舒适噪声帧，其余不发
+    const VoiceActivityDetector::Result va = vad_.process(s, kFrameSamples);
+    if (va.speech != speaking_) {
+        speaking_ = va.speech;
+        emit speakingChanged(speaking_);
+    }
+
+    TxFrame f;
+    f.codec = encoder_->name();
+    f.sr = encoder_->wireRate();
+    if (va.speech || !dtx_.loadAcquire()) {
+        dtxRun_ = 0;
+        f.payload = encoder_->encode(s);
+    } else if (dtxRun_++ % kCnIntervalFrames == 0) {
+        f.payload = AudioCodec::comfortNoisePayload(va.noiseDbov);
+        f.codec = QStringLiteral("cn");
+    }
+    if (f.payload.isEmpty()) return;
+
+    // seq 只给发出去的帧编号，DTX 省掉的帧不算丢包
+    f.seq = seq_++;
+    f.ts = QDateTime::currentMSecsSinceEpoch();
+    f.level = va.levelDbov;
+    f.voiced = va.speech;
+    if (!tx_.push(f)) { txOverruns_.ref(); return; }
+    if (txPending_.testAndSetOrdered(0, 1)) emit txReady();
+}
+
+// TCP/UDP 两条路来的帧汇到同一个抖动缓冲；切换路径时重复的 seq 在缓冲里去重
+void AudioEngine::drainRx()
+{
+    RxFrame f;
+    while (rx_.pop(f)) {
+        Peer& peer = peers_[f.sender];
+        const QString key = f.codec + QLatin1Char('/') + QString::number(f.sr);
+        QSharedPointer<AudioDecoder> dec = peer.decoders.value(key);
+        if (!dec) {
+            dec.reset(AudioDecoder::create(f.codec, f.sr));
+            if (!dec) continue;     // 不认识的编码
+            peer.decoders.insert(key, dec);
+        }
+        peer.jb.push(f.seq, f.ts, f.payload, dec, f.arrival);
+    }
+}
+
+void AudioEngine::mixFrame(qint16* out, qint64 playoutMs)
+{
+    std::fill(out, out + kFrameSamples, qint16(0));
+
+    // 逐路读取并按各自增益饱和混合（gain==0 静音时内核直接跳过）
+    for (auto it = peers_.begin(); it != peers_.end(); ++it) {
+        if (it->jb.pop(peerBuf_.data(), playoutMs) != JitterBuffer::Silence)
+            AudioDsp::mixAddGain(out, peerBuf_.constData(), kFrameSamples,
+                                 peerGain_.value(it.key(), AudioDsp::kUnityGain));
+    }
+
+    // 整体播放增益
+    AudioDsp::applyGain(out, kFrameSamples, playGain_.loadAcquire());
+}
+
+// 声卡回调：先把收包环里的帧放进抖动缓冲，再按需要的字节数逐帧混音
+qint64 AudioEngine::fillOutput(char* data, qint64 maxlen)
+{
+    if (!audioOut_ || maxlen <= 0) return 0;
+
+    const int bytesPerMs = AudioFormatConv::bytesPerMs(outFmt_);
+    const int bufferMs = audioOut_->bufferSize() / bytesPerMs;
+    // 每次都把设备缓冲填满，所以两次取数间隔超过缓冲时长就说明中间放空过
+    if (lastFill_.isValid() && lastFill_.elapsed() > bufferMs) outUnderruns_.ref();
+    lastFill_.start();
+
+    drainRx();
+
+    // 这次混出的帧排在设备缓冲和未取走的字节之后才出声：用于口到耳时延统计
+    qint64 playoutMs = QDateTime::currentMSecsSinceEpoch() + bufferMs + outPending_.size() / bytesPerMs;
+    while (outPending_.size() < maxlen) {
+        mixFrame(mixBuf_.data(), playoutMs);
+        proc_->farEnd(mixBuf_.constData(), kFrameSamples);
+        // 转成设备格式（采样率/声道/样本类型）
+        outBuf_.clear();
+        outResampler_.process(mixBuf_.constData(), kFrameSamples, outBuf_);
+        outPending_ += AudioFormatConv::fromMono16(outBuf_.constData(), outBuf_.size(), outFmt_);
+        playoutMs += kFrameMs;
+    }
+
+    std::memcpy(data, outPending_.constData(), size_t(maxlen));
+    outPending_.remove(0, int(maxlen));
+    outQueueMs_ = bufferMs + outPending_.size() / bytesPerMs;
+    return maxlen;
+}
+
+void AudioEngine::logStats()
+{
+    QHash<QString, JitterBuffer::Stats> snap;
+    for (auto it = peers_.begin(); it != peers_.end(); ++it) {
+        const JitterBuffer::Stats s = it->jb.stats();
+        snap.insert(it.key(), s);
+        if (s.received == 0) continue;
+        qInfo().noquote() << "[audio-jb]" << it.key()
+                          << "depth=" << s.depthMs << "target=" << s.targetMs
+                          << "jitter=" << QString::number(s.jitterMs, 'f', 1)
+                          << "m2e=" << QString::number(s.delayMeanMs, 'f', 0)
+                          << "+-" << QString::number(s.delayStdMs, 'f', 1)
+                          << "recv=" << s.received << "late=" << s.late << "missing=" << s.missing
+                          << "plc=" << s.concealed << "fec=" << s.fec
+                          << "compress=" << s.compressed << "drop=" << s.dropped;
+        it->jb.resetStats();
+    }
+    {
+        QMutexLocker lk(&statsMu_);
+        statsSnap_ = snap;
+    }
+
+    const Counters c = counters();
+    if (c.outUnderruns || c.inOverruns || c.rxOverruns || c.txOverruns || c.procMaxUs)
+        qInfo().noquote() << "[audio-engine]" << "underrun=" << c.outUnderruns << "in_overrun=" << c.inOverruns
+                          << "rx_overrun=" << c.rxOverruns << "tx_overrun=" << c.txOverruns
+                          << "proc=" << proc_->name() << c.procAvgUs << "/" << c.procMaxUs << "us";
+    if (c.procMaxUs > kFrameMs * 1000)
+        qWarning() << "[audio-engine] voice processing over frame budget:" << c.procMaxUs << "us";
+    procUsSum_.storeRelease(0);
+    procFrames_.storeRelease(0);
+    procUsMax_.storeRelease(0);
+}
@@ -0,0 +1,522 @@
+#include "audioproc.h"
+#include "audiocodec.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace {
+typedef std::complex<float> Cpx;
+
+const float kPi = 3.14159265358979f;
+
+// AEC：64 点一块（4ms），128 点 FFT 重叠保留；64 个分块覆盖 256ms 回声尾长
+const int   kAecBlock       = 64;
+const int   kAecFft         = 2 * kAecBlock;
+const int   kAecBins        = kAecBlock + 1;
+const int   kAecPartitions  = 64;
+const float kAecMu          = 0.5f;
+const float kAecMuFloor     = 0.1f;     // 步长下限（相对 kAecMu）：起步和双讲时的速度
+const float kAecFarFloor    = 1e-7f;    // 远端平均功率（约 -70dBFS）以下不更新
+const float kAecReg         = 1e-3f;
+const int   kAecDivergeBlocks = 50;     // 误差比近端还大连续这么多块（200ms）视为发散，滤波器清零
+
+// 参考对齐：最新的参考此刻还没播出（设备排队 + 未取走），麦克风这帧已经录下（采集排队），
+// 两者之和就是麦克风这帧开头对应的参考位置。取最新参考之前 (时延 - 余量) 的样本与之配对，
+// 硬件里看不见的那段延迟只会让回声更靠后，保证参考领先回声、回声落在尾长之内
+// 时延取一个窗口里的最小值，和当前对齐差得多才重新对齐（会重学滤波器）
+const int kRefMaxSamples      = AudioCodec::kSampleRate * 500 / 1000;
+const int kRefDefaultSamples  = AudioCodec::kSampleRate * 60 / 1000;   // 还没有实测时：输出排队 3 帧 + 本帧 - 余量
+const int kRefMarginSamples   = AudioCodec::kSampleRate * 20 / 1000;
+const int kRefMaxDelaySamples = AudioCodec::kSampleRate * 250 / 1000;
+const int kRefRealignSamples  = AudioCodec::kSampleRate * 20 / 1000;
+const int kRefWindowFrames    = 25;     // 500ms
+
+// NS：320 点 sqrt-Hann、160 点跳（50% 重叠）、512 点 FFT
+const int   kNsHop        = 160;
+const int   kNsWin        = 2 * kNsHop;
+const int   kNsFft        = 512;
+const int   kNsBins       = kNsFft / 2 + 1;
+const float kNsGainFloor  = 0.1f;       // 最多压 20dB，压太狠残留“水声”
+const float kNsDdAlpha    = 0.98f;      // 判决引导平滑
+const float kNsPsdSmooth  = 0.8f;
+const float kNsNoiseRise  = 1.0069f;    // 噪声估计每跳最多升这么多（约 3dB/s）
+const int   kNsInitHops   = 20;         // 开头 200ms 直接当噪声学
+const float kNsEchoLeak   = 0.15f;      // 回声估计里按这个比例算残余回声
+
+// AGC：dB 量，按帧（20ms）计
+const float kAgcTargetDb    = -20.0f;
+const float kAgcMaxGainDb   = 18.0f;
+const float kAgcMinGainDb   = -6.0f;
+const float kAgcUpDb        = 0.1f;     // 5dB/s
+const float kAgcDownDb      = 1.0f;
+const float kAgcGateDb      = -55.0f;
+const float kAgcSpeechDb    = 9.0f;     // 高出底噪这么多才算语音
+const float kAgcFloorRiseDb = 0.02f;
+const float kAgcLimit       = 0.9f;
+
+inline Cpx mul(const Cpx& a, const Cpx& b)
+{
+    return Cpx(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+inline Cpx mulConj(const Cpx& a, const Cpx& b)     // conj(a) * b
+{
+    return Cpx(a.real() * b.real() + a.imag() * b.imag(), a.real() * b.imag() - a.imag() * b.real());
+}
+
+inline float power(const Cpx& a) { return a.real() * a.real() + a.imag() * a.imag(); }
+
+inline float toDb(float p) { return 10.0f * std::log10(p + 1e-12f); }
+
+// 基 2 复数 FFT，长度固定、旋转因子预算好
+class Fft {
+public:
+    explicit Fft(int n) : n_(n), tw_(n / 2), rev_(n) {
+        int bits = 0;
+        while ((1 << bits) < n) ++bits;
+        for (int i = 0; i < n; ++i) {
+            int r = 0;
+            for (int b = 0; b < bits; ++b) if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+            rev_[i] = r;
+        }
+        for (int i = 0; i < n / 2; ++i) tw_[i] = std::polar(1.0f, -2.0f * kPi * i / n);
+    }
+
+    void forward(Cpx* a) const { run(a, false); }
+
+    // 由前 n/2+1 个频点（实信号共轭对称）还原，含 1/n 缩放；a 长度 n
+    void inverseReal(const Cpx* half, Cpx* a) const {
+        const int h = n_ / 2;
+        for (int k = 0; k <= h; ++k) a[k] = half[k];
+        for (int k = 1; k < h; ++k) a[n_ - k] = std::conj(half[k]);
+        run(a, true);
+        const float s = 1.0f / n_;
+        for (int i = 0; i < n_; ++i) a[i] = Cpx(a[i].real() * s, 0.0f);
+    }
+
+private:
+    void run(Cpx* a, bool inv) const {
+        for (int i = 0; i < n_; ++i) if (i < rev_[i]) std::swap(a[i], a[rev_[i]]);
+        for (int len = 2; len <= n_; len <<= 1) {
+            const int half = len / 2, step = n_ / len;
+            for (int i = 0; i < n_; i += len) {
+                for (int j = 0; j < half; ++j) {
+                    const Cpx w = inv ? std::conj(tw_[j * step]) : tw_[j * step];
+                    const Cpx t = mul(a[i + j + half], w);
+                    a[i + j + half] = a[i + j] - t;
+                    a[i + j] += t;
+                }
+            }
+        }
+    }
+
+    int n_;
+    QVector<Cpx> tw_;
+    QVector<int> rev_;
+};
+
+// 分块频域 NLMS 回声消除
+class EchoCanceller {
+public:
+    EchoCanceller()
+        : X_(kAecPartitions * kAecBins), Xp_(kAecPartitions * kAecBins), W_(kAecPartitions * kAecBins), Px_(kAecBins),
+          xPrev_(kAecBlock), err_(kAecBlock), buf_(kAecFft), Y_(kAecBins), G_(kAecBins), prop_(kAecPartitions) {}
+
+    void reset() {
+        std::fill(X_.begin(), X_.end(), Cpx());
+        std::fill(Xp_.begin(), Xp_.end(), 0.0f);
+        std::fill(W_.begin(), W_.end(), Cpx());
+        std::fill(Px_.begin(), Px_.end(), 0.0f);
+        std::fill(xPrev_.begin(), xPrev_.end(), 0.0f);
+        head_ = 0;
+        constrain_ = 0;
+        bad_ = 0;
+    }
+
+    // x：与近端对齐的远端参考，d：近端；输出 e = d - y 与回声估计 y；都是 kAecBlock 点
+    void process(const float* x, const float* d, float* e, float* y) {
+        Cpx* b = buf_.data();
+
+        // 最新一块远端谱放到分块 0，其余顺延
+        head_ = (head_ + kAecPartitions - 1) % kAecPartitions;
+        for (int i = 0; i < kAecBlock; ++i) {
+            b[i] = Cpx(xPrev_[i], 0.0f);
+            b[kAecBlock + i] = Cpx(x[i], 0.0f);
+        }
+        fft_.forward(b);
+        Cpx* xh = X_.data() + head_ * kAecBins;
+        float* xph = Xp_.data() + head_ * kAecBins;
+        for (int k = 0; k < kAecBins; ++k) {
+            xh[k] = b[k];
+            xph[k] = power(b[k]);
+        }
+        std::copy(x, x + kAecBlock, xPrev_.begin());
+
+        // 回声估计：各分块滤波器 × 对应延迟的远端谱求和，重叠保留取后半
+        Cpx* Y = Y_.data();
+        std::fill(Y, Y + kAecBins, Cpx());
+        for (int p = 0; p < kAecPartitions; ++p) {
+            const Cpx* xp = X_.constData() + ((head_ + p) % kAecPartitions) * kAecBins;
+            const Cpx* wp = W_.constData() + p * kAecBins;
+            for (int k = 0; k < kAecBins; ++k) Y[k] += mul(wp[k], xp[k]);
+        }
+        fft_.inverseReal(Y, b);
+
+        float* r = err_.data();
+        float pd = 0.0f, pe = 0.0f, py = 0.0f, pf = 0.0f;
+        for (int i = 0; i < kAecBlock; ++i) {
+            y[i] = b[kAecBlock + i].real();
+            r[i] = d[i] - y[i];
+            pd += d[i] * d[i];
+            pe += r[i] * r[i];
+            py += y[i] * y[i];
+            pf += x[i] * x[i];
+        }
+
+        // 误差比近端还大说明估计跑偏（远端刚停时长尾没学好，或回声路径变了）：这块直接输出近端，
+        // 持续跑偏才清零重学
+        if (pe > pd + kAecFarFloor * kAecBlock) {
+            std::copy(d, d + kAecBlock, e);
+            std::fill(y, y + kAecBlock, 0.0f);
+            if (++bad_ >= kAecDivergeBlocks) {
+                std::fill(W_.begin(), W_.end(), Cpx());
+                bad_ = 0;
+                return;
+            }
+        } else {
+            std::copy(r, r + kAecBlock, e);
+            bad_ = 0;
+        }
+        if (pf < kAecFarFloor * kAecBlock) return;
+
+        // 步长按“回声估计/误差”收放：收敛后误差里主要是残余回声，比值大用满步长；
+        // 近端有人说话（双讲）时误差远大于回声估计，步长降到下限，滤波器不被带偏
+        const float mu = kAecMu * qBound(kAecMuFloor, py / (pe + 1e-9f), 1.0f);
+
+        for (int i = 0; i < kAecBlock; ++i) {
+            b[i] = Cpx();
+            b[kAecBlock + i] = Cpx(r[i], 0.0f);
+        }
+        fft_.forward(b);
+
+        // 各分块按滤波器能量分步长（比例型 IPNLMS），稀疏回声路径收敛更快；全零时均分。
+        // 归一化用同样加权的整个窗口远端功率，远端忽大忽小时步长不会冲过头
+        float mx = 0.0f, sum = 0.0f;
+        for (int p = 0; p < kAecPartitions; ++p) {
+            const Cpx* wp = W_.constData() + p * kAecBins;
+            float n = 0.0f;
+            for (int k = 0; k < kAecBins; ++k) n += power(wp[k]);
+            prop_[p] = std::sqrt(n);
+            mx = std::max(mx, prop_[p]);
+        }
+        for (int p = 0; p < kAecPartitions; ++p) {
+            prop_[p] += 0.1f * mx + 1e-9f;
+            sum += prop_[p];
+        }
+        float* px = Px_.data();
+        std::fill(px, px + kAecBins, 0.0f);
+        for (int p = 0; p < kAecPartitions; ++p) {
+            prop_[p] /= sum;
+            const float* xpp = Xp_.constData() + ((head_ + p) % kAecPartitions) * kAecBins;
+            for (int k = 0; k < kAecBins; ++k) px[k] += prop_[p] * xpp[k];
+        }
+        Cpx* G = G_.data();
+        for (int k = 0; k < kAecBins; ++k) G[k] = b[k] * (mu / (px[k] + kAecReg));
+        for (int p = 0; p < kAecPartitions; ++p) {
+            const float g = prop_[p];
+            const Cpx* xp = X_.constData() + ((head_ + p) % kAecPartitions) * kAecBins;
+            Cpx* wp = W_.data() + p * kAecBins;
+            for (int k = 0; k < kAecBins; ++k) wp[k] += g * mulConj(xp[k], G[k]);
+        }
+
+        // 梯度约束（时域后半清零）轮流做一个分块，省下每块 2×64 次 FFT
+        Cpx* wc = W_.data() + constrain_ * kAecBins;
+        fft_.inverseReal(wc, b);
+        for (int i = kAecBlock; i < kAecFft; ++i) b[i] = Cpx();
+        fft_.forward(b);
+        std::copy(b, b + kAecBins, wc);
+        constrain_ = (constrain_ + 1) % kAecPartitions;
+    }
+
+private:
+    Fft fft_{kAecFft};
+    QVector<Cpx>   X_;      // 远端谱历史，环形，head_ 为最新
+    QVector<float> Xp_;     // 对应的功率谱
+    QVector<Cpx>   W_;      // 各分块滤波器
+    QVector<float> Px_;     // 按分块步长加权的远端功率（归一化分母）
+    QVector<float> xPrev_;
+    QVector<float> err_;
+    QVector<Cpx>   buf_;
+    QVector<Cpx>   Y_;
+    QVector<Cpx>   G_;
+    QVector<float> prop_;
+    int head_ = 0;
+    int constrain_ = 0;
+    int bad_ = 0;
+};
+
+// 稳态噪声 + 残余回声的谱减（维纳增益），输出比输入晚一跳
+class SpectralSuppressor {
+public:
+    SpectralSuppressor(bool noise, bool echo)
+        : noise_(noise), echo_(echo), win_(kNsWin), inPrev_(kNsHop), echoPrev_(kNsHop), ola_(kNsHop),
+          buf_(kNsFft), echoBuf_(kNsFft), half_(kNsBins), N_(kNsBins), P_(kNsBins), prevClean_(kNsBins) {
+        for (int i = 0; i < kNsWin; ++i) win_[i] = std::sqrt(0.5f - 0.5f * std::cos(2.0f * kPi * i / kNsWin));
+    }
+
+    void reset() {
+        std::fill(inPrev_.begin(), inPrev_.end(), 0.0f);
+        std::fill(echoPrev_.begin(), echoPrev_.end(), 0.0f);
+        std::fill(ola_.begin(), ola_.end(), 0.0f);
+        std::fill(N_.begin(), N_.end(), 0.0f);
+        std::fill(P_.begin(), P_.end(), 0.0f);
+        std::fill(prevClean_.begin(), prevClean_.end(), 0.0f);
+        hops_ = 0;
+    }
+
+    // in/echo/out 各 kNsHop 点
+    void process(const float* in, const float* echo, float* out) {
+        Cpx* b = buf_.data();
+        window(inPrev_.constData(), in, b);
+        fft_.forward(b);
+
+        Cpx* eb = echoBuf_.data();
+        if (echo_) {
+            window(echoPrev_.constData(), echo, eb);
+            fft_.forward(eb);
+            std::copy(echo, echo + kNsHop, echoPrev_.begin());
+        }
+        std::copy(in, in + kNsHop, inPrev_.begin());
+
+        float* N = N_.data();
+        float* P = P_.data();
+        float* pc = prevClean_.data();
+        Cpx* h = half_.data();
+        for (int k = 0; k < kNsBins; ++k) {
+            const float s = power(b[k]);
+            float ntot = 1e-9f;
+            if (noise_) {
+                // 最小值跟踪：平滑功率往下立刻跟，往上按 kNsNoiseRise 慢慢爬，说话时不会把语音当噪声
+                P[k] = kNsPsdSmooth * P[k] + (1.0f - kNsPsdSmooth) * s;
+                if (hops_ < kNsInitHops)  N[k] = (N[k] * hops_ + P[k]) / (hops_ + 1);
+                else if (P[k] < N[k])     N[k] = P[k];
+                else                      N[k] *= kNsNoiseRise;
+                ntot += N[k];
+            }
+            if (echo_) ntot += kNsEchoLeak * power(eb[k]);
+
+            const float post = s / ntot;
+            const float prio = kNsDdAlpha * pc[k] / ntot + (1.0f - kNsDdAlpha) * std::max(post - 1.0f, 0.0f);
+            const float g = std::max(prio / (1.0f + prio), kNsGainFloor);
+            pc[k] = g * g * s;
+            h[k] = b[k] * g;
+        }
+        ++hops_;
+
+        fft_.inverseReal(h, b);
+        for (int i = 0; i < kNsHop; ++i) {
+            out[i] = ola_[i] + b[i].real() * win_[i];
+            ola_[i] = b[kNsHop + i].real() * win_[kNsHop + i];
+        }
+    }
+
+private:
+    void window(const float* prev, const float* cur, Cpx* b) const {
+        for (int i = 0; i < kNsHop; ++i) {
+            b[i] = Cpx(prev[i] * win_[i], 0.0f);
+            b[kNsHop + i] = Cpx(cur[i] * win_[kNsHop + i], 0.0f);
+        }
+        std::fill(b + kNsWin, b + kNsFft, Cpx());
+    }
+
+    bool noise_;
+    bool echo_;
+    Fft fft_{kNsFft};
+    QVector<float> win_;
+    QVector<float> inPrev_, echoPrev_, ola_;
+    QVector<Cpx>   buf_, echoBuf_, half_;
+    QVector<float> N_;          // 噪声谱估计
+    QVector<float> P_;          // 平滑功率谱
+    QVector<float> prevClean_;  // 上一跳增益后的功率，判决引导用
+    int hops_ = 0;
+};
+
+// 数字 AGC：按帧估语音电平，增益慢升快降，帧内线性过渡并按峰值限幅
+class AutoGain {
+public:
+    void reset() {
+        gainDb_ = 0.0f;
+        gain_ = 1.0f;
+        floorDb_ = kAgcGateDb;
+        speechDb_ = kAgcTargetDb;
+    }
+
+    void process(float* s, int n) {
+        float energy = 0.0f, peak = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            energy += s[i] * s[i];
+            peak = std::max(peak, std::fabs(s[i]));
+        }
+        const float levelDb = toDb(energy / n);
+
+        floorDb_ = std::min(levelDb, floorDb_ + kAgcFloorRiseDb);
+        if (levelDb > kAgcGateDb && levelDb > floorDb_ + kAgcSpeechDb) {
+            speechDb_ += 0.1f * (levelDb - speechDb_);
+            const float want = qBound(kAgcMinGainDb, kAgcTargetDb - speechDb_, kAgcMaxGainDb);
+            if (want > gainDb_) gainDb_ = std::min(want, gainDb_ + kAgcUpDb);
+            else                gainDb_ = std::max(want, gainDb_ - kAgcDownDb);
+        }
+
+        float g = std::pow(10.0f, gainDb_ / 20.0f);
+        if (peak * g > kAgcLimit) {
+            g = kAgcLimit / peak;
+            gainDb_ = 20.0f * std::log10(g);
+        }
+        const float step = (g - gain_) / n;
+        for (int i = 0; i < n; ++i) {
+            gain_ += step;
+            s[i] *= gain_;
+        }
+        gain_ = g;
+    }
+
+private:
+    float gainDb_ = 0.0f;
+    float gain_ = 1.0f;
+    float floorDb_ = kAgcGateDb;
+    float speechDb_ = kAgcTargetDb;
+};
+
+class BypassProcessor : public VoiceProcessor {
+public:
+    QString name() const override { return QStringLiteral("bypass"); }
+    void farEnd(const qint16*, int) override {}
+    void setEchoDelay(int) override {}
+    void process(qint16*, int) override {}
+    void reset() override {}
+};
+
+class VoiceChain : public VoiceProcessor {
+public:
+    explicit VoiceChain(const Config& cfg)
+        : d_(AudioCodec::kFrameSamples), e_(AudioCodec::kFrameSamples),
+          y_(AudioCodec::kFrameSamples), out_(AudioCodec::kFrameSamples) {
+        if (cfg.aec) aec_.reset(new EchoCanceller);
+        if (cfg.aec || cfg.ns) ns_.reset(new SpectralSuppressor(cfg.ns, cfg.aec));
+        if (cfg.agc) agc_.reset(new AutoGain);
+        QStringList parts;
+        if (cfg.aec) parts << QStringLiteral("aec");
+        if (cfg.ns)  parts << QStringLiteral("ns");
+        if (cfg.agc) parts << QStringLiteral("agc");
+        name_ = parts.join(QLatin1Char('+'));
+        reset();
+    }
+
+    QString name() const override { return name_; }
+
+    void farEnd(const qint16* pcm, int n) override {
+        if (!aec_) return;
+        const int at = ref_.size();
+        ref_.resize(at + n);
+        for (int i = 0; i < n; ++i) ref_[at + i] = pcm[i] * (1.0f / 32768.0f);
+        // 麦克风没开或采集卡住：参考只留最近一段，下次处理时重新对齐
+        if (ref_.size() - refRead_ > kRefMaxSamples) {
+            refRead_ = ref_.size() - kRefMaxSamples;
+            resync_ = true;
+        }
+        if (refRead_ > kRefMaxSamples) {
+            ref_.remove(0, refRead_);
+            refRead_ = 0;
+        }
+    }
+
+    void setEchoDelay(int ms) override {
+        if (!aec_) return;
+        const int s = qBound(0, ms * (AudioCodec::kSampleRate / 1000) - kRefMarginSamples, kRefMaxDelaySamples);
+        delayMin_ = qMin(delayMin_, s);
+        if (++delayFrames_ < kRefWindowFrames) return;
+        if (qAbs(delayMin_ - refDelay_) > kRefRealignSamples) {
+            refDelay_ = delayMin_;
+            resync_ = true;
+        }
+        delayMin_ = kRefMaxDelaySamples;
+        delayFrames_ = 0;
+    }
+
+    void process(qint16* pcm, int n) override {
+        if (n != AudioCodec::kFrameSamples) return;
+        float* d = d_.data();
+        float* e = e_.data();
+        float* y = y_.data();
+        float* out = out_.data();
+        for (int i = 0; i < n; ++i) d[i] = pcm[i] * (1.0f / 32768.0f);
+
+        if (aec_) {
+            const float* x = takeRef(n);
+            for (int i = 0; i < n; i += kAecBlock) aec_->process(x + i, d + i, e + i, y + i);
+        } else {
+            std::copy(d, d + n, e);
+            std::fill(y, y + n, 0.0f);
+        }
+
+        if (ns_) {
+            for (int i = 0; i < n; i += kNsHop) ns_->process(e + i, y + i, out + i);
+        } else {
+            std::copy(e, e + n, out);
+        }
+
+        if (agc_) agc_->process(out, n);
+
+        for (int i = 0; i < n; ++i)
+            pcm[i] = qint16(qBound(-32768L, std::lrint(out[i] * 32768.0f), 32767L));
+    }
+
+    void reset() override {
+        ref_.clear();
+        refRead_ = 0;
+        resync_ = true;
+        delayMin_ = kRefMaxDelaySamples;
+        delayFrames_ = 0;
+        if (aec_) aec_->reset();
+        if (ns_)  ns_->reset();
+        if (agc_) agc_->reset();
+    }
+
+private:
+    // 按样本数顺序配对参考与麦克风；参考断供、积压越界或时延变了时重新对齐到 refDelay_ 并重学滤波器
+    const float* takeRef(int n) {
+        const int avail = ref_.size() - refRead_;
+        if (resync_ || avail < n) {
+            const int keep = qMin(avail, refDelay_);
+            QVector<float> fresh(refDelay_ - keep, 0.0f);
+            fresh.reserve(kRefMaxSamples + n);
+            for (int i = ref_.size() - keep; i < ref_.size(); ++i) fresh.append(ref_[i]);
+            ref_.swap(fresh);
+            refRead_ = 0;
+            resync_ = false;
+            aec_->reset();
+        }
+        const float* p = ref_.constData() + refRead_;
+        refRead_ += n;
+        return p;
+    }
+
+    QScopedPointer<EchoCanceller> aec_;
+    QScopedPointer<SpectralSuppressor> ns_;
+    QScopedPointer<AutoGain> agc_;
+    QString name_;
+    QVector<float> ref_;
+    int  refRead_ = 0;
+    int  refDelay_ = kRefDefaultSamples;
+    int  delayMin_ = kRefMaxDelaySamples;
+    int  delayFrames_ = 0;
+    bool resync_ = true;
+    QVector<float> d_, e_, y_, out_;
+};
+}
+
+VoiceProcessor* VoiceProcessor::create(const Config& cfg)
+{
+    if (cfg.isBypass()) return new BypassProcessor;
+    return new VoiceChain(cfg);
+}
@@ -0,0 +1,127 @@
+#include "camencoder.h"
+
+namespace {
+const int    kMinQuality   = 30;
+const double kEmaAlpha     = 0.2;
+const double kHighWater    = 0.6;   // EMA 超过预算的 60% 就降，给发送/预览留余量
+const double kLowWater     = 0.3;
+const int    kStepDown     = 5;
+const int    kStepUp       = 2;
+const int    kDownHoldMs   = 500;   // 每次调整后等 EMA 跟上再判断
+const int    kUpHoldMs     = 2000;  // 回升比下降慢，避免来回抖
+}
+
+CameraEncoder::CameraEncoder(QObject* parent)
+    : QObject(parent)
+{
+    worker_ = new QObject;
+    worker_->moveToThread(&thread_);
+    connect(&thread_, &QThread::finished, worker_, &QObject::deleteLater);
+    thread_.setObjectName(QStringLiteral("CameraEncoder"));
+    thread_.start();
+}
+
+CameraEncoder::~CameraEncoder()
+{
+    thread_.quit();
+    thread_.wait();
+}
+
+void CameraEncoder::setBaseQuality(int q)
+{
+    q = qBound(kMinQuality, q, 95);
+    baseQuality_.storeRelease(q);
+    // 基准调低时立即生效；调高交给 adaptQuality 逐步回升
+    if (quality_.loadAcquire() > q) quality_.storeRelease(q);
+    QMutexLocker lk(&mu_);
+    stats_.quality = quality_.loadAcquire();
+}
+
+void CameraEncoder::setFrameBudgetMs(int ms)
+{
+    budgetMs_.storeRelease(qMax(1, ms));
+}
+
+void CameraEncoder::submit(const QVector<QImage>& layers, const QJsonObject& meta)
+{
+    if (layers.isEmpty() || layers.first().isNull()) return;
+    QMutexLocker lk(&mu_);
+    if (!pending_.isEmpty()) ++stats_.dropped;
+    pending_ = layers;
+    pendingMeta_ = meta;
+    if (busy_) return;
+    busy_ = true;
+    QMetaObject::invokeMethod(worker_, [this]{ drain(); }, Qt::QueuedConnection);
+}
+
+CameraEncoder::Stats CameraEncoder::stats() const
+{
+    QMutexLocker lk(&mu_);
+    return stats_;
+}
+
+void CameraEncoder::drain()
+{
+    for (;;) {
+        QVector<QImage> layers;
+        QJsonObject meta;
+        {
+            QMutexLocker lk(&mu_);
+            if (pending_.isEmpty()) { busy_ = false; return; }
+            layers.swap(pending_);
+            meta.swap(pendingMeta_);
+        }
+
+        meta["seq"] = double(seq_++);
+        const int quality = quality_.loadAcquire();
+        QElapsedTimer t;
+        t.start();
+        for (int l = 0; l < layers.size(); ++l) {
+            const QImage& img = layers.at(l);
+            if (img.isNull()) continue;
+            QByteArray jpeg;
+            jpeg.reserve(img.width() * img.height() / 6);
+            QBuffer buf(&jpeg);
+            buf.open(QIODevice::WriteOnly);
+            QImageWriter w(&buf, "jpeg");
+            w.setQuality(quality);
+            w.setOptimizedWrite(true);
+            const bool ok = w.write(img);
+            buf.close();
+            if (!ok) continue;
+
+            QJsonObject m = meta;
+            m["layer"] = l;
+            emit encoded(jpeg, m, img.size());
+        }
+        // 预算按整组算：多层的开销也要落在帧间隔内
+        adaptQuality(t.nsecsElapsed() / 1e6);
+    }
+}
+
+void CameraEncoder::adaptQuality(double costMs)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const double budget = budgetMs_.loadAcquire();
+    const int base = baseQuality_.loadAcquire();
+    int q = quality_.loadAcquire();
+
+    QMutexLocker lk(&mu_);
+    stats_.encodeMsAvg = stats_.encoded == 0 ? costMs
+                       : stats_.encodeMsAvg + kEmaAlpha * (costMs - stats_.encodeMsAvg);
+    ++stats_.encoded;
+
+    const int before = q;
+    if (stats_.encodeMsAvg > budget * kHighWater && now - lastAdaptMs_ >= kDownHoldMs) {
+        q = qMax(kMinQuality, q - kStepDown);
+    } else if (stats_.encodeMsAvg < budget * kLowWater && q < base && now - lastAdaptMs_ >= kUpHoldMs) {
+        q = qMin(base, q + kStepUp);
+    }
+    if (q != before) {
+        lastAdaptMs_ = now;
+        quality_.storeRelease(q);
+        qInfo() << "[cam-enc] quality" << before << "->" << q
+                << "avg" << stats_.encodeMsAvg << "ms budget" << budget << "ms dropped" << stats_.dropped;
+    }
+    stats_.quality = q;
+}
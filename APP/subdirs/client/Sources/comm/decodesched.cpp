@@ -0,0 +1,129 @@
+#include "decodesched.h"
+
+namespace {
+class DecodeJob : public QRunnable {
+public:
+    DecodeJob(QByteArray jpeg, QSize target, std::function<void(QImage)> done)
+        : jpeg_(std::move(jpeg)), target_(target), done_(std::move(done)) {}
+
+    void run() override {
+        QBuffer buf(&jpeg_);
+        buf.open(QIODevice::ReadOnly);
+        QImageReader reader(&buf);
+        reader.setAutoTransform(true);
+        // 只读头拿原始尺寸；比显示尺寸大才缩小解码，不放大
+        const QSize src = reader.size();
+        if (src.isValid() && target_.isValid()
+            && (src.width() > target_.width() || src.height() > target_.height())) {
+            reader.setScaledSize(src.scaled(target_, Qt::KeepAspectRatio));
+        }
+        done_(reader.read());
+    }
+
+private:
+    QByteArray jpeg_;
+    QSize target_;
+    std::function<void(QImage)> done_;
+};
+}
+
+DecodeScheduler::DecodeScheduler(TargetFn target, QObject* parent)
+    : QObject(parent), target_(std::move(target))
+{
+    pool_.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+    timer_.setInterval(16);
+    connect(&timer_, &QTimer::timeout, this, &DecodeScheduler::onTick);
+}
+
+DecodeScheduler::~DecodeScheduler()
+{
+    // 等在途任务结束；之后投递回来的结果随本对象销毁而丢弃
+    pool_.clear();
+    pool_.waitForDone();
+}
+
+void DecodeScheduler::setIntervalMs(int ms)
+{
+    timer_.setInterval(qMax(1, ms));
+}
+
+void DecodeScheduler::submit(const QString& sender, const QString& media, const QByteArray& jpeg)
+{
+    if (jpeg.isEmpty()) return;
+    slots_[slotKey(sender, media)].jpeg = jpeg;
+    if (!timer_.isActive()) timer_.start();
+}
+
+void DecodeScheduler::kick()
+{
+    if (!timer_.isActive()) timer_.start();
+}
+
+// 空闲槽位直接删；有任务在途的只清掉待解帧、换代号，等结果回来时再删
+QHash<QString, DecodeScheduler::Slot>::iterator DecodeScheduler::dropSlot(QHash<QString, Slot>::iterator it)
+{
+    if (!it->inFlight) return slots_.erase(it);
+    it->jpeg.clear();
+    ++it->gen;
+    return ++it;
+}
+
+void DecodeScheduler::drop(const QString& sender, const QString& media)
+{
+    auto it = slots_.find(slotKey(sender, media));
+    if (it != slots_.end()) dropSlot(it);
+}
+
+void DecodeScheduler::forget(const QString& sender)
+{
+    const QString prefix = sender + QLatin1Char('\n');
+    for (auto it = slots_.begin(); it != slots_.end(); ) {
+        if (it.key().startsWith(prefix)) it = dropSlot(it);
+        else ++it;
+    }
+}
+
+void DecodeScheduler::clear()
+{
+    for (auto it = slots_.begin(); it != slots_.end(); ) it = dropSlot(it);
+}
+
+void DecodeScheduler::onTick()
+{
+    bool pending = false;   // 还有可派发或在途的帧
+    for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+        Slot& s = it.value();
+        if (s.inFlight) { pending = true; continue; }
+        if (s.jpeg.isEmpty()) continue;
+
+        const int nl = it.key().indexOf(QLatin1Char('\n'));
+        const QSize target = target_ ? target_(it.key().left(nl), it.key().mid(nl + 1)) : QSize();
+        if (target.isEmpty()) continue;   // 不可见：保留最新帧，等 kick
+
+        s.inFlight = true;
+        pending = true;
+        const QString key = it.key();
+        const quint32 gen = s.gen;
+        QByteArray jpeg;
+        jpeg.swap(s.jpeg);
+        pool_.start(new DecodeJob(std::move(jpeg), target, [this, key, gen](QImage img) {
+            QMetaObject::invokeMethod(this, [this, key, gen, img]{ onDecoded(key, gen, img); }, Qt::QueuedConnection);
+        }));
+    }
+    if (!pending) timer_.stop();
+}
+
+void DecodeScheduler::onDecoded(const QString& key, quint32 gen, const QImage& img)
+{
+    auto it = slots_.find(key);
+    if (it == slots_.end()) return;
+    it->inFlight = false;
+    if (it->gen != gen) {
+        // 派发后被 drop：旧结果作废；期间又来了新帧就留着等下一拍
+        if (it->jpeg.isEmpty()) slots_.erase(it);
+        return;
+    }
+    if (img.isNull()) return;
+    const int nl = key.indexOf(QLatin1Char('\n'));
+    emit frameDecoded(key.left(nl), key.mid(nl + 1), img);
+}
@@ -0,0 +1,116 @@
+#include "deltacodec.h"
+#include <algorithm>
+
+namespace DeltaCodec {
+
+QByteArray encode(const QImage& prev, const QImage& curr, int block, int level)
+{
+    if (prev.size() != curr.size()) return QByteArray();
+
+    const int W = curr.width(), H = curr.height();
+    const int bw = qMax(8, block), bh = qMax(8, block);
+    const int bx = (W + bw - 1) / bw;
+    const int by = (H + bh - 1) / bh;
+
+    QVector<QRect> rects;
+    rects.reserve(bx * by / 4);
+
+    // 粗粒度：逐块比较是否有变化（memcmp 快速判定）
+    for (int gy = 0; gy < by; ++gy) {
+        for (int gx = 0; gx < bx; ++gx) {
+            int x = gx * bw;
+            int y = gy * bh;
+            int w = qMin(bw, W - x);
+            int h = qMin(bh, H - y);
+            bool diff = false;
+            for (int row = 0; row < h; ++row) {
+                const uchar* p0 = prev.constScanLine(y + row) + x * 4;
+                const uchar* p1 = curr.constScanLine(y + row) + x * 4;
+                if (memcmp(p0, p1, w * 4) != 0) { diff = true; break; }
+            }
+            if (diff) rects.push_back(QRect(x, y, w, h));
+        }
+    }
+
+    if (rects.isEmpty()) {
+        // 无变化：发一个极小的“空增量”，由接收端略过
+        QByteArray blob;
+        QDataStream ds(&blob, QIODevice::WriteOnly);
+        ds.setByteOrder(QDataStream::BigEndian);
+        ds << kMagic << (quint16)0;
+        return blob;
+    }
+
+    // 简单合并：把同一行相邻块合并成长条（降低 rect 数）
+    std::sort(rects.begin(), rects.end(), [](const QRect& a, const QRect& b){
+        if (a.y() == b.y()) return a.x() < b.x();
+        return a.y() < b.y();
+    });
+    QVector<QRect> merged;
+    for (const QRect& r : rects) {
+        if (!merged.isEmpty()) {
+            QRect& last = merged.last();
+            if (last.y() == r.y() && last.height() == r.height() && last.right()+1 >= r.x()-1) {
+                last.setRight(qMax(last.right(), r.right()));
+                continue;
+            }
+        }
+        merged.push_back(r);
+    }
+
+    if (merged.size() > kMaxRects) return QByteArray();
+
+    QByteArray blob;
+    blob.reserve(merged.size() * 128);
+    QDataStream ds(&blob, QIODevice::WriteOnly);
+    ds.setByteOrder(QDataStream::BigEndian);
+    ds << kMagic << (quint16)merged.size();
+
+    QByteArray raw;
+    for (const QRect& r : merged) {
+        // 提取原始像素（逐行拼接）
+        raw.resize(r.width() * r.height() * 4);
+        char* dst = raw.data();
+        for (int row = 0; row < r.height(); ++row) {
+            memcpy(dst, curr.constScanLine(r.y() + row) + r.x() * 4, r.width() * 4);
+            dst += r.width() * 4;
+        }
+        const QByteArray comp = qCompress(raw, level);   // 压缩等级 1..9，6 性能/比率折中
+        ds << (quint16)r.x() << (quint16)r.y() << (quint16)r.width() << (quint16)r.height();
+        ds << (quint32)comp.size();
+        ds.writeRawData(comp.constData(), comp.size());
+    }
+    return blob;
+}
+
+bool applyInto(QImage& back, const QByteArray& blob)
+{
+    QDataStream ds(blob);
+    ds.setByteOrder(QDataStream::BigEndian);
+    quint32 magic = 0; quint16 rectCount = 0;
+    ds >> magic >> rectCount;
+    if (ds.status() != QDataStream::Ok || magic != kMagic) return false;
+
+    const int W = back.width(), H = back.height();
+    for (int i = 0; i < rectCount; ++i) {
+        quint16 x=0, y=0, rw=0, rh=0; quint32 clen=0;
+        ds >> x >> y >> rw >> rh >> clen;
+        if (ds.status() != QDataStream::Ok) return false;
+        if (ds.device()->bytesAvailable() < qint64(clen)) return false;
+        QByteArray comp; comp.resize(int(clen));
+        ds.readRawData(comp.data(), int(clen));
+        // 发送端尺寸变了而背板还没跟上时，块可能落在外面
+        if (int(x) + rw > W || int(y) + rh > H) continue;
+        const QByteArray raw = qUncompress(comp);
+        if (raw.size() != int(rw) * int(rh) * 4) continue;
+
+        const char* src = raw.constData();
+        for (int row = 0; row < rh; ++row) {
+            uchar* dst = back.scanLine(y + row) + x * 4;
+            memcpy(dst, src + row * rw * 4, rw * 4);
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,248 @@
+#include "jitterbuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+const int kWindow           = 128;   // 相对时延样本数（约 2.5s）
+const int kInitialTargetMs  = 60;
+const int kMaxTargetMs      = 400;
+const int kHardDropMs       = 200;   // 超出目标这么多直接丢
+const int kCompressAfter    = 3;     // 连续这么多帧超出目标才压缩
+const int kMaxConcealFrames = 5;
+const int kMaxCngFrames     = 50;    // 发送端每 160ms 一个 CN 帧，1s 没来就当它走了
+}
+
+JitterBuffer::JitterBuffer(int frameSamples, int frameMs)
+    : frameSamples_(qMax(1, frameSamples)), frameMs_(qMax(1, frameMs))
+{
+}
+
+void JitterBuffer::reset()
+{
+    frames_.clear();
+    haveSeq_ = false;
+    maxSeq_ = nextSeq_ = 0;
+    started_ = false;
+    transit_.clear();
+    transitPos_ = 0;
+    pushesSinceTarget_ = 0;
+    haveTransit_ = false;
+    jitter_ = 0;
+    targetMs_ = kInitialTargetMs;
+    last_.clear();
+    lastDec_.clear();
+    lossRun_ = overRun_ = cngRun_ = 0;
+}
+
+void JitterBuffer::resetStats()
+{
+    received_ = late_ = missing_ = concealed_ = fec_ = compressed_ = dropped_ = 0;
+    delayN_ = 0;
+    delayMean_ = delayM2_ = 0;
+}
+
+int JitterBuffer::depthMs() const
+{
+    if (frames_.isEmpty()) return 0;
+    const qint64 first = started_ ? nextSeq_ : frames_.firstKey();
+    return int((frames_.lastKey() - first + 1) * frameMs_);
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const
+{
+    Stats s;
+    s.depthMs     = depthMs();
+    s.targetMs    = targetMs_;
+    s.jitterMs    = jitter_;
+    s.delayMeanMs = delayMean_;
+    s.delayStdMs  = delayN_ > 1 ? std::sqrt(delayM2_ / double(delayN_ - 1)) : 0.0;
+    s.received    = received_;
+    s.late        = late_;
+    s.missing     = missing_;
+    s.concealed   = concealed_;
+    s.fec         = fec_;
+    s.compressed  = compressed_;
+    s.dropped     = dropped_;
+    return s;
+}
+
+void JitterBuffer::push(quint32 seq, qint64 sendTs, const QByteArray& payload,
+                        const QSharedPointer<AudioDecoder>& dec, qint64 nowMs)
+{
+    if (payload.isEmpty() || !dec) return;
+
+    // 32 位 seq 展开成单调的 64 位
+    qint64 s = haveSeq_ ? maxSeq_ + qint32(seq - quint32(maxSeq_)) : qint64(seq);
+    if (haveSeq_ && (s < nextSeq_ - 100 || s > maxSeq_ + 500)) {
+        // 对端重启或长时间断流后 seq 跳变，重新开始
+        reset();
+        s = qint64(seq);
+    }
+    if (!haveSeq_) { haveSeq_ = true; maxSeq_ = s; nextSeq_ = s; }
+
+    ++received_;
+    if (s < nextSeq_ || frames_.contains(s)) { ++late_; return; }
+    maxSeq_ = qMax(maxSeq_, s);
+
+    Frame f;
+    f.payload = payload;
+    f.dec = dec;
+    f.sendTs = sendTs;
+    frames_.insert(s, f);
+
+    // 时延窗口 + RFC 3550 抖动；两端时钟差在做差/取相对值时抵消
+    const qint64 transit = nowMs - sendTs;
+    if (haveTransit_) {
+        const double d = std::abs(double(transit - lastTransit_));
+        jitter_ += (d - jitter_) / 16.0;
+    }
+    lastTransit_ = transit;
+    haveTransit_ = true;
+    if (transit_.size() < kWindow) transit_.push_back(transit);
+    else transit_[transitPos_] = transit;
+    transitPos_ = (transitPos_ + 1) % kWindow;
+    if (++pushesSinceTarget_ >= 8) { pushesSinceTarget_ = 0; updateTarget(); }
+}
+
+void JitterBuffer::updateTarget()
+{
+    if (transit_.size() < 16) return;
+    QVector<qint64> rel = transit_;
+    const qint64 base = *std::min_element(rel.cbegin(), rel.cend());
+    for (qint64& v : rel) v -= base;
+    const int k = (rel.size() * 95) / 100;
+    std::nth_element(rel.begin(), rel.begin() + k, rel.end());
+    targetMs_ = qBound(2 * frameMs_, int(rel[k]) + frameMs_, kMaxTargetMs);
+}
+
+void JitterBuffer::conceal(qint16* out)
+{
+    ++lossRun_;
+    if (lossRun_ > kMaxConcealFrames) {
+        std::memset(out, 0, size_t(frameSamples_) * sizeof(qint16));
+        return;
+    }
+    ++concealed_;
+    // nextSeq_ 已指向缺帧之后那一帧：它若已到，其中的 FEC 冗余可恢复缺帧
+    auto next = frames_.constFind(nextSeq_);
+    if (next != frames_.cend() && next->dec->decodeFec(next->payload, out)) {
+        ++fec_;
+    } else if (!(lastDec_ && lastDec_->conceal(out))) {
+        repeatLast(out);
+        return;
+    }
+    last_.resize(frameSamples_);
+    std::memcpy(last_.data(), out, size_t(frameSamples_) * sizeof(qint16));
+}
+
+void JitterBuffer::repeatLast(qint16* out)
+{
+    if (last_.size() != frameSamples_) {
+        std::memset(out, 0, size_t(frameSamples_) * sizeof(qint16));
+        return;
+    }
+    // 重复上一帧，增益在帧内线性下降，避免台阶
+    const float g0 = std::pow(0.7f, float(lossRun_ - 1));
+    const float g1 = std::pow(0.7f, float(lossRun_));
+    const float step = (g1 - g0) / float(frameSamples_);
+    float g = g0;
+    for (int i = 0; i < frameSamples_; ++i, g += step)
+        out[i] = qint16(last_[i] * g);
+    // 后续补帧在衰减后的基础上继续
+    std::memcpy(last_.data(), out, size_t(frameSamples_) * sizeof(qint16));
+}
+
+void JitterBuffer::noteDelay(qint64 sendTs, qint64 playoutMs)
+{
+    const double d = double(playoutMs - sendTs);
+    ++delayN_;
+    const double delta = d - delayMean_;
+    delayMean_ += delta / double(delayN_);
+    delayM2_ += delta * (d - delayMean_);
+}
+
+JitterBuffer::Result JitterBuffer::pop(qint16* out, qint64 playoutMs)
+{
+    if (!started_) {
+        if (frames_.isEmpty() || depthMs() < targetMs_) {
+            std::memset(out, 0, size_t(frameSamples_) * sizeof(qint16));
+            return Silence;
+        }
+        started_ = true;
+        nextSeq_ = frames_.firstKey();
+        lossRun_ = overRun_ = 0;
+    }
+
+    // 严重积压（如网络卡顿后一次涌入）：直接丢到目标深度
+    if (depthMs() > targetMs_ + kHardDropMs) {
+        while (!frames_.isEmpty() && depthMs() > targetMs_) {
+            if (frames_.remove(nextSeq_)) ++dropped_;
+            ++nextSeq_;
+        }
+    }
+
+    if (lastDec_ && lastDec_->isComfortNoise()) {
+        // DTX 期间：CN 帧到了就播（更新电平）；语音帧攒够目标深度再播，话头按当时抖动重新定播放点
+        auto n = frames_.constFind(nextSeq_);
+        const bool nextIsCn = n != frames_.cend() && n->dec->isComfortNoise();
+        if (!nextIsCn && (frames_.isEmpty() || depthMs() < targetMs_)) {
+            if (++cngRun_ <= kMaxCngFrames && lastDec_->conceal(out)) return Concealed;
+            lastDec_.clear();
+            started_ = false;
+            std::memset(out, 0, size_t(frameSamples_) * sizeof(qint16));
+            return Silence;
+        }
+    }
+
+    auto it = frames_.find(nextSeq_);
+    if (it == frames_.end()) {
+        if (frames_.isEmpty() && lossRun_ >= kMaxConcealFrames) {
+            // 对端不说话了：回到预缓冲，下一段话按当时的目标深度重新攒
+            started_ = false;
+            std::memset(out, 0, size_t(frameSamples_) * sizeof(qint16));
+            return Silence;
+        }
+        ++nextSeq_;
+        ++missing_;
+        conceal(out);
+        return lossRun_ <= kMaxConcealFrames ? Concealed : Silence;
+    }
+
+    Frame f = it.value();
+    frames_.erase(it);
+    ++nextSeq_;
+    if (!f.dec->decode(f.payload, out)) {
+        ++missing_;
+        conceal(out);
+        return lossRun_ <= kMaxConcealFrames ? Concealed : Silence;
+    }
+    lastDec_ = f.dec;
+    cngRun_ = 0;
+
+    overRun_ = (depthMs() > targetMs_ + frameMs_) ? overRun_ + 1 : 0;
+    auto next = frames_.find(nextSeq_);
+    if (overRun_ >= kCompressAfter && next != frames_.end()) {
+        // 两帧交叉淡化成一帧，缓冲缩短一帧时长（下一帧仍要解码，保持解码器状态连续）
+        tmp_.resize(frameSamples_);
+        if (next->dec->decode(next->payload, tmp_.data())) {
+            const qint16* b = tmp_.constData();
+            const float inv = 1.0f / float(frameSamples_);
+            for (int i = 0; i < frameSamples_; ++i) {
+                const float w = float(i) * inv;
+                out[i] = qint16(out[i] * (1.0f - w) + b[i] * w);
+            }
+            f.sendTs = next->sendTs;
+            ++compressed_;
+        }
+        frames_.erase(next);
+        ++nextSeq_;
+        overRun_ = 0;
+    }
+
+    last_.resize(frameSamples_);
+    std::memcpy(last_.data(), out, size_t(frameSamples_) * sizeof(qint16));
+    lossRun_ = 0;
+    noteDelay(f.sendTs, playoutMs);
+    return Played;
+}
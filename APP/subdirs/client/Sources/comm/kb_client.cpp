@@ -1,20 +1,7 @@
 #include "kb_client.h"
 
-QJsonObject KbClient::call(const QHostAddress& host, quint16 port, const QJsonObject& req, int msTimeout)
+void KbClient::call(const QHostAddress& host, quint16 port, const QJsonObject& req,
+                    QObject* context, Callback cb, int msTimeout)
 {
-    QTcpSocket s;
-    s.connectToHost(host, port);
-    if (!s.waitForConnected(msTimeout)) return QJsonObject{{"ok", false}, {"msg", "connect timeout"}};
-
-    QByteArray line = QJsonDocument(req).toJson(QJsonDocument::Compact) + '\n';
-    s.write(line);
-    s.flush();
-
-    if (!s.waitForReadyRead(msTimeout)) return QJsonObject{{"ok", false}, {"msg", "no reply"}};
-    QByteArray reply = s.readLine().trimmed();
-    QJsonParseError pe{};
-    auto doc = QJsonDocument::fromJson(reply, &pe);
-    if (pe.error != QJsonParseError::NoError || !doc.isObject())
-        return QJsonObject{{"ok", false}, {"msg", "bad json"}};
-    return doc.object();
+    ControlClient::shared(host.toString(), port)->call(req, context, std::move(cb), msTimeout);
 }
@@ -1,12 +1,14 @@
 #include "knowledge_panel.h"
-#include "kb_client.h"
+#include "recording_model.h"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QLineEdit>
 #include <QSpinBox>
 #include <QPushButton>
-#include <QTableWidget>
+#include <QTableView>
+#include <QComboBox>
+#include <QDateTime>
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QJsonDocument>
@@ -15,12 +17,15 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QFileInfo>
+#include <QFile>
 #include <QDir>
 #include <QProcess>
 #include <QApplication>
 #include <QSettings>
 #include <QFileDialog>
 #include <QStandardPaths>
+#include <QLabel>
+#include <QMouseEvent>
 #include <QDebug>
 
 static QString buildPanelQss(const QString& theme) {
@@ -63,9 +68,9 @@ static QString buildPanelQss(const QString& theme) {
         "#KnowledgePanelRoot QSpinBox { background:%3; color:%2; border:1px solid %4; padding:6px; border-radius:10px; }"
         "#KnowledgePanelRoot QPushButton { background:%5; color:#ffffff; border:1px solid %6; padding:6px 12px; border-radius:10px; }"
         "#KnowledgePanelRoot QPushButton:hover { background:%7; }"
-        "#KnowledgePanelRoot QTableWidget { background:%8; color:%9; gridline-color:%10; border:1px solid %10; border-radius:10px; }"
+        "#KnowledgePanelRoot QTableView { background:%8; color:%9; gridline-color:%10; border:1px solid %10; border-radius:10px; }"
         "#KnowledgePanelRoot QHeaderView::section { background:%5; color:%11; border:none; padding:6px; }"
-        "#KnowledgePanelRoot QTableWidget::item:selected { background:%12; color:%13; }";
+        "#KnowledgePanelRoot QTableView::item:selected { background:%12; color:%13; }";
 
     // 依次替换 %1..%13
     qss = qss
@@ -121,6 +126,12 @@ KnowledgePanel::KnowledgePanel(QWidget* parent)
     roomEdit_    = new QLineEdit(this);
     roomEdit_->setPlaceholderText(QStringLiteral("房间（可留空查看全部）"));
 
+    rangeCombo_  = new QComboBox(this);
+    rangeCombo_->addItem(QStringLiteral("全部时间"), 0);
+    rangeCombo_->addItem(QStringLiteral("今天"), 1);
+    rangeCombo_->addItem(QStringLiteral("近7天"), 7);
+    rangeCombo_->addItem(QStringLiteral("近30天"), 30);
+
     refreshBtn_  = new QPushButton(QStringLiteral("刷新"), this);
 
     auto* topBar = new QHBoxLayout();
@@ -129,40 +140,57 @@ KnowledgePanel::KnowledgePanel(QWidget* parent)
     topBar->addWidget(hostEdit_, 0);
     topBar->addWidget(portSpin_, 0);
     topBar->addWidget(roomEdit_, 1);
+    topBar->addWidget(rangeCombo_, 0);
     topBar->addWidget(refreshBtn_, 0);
 
-    // 表格
-    table_ = new QTableWidget(this);
-    table_->setColumnCount(8);
-    QStringList headers;
-    headers << QStringLiteral("ID")
-            << QStringLiteral("房间")
-            << QStringLiteral("用户")
-            << QStringLiteral("路径")
-            << QStringLiteral("类型")
-            << QStringLiteral("标题")
-            << QStringLiteral("开始")
-            << QStringLiteral("结束");
-    table_->setHorizontalHeaderLabels(headers);
-    table_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-    table_->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
-    table_->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-    table_->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
-    table_->horizontalHeader()->setSectionResizeMode(4, QHeaderView::ResizeToContents);
-    table_->horizontalHeader()->setSectionResizeMode(5, QHeaderView::ResizeToContents);
-    table_->horizontalHeader()->setSectionResizeMode(6, QHeaderView::ResizeToContents);
-    table_->horizontalHeader()->setSectionResizeMode(7, QHeaderView::ResizeToContents);
+    // 表格：模型分页加载，视图只绘制可见行
+    // 固定行高 + 非 ResizeToContents 列宽，滚动/插入时不遍历全部行
+    model_ = new RecordingLibraryModel(this);
+    table_ = new QTableView(this);
+    table_->setModel(model_);
+    table_->setWordWrap(false);
+    table_->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    table_->verticalHeader()->setDefaultSectionSize(28);
+    table_->verticalHeader()->hide();
+    auto* hh = table_->horizontalHeader();
+    hh->setSectionResizeMode(QHeaderView::Interactive);
+    hh->resizeSection(0, 60);
+    hh->resizeSection(1, 90);
+    hh->resizeSection(2, 100);
+    hh->setSectionResizeMode(3, QHeaderView::Stretch);
+    hh->resizeSection(4, 70);
+    hh->resizeSection(5, 160);
+    hh->resizeSection(6, 150);
+    hh->resizeSection(7, 150);
     table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->setSelectionMode(QAbstractItemView::SingleSelection);
     table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
+    // 预览条：显示所选录制的缩略图雪碧图，点击某一格从对应关键帧开始播放
+    previewLabel_ = new QLabel(this);
+    previewLabel_->setAlignment(Qt::AlignCenter);
+    previewLabel_->setMinimumHeight(120);
+    previewLabel_->setMaximumHeight(240);
+    previewLabel_->setCursor(Qt::PointingHandCursor);
+    previewLabel_->setText(QStringLiteral("选择一条录制查看预览"));
+    previewLabel_->installEventFilter(this);
+
     auto* lay = new QVBoxLayout(this);
     lay->setContentsMargins(0, 0, 0, 0);
     lay->setSpacing(0);
     lay->addLayout(topBar);
-    lay->addWidget(table_);
+    lay->addWidget(table_, 1);
+    lay->addWidget(previewLabel_, 0);
 
     connect(refreshBtn_, &QPushButton::clicked, this, &KnowledgePanel::refresh);
-    connect(table_, &QTableWidget::cellDoubleClicked, this, &KnowledgePanel::onTableDoubleClicked);
+    connect(table_, &QTableView::doubleClicked, this, &KnowledgePanel::onTableDoubleClicked);
+    connect(table_->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, [this](const QModelIndex&, const QModelIndex&){ onCurrentRowChanged(); });
+    connect(model_, &RecordingLibraryModel::loadingChanged, this, &KnowledgePanel::setBusy);
+    connect(model_, &RecordingLibraryModel::loadFailed, this, [this](const QString& msg){
+        QMessageBox::warning(this, QStringLiteral("查询失败"),
+                             QStringLiteral("get_recording_library 失败: %1").arg(msg));
+    });
 
     qInfo() << "[KB] KnowledgePanel ctor";
 }
@@ -187,86 +215,29 @@ QString KnowledgePanel::roomFilter() const { return roomEdit_->text().trimmed();
 void KnowledgePanel::setBusy(bool on)
 {
     refreshBtn_->setEnabled(!on);
+    if (on == busy_) return;
+    busy_ = on;
     if (on) QApplication::setOverrideCursor(Qt::BusyCursor);
     else    QApplication::restoreOverrideCursor();
 }
 
 void KnowledgePanel::refresh()
 {
-    setBusy(true);
-    table_->setRowCount(0);
+    clearPreview();
 
-    const QString hostStr = hostEdit_->text().trimmed();
-    const QHostAddress host(hostStr);
+    const QHostAddress host(hostEdit_->text().trimmed());
     const quint16 port = quint16(portSpin_->value());
     const QString room = roomEdit_->text().trimmed();
 
-    qInfo() << "[KB] refresh() host=" << hostStr << "port=" << port << "room=" << room;
-
-    const QJsonObject recResp = KbClient::getRecordings(host, port, room);
-    qInfo().noquote() << "[KB] recResp =" << QString::fromUtf8(QJsonDocument(recResp).toJson(QJsonDocument::Compact));
-
-    if (!recResp.value("ok").toBool()) {
-        QMessageBox::warning(this, QStringLiteral("查询失败"),
-                             QStringLiteral("get_recordings 失败: %1").arg(recResp.value("msg").toString()));
-        setBusy(false);
-        return;
-    }
-    const QJsonArray recItems = recResp.value("items").toArray();
-    qInfo() << "[KB] recordings count =" << recItems.size();
-
-    int rowsAdded = 0;
-
-    for (const auto& v : recItems) {
-        const QJsonObject rec = v.toObject();
-        const int recId = rec.value("id").toInt();
-        const QString roomId = rec.value("room_id").toString();
-        const QString title = rec.value("title").toString();
-        const QString started = rec.value("started_at").toVariant().toString();
-        const QString ended   = rec.value("ended_at").toVariant().toString();
-
-        const QJsonObject filesResp = KbClient::getRecordingFiles(host, port, recId);
-        qInfo().noquote() << "[KB] filesResp(recId=" << recId << ") ="
-                          << QString::fromUtf8(QJsonDocument(filesResp).toJson(QJsonDocument::Compact));
-
-        if (!filesResp.value("ok").toBool()) {
-            qWarning() << "[KB] getRecordingFiles failed recId=" << recId
-                       << "msg=" << filesResp.value("msg").toString();
-            continue;
-        }
-        const QJsonArray files = filesResp.value("files").toArray();
-        qInfo() << "[KB] files count for recId=" << recId << ":" << files.size();
-
-        for (const auto& fv : files) {
-            const QJsonObject f = fv.toObject();
-            const QString user  = f.value("user").toString();
-            const QString path  = f.value("file_path").toString();
-            const QString kind  = f.value("kind").toString();
-
-            const int row = table_->rowCount();
-            table_->insertRow(row);
-
-            auto put = [&](int col, const QString& text){
-                auto* it = new QTableWidgetItem(text);
-                it->setToolTip(text);
-                table_->setItem(row, col, it);
-            };
-            put(0, QString::number(recId));
-            put(1, roomId);
-            put(2, user);
-            put(3, path);
-            put(4, kind);
-            put(5, title);
-            put(6, started);
-            put(7, ended);
-
-            ++rowsAdded;
-        }
+    qint64 fromMs = 0;
+    const int days = rangeCombo_->currentData().toInt();
+    if (days > 0) {
+        const QDateTime dayStart(QDate::currentDate().addDays(1 - days), QTime(0, 0));
+        fromMs = dayStart.toMSecsSinceEpoch();
     }
 
-    qInfo() << "[KB] rows added to table =" << rowsAdded;
-    table_->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
-    setBusy(false);
+    qInfo() << "[KB] refresh() host=" << host.toString() << "port=" << port << "room=" << room << "days=" << days;
+    model_->reload(host, port, room, fromMs);
 }
 
 QString KnowledgePanel::findFfplay() const
@@ -385,7 +356,7 @@ QString KnowledgePanel::resolveAbsolutePath(const QString& relOrAbs, bool intera
     return joinWithRoot(rel);
 }
 
-void KnowledgePanel::playFile(const QString& filePath) const
+void KnowledgePanel::playFile(const QString& filePath, qint64 startMs) const
 {
     // URL 直接打开
     if (filePath.startsWith("http://") || filePath.startsWith("https://")) {
@@ -405,17 +376,110 @@ void KnowledgePanel::playFile(const QString& filePath) const
 
     const QString ffplay = findFfplay();
     if (!ffplay.isEmpty()) {
-        QProcess::startDetached(ffplay, QStringList() << "-autoexit" << "-fs" << fi.absoluteFilePath());
+        QStringList args;
+        if (startMs > 0) args << "-ss" << QString::number(startMs / 1000.0, 'f', 3);
+        args << "-autoexit" << "-fs" << fi.absoluteFilePath();
+        QProcess::startDetached(ffplay, args);
         return;
     }
     // 没有 ffplay 时退回系统默认播放器
     QDesktopServices::openUrl(QUrl::fromLocalFile(fi.absoluteFilePath()));
 }
 
-void KnowledgePanel::onTableDoubleClicked(int row, int /*col*/)
+void KnowledgePanel::onTableDoubleClicked(const QModelIndex& index)
 {
-    if (row < 0) return;
-    auto* it = table_->item(row, 3);
-    if (!it) return;
-    playFile(it->text());
+    const auto* r = model_->rowAt(index.row());
+    if (!r) return;
+    playFile(r->filePath);
+}
+
+void KnowledgePanel::onCurrentRowChanged()
+{
+    showPreviewForRow(table_->currentIndex().row());
+}
+
+void KnowledgePanel::clearPreview()
+{
+    previewVideo_.clear();
+    previewSprite_ = QImage();
+    previewIndex_ = QJsonObject();
+    previewLabel_->setPixmap(QPixmap());
+    previewLabel_->setText(QStringLiteral("选择一条录制查看预览"));
+}
+
+void KnowledgePanel::showPreviewForRow(int row)
+{
+    clearPreview();
+    const auto* r = model_->rowAt(row);
+    if (!r) return;
+
+    previewVideo_ = r->filePath;
+    const QString thumb = r->thumbPath;
+    const QString index = r->indexPath;
+    if (thumb.isEmpty() || index.isEmpty()) {
+        previewLabel_->setText(QStringLiteral("该录制没有预览（双击播放）"));
+        return;
+    }
+
+    // 预览不弹目录选择框，找不到就提示
+    QFile f(resolveAbsolutePath(index, /*interactive*/false));
+    if (f.open(QIODevice::ReadOnly)) {
+        previewIndex_ = QJsonDocument::fromJson(f.readAll()).object();
+    }
+    previewSprite_ = QImage(resolveAbsolutePath(thumb, /*interactive*/false));
+    if (previewSprite_.isNull() || previewIndex_.isEmpty()) {
+        previewLabel_->setText(QStringLiteral("预览文件不可用（双击播放）"));
+        return;
+    }
+
+    const QSize box = previewLabel_->size();
+    previewLabel_->setPixmap(QPixmap::fromImage(previewSprite_)
+                                 .scaled(box, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    previewLabel_->setToolTip(QStringLiteral("时长 %1 秒，点击缩略图从该处播放")
+                                  .arg(previewIndex_.value("duration_ms").toVariant().toLongLong() / 1000));
+}
+
+qint64 KnowledgePanel::seekTimeForPreviewPos(const QPoint& pos) const
+{
+    const QJsonObject sp = previewIndex_.value("sprite").toObject();
+    const QPixmap* pm = previewLabel_->pixmap();
+    if (sp.isEmpty() || !pm || pm->isNull()) return -1;
+
+    // 标签内居中显示，先换算到雪碧图坐标
+    const QSize shown = pm->size();
+    const QPoint origin((previewLabel_->width() - shown.width()) / 2,
+                        (previewLabel_->height() - shown.height()) / 2);
+    const QPoint local = pos - origin;
+    if (local.x() < 0 || local.y() < 0 || local.x() >= shown.width() || local.y() >= shown.height()) return -1;
+
+    const double sx = double(previewSprite_.width()) / qMax(1, shown.width());
+    const double sy = double(previewSprite_.height()) / qMax(1, shown.height());
+    const int col = int(local.x() * sx) / qMax(1, sp.value("tile_w").toInt(1));
+    const int row = int(local.y() * sy) / qMax(1, sp.value("tile_h").toInt(1));
+    const int idx = row * sp.value("cols").toInt(1) + col;
+    const QJsonArray thumbs = sp.value("thumbs").toArray();
+    if (idx < 0 || idx >= thumbs.size()) return -1;
+    const qint64 t = thumbs.at(idx).toVariant().toLongLong();
+
+    // 对齐到不晚于 t 的关键帧，ffplay -ss 直接从关键帧解码
+    qint64 seek = 0;
+    for (const auto& v : previewIndex_.value("keyframes").toArray()) {
+        const qint64 k = v.toObject().value("t_ms").toVariant().toLongLong();
+        if (k > t) break;
+        seek = k;
+    }
+    return seek;
+}
+
+bool KnowledgePanel::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == previewLabel_ && event->type() == QEvent::MouseButtonRelease) {
+        auto* me = static_cast<QMouseEvent*>(event);
+        if (me->button() == Qt::LeftButton && !previewVideo_.isEmpty()) {
+            const qint64 ms = seekTimeForPreviewPos(me->pos());
+            if (ms >= 0) playFile(previewVideo_, ms);
+        }
+        return true;
+    }
+    return QWidget::eventFilter(watched, event);
 }
@@ -14,6 +14,7 @@
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QGuiApplication>
 #include <QGridLayout>
 #include <QHBoxLayout>
 #include <QImageReader>
@@ -32,7 +33,9 @@
 #include <QPixmap>
 #include <QPushButton>
 #include <QRegExp>
+#include <QScreen>
 #include <QScrollArea>
+#include <QScrollBar>
 #include <QSet>
 #include <QStackedWidget>
 #include <QStandardPaths>
@@ -43,6 +46,7 @@
 #include <QVBoxLayout>
 #include <QVideoFrame>
 #include <QVideoProbe>
+#include <QWindow>
 #include <QColorDialog>
 #include <QtMath>
 #include <cmath>
@@ -52,9 +56,11 @@
 #include "knowledge_tab_helper.h"
 #include "annot.h"
 #include "annotcanvas.h"
+#include "deltacodec.h"
 #include "protocol.h"
 #include "udpmedia.h"
 #include "volume_popup.h"
+#include "yuvconvert.h"
 
 // ---------------------------- 小部件与帮助函数（聊天预览） ----------------------------
 
@@ -105,17 +111,6 @@ private:
     QImage full_;
 };
 
-// 将图像按控件尺寸等比例缩放后设置
-static void fitLabelImage(QLabel* lbl, const QImage& img) {
-    if (!lbl) return;
-    if (img.isNull()) { lbl->clear(); return; }
-    const QSize s = lbl->size();
-    if (s.width() < 2 || s.height() < 2) return;
-    QPixmap pm = QPixmap::fromImage(img).scaled(s, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    lbl->setPixmap(pm);
-    lbl->setText(QString());
-}
-
 static VideoTile* makeTile(QWidget* parent, const QString& nameText) {
     auto* box = new QWidget(parent);
     auto* v = new QVBoxLayout(box);
@@ -284,57 +279,6 @@ static void chatAddFile(const QString& sender, const QString& filename, const QS
 
 // ---------------------------- MainWindow 逻辑 ----------------------------
 
-QImage MainWindow::composeTileImage(const VideoTile* t, const QSize& target)
-{
-    if (!t || !target.isValid() || target.width()<2 || target.height()<2) return QImage();
-
-    const bool hasCam    = !t->lastCam.isNull();
-    const bool hasScreen = !t->lastScreen.isNull();
-
-    QImage bg(target, QImage::Format_RGB32);
-    bg.fill(Qt::black);
-
-    QPainter p(&bg);
-    p.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform, true);
-
-    auto drawFit = [&](const QImage& img, const QRect& rect){
-        if (img.isNull() || rect.isEmpty()) return;
-        QSize fitted = img.size();
-        fitted.scale(rect.size(), Qt::KeepAspectRatio);
-        QPoint topLeft(rect.x() + (rect.width()-fitted.width())/2,
-                       rect.y() + (rect.height()-fitted.height())/2);
-        p.drawImage(QRect(topLeft, fitted), img);
-    };
-
-    if (!hasCam && !hasScreen) { p.end(); return QImage(); }
-    if (hasCam && !hasScreen)  { drawFit(t->lastCam,   QRect(QPoint(0,0), target)); p.end(); return bg; }
-    if (!hasCam && hasScreen)  { drawFit(t->lastScreen, QRect(QPoint(0,0), target)); p.end(); return bg; }
-
-    // PiP
-    const QImage& bigImg   = t->camPrimary ? t->lastCam   : t->lastScreen;
-    const QImage& smallImg = t->camPrimary ? t->lastScreen : t->lastCam;
-
-    drawFit(bigImg, QRect(QPoint(0,0), target));
-
-    const int margin = 8;
-    int smallW = qMax(80, target.width() * 28 / 100);
-    int smallH = smallW * smallImg.height() / qMax(1, smallImg.width());
-    if (smallH > target.height() * 40 / 100) {
-        smallH = target.height() * 40 / 100;
-        smallW = smallH * smallImg.width() / qMax(1, smallImg.height());
-    }
-    QRect smallRect(target.width() - margin - smallW, margin, smallW, smallH);
-
-    QColor panel(0,0,0,160);
-    p.fillRect(smallRect.adjusted(-2,-2,2,2), panel);
-    p.setPen(QPen(Qt::white, 2));
-    p.drawRect(smallRect);
-    drawFit(smallImg, smallRect);
-
-    p.end();
-    return bg;
-}
-
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
@@ -414,6 +358,10 @@ MainWindow::MainWindow(QWidget *parent)
     focusThumbLayout_->setContentsMargins(4,4,4,4);
     focusThumbLayout_->setSpacing(6);
     scroll->setWidget(focusThumbContainer_);
+    // 滚进视野的缩略图才解码，滚动后让解码调度重新检查
+    connect(scroll->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]{
+        if (decoder_) decoder_->kick();
+    });
 
     focusHLay->addWidget(mainArea_, /*stretch*/3);
     focusHLay->addWidget(scroll,    /*stretch*/1);
@@ -426,6 +374,13 @@ MainWindow::MainWindow(QWidget *parent)
     btnCamera_ = new QPushButton("开启摄像头");
     btnMic_    = new QPushButton("开启麦克风");
     btnShare_  = new QPushButton("开启共享屏幕");
+    btnFollowSpeaker_ = new QPushButton(QStringLiteral("跟随发言人"));
+    btnFollowSpeaker_->setCheckable(true);
+    btnFollowSpeaker_->setToolTip(QStringLiteral("主画面自动切到正在讲话的人"));
+    btnVoiceProc_ = new QPushButton(QStringLiteral("回声消除"));
+    btnVoiceProc_->setCheckable(true);
+    btnVoiceProc_->setChecked(true);
+    btnVoiceProc_->setToolTip(QStringLiteral("回声消除 + 降噪 + 自动增益；外放有回声、有噪声时保持开启，关闭即原声直通"));
 
     cbShareQ_  = new QComboBox(this);
     cbShareQ_->addItem(QStringLiteral("流畅 (848x480 @8fps q50)"));
@@ -438,6 +393,8 @@ MainWindow::MainWindow(QWidget *parent)
     rowBtn->addWidget(btnCamera_);
     rowBtn->addWidget(btnMic_);
     rowBtn->addWidget(btnShare_);
+    rowBtn->addWidget(btnFollowSpeaker_);
+    rowBtn->addWidget(btnVoiceProc_);
     rowBtn->addSpacing(12);
     rowBtn->addWidget(new QLabel(QStringLiteral("共享画质:")));
     rowBtn->addWidget(cbShareQ_);
@@ -582,6 +539,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(&conn_, &ClientConn::packetArrived, audio_, &AudioChat::onPacket);
 
     udp_ = new UdpMediaClient(this);
+    audio_->setUdpClient(udp_);
 
     share_ = new ScreenShare(&conn_, this);
     share_->setUdpClient(udp_);
@@ -601,9 +559,16 @@ MainWindow::MainWindow(QWidget *parent)
     connect(&conn_,    &ClientConn::packetArrived, this, &MainWindow::onPkt);
     connect(&conn_,    &ClientConn::disconnected, this, [this]{
         btnLeave_->setEnabled(false);
+        inRoom_ = false;
         // 用户不需要日志，这里不输出
     });
 
+    connect(btnVoiceProc_, &QPushButton::toggled, this, [this](bool on){
+        VoiceProcessor::Config cfg;
+        cfg.aec = cfg.ns = cfg.agc = on;
+        audio_->setVoiceProcessing(cfg);
+    });
+
     connect(btnMic_, &QPushButton::clicked, this, [this]{
         bool on = !audio_->isEnabled();
         audio_->setEnabled(on);
@@ -648,30 +613,7 @@ MainWindow::MainWindow(QWidget *parent)
                 back.fill(Qt::black);
             }
 
-            // 解析 DS01
-            QDataStream ds(blob);
-            ds.setByteOrder(QDataStream::BigEndian);
-            quint32 magic=0; quint16 rectCount=0;
-            ds >> magic >> rectCount;
-            if (magic != 0x44533031) return; // 'DS01'
-
-            for (int i = 0; i < rectCount; ++i) {
-                quint16 x=0,y=0,rw=0,rh=0; quint32 clen=0;
-                ds >> x >> y >> rw >> rh >> clen;
-                if (ds.status()!=QDataStream::Ok) return;
-                if (int(ds.device()->bytesAvailable()) < int(clen)) return;
-                QByteArray comp; comp.resize(int(clen));
-                ds.readRawData(comp.data(), clen);
-                QByteArray raw = qUncompress(comp);
-                if (raw.size() != int(rw) * int(rh) * 4) continue;
-
-                // 写回到背板
-                const char* src = raw.constData();
-                for (int row = 0; row < rh; ++row) {
-                    uchar* dst = back.scanLine(y + row) + x * 4;
-                    memcpy(dst, src + row * rw * 4, rw * 4);
-                }
-            }
+            if (!DeltaCodec::applyInto(back, blob)) return;
 
             // 显示更新
             t->lastScreen = back;
@@ -682,6 +624,37 @@ MainWindow::MainWindow(QWidget *parent)
 
     lastSend_.start();
 
+    // 摄像头 JPEG 在编码线程完成，GUI 线程只负责发出
+    camEncoder_ = new CameraEncoder(this);
+    camEncoder_->setBaseQuality(jpegQuality_);
+    camEncoder_->setFrameBudgetMs(1000 / qMax(1, targetFps_));
+    connect(camEncoder_, &CameraEncoder::encoded, this,
+            [this](QByteArray jpeg, QJsonObject meta, QSize wh) {
+        if (!camera_) return;   // 编码期间摄像头已关
+        meta["w"] = wh.width();
+        meta["h"] = wh.height();
+        camRate_->onFrameQueued(jpeg.size(), meta.value("layer").toInt());
+        conn_.send(MSG_VIDEO_FRAME, meta, jpeg);
+    });
+
+    // 摄像头码率按上行实际情况调整；接收端回报丢帧
+    camRate_ = new CamRateController(&conn_, this);
+    connect(camRate_, &CamRateController::rungChanged, this, &MainWindow::applyCameraRung);
+    camRx_ = new CamRxReporter(&conn_, this);
+
+    // 远端帧按显示节拍、只对可见画面、按显示尺寸解码
+    decoder_ = new DecodeScheduler([this](const QString& sender, const QString& media) {
+        return decodeTargetFor(sender, media);
+    }, this);
+    decoder_->setIntervalMs(previewIntervalMs());
+    connect(decoder_, &DecodeScheduler::frameDecoded, this, &MainWindow::onRemoteFrameDecoded);
+
+    // 画面布局变化后合并一次，按各远端画面大小向服务器订阅层级
+    layerPrefTimer_ = new QTimer(this);
+    layerPrefTimer_->setSingleShot(true);
+    layerPrefTimer_->setInterval(300);
+    connect(layerPrefTimer_, &QTimer::timeout, this, &MainWindow::sendLayerPrefs);
+
     // 初始共享画质参数
     applyShareQualityPreset();
 
@@ -751,20 +724,20 @@ MainWindow::MainWindow(QWidget *parent)
     });
 
     // 画布事件 -> 本地应用 + 网络广播
-    connect(annotCanvas_, &AnnotCanvas::annotateEvent, this, [this](QJsonObject ev){
+    connect(annotCanvas_, &AnnotCanvas::annotateEvent, this, [this](QJsonObject ev, const QByteArray& bin){
         if (mainKey_.isEmpty()) return;
         ev["roomId"] = edRoom->text();
         ev["sender"] = edUser->text();
 
         if (auto* m = modelFor(ev.value("target").toString())) {
-            m->applyEvent(ev);
+            m->applyEvent(ev, bin);
         }
 
         QJsonObject evNet = ev;
         if (evNet.value("target").toString() == kLocalKey_) {
             evNet["target"] = edUser->text();
         }
-        conn_.send(MSG_ANNOT, evNet);
+        conn_.send(MSG_ANNOT, evNet, bin);
 
         // 刷新
         updateMainFitted();
@@ -854,8 +827,14 @@ void MainWindow::onJoin()
     audio_->setIdentity(edRoom->text(), edUser->text());
     share_->setIdentity(edRoom->text(), edUser->text());
     udp_->setIdentity(edRoom->text(), edUser->text());
+    camRx_->setIdentity(edRoom->text(), edUser->text());
+    // 服务器换房间后清空了订阅与需求层
+    layerPrefsSent_.clear();
+    camLayers_ = {0};
+    scheduleLayerPrefs();
 
     btnLeave_->setEnabled(true);
+    inRoom_ = true;
     applyShareQualityPreset();
 }
 
@@ -891,6 +870,8 @@ void MainWindow::onLeave()
         btnAnnotOn_->setChecked(false);
     }
 
+    applyActiveSpeakers(QStringList());
+
     // 清空本地预览
     localTile_.lastCam = QImage();
     localTile_.lastScreen = QImage();
@@ -904,6 +885,7 @@ void MainWindow::onLeave()
     conn_.disconnectFromServer();
 
     btnLeave_->setEnabled(false);
+    inRoom_ = false;
 }
 
 /* ---------- 聊天发送 ---------- */
@@ -1009,14 +991,14 @@ void MainWindow::onSendFile()
 }
 
 /* ---------- 自适应/协议处理 ---------- */
-void MainWindow::applyAdaptiveByMembers(int members)
+// 采集分辨率固定为最高档，换档只改转换尺寸/节流/质量，不重启摄像头
+void MainWindow::applyCameraRung(const CamRateController::Rung& r)
 {
-    if (members <= 2) { sendSize_ = QSize(640,480); targetFps_ = 12; jpegQuality_ = 60; }
-    else if (members <= 4) { sendSize_ = QSize(480,360); targetFps_ = 10; jpegQuality_ = 55; }
-    else { sendSize_ = QSize(320,240); targetFps_ = 8;  jpegQuality_ = 50; }
-
-    if (camera_) configureCamera(camera_);
-    applyShareQualityPreset();
+    sendSize_ = r.size;
+    targetFps_ = r.fps;
+    jpegQuality_ = r.quality;
+    camEncoder_->setBaseQuality(jpegQuality_);
+    camEncoder_->setFrameBudgetMs(1000 / qMax(1, targetFps_));
 }
 
 void MainWindow::onPkt(Packet p)
@@ -1053,22 +1035,12 @@ void MainWindow::onPkt(Packet p)
         const QString sender = p.json.value("sender").toString();
         if (sender.isEmpty() || sender == edUser->text()) break;
 
+        if (p.json.value("media").toString("camera") == "camera") camRx_->onFrame(sender, p.json);
         VideoTile* t = ensureRemoteTile(sender);
+        kickRemoteAlive(t);
 
-        QBuffer buf(const_cast<QByteArray*>(&p.bin));
-        buf.open(QIODevice::ReadOnly);
-        QImageReader reader(&buf);
-        reader.setAutoTransform(true);
-        QImage img = reader.read();
-
-        const QString media = p.json.value("media").toString("camera");
-        if (!img.isNull()) {
-            if (media == "screen") t->lastScreen = img;
-            else                    t->lastCam    = img;
-            kickRemoteAlive(t);
-            refreshTilePixmap(t);
-            if (mainKey_ == sender) updateMainFromTile(t);
-        }
+        // 不在这里解码：交给调度器，只保留最新一帧
+        decoder_->submit(sender, p.json.value("media").toString("camera"), p.bin);
         break;
     }
 
@@ -1077,14 +1049,21 @@ void MainWindow::onPkt(Packet p)
         const QString kind  = p.json.value("kind").toString();
         const QString state = p.json.value("state").toString();
         const QString sender = p.json.value("sender").toString();
+        if (kind == "rx_report") {
+            // 只关心别人对自己摄像头的回报
+            if (camera_ && p.json.value("to").toString() == edUser->text())
+                camRate_->onRxReport(p.json.value("recv").toInt(), p.json.value("lost").toInt());
+            break;
+        }
+        if (kind == "audio_caps") break;   // 语音编码协商，AudioChat 自己处理
         if (!sender.isEmpty() && sender != edUser->text()) {
             VideoTile* t = ensureRemoteTile(sender);
             if (kind == "视频" || kind == "video") {
-                if (state == "off") t->lastCam = QImage();
+                if (state == "off") { t->lastCam = QImage(); decoder_->drop(sender, "camera"); }
                 refreshTilePixmap(t);
                 if (mainKey_ == sender) updateMainFromTile(t);
             } else if (kind == "screen") {
-                if (state == "off") t->lastScreen = QImage();
+                if (state == "off") { t->lastScreen = QImage(); decoder_->drop(sender, "screen"); }
                 refreshTilePixmap(t);
                 if (mainKey_ == sender) updateMainFromTile(t);
             }
@@ -1095,6 +1074,19 @@ void MainWindow::onPkt(Packet p)
     case MSG_SERVER_EVENT:
     {
         const QString kind = p.json.value("kind").toString();
+        if (kind == "layers") {
+            camLayers_.clear();
+            for (auto v : p.json.value("layers").toArray()) camLayers_ << v.toInt();
+            if (!camLayers_.contains(0)) camLayers_ << 0;
+            break;
+        }
+        if (kind == "active_speaker") {
+            if (p.json.value("roomId").toString() != edRoom->text()) break;
+            QStringList speakers;
+            for (auto v : p.json.value("speakers").toArray()) speakers << v.toString();
+            applyActiveSpeakers(speakers);
+            break;
+        }
         if (kind == "room") {
             QStringList members;
             for (auto v : p.json.value("members").toArray())
@@ -1120,7 +1112,9 @@ void MainWindow::onPkt(Packet p)
                 }
             }
 
-            applyAdaptiveByMembers(members.size());
+            camRate_->setMemberCount(members.size());
+            if (audio_) audio_->setRoomMembers(members);
+            applyShareQualityPreset();
 
             if (currentMode() == ViewMode::Grid) refreshGridOnly();
             else refreshFocusThumbs();
@@ -1138,7 +1132,7 @@ void MainWindow::onPkt(Packet p)
         if (target.isEmpty()) break;
 
         if (auto* m = modelFor(target)) {
-            if (m->applyEvent(p.json)) {
+            if (m->applyEvent(p.json, p.bin)) {
                 if (mainKey_ == target) {
                     updateMainFitted();
                 }
@@ -1178,6 +1172,10 @@ void MainWindow::onPkt(Packet p)
         break;
     }
 
+    case MSG_ECHO:
+        camRate_->onEcho(p.json);
+        break;
+
     default:
         break;
     }
@@ -1201,6 +1199,7 @@ void MainWindow::startCamera()
     }
 
     camera_->start();
+    camRate_->start();
 
     btnCamera_->setText("关闭摄像头");
 
@@ -1217,6 +1216,7 @@ void MainWindow::stopCamera()
     if (!camera_) return;
 
     camera_->stop();
+    camRate_->stop();
 
     if (probe_) {
         probe_->setSource(static_cast<QMediaObject*>(nullptr));
@@ -1269,7 +1269,7 @@ void MainWindow::onToggleShare()
 
 void MainWindow::configureCamera(QCamera* cam)
 {
-    QSize desiredRes = sendSize_;
+    QSize desiredRes = CamRateController::captureSize();
     QList<QSize> resList = cam->supportedViewfinderResolutions();
     if (!resList.isEmpty()) {
         if (!resList.contains(desiredRes)) {
@@ -1285,14 +1285,18 @@ void MainWindow::configureCamera(QCamera* cam)
     QList<QVideoFrame::PixelFormat> fmts =
         cam->supportedViewfinderPixelFormats(QCameraViewfinderSettings());
 
+    // 摄像头原生 YUV 优先：转换与缩放由 YuvConvert 一次完成，省掉驱动侧的 RGB 转换
     auto prefer = QList<QVideoFrame::PixelFormat>{
+        QVideoFrame::Format_NV12,
+        QVideoFrame::Format_YUYV,
+        QVideoFrame::Format_YUV420P,
+        QVideoFrame::Format_UYVY,
         QVideoFrame::Format_ARGB32,
         QVideoFrame::Format_ARGB32_Premultiplied,
         QVideoFrame::Format_RGB32,
         QVideoFrame::Format_RGB24,
         QVideoFrame::Format_BGR32,
-        QVideoFrame::Format_BGR24,
-        QVideoFrame::Format_YUYV
+        QVideoFrame::Format_BGR24
     };
 
     QVideoFrame::PixelFormat chosenFmt = QVideoFrame::Format_Invalid;
@@ -1313,62 +1317,38 @@ void MainWindow::configureCamera(QCamera* cam)
 }
 
 /* ---------- 帧处理 ---------- */
-QImage MainWindow::makeImageFromFrame(const QVideoFrame &frame)
+// 本地预览只需显示尺寸：缩略图，本地在主画面时取两者较大者；不放大
+QSize MainWindow::localPreviewSize(const QSize& frameSize) const
 {
-    if (!frame.isValid()) return QImage();
-
-    QVideoFrame clone(frame);
-    if (!clone.map(QAbstractVideoBuffer::ReadOnly)) {
-        return QImage();
-    }
+    QSize box = localTile_.video ? localTile_.video->size() : QSize();
+    if (mainKey_ == kLocalKey_ && mainVideo_) box = box.expandedTo(mainVideo_->size());
+    if (box.isEmpty() || box.width() >= frameSize.width() || box.height() >= frameSize.height())
+        return frameSize;
+    return YuvConvert::fitSize(frameSize, box);
+}
 
-    const auto fmt = clone.pixelFormat();
-    const QImage::Format imf = QVideoFrame::imageFormatFromPixelFormat(fmt);
-    if (imf != QImage::Format_Invalid) {
-        QImage img(clone.bits(), clone.width(), clone.height(), clone.bytesPerLine(), imf);
-        QImage copy = img.copy();
-        clone.unmap();
-        return copy;
-    }
+// 窗口最小化或本地画面不在任何可见位置时不做预览转换
+bool MainWindow::localPreviewVisible() const
+{
+    if (!isVisible() || isMinimized()) return false;
+    if (localTile_.video && localTile_.video->isVisible()) return true;
+    return mainKey_ == kLocalKey_ && mainVideo_ && mainVideo_->isVisible();
+}
 
-    if (fmt == QVideoFrame::Format_YUYV) {
-        const uchar *base = clone.bits();
-        const int width = clone.width();
-        const int height = clone.height();
-        const int stride = clone.bytesPerLine();
-
-        QImage out(width, height, QImage::Format_RGB32);
-        auto clip = [](int v){ return v < 0 ? 0 : (v > 255 ? 255 : v); };
-
-        for (int y = 0; y < height; ++y) {
-            const uchar* line = base + y * stride;
-            QRgb* dst = reinterpret_cast<QRgb*>(out.scanLine(y));
-            for (int x = 0; x < width; x += 2) {
-                const int i = x << 1;
-                int y0 = line[i + 0] - 16;
-                int u  = line[i + 1] - 128;
-                int y1 = line[i + 2] - 16;
-                int v  = line[i + 3] - 128;
-
-                int r0 = clip((298 * y0 + 409 * v + 128) >> 8);
-                int g0 = clip((298 * y0 - 100 * u - 208 * v + 128) >> 8);
-                int b0 = clip((298 * y0 + 516 * u + 128) >> 8);
-
-                int r1 = clip((298 * y1 + 409 * v + 128) >> 8);
-                int g1 = clip((298 * y1 - 100 * u - 208 * v + 128) >> 8);
-                int b1 = clip((298 * y1 + 516 * u + 128) >> 8);
-
-                dst[x]     = qRgb(r0, g0, b0);
-                if (x + 1 < width)
-                    dst[x + 1] = qRgb(r1, g1, b1);
-            }
-        }
-        clone.unmap();
-        return out;
-    }
+int MainWindow::previewIntervalMs() const
+{
+    const QWindow* w = windowHandle();
+    const QScreen* sc = w ? w->screen() : QGuiApplication::primaryScreen();
+    const qreal hz = sc ? sc->refreshRate() : 60.0;
+    return qMax(1, qRound(1000.0 / qBound<qreal>(10.0, hz, 240.0)));
+}
 
-    clone.unmap();
-    return QImage();
+// 本地画面在主画面时每帧都显示；只是缩略图时 15fps 足够，30fps 摄像头隔帧转换
+int MainWindow::localPreviewIntervalMs() const
+{
+    static const int kThumbPreviewFps = 15;
+    if (mainKey_ == kLocalKey_) return previewIntervalMs();
+    return qMax(previewIntervalMs(), 1000 / kThumbPreviewFps);
 }
 
 void MainWindow::updateLocalPreview(const QImage& img)
@@ -1387,46 +1367,83 @@ void MainWindow::onLocalScreenFrame(QImage img)
     if (mainKey_ == kLocalKey_) updateMainFromTile(&localTile_);
 }
 
-void MainWindow::sendImage(const QImage& img)
+// 分层尺寸：0 层为当前档位尺寸；1/2 层分别不超过 320x240 / 160x120，
+// 只在有人订阅且确实比上一层小时产出
+QVector<QSize> MainWindow::cameraLayerSizes(const QSize& full) const
 {
-    if (img.isNull()) return;
-
-    const qint64 intervalMs = 1000 / qMax(1, targetFps_);
-    if (lastSend_.isValid() && lastSend_.elapsed() < intervalMs)
-        return;
-    lastSend_.restart();
-
-    const QImage scaled = img.scaled(sendSize_, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-    QByteArray jpeg;
-    QBuffer buffer(&jpeg);
-    buffer.open(QIODevice::WriteOnly);
-    QImageWriter writer(&buffer, "jpeg");
-    writer.setQuality(jpegQuality_);
-    writer.setOptimizedWrite(true);
-    if (!writer.write(scaled)) {
-        return;
+    static const QSize kLayerCap[] = { QSize(), QSize(320, 240), QSize(160, 120) };
+    QVector<QSize> sizes(3);
+    sizes[0] = YuvConvert::fitSize(full, sendSize_);
+    QSize prev = sizes[0];
+    for (int l = 1; l < sizes.size(); ++l) {
+        if (!camLayers_.contains(l)) continue;
+        const QSize s = YuvConvert::fitSize(full, kLayerCap[l].boundedTo(sendSize_));
+        if (s.width() < prev.width()) { sizes[l] = s; prev = s; }
     }
-    buffer.close();
+    return sizes;
+}
+
+void MainWindow::sendCameraLayers(const QVector<QImage>& layers)
+{
+    if (layers.isEmpty() || layers.first().isNull()) return;
 
     QJsonObject j{{"roomId", edRoom->text()},
                   {"sender", edUser->text()},
                   {"media",  "camera"},
-                  {"w", scaled.width()},
-                  {"h", scaled.height()},
                   {"ts", QDateTime::currentMSecsSinceEpoch()}};
-    conn_.send(MSG_VIDEO_FRAME, j, jpeg);
+    camEncoder_->submit(layers, j);
 }
 
 void MainWindow::onVideoFrame(const QVideoFrame &frame)
 {
     if (!camera_ || !frame.isValid()) return;
 
-    QImage img = makeImageFromFrame(frame);
+    // 先定这一帧的用途：入会后才发送，按 targetFps_ 节流；预览按显示位置节流；都不需要就不 map 不转换
+    // 节流留 1/4 帧余量：摄像头帧间隔有抖动，卡整数毫秒会把 30fps 节流成 15fps
+    auto due = [](const QElapsedTimer& t, int intervalMs) {
+        return !t.isValid() || t.elapsed() >= intervalMs - intervalMs / 4;
+    };
+    const bool wantSend = inRoom_ && conn_.isConnected() && due(lastSend_, 1000 / qMax(1, targetFps_));
+    const bool wantPreview = localPreviewVisible() && due(lastPreview_, localPreviewIntervalMs());
+    if (!wantSend && !wantPreview) return;
+    if (wantSend) lastSend_.restart();
+    if (wantPreview) lastPreview_.restart();
+
+    // 一次 map 只产出需要的尺寸，不生成原尺寸 RGB 中间图
+    QVideoFrame clone(frame);
+    if (clone.map(QAbstractVideoBuffer::ReadOnly)) {
+        YuvConvert::FrameView view;
+        if (YuvConvert::viewFromMappedFrame(clone, &view)) {
+            const QSize full(view.width, view.height);
+            // 前 3 个为各发送层（不发送时为空尺寸），最后一个为预览
+            QVector<QSize> sizes = wantSend ? cameraLayerSizes(full) : QVector<QSize>(3);
+            sizes << (wantPreview ? localPreviewSize(full) : QSize());
+            QVector<QImage> outs(sizes.size());
+            YuvConvert::convertScaled(view, sizes.constData(), outs.data(), sizes.size());
+            clone.unmap();
+
+            if (wantPreview) updateLocalPreview(outs.takeLast());
+            else outs.removeLast();
+            if (wantSend) sendCameraLayers(outs);
+            return;
+        }
+        clone.unmap();
+    }
+
+    // 其它像素格式走原先的整帧转换
+    QImage img = YuvConvert::frameToImage(frame);
     if (img.isNull()) return;
 
-    updateLocalPreview(img);
-    sendImage(img);
+    if (wantPreview) updateLocalPreview(img);
+    if (wantSend) {
+        const QVector<QSize> sizes = cameraLayerSizes(img.size());
+        QVector<QImage> layers(sizes.size());
+        for (int l = 0; l < sizes.size(); ++l) {
+            if (!sizes[l].isEmpty())
+                layers[l] = img.scaled(sizes[l], Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        sendCameraLayers(layers);
+    }
 }
 
 /* ---------- 视图/缩略图 ---------- */
@@ -1475,6 +1492,9 @@ void MainWindow::removeRemoteTile(const QString& sender)
     remoteTiles_.erase(it);
 
     if (audio_) audio_->dropPeer(sender);
+    compositor_.forget(t->video);
+    camRx_->forget(sender);
+    decoder_->forget(sender);
 
     if (currentMode() == ViewMode::Grid) refreshGridOnly();
     else refreshFocusThumbs();
@@ -1612,23 +1632,96 @@ void MainWindow::setMainKey(const QString& key)
     annotCanvas_->setEnabledDrawing(btnAnnotOn_->isChecked() && !mainKey_.isEmpty());
 }
 
+// 发言者名字标绿；打开“跟随发言人”时主画面切到主讲人（标注中不切，免得画到别人画面上）
+void MainWindow::applyActiveSpeakers(const QStringList& speakers)
+{
+    activeSpeakers_ = speakers;
+    auto mark = [](VideoTile* t, bool on) {
+        if (t && t->name) t->name->setStyleSheet(on ? "font-weight:bold; color:#2e7d32;" : "font-weight:bold;");
+    };
+    mark(&localTile_, speakers.contains(edUser->text()));
+    for (auto it = remoteTiles_.begin(); it != remoteTiles_.end(); ++it)
+        mark(it.value(), speakers.contains(it.key()));
+
+    if (!btnFollowSpeaker_->isChecked() || btnAnnotOn_->isChecked() || speakers.isEmpty()) return;
+    const QString dominant = speakers.first();
+    if (dominant == edUser->text() || dominant == mainKey_) return;
+    if (remoteTiles_.contains(dominant)) setMainKey(dominant);
+}
+
 void MainWindow::updateMainFromTile(VideoTile* t)
 {
     if (!t) return;
-    QImage composed = composeTileImage(t, mainVideo_->size());
-    if (composed.isNull()) {
+    if (t->lastCam.isNull() && t->lastScreen.isNull()) {
+        compositor_.forget(mainVideo_);
         mainVideo_->clear();
         mainVideo_->setText(QStringLiteral("等待视频/屏幕..."));
         return;
     }
-    fitLabelImage(mainVideo_, composed);
     // 主画面上的标注由 annotCanvas_ 叠加绘制
+    compositor_.render(mainVideo_, t->lastCam, t->lastScreen, t->camPrimary, nullptr);
 }
 
 void MainWindow::updateAllThumbFitted()
 {
     refreshTilePixmap(&localTile_);
     for (auto* t : remoteTiles_) refreshTilePixmap(t);
+    scheduleLayerPrefs();
+    if (decoder_) decoder_->kick();
+}
+
+// 解码目标尺寸：焦点模式下的主画面取主画面尺寸，其余取缩略图；看不见的返回空
+QSize MainWindow::decodeTargetFor(const QString& sender, const QString& /*media*/) const
+{
+    if (!isVisible() || isMinimized()) return QSize();
+    VideoTile* t = remoteTiles_.value(sender, nullptr);
+    if (!t) return QSize();
+
+    const QLabel* view = nullptr;
+    if (currentMode() == ViewMode::Focus && mainKey_ == sender) view = mainVideo_;
+    else if (t->video->isVisible() && !t->video->visibleRegion().isEmpty()) view = t->video;
+    if (!view) return QSize();
+    return view->size() * view->devicePixelRatioF();
+}
+
+void MainWindow::onRemoteFrameDecoded(const QString& sender, const QString& media, const QImage& img)
+{
+    auto it = remoteTiles_.find(sender);
+    if (it == remoteTiles_.end()) return;
+    VideoTile* t = it.value();
+    if (media == "screen") t->lastScreen = img;
+    else                   t->lastCam    = img;
+    refreshTilePixmap(t);
+    if (mainKey_ == sender) updateMainFromTile(t);
+}
+
+void MainWindow::scheduleLayerPrefs()
+{
+    if (layerPrefTimer_) layerPrefTimer_->start();
+}
+
+// 按显示宽度（物理像素）选层：>320 取 0 层，>160 取 1 层，否则 2 层
+void MainWindow::sendLayerPrefs()
+{
+    if (!conn_.isConnected() || edRoom->text().isEmpty()) return;
+
+    const bool focus = currentMode() == ViewMode::Focus;
+    const qreal dpr = devicePixelRatioF();
+    QHash<QString, int> prefs;
+    for (auto it = remoteTiles_.begin(); it != remoteTiles_.end(); ++it) {
+        VideoTile* t = it.value();
+        const QLabel* view = (focus && mainKey_ == it.key()) ? mainVideo_ : t->video;
+        const int w = qRound(view->width() * dpr);
+        prefs.insert(it.key(), w > 320 ? 0 : (w > 160 ? 1 : 2));
+    }
+    if (prefs == layerPrefsSent_) return;
+    layerPrefsSent_ = prefs;
+
+    QJsonObject obj;
+    for (auto it = prefs.begin(); it != prefs.end(); ++it) obj.insert(it.key(), it.value());
+    conn_.send(MSG_VIDEO_LAYER, QJsonObject{{"roomId", edRoom->text()},
+                                            {"sender", edUser->text()},
+                                            {"prefs", obj}});
 }
 
 void MainWindow::updateMainFitted()
@@ -1647,8 +1740,8 @@ void MainWindow::updateMainFitted()
 void MainWindow::refreshTilePixmap(VideoTile* t)
 {
     if (!t || !t->video) return;
-    QImage composed = composeTileImage(t, t->video->size());
-    if (composed.isNull()) {
+    if (t->lastCam.isNull() && t->lastScreen.isNull()) {
+        compositor_.forget(t->video);
         t->video->clear();
         t->video->setText(QStringLiteral("等待视频/屏幕..."));
         return;
@@ -1656,15 +1749,8 @@ void MainWindow::refreshTilePixmap(VideoTile* t)
 
     // 缩略图上叠加标注（主画面由 AnnotCanvas 绘制叠加）
     const bool isMain = (centerStack_->currentWidget() == focusPage_ && mainKey_ == t->key);
-    if (!isMain) {
-        if (auto* m = annotModels_.value(t->key, nullptr)) {
-            QPainter p(&composed);
-            m->paint(p, composed.size());
-            p.end();
-        }
-    }
-
-    fitLabelImage(t->video, composed);
+    const AnnotModel* overlay = isMain ? nullptr : annotModels_.value(t->key, nullptr);
+    compositor_.render(t->video, t->lastCam, t->lastScreen, t->camPrimary, overlay);
 }
 
 void MainWindow::togglePiP(VideoTile* t)
@@ -0,0 +1,252 @@
+#include "ratecontrol.h"
+
+namespace {
+// 由低到高；名义码率由像素数 × 帧率 × 质量对应的字节/像素估算，再乘实测复杂度修正
+const CamRateController::Rung kLadder[] = {
+    { QSize(320, 240),  5, 45 },
+    { QSize(320, 240),  8, 50 },
+    { QSize(480, 360),  8, 50 },
+    { QSize(480, 360), 10, 55 },
+    { QSize(640, 480), 10, 55 },
+    { QSize(640, 480), 12, 60 },
+    { QSize(640, 480), 15, 65 },
+};
+const int kRungCount = int(sizeof(kLadder) / sizeof(kLadder[0]));
+
+const int    kTickMs         = 250;
+const int    kDecideMs       = 1000;
+const int    kEchoMs         = 1000;
+const int    kUpCooldownMs   = 3000;   // 降档后/升档后至少稳定这么久才再升
+const int    kRttSlackMs     = 300;    // 超出基线 RTT 视为排队
+const int    kMinRttWindowMs = 30000;  // 基线 RTT 定期重测，适应换网
+const double kMinKbps        = 100;
+const double kMaxKbps        = 4000;
+const double kDecrease       = 0.8;
+const double kIncrease       = 1.08;
+const double kLossHigh       = 0.05;
+const double kLossLow        = 0.02;
+const qint64 kBacklogIdle    = 16 * 1024;
+
+double nominalBytes(const CamRateController::Rung& r)
+{
+    const double bpp = 0.03 + 0.002 * (r.quality - 40);   // JPEG 字节/像素的经验值
+    return r.size.width() * r.size.height() * bpp;
+}
+}
+
+CamRateController::CamRateController(ClientConn* conn, QObject* parent)
+    : QObject(parent), conn_(conn)
+{
+    maxRung_ = kRungCount - 1;
+    timer_.setInterval(kTickMs);
+    connect(&timer_, &QTimer::timeout, this, &CamRateController::onTick);
+    clock_.start();
+}
+
+QSize CamRateController::captureSize()
+{
+    return kLadder[kRungCount - 1].size;
+}
+
+void CamRateController::start()
+{
+    const qint64 now = clock_.elapsed();
+    // 从中档起步，空闲时逐档爬升；4G 现场不至于一上来就塞满上行
+    rung_ = qMin(maxRung_, 3);
+    targetKbps_ = rungKbps(rung_);
+    windowStartMs_ = now;
+    windowBytes_ = 0;
+    windowBase_ = 0;
+    sendKbps_ = 0;
+    lastBacklog_ = conn_ ? conn_->bytesToWrite() : 0;
+    growTicks_ = 0;
+    srttMs_ = minRttMs_ = -1;
+    minRttResetMs_ = now;
+    lastEchoMs_ = 0;
+    lossRatio_ = 0;
+    lastDecreaseMs_ = lastDecideMs_ = now;
+    lastRungChangeMs_ = now;
+    timer_.start();
+    emit rungChanged(kLadder[rung_]);
+}
+
+void CamRateController::stop()
+{
+    timer_.stop();
+}
+
+void CamRateController::setMemberCount(int n)
+{
+    maxRung_ = n <= 2 ? kRungCount - 1 : (n <= 4 ? 3 : 1);
+    if (rung_ > maxRung_) {
+        setRung(maxRung_, clock_.elapsed());
+        targetKbps_ = qMin(targetKbps_, rungKbps(maxRung_) * 1.25);
+    } else if (!isRunning()) {
+        rung_ = qMin(rung_, maxRung_);
+    }
+}
+
+const CamRateController::Rung& CamRateController::current() const
+{
+    return kLadder[rung_];
+}
+
+double CamRateController::rungKbps(int idx) const
+{
+    const Rung& r = kLadder[idx];
+    return nominalBytes(r) * complexity_ * layerFactor_ * r.fps * 8.0 / 1000.0;
+}
+
+void CamRateController::onFrameQueued(int bytes, int layer)
+{
+    windowBytes_ += bytes;
+    if (layer != 0) return;
+    windowBase_ += bytes;
+    const double ratio = bytes / qMax(1.0, nominalBytes(kLadder[rung_]));
+    complexity_ += 0.1 * (qBound(0.25, ratio, 4.0) - complexity_);
+}
+
+void CamRateController::onEcho(const QJsonObject& json)
+{
+    if (json.value("kind").toString() != "rtt") return;
+    const qint64 sent = qint64(json.value("ts").toDouble());
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (sent <= 0 || now < sent) return;
+    const int rtt = int(now - sent);
+    srttMs_ = srttMs_ < 0 ? rtt : (srttMs_ * 7 + rtt) / 8;
+    if (minRttMs_ < 0 || rtt < minRttMs_) minRttMs_ = rtt;
+}
+
+void CamRateController::onRxReport(int recv, int lost)
+{
+    const int total = recv + lost;
+    if (total < 5) return;   // 样本太少不作数
+    lossRatio_ = qMax(lossRatio_, double(lost) / total);
+}
+
+void CamRateController::onTick()
+{
+    if (!conn_ || !conn_->isConnected()) return;
+    const qint64 now = clock_.elapsed();
+
+    // 发送速率（应用层写入速率）
+    if (now - windowStartMs_ >= kDecideMs) {
+        const double kbps = windowBytes_ * 8.0 / qMax<qint64>(1, now - windowStartMs_);
+        sendKbps_ = sendKbps_ <= 0 ? kbps : sendKbps_ * 0.5 + kbps * 0.5;
+        if (windowBase_ > 0)
+            layerFactor_ += 0.3 * (qBound(1.0, double(windowBytes_) / windowBase_, 2.0) - layerFactor_);
+        windowStartMs_ = now;
+        windowBytes_ = 0;
+        windowBase_ = 0;
+    }
+
+    // 积压：连续增长或超过半秒的目标码率都算拥塞
+    const qint64 backlog = conn_->bytesToWrite();
+    growTicks_ = (backlog > lastBacklog_ && backlog > kBacklogIdle) ? growTicks_ + 1 : 0;
+    lastBacklog_ = backlog;
+    const double backlogMs = backlog * 8.0 / qMax(kMinKbps, targetKbps_);
+
+    if (now - lastEchoMs_ >= kEchoMs) {
+        lastEchoMs_ = now;
+        conn_->send(MSG_ECHO, QJsonObject{{"kind", "rtt"}, {"ts", QDateTime::currentMSecsSinceEpoch()}});
+    }
+    if (now - minRttResetMs_ >= kMinRttWindowMs) {
+        minRttResetMs_ = now;
+        minRttMs_ = srttMs_;
+    }
+
+    const bool rttHigh = srttMs_ >= 0 && minRttMs_ >= 0 && srttMs_ > minRttMs_ + kRttSlackMs;
+    const bool congested = growTicks_ >= 4 || backlogMs > 500 || rttHigh || lossRatio_ > kLossHigh;
+
+    // 拥塞立即处理（降档后留一个决策周期让积压回落），否则每秒决策一次
+    if (congested ? now - lastDecreaseMs_ >= kDecideMs : now - lastDecideMs_ >= kDecideMs)
+        decide(now, congested);
+}
+
+void CamRateController::decide(qint64 now, bool congested)
+{
+    lastDecideMs_ = now;
+    const qint64 backlog = lastBacklog_;
+
+    if (congested) {
+        const double base = sendKbps_ > 0 ? qMin(targetKbps_, sendKbps_) : targetKbps_;
+        targetKbps_ = qMax(kMinKbps, base * kDecrease);
+        lastDecreaseMs_ = now;
+    } else if (backlog < kBacklogIdle && lossRatio_ < kLossLow && now - lastDecreaseMs_ >= kUpCooldownMs) {
+        targetKbps_ = qMin(kMaxKbps, targetKbps_ * kIncrease + 10);
+    }
+    // 受应用层上限约束：已在最高档时目标码率不无限增长
+    targetKbps_ = qMin(targetKbps_, rungKbps(maxRung_) * 1.25);
+    lossRatio_ = 0;
+
+    int fit = 0;
+    for (int i = maxRung_; i > 0; --i) {
+        if (rungKbps(i) <= targetKbps_) { fit = i; break; }
+    }
+    if (fit < rung_) {
+        setRung(fit, now);
+    } else if (fit > rung_ && now - lastRungChangeMs_ >= kUpCooldownMs) {
+        setRung(rung_ + 1, now);   // 升档一次一级
+    }
+}
+
+void CamRateController::setRung(int idx, qint64 now)
+{
+    idx = qBound(0, idx, maxRung_);
+    if (idx == rung_) return;
+    rung_ = idx;
+    lastRungChangeMs_ = now;
+    const Rung& r = kLadder[rung_];
+    qInfo() << "[cam-rate] rung" << rung_ << r.size << r.fps << "fps q" << r.quality
+            << "target" << int(targetKbps_) << "kbps send" << int(sendKbps_)
+            << "srtt" << srttMs_ << "backlog" << lastBacklog_;
+    emit rungChanged(r);
+}
+
+/* ---------- CamRxReporter ---------- */
+CamRxReporter::CamRxReporter(ClientConn* conn, QObject* parent)
+    : QObject(parent), conn_(conn)
+{
+    timer_.setInterval(2000);
+    connect(&timer_, &QTimer::timeout, this, &CamRxReporter::flush);
+    timer_.start();
+}
+
+void CamRxReporter::setIdentity(const QString& roomId, const QString& user)
+{
+    if (roomId != roomId_) stats_.clear();
+    roomId_ = roomId;
+    user_ = user;
+}
+
+void CamRxReporter::onFrame(const QString& sender, const QJsonObject& json)
+{
+    if (!json.contains("seq")) return;   // 老版本发送端
+    const qint64 seq = qint64(json.value("seq").toDouble());
+    const int layer = json.value("layer").toInt(0);
+    Stat& s = stats_[sender];
+    if (s.layer != layer) { s.layer = layer; s.lastSeq = -1; }
+    // seq 回退说明对端重开了摄像头，从新 seq 接着计
+    if (s.lastSeq >= 0 && seq > s.lastSeq) s.lost += int(qMin<qint64>(seq - s.lastSeq - 1, 1000));
+    s.lastSeq = seq;
+    ++s.recv;
+}
+
+void CamRxReporter::flush()
+{
+    if (!conn_ || !conn_->isConnected() || roomId_.isEmpty()) return;
+    for (auto it = stats_.begin(); it != stats_.end(); ++it) {
+        Stat& s = it.value();
+        if (s.recv + s.lost == 0) continue;
+        QJsonObject j{{"roomId", roomId_},
+                      {"sender", user_},
+                      {"kind",   "rx_report"},
+                      {"to",     it.key()},
+                      {"media",  "camera"},
+                      {"recv",   s.recv},
+                      {"lost",   s.lost},
+                      {"ts",     QDateTime::currentMSecsSinceEpoch()}};
+        conn_->send(MSG_CONTROL, j);
+        s.recv = s.lost = 0;
+    }
+}
@@ -0,0 +1,168 @@
+#include "recording_model.h"
+#include "kb_client.h"
+
+#include <QJsonArray>
+#include <QDateTime>
+
+namespace {
+const int kPageSize = 100;
+enum Column { ColId, ColRoom, ColUser, ColPath, ColKind, ColTitle, ColStart, ColEnd, ColCount };
+}
+
+RecordingLibraryModel::RecordingLibraryModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void RecordingLibraryModel::reload(const QHostAddress& host, quint16 port, const QString& roomId,
+                                   qint64 fromMs, qint64 toMs)
+{
+    ++gen_;
+    beginResetModel();
+    rows_.clear();
+    endResetModel();
+
+    host_ = host;
+    port_ = port;
+    roomId_ = roomId;
+    fromMs_ = fromMs;
+    toMs_ = toMs;
+    afterRecId_ = 0;
+    afterFileId_ = 0;
+    hasMore_ = false;
+    loading_ = false;
+    requestPage();
+}
+
+const RecordingLibraryModel::Row* RecordingLibraryModel::rowAt(int row) const
+{
+    if (row < 0 || row >= rows_.size()) return nullptr;
+    return &rows_.at(row);
+}
+
+int RecordingLibraryModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : rows_.size();
+}
+
+int RecordingLibraryModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColCount;
+}
+
+QVariant RecordingLibraryModel::data(const QModelIndex& index, int role) const
+{
+    const Row* r = rowAt(index.row());
+    if (!r) return QVariant();
+
+    if (role == Qt::DisplayRole || role == Qt::ToolTipRole) {
+        switch (index.column()) {
+        case ColId:    return QString::number(r->recordingId);
+        case ColRoom:  return r->roomId;
+        case ColUser:  return r->user;
+        case ColPath:  return r->filePath;
+        case ColKind:  return r->kind;
+        case ColTitle: return r->title;
+        case ColStart: return r->started;
+        case ColEnd:   return r->ended;
+        default: break;
+        }
+    } else if (role == ThumbPathRole) {
+        return r->thumbPath;
+    } else if (role == IndexPathRole) {
+        return r->indexPath;
+    }
+    return QVariant();
+}
+
+QVariant RecordingLibraryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+    switch (section) {
+    case ColId:    return QStringLiteral("ID");
+    case ColRoom:  return QStringLiteral("房间");
+    case ColUser:  return QStringLiteral("用户");
+    case ColPath:  return QStringLiteral("路径");
+    case ColKind:  return QStringLiteral("类型");
+    case ColTitle: return QStringLiteral("标题");
+    case ColStart: return QStringLiteral("开始");
+    case ColEnd:   return QStringLiteral("结束");
+    default: return QVariant();
+    }
+}
+
+bool RecordingLibraryModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && hasMore_ && !loading_;
+}
+
+void RecordingLibraryModel::fetchMore(const QModelIndex& parent)
+{
+    if (!canFetchMore(parent)) return;
+    requestPage();
+}
+
+void RecordingLibraryModel::setLoading(bool on)
+{
+    if (loading_ == on) return;
+    loading_ = on;
+    emit loadingChanged(on);
+}
+
+QString RecordingLibraryModel::formatTime(const QJsonValue& v)
+{
+    const qint64 ms = v.toVariant().toLongLong();
+    if (ms <= 0) return QString();
+    return QDateTime::fromMSecsSinceEpoch(ms).toString(QStringLiteral("yyyy-MM-dd HH:mm:ss"));
+}
+
+void RecordingLibraryModel::requestPage()
+{
+    QJsonObject req{{"action", "get_recording_library"}, {"limit", kPageSize}};
+    if (!roomId_.isEmpty()) req["room_id"] = roomId_;
+    if (fromMs_ > 0) req["from_ms"] = double(fromMs_);
+    if (toMs_ > 0) req["to_ms"] = double(toMs_);
+    if (afterRecId_ > 0) {
+        req["after_rec_id"] = afterRecId_;
+        req["after_file_id"] = afterFileId_;
+    }
+
+    setLoading(true);
+    const int gen = gen_;
+    KbClient::call(host_, port_, req, this, [this, gen](const QJsonObject& rep){
+        if (gen != gen_) return;
+        setLoading(false);
+        if (!rep.value("ok").toBool()) {
+            hasMore_ = false;
+            emit loadFailed(rep.value("msg").toString());
+            return;
+        }
+
+        const QJsonArray arr = rep.value("rows").toArray();
+        hasMore_ = rep.value("has_more").toBool() && !arr.isEmpty();
+        afterRecId_ = rep.value("next_after_rec_id").toInt();
+        afterFileId_ = rep.value("next_after_file_id").toInt();
+        if (arr.isEmpty()) return;
+
+        const int first = rows_.size();
+        beginInsertRows(QModelIndex(), first, first + arr.size() - 1);
+        rows_.reserve(first + arr.size());
+        for (const QJsonValue& v : arr) {
+            const QJsonObject o = v.toObject();
+            Row r;
+            r.recordingId = o.value("recording_id").toInt();
+            r.roomId      = o.value("room_id").toString();
+            r.user        = o.value("user").toString();
+            r.filePath    = o.value("file_path").toString();
+            r.kind        = o.value("kind").toString();
+            r.title       = o.value("title").toString();
+            r.started     = formatTime(o.value("started_at"));
+            r.ended       = formatTime(o.value("ended_at"));
+            r.thumbPath   = o.value("thumb_path").toString();
+            r.indexPath   = o.value("index_path").toString();
+            rows_.push_back(r);
+        }
+        endInsertRows();
+    });
+}
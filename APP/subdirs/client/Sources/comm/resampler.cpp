@@ -0,0 +1,149 @@
+#include "resampler.h"
+#include <cmath>
+#include <cstring>
+
+Resampler::Resampler(int inRate, int outRate)
+    : inRate_(inRate), outRate_(outRate)
+{
+    setRates(inRate, outRate);
+}
+
+void Resampler::setRates(int inRate, int outRate)
+{
+    inRate_  = qMax(1, inRate);
+    outRate_ = qMax(1, outRate);
+    step_ = double(inRate_) / double(outRate_);
+    taps_ = outRate_ < inRate_ ? qMax(1, qRound(step_)) : 1;
+    reset();
+}
+
+void Resampler::reset()
+{
+    pos_ = 0.0;
+    prev_ = 0;
+    hist_.fill(0, taps_ - 1);
+    histSum_ = 0;
+}
+
+void Resampler::process(const qint16* in, int n, QVector<qint16>& out)
+{
+    if (n <= 0) return;
+    if (isPassthrough()) {
+        const int base = out.size();
+        out.resize(base + n);
+        std::memcpy(out.data() + base, in, size_t(n) * sizeof(qint16));
+        return;
+    }
+
+    const qint16* src = in;
+    if (taps_ > 1) {
+        // 滑动平均：y[i] = (x[i-taps+1] + ... + x[i]) / taps
+        filtered_.resize(n);
+        const int h = taps_ - 1;
+        for (int i = 0; i < n; ++i) {
+            const int oldest = i < h ? hist_[i] : in[i - h];
+            histSum_ += in[i];
+            filtered_[i] = qint16(histSum_ / taps_);
+            histSum_ -= oldest;
+        }
+        // 保留本块最后 taps-1 个原始样本
+        if (n >= h) {
+            std::memcpy(hist_.data(), in + n - h, size_t(h) * sizeof(qint16));
+        } else {
+            hist_.remove(0, n);
+            for (int i = 0; i < n; ++i) hist_.push_back(in[i]);
+        }
+        src = filtered_.constData();
+    }
+
+    out.reserve(out.size() + int(n / step_) + 2);
+    while (pos_ < double(n - 1)) {
+        const int i0 = int(std::floor(pos_));
+        const double frac = pos_ - i0;
+        const int s0 = i0 < 0 ? prev_ : src[i0];
+        const int s1 = src[i0 + 1];
+        out.push_back(qint16(s0 + (s1 - s0) * frac));
+        pos_ += step_;
+    }
+    pos_ -= n;
+    prev_ = src[n - 1];
+}
+
+namespace AudioFormatConv {
+
+bool isSupported(const QAudioFormat& f)
+{
+    if (f.channelCount() < 1 || f.sampleRate() <= 0) return false;
+    if (f.sampleSize() > 8 && f.byteOrder() != QAudioFormat::LittleEndian) return false;
+    return (f.sampleType() == QAudioFormat::SignedInt   && f.sampleSize() == 16)
+        || (f.sampleType() == QAudioFormat::Float       && f.sampleSize() == 32)
+        || (f.sampleType() == QAudioFormat::UnSignedInt && f.sampleSize() == 8);
+}
+
+int bytesPerMs(const QAudioFormat& f)
+{
+    return qMax(1, f.sampleRate() * f.channelCount() * (f.sampleSize() / 8) / 1000);
+}
+
+void toMono16(const QByteArray& raw, const QAudioFormat& f, QVector<qint16>& out)
+{
+    const int ch = qMax(1, f.channelCount());
+    const int frameBytes = ch * (f.sampleSize() / 8);
+    const int frames = frameBytes > 0 ? raw.size() / frameBytes : 0;
+    out.resize(frames);
+    if (frames == 0) return;
+
+    if (f.sampleSize() == 16) {
+        const qint16* s = reinterpret_cast<const qint16*>(raw.constData());
+        if (ch == 1) { std::memcpy(out.data(), s, size_t(frames) * sizeof(qint16)); return; }
+        for (int i = 0; i < frames; ++i, s += ch) {
+            int acc = 0;
+            for (int c = 0; c < ch; ++c) acc += s[c];
+            out[i] = qint16(acc / ch);
+        }
+    } else if (f.sampleSize() == 32) {
+        const float* s = reinterpret_cast<const float*>(raw.constData());
+        for (int i = 0; i < frames; ++i, s += ch) {
+            float acc = 0.0f;
+            for (int c = 0; c < ch; ++c) acc += s[c];
+            out[i] = qint16(qBound(-32768.0f, acc / ch * 32767.0f, 32767.0f));
+        }
+    } else {
+        const uchar* s = reinterpret_cast<const uchar*>(raw.constData());
+        for (int i = 0; i < frames; ++i, s += ch) {
+            int acc = 0;
+            for (int c = 0; c < ch; ++c) acc += int(s[c]) - 128;
+            out[i] = qint16((acc / ch) * 256);
+        }
+    }
+}
+
+QByteArray fromMono16(const qint16* s, int n, const QAudioFormat& f)
+{
+    const int ch = qMax(1, f.channelCount());
+    QByteArray raw;
+    if (f.sampleSize() == 16) {
+        raw.resize(n * ch * 2);
+        qint16* d = reinterpret_cast<qint16*>(raw.data());
+        if (ch == 1) { std::memcpy(d, s, size_t(n) * sizeof(qint16)); return raw; }
+        for (int i = 0; i < n; ++i)
+            for (int c = 0; c < ch; ++c) *d++ = s[i];
+    } else if (f.sampleSize() == 32) {
+        raw.resize(n * ch * 4);
+        float* d = reinterpret_cast<float*>(raw.data());
+        for (int i = 0; i < n; ++i) {
+            const float v = s[i] / 32768.0f;
+            for (int c = 0; c < ch; ++c) *d++ = v;
+        }
+    } else {
+        raw.resize(n * ch);
+        uchar* d = reinterpret_cast<uchar*>(raw.data());
+        for (int i = 0; i < n; ++i) {
+            const uchar v = uchar((s[i] >> 8) + 128);
+            for (int c = 0; c < ch; ++c) *d++ = v;
+        }
+    }
+    return raw;
+}
+
+}
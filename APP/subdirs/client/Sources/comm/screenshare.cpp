@@ -1,5 +1,6 @@
 #include "screenshare.h"
 #include "udpmedia.h"
+#include "deltacodec.h"
 
 ScreenShare::ScreenShare(ClientConn* conn, QObject* parent)
     : QObject(parent), conn_(conn)
@@ -93,7 +94,7 @@ void ScreenShare::onTick() {
 
     if (!needKey && !prevFrame_.isNull()) {
         // 尝试增量帧：按块比较，生成 DS01 blob
-        QByteArray blob = buildDeltaBlob(prevFrame_, img, /*block*/32);
+        QByteArray blob = DeltaCodec::encode(prevFrame_, img, /*block*/32);
         if (!blob.isEmpty() && udp_) {
             udp_->sendScreenDelta(blob, img.width(), img.height(), now);
             prevFrame_ = img;
@@ -122,89 +123,3 @@ void ScreenShare::onEncodedKeyframe(QByteArray jpeg, QSize wh, qint64 /*encodeMs
         lastKeyMs_ = now;
     }
 }
-
-// DS01 blob：BigEndian
-// u32 magic='DS01', u16 rectCount,
-// [rectLoop] u16 x, u16 y, u16 w, u16 h, u32 compLen, [compData...]
-// compData 是 QImage::Format_RGB32 的原始像素区域逐行拼接后 qCompress 得到
-QByteArray ScreenShare::buildDeltaBlob(const QImage& prev, const QImage& curr, int block) const
-{
-    if (prev.size() != curr.size()) return QByteArray();
-
-    const int W = curr.width(), H = curr.height();
-    const int bw = qMax(8, block), bh = qMax(8, block);
-    const int bx = (W + bw - 1) / bw;
-    const int by = (H + bh - 1) / bh;
-
-    QVector<QRect> rects;
-    rects.reserve(bx * by / 4);
-
-    // 粗粒度：逐块比较是否有变化（memcmp 快速判定）
-    for (int gy = 0; gy < by; ++gy) {
-        for (int gx = 0; gx < bx; ++gx) {
-            int x = gx * bw;
-            int y = gy * bh;
-            int w = qMin(bw, W - x);
-            int h = qMin(bh, H - y);
-            bool diff = false;
-            for (int row = 0; row < h; ++row) {
-                const uchar* p0 = prev.constScanLine(y + row) + x * 4;
-                const uchar* p1 = curr.constScanLine(y + row) + x * 4;
-                if (memcmp(p0, p1, w * 4) != 0) { diff = true; break; }
-            }
-            if (diff) rects.push_back(QRect(x, y, w, h));
-        }
-    }
-
-    if (rects.isEmpty()) {
-        // 无变化：发一个极小的“空增量”，由接收端略过
-        QByteArray blob;
-        QDataStream ds(&blob, QIODevice::WriteOnly);
-        ds.setByteOrder(QDataStream::BigEndian);
-        ds << (quint32)0x44533031 /*'DS01'*/ << (quint16)0;
-        return blob;
-    }
-
-    // 简单合并：把同一行相邻块合并成长条（降低 rect 数）
-    std::sort(rects.begin(), rects.end(), [](const QRect& a, const QRect& b){
-        if (a.y() == b.y()) return a.x() < b.x();
-        return a.y() < b.y();
-    });
-    QVector<QRect> merged;
-    for (const QRect& r : rects) {
-        if (!merged.isEmpty()) {
-            QRect& last = merged.last();
-            if (last.y() == r.y() && last.height() == r.height() && last.right()+1 >= r.x()-1) {
-                last.setRight(qMax(last.right(), r.right()));
-                continue;
-            }
-        }
-        merged.push_back(r);
-    }
-
-    // 限制最大 rect 数量，超出则返回空（触发关键帧）
-    const int maxRects = 120;
-    if (merged.size() > maxRects) return QByteArray();
-
-    // 打包 DS01
-    QByteArray blob;
-    blob.reserve(merged.size() * 128);
-    QDataStream ds(&blob, QIODevice::WriteOnly);
-    ds.setByteOrder(QDataStream::BigEndian);
-    ds << (quint32)0x44533031 /*'DS01'*/ << (quint16)merged.size();
-
-    for (const QRect& r : merged) {
-        // 提取原始像素（逐行拼接）
-        QByteArray raw;
-        raw.reserve(r.width() * r.height() * 4);
-        for (int row = 0; row < r.height(); ++row) {
-            const uchar* src = curr.constScanLine(r.y() + row) + r.x() * 4;
-            raw.append(reinterpret_cast<const char*>(src), r.width() * 4);
-        }
-        QByteArray comp = qCompress(raw, 6); // 压缩等级 1..9，6 性能/比率折中
-        ds << (quint16)r.x() << (quint16)r.y() << (quint16)r.width() << (quint16)r.height();
-        ds << (quint32)comp.size();
-        ds.writeRawData(comp.constData(), comp.size());
-    }
-    return blob;
-}
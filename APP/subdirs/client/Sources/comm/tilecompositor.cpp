@@ -0,0 +1,118 @@
+#include "tilecompositor.h"
+#include "annot.h"
+
+#include <QLabel>
+
+namespace {
+QRect fitRect(const QSize& src, const QRect& box)
+{
+    QSize s = src;
+    s.scale(box.size(), Qt::KeepAspectRatio);
+    return QRect(QPoint(box.x() + (box.width() - s.width()) / 2,
+                        box.y() + (box.height() - s.height()) / 2), s);
+}
+
+// label 当前显示的 pixmap 的 cacheKey，没有时为 0；5.15 起返回指针的 pixmap() 已废弃
+qint64 shownPixmapKey(const QLabel* label)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    return label->pixmap(Qt::ReturnByValue).cacheKey();
+#else
+    const QPixmap* pm = label->pixmap();
+    return pm ? pm->cacheKey() : 0;
+#endif
+}
+}
+
+const QImage& TileCompositor::scaledSource(Scaled& cache, const QImage& src, const QSize& size)
+{
+    if (cache.key == src.cacheKey() && cache.size == size) return cache.img;
+    cache.key = src.cacheKey();
+    cache.size = size;
+    cache.img = (src.size() == size) ? src
+              : src.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    // 统一成 RGB32，后面贴到画布是直接拷贝
+    if (cache.img.format() != QImage::Format_RGB32)
+        cache.img = cache.img.convertToFormat(QImage::Format_RGB32);
+    return cache.img;
+}
+
+bool TileCompositor::render(QLabel* label, const QImage& cam, const QImage& screen,
+                            bool camPrimary, const AnnotModel* overlay)
+{
+    if (!label) return false;
+    const bool hasCam = !cam.isNull();
+    const bool hasScreen = !screen.isNull();
+    if (!hasCam && !hasScreen) { forget(label); return false; }
+
+    const qreal dpr = label->devicePixelRatioF();
+    const QSize target = label->contentsRect().size() * dpr;
+    if (target.width() < 2 || target.height() < 2) return false;
+
+    const bool pip = hasCam && hasScreen;
+    const QImage& bigImg = pip ? (camPrimary ? cam : screen) : (hasCam ? cam : screen);
+    const QImage* smallImg = pip ? (camPrimary ? &screen : &cam) : nullptr;
+    const quint64 annotRev = overlay ? overlay->revision() : 0;
+
+    Surface& s = surfaces_[label];
+    const bool pixmapCurrent = s.pixmapKey != 0 && shownPixmapKey(label) == s.pixmapKey;
+    if (pixmapCurrent && s.canvas.size() == target
+        && s.big.key == bigImg.cacheKey() && (smallImg ? smallImg->cacheKey() : 0) == s.small.key
+        && s.annotModel == overlay && s.annotRev == annotRev) {
+        return true;
+    }
+
+    if (s.canvas.size() != target) s.canvas = QImage(target, QImage::Format_RGB32);
+    if (!smallImg) s.small = Scaled();
+
+    const QRect full(QPoint(0, 0), target);
+    const QRect bigRect = fitRect(bigImg.size(), full);
+    const QImage& big = scaledSource(s.big, bigImg, bigRect.size());
+
+    QPainter p(&s.canvas);
+    // 只填黑边，画面区域直接被覆盖
+    if (bigRect.top() > 0)             p.fillRect(0, 0, target.width(), bigRect.top(), Qt::black);
+    if (bigRect.bottom() < full.bottom()) p.fillRect(0, bigRect.bottom() + 1, target.width(), full.bottom() - bigRect.bottom(), Qt::black);
+    if (bigRect.left() > 0)            p.fillRect(0, bigRect.top(), bigRect.left(), bigRect.height(), Qt::black);
+    if (bigRect.right() < full.right()) p.fillRect(bigRect.right() + 1, bigRect.top(), full.right() - bigRect.right(), bigRect.height(), Qt::black);
+    p.drawImage(bigRect.topLeft(), big);
+
+    // PiP：右上角小窗
+    if (smallImg) {
+        const int margin = qRound(8 * dpr);
+        int smallW = qMax(qRound(80 * dpr), target.width() * 28 / 100);
+        int smallH = smallW * smallImg->height() / qMax(1, smallImg->width());
+        if (smallH > target.height() * 40 / 100) {
+            smallH = target.height() * 40 / 100;
+            smallW = smallH * smallImg->width() / qMax(1, smallImg->height());
+        }
+        const QRect smallRect(target.width() - margin - smallW, margin, smallW, smallH);
+        p.fillRect(smallRect.adjusted(-2, -2, 2, 2), QColor(0, 0, 0, 160));
+        p.setPen(QPen(Qt::white, 2));
+        p.drawRect(smallRect);
+        const QRect inner = fitRect(smallImg->size(), smallRect);
+        if (!inner.isEmpty()) p.drawImage(inner.topLeft(), scaledSource(s.small, *smallImg, inner.size()));
+    }
+
+    // 标注层：内容或尺寸变了才重画
+    if (overlay) {
+        if (s.annot.size() != target || s.annotModel != overlay || s.annotRev != annotRev) {
+            if (s.annot.size() != target) s.annot = QImage(target, QImage::Format_ARGB32_Premultiplied);
+            s.annot.fill(Qt::transparent);
+            QPainter ap(&s.annot);
+            overlay->paint(ap, target);
+        }
+        p.drawImage(0, 0, s.annot);
+    } else {
+        s.annot = QImage();
+    }
+    s.annotModel = overlay;
+    s.annotRev = annotRev;
+    p.end();
+
+    QPixmap pm = QPixmap::fromImage(s.canvas);
+    pm.setDevicePixelRatio(dpr);
+    s.pixmapKey = pm.cacheKey();
+    label->setPixmap(pm);
+    return true;
+}
@@ -13,6 +13,7 @@ UdpMediaClient::UdpMediaClient(QObject* parent) : QObject(parent)
 void UdpMediaClient::configureServer(const QString& host, quint16 port) {
     serverAddr_ = QHostAddress(host);
     serverPort_ = port;
+    setUdpOk(false);
     if (sock_.state() != QAbstractSocket::BoundState) {
         sock_.bind(QHostAddress::AnyIPv4, 0, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
     }
@@ -31,6 +32,14 @@ void UdpMediaClient::stop() {
     heartbeat_.stop();
     cleanup_.stop();
     reassem_.clear();
+    setUdpOk(false);
+}
+
+void UdpMediaClient::setUdpOk(bool ok) {
+    if (udpOk_ == ok) return;
+    udpOk_ = ok;
+    qInfo() << "[udp] audio path" << (ok ? "up" : "down");
+    emit udpStateChanged(ok);
 }
 
 void UdpMediaClient::sendRegister() {
@@ -66,6 +75,37 @@ QByteArray UdpMediaClient::buildVideoChunk(const QString& roomId, const QString&
     return d;
 }
 
+QByteArray UdpMediaClient::buildAudio(const QString& roomId, const QString& sender,
+                                      quint32 seq, qint64 ts, quint8 codec, int sr,
+                                      const QByteArray& payload, quint16 levelBits) {
+    QByteArray d;
+    d.reserve(48 + (roomId.size() + sender.size()) * 2 + payload.size());
+    QDataStream ds(&d, QIODevice::WriteOnly);
+    ds.setByteOrder(QDataStream::BigEndian);
+    ds << (quint32)kMagic << (quint8)2 /*ver*/ << (quint8)3 /*type*/ << levelBits;
+    ds << roomId << sender;
+    ds << (quint32)seq << (quint64)ts;
+    ds << (quint8)codec << (quint16)sr;
+    ds << (quint16)payload.size();
+    ds.writeRawData(payload.constData(), payload.size());
+    return d;
+}
+
+bool UdpMediaClient::sendAudio(const QString& codec, int sr, quint32 seq, qint64 tsMs, const QByteArray& payload,
+                               int level, bool voiced) {
+    if (!udpOk_ || serverPort_ == 0 || roomId_.isEmpty() || user_.isEmpty()) return false;
+    if (payload.isEmpty() || payload.size() > kChunkPayload) return false;
+    quint8 id = AudioMulaw;
+    if (codec == QLatin1String("opus"))       id = AudioOpus;
+    else if (codec == QLatin1String("pcm16")) id = AudioPcm16;
+    else if (codec == QLatin1String("cn"))    id = AudioCn;
+    else if (codec != QLatin1String("mulaw")) return false;
+    quint16 levelBits = 0;
+    if (level >= 0) levelBits = quint16(kAudioLevelPresent | (voiced ? kAudioVoiced : 0) | qMin(level, 127));
+    const QByteArray d = buildAudio(roomId_, user_, seq, tsMs, id, sr, payload, levelBits);
+    return sock_.writeDatagram(d, serverAddr_, serverPort_) == d.size();
+}
+
 void UdpMediaClient::sendScreenJpeg(const QByteArray& jpeg, int w, int h, qint64 tsMs) {
     if (serverPort_ == 0 || roomId_.isEmpty() || user_.isEmpty() || jpeg.isEmpty()) return;
     const quint32 fid = ++frameSeq_;
@@ -98,6 +138,7 @@ void UdpMediaClient::sendScreenDelta(const QByteArray& blob, int w, int h, qint6
 
 void UdpMediaClient::onHeartbeat() {
     if (serverPort_ == 0 || roomId_.isEmpty() || user_.isEmpty()) return;
+    if (udpOk_ && QDateTime::currentMSecsSinceEpoch() - lastAckMs_ > kAckTimeoutMs) setUdpOk(false);
     sendRegister();
 }
 
@@ -127,6 +168,33 @@ void UdpMediaClient::parseDatagram(const QByteArray& dgram, const QHostAddress&,
     ds >> magic >> ver >> type >> reserved;
     if (magic != kMagic || (ver != 1 && ver != 2)) return;
 
+    if (type == 4) {
+        // 注册回执
+        QString room, user;
+        ds >> room >> user;
+        if (ds.status() != QDataStream::Ok || room != roomId_ || user != user_) return;
+        lastAckMs_ = QDateTime::currentMSecsSinceEpoch();
+        setUdpOk(true);
+        return;
+    }
+
+    if (type == 3) {
+        QString room, sender;
+        quint32 seq=0; quint64 ts=0; quint8 codec=0; quint16 sr=0, len=0;
+        ds >> room >> sender >> seq >> ts >> codec >> sr >> len;
+        if (ds.status() != QDataStream::Ok || roomId_.isEmpty() || room != roomId_) return;
+        if (int(dgram.size()) < ds.device()->pos() + (qint64)len) return;
+        QByteArray payload;
+        payload.resize(int(len));
+        ds.readRawData(payload.data(), len);
+        const QString name = codec == AudioOpus ? QStringLiteral("opus")
+                           : codec == AudioPcm16 ? QStringLiteral("pcm16")
+                           : codec == AudioCn ? QStringLiteral("cn")
+                           : QStringLiteral("mulaw");
+        emit udpAudioFrame(sender, name, int(sr), seq, qint64(ts), payload);
+        return;
+    }
+
     if (type == 2) {
         QString room, sender;
         quint32 fid=0; quint16 idx=0, cnt=0; quint16 w=0, h=0; quint64 ts=0; quint32 len=0;
@@ -0,0 +1,52 @@
+#include "vad.h"
+#include <cmath>
+
+namespace {
+const double kFloorDb       = -70.0;    // 低于它一律按静音
+const double kMinSpeechDb   = -55.0;
+const double kMarginDb      = 9.0;      // 高出噪声底这么多才可能是语音
+const double kStrongDb      = 18.0;     // 高出这么多不看过零率
+const double kMaxZcr        = 0.30;     // 人声（16kHz 采样）过零率上限
+const double kNoiseDownRate = 0.30;     // 能量低于噪声底时的跟随速度
+const double kNoiseUpDb     = 0.02;     // 每帧上漂，约 1dB/s
+const int    kHangFrames    = 12;       // 240ms 拖尾
+}
+
+void VoiceActivityDetector::reset()
+{
+    noiseDb_ = kFloorDb;
+    haveNoise_ = false;
+    hang_ = 0;
+}
+
+VoiceActivityDetector::Result VoiceActivityDetector::process(const qint16* pcm, int n)
+{
+    Result r;
+    if (n <= 0) return r;
+
+    double energy = 0.0;
+    int crossings = 0;
+    for (int i = 0; i < n; ++i) {
+        const double v = pcm[i];
+        energy += v * v;
+        if (i > 0 && ((pcm[i] ^ pcm[i - 1]) < 0)) ++crossings;
+    }
+    energy /= double(n);
+    const double db = qMax(kFloorDb, 10.0 * std::log10(energy / (32768.0 * 32768.0) + 1e-12));
+    const double zcr = double(crossings) / double(n);
+
+    if (!haveNoise_) { noiseDb_ = db; haveNoise_ = true; }
+    if (db < noiseDb_) noiseDb_ += (db - noiseDb_) * kNoiseDownRate;
+    else               noiseDb_ = qMin(noiseDb_ + kNoiseUpDb, db);
+
+    const double above = db - noiseDb_;
+    const bool active = db > kMinSpeechDb
+                     && (above > kStrongDb || (above > kMarginDb && zcr < kMaxZcr));
+    if (active) hang_ = kHangFrames;
+    else if (hang_ > 0) --hang_;
+
+    r.speech = active || hang_ > 0;
+    r.levelDbov = qBound(0, int(-db + 0.5), 127);
+    r.noiseDbov = qBound(0, int(-noiseDb_ + 0.5), 127);
+    return r;
+}
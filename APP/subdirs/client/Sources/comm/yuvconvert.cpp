@@ -0,0 +1,334 @@
+#include "yuvconvert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define YUV_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define YUV_NEON 1
+#endif
+
+namespace YuvConvert {
+
+namespace {
+
+// 6 位定点：R = 74(Y-16) + 102V，G = 74(Y-16) - 25U - 52V，B = 74(Y-16) + 129U，再 >>6
+// 中间量按 int16 饱和；只有结果必然 >255 时才会饱和，所以与 int 计算后钳位等价
+const int kY = 74, kRV = 102, kGU = -25, kGV = -52, kBU = 129, kRound = 32;
+
+inline int sat16(int v) { return v < -32768 ? -32768 : (v > 32767 ? 32767 : v); }
+inline uchar clip8(int v) { return uchar(v < 0 ? 0 : (v > 255 ? 255 : v)); }
+
+inline quint32 pixel(int y, int u, int v)
+{
+    const int yy = kY * (y - 16) + kRound;
+    const int uu = u - 128;
+    const int vv = v - 128;
+    const int r = sat16(yy + kRV * vv) >> 6;
+    const int g = sat16(yy + sat16(kGU * uu + kGV * vv)) >> 6;
+    const int b = sat16(yy + kBU * uu) >> 6;
+    return 0xFF000000u | (quint32(clip8(r)) << 16) | (quint32(clip8(g)) << 8) | clip8(b);
+}
+
+// 每个目标像素对应的源坐标，按输出尺寸缓存
+struct Sampler {
+    QVector<int> sx;      // 亮度列
+    QVector<int> sy;      // 亮度行
+    bool box2x2 = false;  // 缩小 ≥2 倍时亮度取 2x2 均值，减轻最近邻的锯齿
+};
+
+Sampler makeSampler(int sw, int sh, int dw, int dh)
+{
+    Sampler s;
+    s.sx.resize(dw);
+    s.sy.resize(dh);
+    s.box2x2 = sw >= dw * 2 && sh >= dh * 2;
+    const int maxX = s.box2x2 ? sw - 2 : sw - 1;
+    const int maxY = s.box2x2 ? sh - 2 : sh - 1;
+    // 取目标像素中心对应的源位置
+    for (int x = 0; x < dw; ++x) s.sx[x] = qBound(0, int((qint64(2 * x + 1) * sw / dw - 1) / 2), qMax(0, maxX));
+    for (int y = 0; y < dh; ++y) s.sy[y] = qBound(0, int((qint64(2 * y + 1) * sh / dh - 1) / 2), qMax(0, maxY));
+    return s;
+}
+
+inline uchar lumaAt(const uchar* row0, const uchar* row1, int off0, int off1, bool box)
+{
+    if (!box) return row0[off0];
+    return uchar((row0[off0] + row0[off1] + row1[off0] + row1[off1] + 2) >> 2);
+}
+
+// gather：把一行目标像素需要的 Y/U/V 取到连续缓冲
+void gatherRow(const FrameView& f, const Sampler& s, int dy, int dw, uchar* Y, uchar* U, uchar* V)
+{
+    const int sy = s.sy[dy];
+    const int cy = sy >> 1;
+    const bool box = s.box2x2;
+    const int* sx = s.sx.constData();
+
+    switch (f.layout) {
+    case Layout::YUYV:
+    case Layout::UYVY: {
+        const int yo = f.layout == Layout::YUYV ? 0 : 1;   // Y 在打包组内的偏移
+        const int uo = f.layout == Layout::YUYV ? 1 : 0;
+        const uchar* r0 = f.plane[0] + sy * f.stride[0];
+        const uchar* r1 = box ? r0 + f.stride[0] : r0;
+        for (int x = 0; x < dw; ++x) {
+            const int px = sx[x];
+            Y[x] = lumaAt(r0, r1, px * 2 + yo, (px + 1) * 2 + yo, box);
+            const int g = (px >> 1) * 4;
+            U[x] = r0[g + uo];
+            V[x] = r0[g + uo + 2];
+        }
+        break;
+    }
+    case Layout::NV12:
+    case Layout::NV21: {
+        const uchar* r0 = f.plane[0] + sy * f.stride[0];
+        const uchar* r1 = box ? r0 + f.stride[0] : r0;
+        const uchar* c = f.plane[1] + cy * f.stride[1];
+        const int uo = f.layout == Layout::NV12 ? 0 : 1;
+        for (int x = 0; x < dw; ++x) {
+            const int px = sx[x];
+            Y[x] = lumaAt(r0, r1, px, px + 1, box);
+            const int g = (px >> 1) * 2;
+            U[x] = c[g + uo];
+            V[x] = c[g + (uo ^ 1)];
+        }
+        break;
+    }
+    case Layout::I420:
+    case Layout::YV12: {
+        const uchar* r0 = f.plane[0] + sy * f.stride[0];
+        const uchar* r1 = box ? r0 + f.stride[0] : r0;
+        const int up = f.layout == Layout::I420 ? 1 : 2;
+        const uchar* cu = f.plane[up] + cy * f.stride[up];
+        const uchar* cv = f.plane[3 - up] + cy * f.stride[3 - up];
+        for (int x = 0; x < dw; ++x) {
+            const int px = sx[x];
+            Y[x] = lumaAt(r0, r1, px, px + 1, box);
+            U[x] = cu[px >> 1];
+            V[x] = cv[px >> 1];
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void scaleRgb32(const FrameView& f, const Sampler& s, QImage& out)
+{
+    const int dw = out.width();
+    for (int y = 0; y < out.height(); ++y) {
+        const quint32* src = reinterpret_cast<const quint32*>(f.plane[0] + s.sy[y] * f.stride[0]);
+        quint32* dst = reinterpret_cast<quint32*>(out.scanLine(y));
+        for (int x = 0; x < dw; ++x) dst[x] = src[s.sx[x]] | 0xFF000000u;
+    }
+}
+
+} // namespace
+
+void yuvRowToRgb32Scalar(const uchar* y, const uchar* u, const uchar* v, quint32* dst, int n)
+{
+    for (int i = 0; i < n; ++i) dst[i] = pixel(y[i], u[i], v[i]);
+}
+
+void yuvRowToRgb32(const uchar* y, const uchar* u, const uchar* v, quint32* dst, int n)
+{
+    int i = 0;
+#if defined(YUV_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c16 = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i cY = _mm_set1_epi16(kY);
+    const __m128i cRound = _mm_set1_epi16(kRound);
+    const __m128i cRV = _mm_set1_epi16(kRV);
+    const __m128i cGU = _mm_set1_epi16(kGU);
+    const __m128i cGV = _mm_set1_epi16(kGV);
+    const __m128i cBU = _mm_set1_epi16(kBU);
+    const __m128i alpha = _mm_set1_epi8(char(0xFF));
+    for (; i + 8 <= n; i += 8) {
+        __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i)), zero);
+        __m128i uu = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + i)), zero);
+        __m128i vv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + i)), zero);
+        yy = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(yy, c16), cY), cRound);
+        uu = _mm_sub_epi16(uu, c128);
+        vv = _mm_sub_epi16(vv, c128);
+
+        const __m128i r = _mm_srai_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(vv, cRV)), 6);
+        const __m128i g = _mm_srai_epi16(_mm_adds_epi16(yy, _mm_adds_epi16(_mm_mullo_epi16(uu, cGU),
+                                                                           _mm_mullo_epi16(vv, cGV))), 6);
+        const __m128i b = _mm_srai_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(uu, cBU)), 6);
+
+        // 内存序 B G R A（QImage::Format_RGB32 小端）
+        const __m128i b8 = _mm_packus_epi16(b, b);
+        const __m128i g8 = _mm_packus_epi16(g, g);
+        const __m128i r8 = _mm_packus_epi16(r, r);
+        const __m128i bg = _mm_unpacklo_epi8(b8, g8);
+        const __m128i ra = _mm_unpacklo_epi8(r8, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),     _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+#elif defined(YUV_NEON)
+    const int16x8_t c16 = vdupq_n_s16(16);
+    const int16x8_t c128 = vdupq_n_s16(128);
+    const int16x8_t cRound = vdupq_n_s16(kRound);
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t yy = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + i))), c16);
+        const int16x8_t uu = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + i))), c128);
+        const int16x8_t vv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + i))), c128);
+        yy = vmlaq_n_s16(cRound, yy, kY);
+
+        const int16x8_t r = vqaddq_s16(yy, vmulq_n_s16(vv, kRV));
+        const int16x8_t g = vqaddq_s16(yy, vqaddq_s16(vmulq_n_s16(uu, kGU), vmulq_n_s16(vv, kGV)));
+        const int16x8_t b = vqaddq_s16(yy, vmulq_n_s16(uu, kBU));
+
+        uint8x8x4_t px;
+        px.val[0] = vqshrun_n_s16(b, 6);
+        px.val[1] = vqshrun_n_s16(g, 6);
+        px.val[2] = vqshrun_n_s16(r, 6);
+        px.val[3] = vdup_n_u8(0xFF);
+        vst4_u8(reinterpret_cast<uint8_t*>(dst + i), px);
+    }
+#endif
+    yuvRowToRgb32Scalar(y + i, u + i, v + i, dst + i, n - i);
+}
+
+bool viewFromMappedFrame(const QVideoFrame& f, FrameView* out)
+{
+    if (!out || !f.isMapped() || f.width() <= 0 || f.height() <= 0) return false;
+    FrameView v;
+    v.width = f.width();
+    v.height = f.height();
+
+    switch (f.pixelFormat()) {
+    case QVideoFrame::Format_YUYV: v.layout = Layout::YUYV; break;
+    case QVideoFrame::Format_UYVY: v.layout = Layout::UYVY; break;
+    case QVideoFrame::Format_NV12: v.layout = Layout::NV12; break;
+    case QVideoFrame::Format_NV21: v.layout = Layout::NV21; break;
+    case QVideoFrame::Format_YUV420P: v.layout = Layout::I420; break;
+    case QVideoFrame::Format_YV12: v.layout = Layout::YV12; break;
+    case QVideoFrame::Format_RGB32:
+    case QVideoFrame::Format_ARGB32:
+    case QVideoFrame::Format_ARGB32_Premultiplied:
+        v.layout = Layout::RGB32; break;
+    default:
+        return false;
+    }
+
+    const int planes = f.planeCount();
+    for (int p = 0; p < planes && p < 3; ++p) {
+        v.plane[p] = f.bits(p);
+        v.stride[p] = f.bytesPerLine(p);
+    }
+    // 部分后端把三平面 YUV 报成单平面，按紧密排布推算
+    if ((v.layout == Layout::I420 || v.layout == Layout::YV12) && planes < 3) {
+        v.stride[1] = v.stride[2] = v.stride[0] / 2;
+        v.plane[1] = v.plane[0] + v.stride[0] * v.height;
+        v.plane[2] = v.plane[1] + v.stride[1] * ((v.height + 1) / 2);
+    } else if ((v.layout == Layout::NV12 || v.layout == Layout::NV21) && planes < 2) {
+        v.stride[1] = v.stride[0];
+        v.plane[1] = v.plane[0] + v.stride[0] * v.height;
+    }
+    if (!v.plane[0]) return false;
+    *out = v;
+    return true;
+}
+
+QSize fitSize(const QSize& src, const QSize& box)
+{
+    if (src.isEmpty() || box.isEmpty()) return QSize();
+    QSize s = src.scaled(box, Qt::KeepAspectRatio);
+    return QSize(qMax(1, s.width()), qMax(1, s.height()));
+}
+
+void convertScaled(const FrameView& src, const QSize* sizes, QImage* outs, int count)
+{
+    if (src.layout == Layout::Invalid) return;
+
+    QVector<uchar> rowBuf;
+    for (int k = 0; k < count; ++k) {
+        const QSize sz = sizes[k];
+        if (sz.isEmpty()) { outs[k] = QImage(); continue; }
+        QImage& out = outs[k];
+        // 复用调用方传入的缓冲；与别处共享时 scanLine() 会自行 detach
+        if (out.size() != sz || out.format() != QImage::Format_RGB32)
+            out = QImage(sz, QImage::Format_RGB32);
+
+        const Sampler s = makeSampler(src.width, src.height, sz.width(), sz.height());
+        if (src.layout == Layout::RGB32) {
+            scaleRgb32(src, s, out);
+            continue;
+        }
+
+        const int dw = sz.width();
+        rowBuf.resize(dw * 3);
+        uchar* Y = rowBuf.data();
+        uchar* U = Y + dw;
+        uchar* V = U + dw;
+        for (int y = 0; y < sz.height(); ++y) {
+            gatherRow(src, s, y, dw, Y, U, V);
+            yuvRowToRgb32(Y, U, V, reinterpret_cast<quint32*>(out.scanLine(y)), dw);
+        }
+    }
+}
+
+QImage frameToImage(const QVideoFrame& frame)
+{
+    if (!frame.isValid()) return QImage();
+
+    QVideoFrame clone(frame);
+    if (!clone.map(QAbstractVideoBuffer::ReadOnly)) {
+        return QImage();
+    }
+
+    const auto fmt = clone.pixelFormat();
+    const QImage::Format imf = QVideoFrame::imageFormatFromPixelFormat(fmt);
+    if (imf != QImage::Format_Invalid) {
+        QImage img(clone.bits(), clone.width(), clone.height(), clone.bytesPerLine(), imf);
+        QImage copy = img.copy();
+        clone.unmap();
+        return copy;
+    }
+
+    if (fmt == QVideoFrame::Format_YUYV) {
+        const uchar *base = clone.bits();
+        const int width = clone.width();
+        const int height = clone.height();
+        const int stride = clone.bytesPerLine();
+
+        QImage out(width, height, QImage::Format_RGB32);
+        auto clip = [](int v){ return v < 0 ? 0 : (v > 255 ? 255 : v); };
+
+        for (int y = 0; y < height; ++y) {
+            const uchar* line = base + y * stride;
+            QRgb* dst = reinterpret_cast<QRgb*>(out.scanLine(y));
+            for (int x = 0; x < width; x += 2) {
+                const int i = x << 1;
+                int y0 = line[i + 0] - 16;
+                int u  = line[i + 1] - 128;
+                int y1 = line[i + 2] - 16;
+                int v  = line[i + 3] - 128;
+
+                int r0 = clip((298 * y0 + 409 * v + 128) >> 8);
+                int g0 = clip((298 * y0 - 100 * u - 208 * v + 128) >> 8);
+                int b0 = clip((298 * y0 + 516 * u + 128) >> 8);
+
+                int r1 = clip((298 * y1 + 409 * v + 128) >> 8);
+                int g1 = clip((298 * y1 - 100 * u - 208 * v + 128) >> 8);
+                int b1 = clip((298 * y1 + 516 * u + 128) >> 8);
+
+                dst[x]     = qRgb(r0, g0, b0);
+                if (x + 1 < width)
+                    dst[x + 1] = qRgb(r1, g1, b1);
+            }
+        }
+        clone.unmap();
+        return out;
+    }
+
+    clone.unmap();
+    return QImage();
+}
+
+}
@@ -0,0 +1,194 @@
+#include "control_client.h"
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QDebug>
+
+namespace {
+const int kTickMs = 200;
+const int kMinBackoffMs = 500;
+const int kMaxBackoffMs = 8000;
+}
+
+ControlClient* ControlClient::shared(const QString& host, quint16 port)
+{
+    static QHash<QString, QPointer<ControlClient>> clients;
+    const QString key = host + ':' + QString::number(port);
+    QPointer<ControlClient>& c = clients[key];
+    if (!c) c = new ControlClient(host, port, QCoreApplication::instance());
+    return c;
+}
+
+ControlClient::ControlClient(const QString& host, quint16 port, QObject* parent)
+    : QObject(parent), host_(host), port_(port)
+{
+    clock_.start();
+    sock_.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(&sock_, &QTcpSocket::connected, this, &ControlClient::onConnected);
+    connect(&sock_, &QTcpSocket::readyRead, this, &ControlClient::onReadyRead);
+    connect(&sock_, &QTcpSocket::disconnected, this, &ControlClient::onDisconnected);
+    connect(&sock_, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error),
+            this, [this](QAbstractSocket::SocketError){
+                // 连接阶段失败不会发 disconnected
+                if (sock_.state() != QAbstractSocket::ConnectedState) onDisconnected();
+            });
+
+    tick_.setInterval(kTickMs);
+    connect(&tick_, &QTimer::timeout, this, &ControlClient::onTick);
+    tick_.start();
+}
+
+QJsonObject ControlClient::netError(const QString& msg)
+{
+    return QJsonObject{{"ok", false}, {"msg", msg}, {"net_error", true}};
+}
+
+void ControlClient::call(const QJsonObject& req, QObject* context, Callback cb, int timeoutMs)
+{
+    enqueue(req, context, std::move(cb), timeoutMs);
+    ensureConnected();
+    flush();
+}
+
+void ControlClient::addStandingRequest(const QJsonObject& req, QObject* context, Callback cb)
+{
+    Standing s;
+    s.req = req;
+    s.ctx = context;
+    s.hasCtx = context != nullptr;
+    s.cb = cb;
+    standing_.push_back(s);
+    if (isConnected()) enqueue(req, context, cb, 5000);
+    ensureConnected();
+    flush();
+}
+
+void ControlClient::enqueue(const QJsonObject& req, QObject* context, Callback cb, int timeoutMs)
+{
+    const quint64 rid = nextRid_++;
+    Pending p;
+    p.req = req;
+    p.req["rid"] = double(rid);
+    p.ctx = context;
+    p.hasCtx = context != nullptr;
+    p.cb = std::move(cb);
+    p.deadline = clock_.elapsed() + timeoutMs;
+    pending_.insert(rid, p);
+    unsent_.push_back(rid);
+}
+
+void ControlClient::ensureConnected()
+{
+    if (sock_.state() != QAbstractSocket::UnconnectedState) return;
+    if (reconnectAt_ >= 0 && clock_.elapsed() < reconnectAt_) return;   // 退避中
+    reconnectAt_ = -1;
+    rbuf_.clear();
+    sock_.connectToHost(host_, port_);
+}
+
+void ControlClient::flush()
+{
+    if (!isConnected() || unsent_.isEmpty()) return;
+    QByteArray out;
+    for (quint64 rid : qAsConst(unsent_)) {
+        auto it = pending_.find(rid);
+        if (it == pending_.end()) continue;   // 已超时
+        out += QJsonDocument(it->req).toJson(QJsonDocument::Compact);
+        out += '\n';
+        it->sent = true;
+    }
+    unsent_.clear();
+    // 多个请求合并为一次写（流水线）
+    if (!out.isEmpty()) sock_.write(out);
+}
+
+void ControlClient::finish(quint64 rid, const QJsonObject& reply)
+{
+    auto it = pending_.find(rid);
+    if (it == pending_.end()) return;
+    Pending p = it.value();
+    pending_.erase(it);
+    if (p.hasCtx && !p.ctx) return;
+    if (p.cb) p.cb(reply);
+}
+
+void ControlClient::onConnected()
+{
+    backoffMs_ = kMinBackoffMs;
+    up_ = true;
+    // 订阅类请求排在最前，保证推送不漏
+    QVector<quint64> rest = unsent_;
+    unsent_.clear();
+    for (int i = 0; i < standing_.size(); ) {
+        const Standing& s = standing_.at(i);
+        if (s.hasCtx && !s.ctx) { standing_.remove(i); continue; }
+        enqueue(s.req, s.ctx.data(), s.cb, 5000);
+        ++i;
+    }
+    unsent_ += rest;
+    emit connectionChanged(true);
+    flush();
+}
+
+void ControlClient::onReadyRead()
+{
+    rbuf_ += sock_.readAll();
+    int nl;
+    while ((nl = rbuf_.indexOf('\n')) >= 0) {
+        const QByteArray line = rbuf_.left(nl).trimmed();
+        rbuf_.remove(0, nl + 1);
+        if (line.isEmpty()) continue;
+        QJsonParseError pe{};
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &pe);
+        if (pe.error != QJsonParseError::NoError || !doc.isObject()) continue;
+        const QJsonObject o = doc.object();
+        if (o.contains("rid")) {
+            finish(quint64(o.value("rid").toDouble()), o);
+        } else if (o.contains("event")) {
+            emit event(o);
+        }
+    }
+}
+
+void ControlClient::onDisconnected()
+{
+    if (reconnectAt_ >= 0) return;   // error + disconnected 只处理一次
+    const bool wasUp = up_;
+    up_ = false;
+    rbuf_.clear();
+
+    // 先进入退避，回调里新发的请求只排队不立即重连
+    reconnectAt_ = clock_.elapsed() + backoffMs_;
+    backoffMs_ = qMin(backoffMs_ * 2, kMaxBackoffMs);
+
+    // 已发出但未应答的请求无法确定是否执行，直接以失败结束
+    QList<quint64> lost;
+    for (auto it = pending_.cbegin(); it != pending_.cend(); ++it) {
+        if (it->sent) lost << it.key();
+    }
+    for (quint64 rid : lost) finish(rid, netError(QStringLiteral("连接已断开")));
+
+    if (wasUp) emit connectionChanged(false);
+}
+
+void ControlClient::onTick()
+{
+    const qint64 now = clock_.elapsed();
+
+    QList<quint64> expired;
+    for (auto it = pending_.cbegin(); it != pending_.cend(); ++it) {
+        if (now >= it->deadline) expired << it.key();
+    }
+    for (quint64 rid : expired) {
+        const bool sent = pending_.value(rid).sent;
+        finish(rid, netError(sent ? QStringLiteral("服务器无响应")
+                                  : QStringLiteral("无法连接服务器")));
+    }
+
+    // 有待发请求或常驻订阅时才重连
+    if (sock_.state() == QAbstractSocket::UnconnectedState
+        && (!pending_.isEmpty() || !standing_.isEmpty())
+        && reconnectAt_ >= 0 && now >= reconnectAt_) {
+        ensureConnected();
+    }
+}
@@ -0,0 +1,167 @@
+#include "order_sync.h"
+#include "control_client.h"
+
+#include <QJsonArray>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+const int kPageSize = 200;
+
+static OrderInfo orderFromJson(const QJsonObject& o) {
+    return OrderInfo{
+        o.value("id").toInt(), o.value("title").toString(),
+        o.value("desc").toString(), o.value("status").toString()
+    };
+}
+
+static bool idLess(const OrderInfo& a, int id) { return a.id < id; }
+
+static QString replyError(const QJsonObject& rep) {
+    const QString msg = rep.value("msg").toString();
+    return msg.isEmpty() ? QStringLiteral("服务器响应异常") : msg;
+}
+} // namespace
+
+OrderSync::OrderSync(const QString& host, quint16 port,
+                     const QString& role, const QString& username,
+                     QObject* parent)
+    : QObject(parent), conn_(ControlClient::shared(host, port)), role_(role), username_(username)
+{
+    connect(conn_, &ControlClient::event, this, [this](const QJsonObject& ev){
+        if (ev.value("event").toString() == "orders_changed")
+            onRemoteVersion(qint64(ev.value("version").toDouble()));
+    });
+}
+
+void OrderSync::setFilter(const QString& keyword, const QString& status)
+{
+    const QString st = (status == "全部") ? QString() : status;
+    if (keyword == keyword_ && st == status_) return;
+    keyword_ = keyword;
+    status_ = st;
+    loaded_ = false;   // 筛选变了，增量基线失效
+}
+
+QJsonObject OrderSync::baseRequest() const
+{
+    QJsonObject req{
+        {"action", "get_orders"},
+        {"role", role_},
+        {"username", username_}
+    };
+    if (!keyword_.isEmpty()) req["keyword"] = keyword_;
+    if (!status_.isEmpty()) req["status"] = status_;
+    return req;
+}
+
+void OrderSync::reload(Done done)
+{
+    const int gen = ++gen_;
+    busy_ = true;
+    loaded_ = false;
+    fetchPage(gen, 0, -1, done);
+}
+
+// 第一页替换列表并回调 done，界面先显示；后续页追加后发 updated()，拉完才算 loaded_
+void OrderSync::fetchPage(int gen, qint64 afterId, qint64 baseVersion, Done done)
+{
+    QJsonObject req = baseRequest();
+    req["limit"] = kPageSize;
+    if (afterId > 0) req["after_id"] = double(afterId);
+
+    conn_->call(req, this, [this, gen, baseVersion, done](const QJsonObject& rep){
+        if (gen != gen_) return;   // 已被更新的 reload 取代
+        const bool first = baseVersion < 0;
+        if (!rep.value("ok").toBool()) {
+            busy_ = false;
+            // 后续页失败：已显示的部分保留，loaded_ 仍为 false，下次 pullChanges 重新全量拉
+            if (!first) qWarning() << "[orders] page fetch failed:" << replyError(rep);
+            else if (done) done(false, replyError(rep));
+            runQueuedPull();
+            return;
+        }
+        // 以第一页的版本为基线：翻页期间的改动稍后由增量补齐
+        const qint64 ver = first ? qint64(rep.value("version").toDouble()) : baseVersion;
+        const QJsonArray arr = rep.value("orders").toArray();
+        if (first) orders_.clear();
+        orders_.reserve(orders_.size() + arr.size());
+        for (const QJsonValue& v : arr) orders_.append(orderFromJson(v.toObject()));   // 按 id 游标，天然有序
+        const bool more = rep.value("has_more").toBool() && !arr.isEmpty();
+        if (!more) {
+            version_ = qMax<qint64>(0, ver);
+            loaded_ = true;
+            busy_ = false;
+        }
+        if (first) {
+            if (done) done(true, QString());
+            if (gen != gen_) return;   // 回调里又发起了 reload
+        } else {
+            emit updated();
+        }
+        if (more) fetchPage(gen, qint64(rep.value("next_after_id").toDouble()), ver, Done());
+        else runQueuedPull();
+    });
+}
+
+void OrderSync::pullChanges()
+{
+    if (busy_) { pullQueued_ = true; return; }
+    if (!loaded_) {
+        reload([this](bool ok, const QString&){ if (ok) emit updated(); });
+        return;
+    }
+
+    busy_ = true;
+    const int gen = gen_;
+    QJsonObject req = baseRequest();
+    req["since_version"] = double(version_);
+    conn_->call(req, this, [this, gen](const QJsonObject& rep){
+        if (gen != gen_) return;
+        busy_ = false;
+        if (rep.value("ok").toBool()) {
+            // 先删后改：同一 id 删除后又复用时以最新行为准
+            for (const QJsonValue& v : rep.value("removed").toArray()) removeId(v.toInt());
+            for (const QJsonValue& v : rep.value("orders").toArray()) upsert(orderFromJson(v.toObject()));
+            version_ = qMax(version_, qint64(rep.value("version").toDouble()));
+            emit updated();
+        }
+        runQueuedPull();
+    });
+}
+
+void OrderSync::runQueuedPull()
+{
+    if (!pullQueued_) return;
+    pullQueued_ = false;
+    pullChanges();
+}
+
+void OrderSync::upsert(const OrderInfo& od)
+{
+    auto it = std::lower_bound(orders_.begin(), orders_.end(), od.id, idLess);
+    if (it != orders_.end() && it->id == od.id) *it = od;
+    else orders_.insert(it, od);
+}
+
+void OrderSync::removeId(int id)
+{
+    auto it = std::lower_bound(orders_.begin(), orders_.end(), id, idLess);
+    if (it != orders_.end() && it->id == id) orders_.erase(it);
+}
+
+void OrderSync::subscribe()
+{
+    if (subscribed_) return;
+    subscribed_ = true;
+    // 订阅应答带当前版本：断线期间漏掉的推送由它补上
+    conn_->addStandingRequest(QJsonObject{{"action", "subscribe_orders"}}, this,
+                              [this](const QJsonObject& rep){
+        if (rep.value("ok").toBool()) onRemoteVersion(qint64(rep.value("version").toDouble()));
+    });
+}
+
+void OrderSync::onRemoteVersion(qint64 v)
+{
+    if (loaded_ && v > version_) pullChanges();
+}
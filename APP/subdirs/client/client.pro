@@ -18,9 +18,12 @@ INCLUDEPATH += Resources
 HEADERS += \
     Headers/client_factory.h \
     Headers/client_expert.h \
+    Headers/order_sync.h \
+    Headers/control_client.h \
     Headers/comm/devicepanel.h \
     Headers/comm/kb_client.h \
     Headers/comm/knowledge_panel.h \
+    Headers/comm/recording_model.h \
     Headers/comm/knowledge_tab_helper.h \
     Headers/login.h \
     Headers/regist.h \
@@ -30,17 +33,34 @@ HEADERS += \
     Headers/comm/annot.h \
     Headers/comm/annotcanvas.h \
     Headers/comm/audiochat.h \
+    Headers/comm/audiocodec.h \
+    Headers/comm/camencoder.h \
     Headers/comm/clientconn.h \
+    Headers/comm/tilecompositor.h \
+    Headers/comm/decodesched.h \
+    Headers/comm/jitterbuffer.h \
+    Headers/comm/vad.h \
+    Headers/comm/audiodsp.h \
+    Headers/comm/spscring.h \
+    Headers/comm/audioengine.h \
+    Headers/comm/audioproc.h \
+    Headers/comm/deltacodec.h \
+    Headers/comm/ratecontrol.h \
+    Headers/comm/resampler.h \
     Headers/comm/screenshare.h \
     Headers/comm/udpmedia.h \
+    Headers/comm/yuvconvert.h \
     Headers/comm/volume_popup.h
 
 SOURCES += \
     Sources/client_factory.cpp \
     Sources/client_expert.cpp \
+    Sources/order_sync.cpp \
+    Sources/control_client.cpp \
     Sources/comm/devicepanel.cpp \
     Sources/comm/kb_client.cpp \
     Sources/comm/knowledge_panel.cpp \
+    Sources/comm/recording_model.cpp \
     Sources/comm/knowledge_tab_helper.cpp \
     Sources/login.cpp \
     Sources/regist.cpp \
@@ -51,9 +71,22 @@ SOURCES += \
     Sources/comm/annot.cpp \
     Sources/comm/annotcanvas.cpp \
     Sources/comm/audiochat.cpp \
+    Sources/comm/audiocodec.cpp \
+    Sources/comm/camencoder.cpp \
     Sources/comm/clientconn.cpp \
+    Sources/comm/tilecompositor.cpp \
+    Sources/comm/decodesched.cpp \
+    Sources/comm/jitterbuffer.cpp \
+    Sources/comm/vad.cpp \
+    Sources/comm/audiodsp.cpp \
+    Sources/comm/audioengine.cpp \
+    Sources/comm/audioproc.cpp \
+    Sources/comm/deltacodec.cpp \
+    Sources/comm/ratecontrol.cpp \
+    Sources/comm/resampler.cpp \
     Sources/comm/screenshare.cpp \
     Sources/comm/udpmedia.cpp \
+    Sources/comm/yuvconvert.cpp \
     Sources/comm/volume_popup.cpp
 
 FORMS += \
@@ -64,6 +97,13 @@ FORMS += \
 
 RESOURCES += Resources/resources.qrc
 
+# Opus 可选：pkg-config 找到 opus 时启用，否则语音只有 G.711 µ-law
+packagesExist(opus) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opus
+    DEFINES += HAVE_OPUS
+}
+
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,34 @@
+QT += core network gui
+CONFIG += c++11 console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = loadgen
+
+# 无界面压测工具（--mode control 时改压 AuthServer 控制口）：协议/标注/µ-law 用服务器 common 的实现，UDP 媒体通道直接用客户端的 UdpMediaClient
+# gui 只用于生成 JPEG 和标注点编码，不需要显示环境
+COMMON_DIR = $$PWD/../server/common
+include($$COMMON_DIR/common.pri)
+
+# common 要排在客户端头文件目录前面，同名的 annot.h / audiodsp.h 取 common 的
+CLIENT_DIR = $$PWD/../client
+INCLUDEPATH += $$PWD/src
+INCLUDEPATH += $$CLIENT_DIR/Headers/comm
+
+SOURCES += \
+    src/main.cpp \
+    src/simclient.cpp \
+    src/authsim.cpp \
+    src/loadstats.cpp \
+    src/synthmedia.cpp \
+    $$COMMON_DIR/annot.cpp \
+    $$COMMON_DIR/audiodsp.cpp \
+    $$CLIENT_DIR/Sources/comm/udpmedia.cpp
+
+HEADERS += \
+    src/simclient.h \
+    src/authsim.h \
+    src/loadstats.h \
+    src/synthmedia.h \
+    $$COMMON_DIR/annot.h \
+    $$COMMON_DIR/audiodsp.h \
+    $$CLIENT_DIR/Headers/comm/udpmedia.h
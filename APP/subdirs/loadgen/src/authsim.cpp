@@ -0,0 +1,123 @@
+#include "authsim.h"
+
+namespace {
+const int kConnectTimeoutMs = 10000;
+const QString kPassword     = QStringLiteral("loadgen");
+}
+
+AuthSimClient::AuthSimClient(const Config& cfg, LiveCounters* live, QObject* parent)
+    : QObject(parent), cfg_(cfg), live_(live)
+{
+    connect(&sock_, &QTcpSocket::connected, this, &AuthSimClient::onConnected);
+    connect(&sock_, &QTcpSocket::readyRead, this, &AuthSimClient::onReadyRead);
+    connect(&sock_, &QTcpSocket::disconnected, this, &AuthSimClient::onDisconnected);
+    connect(&sock_, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
+            [this](QAbstractSocket::SocketError) {
+        qWarning() << "[loadgen]" << cfg_.user << "control socket error:" << sock_.errorString();
+    });
+    clock_.start();
+}
+
+void AuthSimClient::start()
+{
+    sock_.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    sock_.connectToHost(cfg_.host, cfg_.port);
+    QTimer::singleShot(kConnectTimeoutMs, this, [this] {
+        if (ready_) return;
+        ++stats_.connectFailures;
+        qWarning() << "[loadgen]" << cfg_.user << "control setup timeout";
+    });
+}
+
+void AuthSimClient::stopSending()
+{
+    sending_ = false;
+}
+
+// 准备：注册 + 建工单一起发出，全部应答后开始压测
+void AuthSimClient::onConnected()
+{
+    live_->connected.ref();
+    setupLeft_ = 1 + cfg_.seedOrders;
+    send(AuthOp::Count, QJsonObject{{"action", "register"}, {"role", cfg_.role},
+                                    {"username", cfg_.user}, {"password", kPassword}});
+    for (int i = 0; i < cfg_.seedOrders; ++i) {
+        send(AuthOp::Count, QJsonObject{
+            {"action", "new_order"},
+            {"title", QStringLiteral("loadgen %1 设备巡检 %2").arg(cfg_.user).arg(i)},
+            {"desc", QStringLiteral("压测工单：电机温度异常，需要远程协助排查 #%1").arg(i)},
+            {"factory_user", cfg_.user}});
+    }
+}
+
+void AuthSimClient::onDisconnected()
+{
+    live_->connected.deref();
+    if (ready_) live_->joined.deref();
+    ++stats_.disconnects;
+    ready_ = false;
+    sending_ = false;
+    pending_.clear();
+}
+
+void AuthSimClient::onReadyRead()
+{
+    while (sock_.canReadLine()) {
+        const QByteArray line = sock_.readLine().trimmed();
+        if (line.isEmpty()) continue;
+        const QJsonDocument doc = QJsonDocument::fromJson(line);
+        if (doc.isObject()) onReply(doc.object());
+    }
+}
+
+void AuthSimClient::onReply(const QJsonObject& rep)
+{
+    const QJsonValue rid = rep.value("rid");
+    if (rid.isUndefined()) return;      // 推送事件（本客户端不订阅，正常不会有）
+    const auto it = pending_.find(qint64(rid.toDouble()));
+    if (it == pending_.end()) return;
+    const Pending p = it.value();
+    pending_.erase(it);
+    live_->rxMsgs.ref();
+
+    if (p.op == AuthOp::Count) {
+        // 注册时账号已存在、建单失败都不影响后面的压测
+        if (--setupLeft_ == 0 && !ready_) {
+            ready_ = true;
+            live_->joined.ref();
+        }
+    } else if (p.measured) {
+        const int i = int(p.op);
+        if (rep.value("ok").toBool()) ++stats_.ok[i];
+        else                          ++stats_.failed[i];
+        stats_.lat[i].add((clock_.nsecsElapsed() - p.sentNs) / 100000);
+    }
+    fill();
+}
+
+void AuthSimClient::send(AuthOp op, QJsonObject req)
+{
+    const qint64 rid = nextRid_++;
+    req["rid"] = double(rid);
+    pending_.insert(rid, Pending{op, clock_.nsecsElapsed(),
+                                 QDateTime::currentMSecsSinceEpoch() >= cfg_.measureFromMs});
+    sock_.write(QJsonDocument(req).toJson(QJsonDocument::Compact) + "\n");
+    live_->txMsgs.ref();
+}
+
+// 在途补满到 depth：depth=1 即闭环（收到应答才发下一个）
+void AuthSimClient::fill()
+{
+    auto* rng = QRandomGenerator::global();
+    while (ready_ && sending_ && pending_.size() < cfg_.depth) {
+        if (int(rng->bounded(100)) < cfg_.orderPercent) {
+            QJsonObject req{{"action", "get_orders"}, {"role", cfg_.role},
+                            {"username", cfg_.user}, {"limit", cfg_.orderLimit}};
+            if (!cfg_.keyword.isEmpty()) req["keyword"] = cfg_.keyword;
+            send(AuthOp::Orders, req);
+        } else {
+            send(AuthOp::Login, QJsonObject{{"action", "login"}, {"role", cfg_.role},
+                                            {"username", cfg_.user}, {"password", kPassword}});
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <QtCore>
+#include <QtNetwork>
+#include "loadstats.h"
+
+// 控制口（AuthServer，默认 5555）的模拟客户端：和真实客户端的 ControlClient 一样一条常驻连接、
+// 逐行 JSON、带 rid 流水线（服务器按 rid 把请求分散到各 DB 线程）
+// 先注册自己的账号（已存在也继续）并建 seedOrders 条工单，之后始终保持 depth 个请求在途，
+// 按 orderPercent 在 get_orders（首页，limit 条）和 login 之间选；只统计 measureFromMs 之后发出的请求
+// 对象必须在它所属的工作线程里创建和使用
+class AuthSimClient : public QObject {
+    Q_OBJECT
+public:
+    struct Config {
+        QString host;
+        quint16 port = 5555;
+        QString user;
+        QString role = QStringLiteral("expert");   // expert 查全部工单，factory 只查自己的
+        QString keyword;                            // 非空时 get_orders 带关键字（走全文索引）
+        int  depth = 1;
+        int  orderPercent = 50;
+        int  orderLimit = 200;                      // 与客户端 OrderSync 的页大小一致
+        int  seedOrders = 0;
+        qint64 measureFromMs = 0;
+    };
+
+    AuthSimClient(const Config& cfg, LiveCounters* live, QObject* parent = nullptr);
+
+    void start();
+    void stopSending();
+    AuthStats stats() const { return stats_; }
+
+private:
+    struct Pending {
+        AuthOp op;          // Count = 准备阶段的请求，不统计
+        qint64 sentNs;
+        bool   measured;
+    };
+
+    void onConnected();
+    void onReadyRead();
+    void onDisconnected();
+    void onReply(const QJsonObject& rep);
+    void send(AuthOp op, QJsonObject req);
+    void fill();
+
+    Config cfg_;
+    LiveCounters* live_;
+    AuthStats stats_;
+
+    QTcpSocket sock_;
+    QElapsedTimer clock_;
+    QHash<qint64, Pending> pending_;
+    qint64 nextRid_ = 1;
+    int  setupLeft_ = 0;
+    bool ready_ = false;
+    bool sending_ = true;
+};
@@ -0,0 +1,242 @@
+#include "loadstats.h"
+#include <cmath>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+const char* mediaName(Media m)
+{
+    switch (m) {
+    case Media::Camera:   return "camera";
+    case Media::Audio:    return "audio";
+    case Media::AudioMix: return "audio_mix";
+    case Media::Annot:    return "annot";
+    case Media::Screen:   return "screen";
+    default:              return "?";
+    }
+}
+
+const char* authOpName(AuthOp op)
+{
+    switch (op) {
+    case AuthOp::Login:  return "login";
+    case AuthOp::Orders: return "get_orders";
+    default:             return "?";
+    }
+}
+
+/* ---------- LatencyHist ---------- */
+namespace {
+const int kFineMs   = 200;
+const int kMidMs    = 2000;
+const int kCoarseMs = 20000;
+const int kBins     = kFineMs + (kMidMs - kFineMs) / 10 + (kCoarseMs - kMidMs) / 100 + 1;
+}
+
+int LatencyHist::bucketOf(qint64 ms)
+{
+    if (ms < kFineMs) return int(ms);
+    if (ms < kMidMs) return kFineMs + int(ms - kFineMs) / 10;
+    if (ms < kCoarseMs) return kFineMs + (kMidMs - kFineMs) / 10 + int(ms - kMidMs) / 100;
+    return kBins - 1;
+}
+
+int LatencyHist::bucketFloor(int idx)
+{
+    if (idx < kFineMs) return idx;
+    idx -= kFineMs;
+    if (idx < (kMidMs - kFineMs) / 10) return kFineMs + idx * 10;
+    idx -= (kMidMs - kFineMs) / 10;
+    return kMidMs + idx * 100;
+}
+
+void LatencyHist::add(qint64 ms)
+{
+    if (bins_.isEmpty()) bins_.fill(0, kBins);
+    if (ms < 0) ms = 0;     // 同一进程的时钟，负值只可能是毫秒取整
+    ++bins_[bucketOf(ms)];
+    ++n_;
+    sum_ += ms;
+    max_ = qMax(max_, ms);
+}
+
+void LatencyHist::merge(const LatencyHist& o)
+{
+    if (o.n_ == 0) return;
+    if (bins_.isEmpty()) bins_.fill(0, kBins);
+    for (int i = 0; i < kBins; ++i) bins_[i] += o.bins_[i];
+    n_ += o.n_;
+    sum_ += o.sum_;
+    max_ = qMax(max_, o.max_);
+}
+
+int LatencyHist::percentile(double q) const
+{
+    if (n_ == 0) return -1;
+    const qint64 rank = qMax<qint64>(1, qint64(std::ceil(qBound(0.0, q, 1.0) * n_)));
+    qint64 acc = 0;
+    for (int i = 0; i < kBins; ++i) {
+        acc += bins_[i];
+        if (acc >= rank) return bucketFloor(i);
+    }
+    return bucketFloor(kBins - 1);
+}
+
+/* ---------- LossTracker ---------- */
+void LossTracker::onSeq(const QString& stream, quint32 seq)
+{
+    auto it = tracks_.find(stream);
+    if (it == tracks_.end()) {
+        Track t;
+        t.first = t.max = seq;
+        t.received = 1;
+        tracks_.insert(stream, t);
+        return;
+    }
+    // 按有符号差比较，序号回绕也成立
+    if (qint32(seq - it->max) > 0) it->max = seq;
+    if (qint32(seq - it->first) < 0) it->first = seq;
+    ++it->received;
+}
+
+void LossTracker::merge(const LossTracker& o)
+{
+    mergedRecv_ += o.received();
+    mergedExp_ += o.expected();
+}
+
+qint64 LossTracker::received() const
+{
+    qint64 n = mergedRecv_;
+    for (const Track& t : tracks_) n += t.received;
+    return n;
+}
+
+qint64 LossTracker::expected() const
+{
+    qint64 n = mergedExp_;
+    for (const Track& t : tracks_) n += qint64(t.max - t.first) + 1;
+    return n;
+}
+
+double LossTracker::lossRate() const
+{
+    const qint64 exp = expected();
+    if (exp <= 0) return 0.0;
+    return qMax(0.0, double(exp - received()) / exp);
+}
+
+/* ---------- SimStats ---------- */
+void SimStats::merge(const SimStats& o)
+{
+    for (int m = 0; m < kMediaCount; ++m) {
+        lat[m].merge(o.lat[m]);
+        loss[m].merge(o.loss[m]);
+        txMsgs[m] += o.txMsgs[m];
+        txBytes[m] += o.txBytes[m];
+        txDropped[m] += o.txDropped[m];
+        rxMsgs[m] += o.rxMsgs[m];
+        rxBytes[m] += o.rxBytes[m];
+    }
+    join.merge(o.join);
+    joinFailures += o.joinFailures;
+    disconnects += o.disconnects;
+}
+
+/* ---------- AuthStats ---------- */
+void AuthStats::merge(const AuthStats& o)
+{
+    for (int i = 0; i < kAuthOpCount; ++i) {
+        lat[i].merge(o.lat[i]);
+        ok[i] += o.ok[i];
+        failed[i] += o.failed[i];
+    }
+    connectFailures += o.connectFailures;
+    disconnects += o.disconnects;
+}
+
+/* ---------- ProcSampler ---------- */
+ProcSampler::ProcSampler(qint64 pid)
+    : pid_(pid)
+{
+    qint64 t = 0;
+    valid_ = pid_ > 0 && readTicks(&t);
+    lastTicks_ = t;
+    lastWall_.start();
+    resetPeak();
+}
+
+bool ProcSampler::readTicks(qint64* ticks) const
+{
+#ifdef Q_OS_LINUX
+    QFile f(QStringLiteral("/proc/%1/stat").arg(pid_));
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const QByteArray line = f.readAll();
+    // comm 里可能有空格，从最后一个 ')' 之后开始按空格切：[0]=state ... [11]=utime [12]=stime
+    const int rp = line.lastIndexOf(')');
+    if (rp < 0) return false;
+    const QList<QByteArray> fs = line.mid(rp + 2).split(' ');
+    if (fs.size() < 13) return false;
+    *ticks = fs.at(11).toLongLong() + fs.at(12).toLongLong();
+    return true;
+#else
+    Q_UNUSED(ticks);
+    return false;
+#endif
+}
+
+bool ProcSampler::sample()
+{
+#ifdef Q_OS_LINUX
+    qint64 t = 0;
+    if (!readTicks(&t)) { valid_ = false; return false; }
+    static const long hz = sysconf(_SC_CLK_TCK);
+    const qint64 wallMs = lastWall_.restart();
+    if (wallMs > 0) cpu_ = 100.0 * (t - lastTicks_) / hz / (wallMs / 1000.0);
+    lastTicks_ = t;
+    cpuMax_ = qMax(cpuMax_, cpu_);
+    const qint64 periodMs = periodWall_.elapsed();
+    if (periodMs > 0) cpuAvg_ = 100.0 * (t - periodTicks_) / hz / (periodMs / 1000.0);
+
+    QFile f(QStringLiteral("/proc/%1/status").arg(pid_));
+    if (f.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& l : f.readAll().split('\n')) {
+            if (!l.startsWith("VmRSS:")) continue;
+            rssKb_ = l.mid(6).trimmed().split(' ').value(0).toLongLong();
+            break;
+        }
+    }
+    rssMaxKb_ = qMax(rssMaxKb_, rssKb_);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ProcSampler::resetPeak()
+{
+    cpuAvg_ = 0.0;
+    cpuMax_ = 0.0;
+    rssMaxKb_ = rssKb_;
+    periodTicks_ = lastTicks_;
+    periodWall_.start();
+}
+
+qint64 ProcSampler::findByName(const QString& comm)
+{
+#ifdef Q_OS_LINUX
+    const qint64 self = QCoreApplication::applicationPid();
+    QDir proc(QStringLiteral("/proc"));
+    for (const QString& d : proc.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        bool ok = false;
+        const qint64 pid = d.toLongLong(&ok);
+        if (!ok || pid == self) continue;
+        QFile f(QStringLiteral("/proc/%1/comm").arg(pid));
+        if (!f.open(QIODevice::ReadOnly)) continue;
+        if (QString::fromLocal8Bit(f.readAll()).trimmed() == comm) return pid;
+    }
+#else
+    Q_UNUSED(comm);
+#endif
+    return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <QtCore>
+
+// 压测统计：每个模拟客户端各持一份（只在自己线程写），结束时在主线程合并
+// - 时延：发送端填的 ts（本进程时钟，毫秒）到接收端收到的差；200ms 内按 1ms、2s 内按 10ms、20s 内按 100ms 分桶，
+//   分位数取桶下沿，最大值单独精确记录；控制口压测按 0.1ms 为单位记，同样的桶覆盖到 2s
+// - 丢包：按 (接收端, 发送者) 分流，收到的最大序号 - 首个序号 + 1 为应收数；末尾还在路上的不算丢
+enum class Media { Camera = 0, Audio, AudioMix, Annot, Screen, Count };
+const int kMediaCount = int(Media::Count);
+const char* mediaName(Media m);
+
+class LatencyHist {
+public:
+    void add(qint64 ms);
+    void merge(const LatencyHist& o);
+
+    qint64 count() const { return n_; }
+    qint64 max() const { return max_; }
+    double mean() const { return n_ ? double(sum_) / n_ : 0.0; }
+    // q 取 0..1；没有样本时返回 -1
+    int percentile(double q) const;
+
+private:
+    static int bucketOf(qint64 ms);
+    static int bucketFloor(int idx);
+
+    QVector<quint32> bins_;
+    qint64 n_ = 0;
+    qint64 sum_ = 0;
+    qint64 max_ = 0;
+};
+
+class LossTracker {
+public:
+    void onSeq(const QString& stream, quint32 seq);
+    void merge(const LossTracker& o);
+
+    qint64 received() const;
+    qint64 expected() const;
+    double lossRate() const;
+
+private:
+    struct Track { quint32 first = 0; quint32 max = 0; qint64 received = 0; };
+    QHash<QString, Track> tracks_;
+    qint64 mergedRecv_ = 0;     // 合并进来的只留总数
+    qint64 mergedExp_ = 0;
+};
+
+struct SimStats {
+    LatencyHist lat[kMediaCount];
+    LossTracker loss[kMediaCount];
+    qint64 txMsgs[kMediaCount] = {};
+    qint64 txBytes[kMediaCount] = {};
+    qint64 txDropped[kMediaCount] = {};     // 发送缓冲积压时本地丢弃（真实客户端同样会丢）
+    qint64 rxMsgs[kMediaCount] = {};
+    qint64 rxBytes[kMediaCount] = {};
+    LatencyHist join;                       // 发起连接到收到 joined 回执
+    int joinFailures = 0;
+    int disconnects = 0;
+
+    void merge(const SimStats& o);
+};
+
+// 控制口（AuthServer）压测：login / get_orders 各一组
+enum class AuthOp { Login = 0, Orders, Count };
+const int kAuthOpCount = int(AuthOp::Count);
+const char* authOpName(AuthOp op);
+
+struct AuthStats {
+    LatencyHist lat[kAuthOpCount];          // 发出到收到应答，单位 0.1ms
+    qint64 ok[kAuthOpCount] = {};
+    qint64 failed[kAuthOpCount] = {};       // 应答 ok=false
+    int connectFailures = 0;
+    int disconnects = 0;
+
+    void merge(const AuthStats& o);
+};
+
+// 运行中的全局计数，进度日志用；精确统计以 SimStats 为准
+struct LiveCounters {
+    QAtomicInt connected{0};
+    QAtomicInt joined{0};
+    QAtomicInt udpReady{0};
+    QAtomicInteger<qint64> txMsgs{0};
+    QAtomicInteger<qint64> rxMsgs{0};
+};
+
+// 进程 CPU/RSS 采样（读 /proc，仅 Linux；其他平台 isValid() 为 false）
+class ProcSampler {
+public:
+    explicit ProcSampler(qint64 pid);           // <= 0 时 isValid() 为 false
+
+    bool isValid() const { return valid_; }
+    qint64 pid() const { return pid_; }
+    // 距上次采样的平均 CPU（100 = 一个核跑满）与当前 RSS
+    bool sample();
+    double cpuPercent() const { return cpu_; }
+    qint64 rssKb() const { return rssKb_; }
+
+    // 整段测量期的统计（从 resetPeak 起）
+    void resetPeak();
+    double cpuAvg() const { return cpuAvg_; }
+    double cpuMax() const { return cpuMax_; }
+    qint64 rssMaxKb() const { return rssMaxKb_; }
+
+    // 按进程名（/proc/<pid>/comm）找第一个匹配的进程，找不到返回 0
+    static qint64 findByName(const QString& comm);
+
+private:
+    bool readTicks(qint64* ticks) const;
+
+    qint64 pid_ = 0;
+    bool   valid_ = false;
+    qint64 lastTicks_ = 0;
+    QElapsedTimer lastWall_;
+    double cpu_ = 0.0;
+    qint64 rssKb_ = 0;
+    double cpuAvg_ = 0.0;
+    double cpuMax_ = 0.0;
+    qint64 rssMaxKb_ = 0;
+    qint64 periodTicks_ = 0;
+    QElapsedTimer periodWall_;
+};
@@ -0,0 +1,483 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "simclient.h"
+#include "authsim.h"
+#include "loadstats.h"
+#include "synthmedia.h"
+
+// 无界面压测：N 个模拟参会者分到 M 个房间，对 RoomHub(TCP) / UdpRelay(UDP) 发真实格式的流量，
+// 统计端到端时延分位数、丢包和服务器 CPU/RSS
+// 时间线：ramp 内逐个入房 → warmup 预热（不计）→ duration 测量 → 停发等在途帧落地 → 出报告
+// 例：./loadgen --clients 300 --rooms 30 --duration 60 --json result.json
+// --mode control 改压控制口（AuthServer）：N 条常驻连接并发 login / get_orders，报每秒成功数和时延分位数
+// 例：./loadgen --mode control --clients 64 --depth 4 --seed-orders 50 --duration 30
+
+namespace {
+const int kProgressMs = 5000;
+const int kDrainMs    = 2000;
+
+struct Options {
+    QString mode;
+    QString host;
+    quint16 port = 9000;
+    quint16 authPort = 5555;
+    int clients = 0;
+    int rooms = 0;
+    int threads = 0;
+    int rampS = 0, warmupS = 0, durationS = 0;
+    int camFps = 0, camQuality = 0;
+    QSize camSize;
+    int talkers = 0, sharers = 0, annotators = 0;
+    int screenFps = 0, screenQuality = 0;
+    QSize screenSize;
+    int annotHz = 0;
+    bool udp = true;
+    qint64 serverPid = 0;
+    QString roomPrefix;
+    QString jsonPath;
+    // control 模式
+    QString role;
+    QString keyword;
+    int depth = 1;
+    int orderPercent = 50;
+    int orderLimit = 200;
+    int seedOrders = 0;
+};
+
+QSize parseSize(const QString& s)
+{
+    const QStringList wh = s.toLower().split('x');
+    if (wh.size() != 2) return QSize();
+    return QSize(wh.at(0).toInt(), wh.at(1).toInt());
+}
+
+bool parseOptions(const QCoreApplication& app, Options* o)
+{
+    QCommandLineParser p;
+    p.setApplicationDescription(QStringLiteral("RoomHub / UdpRelay load generator"));
+    p.addHelpOption();
+    auto opt = [&p](const QString& name, const QString& desc, const QString& def) {
+        p.addOption(QCommandLineOption(name, desc + QStringLiteral(" (default %1)").arg(def), QStringLiteral("v"), def));
+    };
+    opt("mode",        "media (RoomHub/UdpRelay) or control (AuthServer login/get_orders)", "media");
+    opt("host",        "server address", "127.0.0.1");
+    opt("port",        "RoomHub TCP port; UDP relay is port+1", "9000");
+    opt("auth-port",   "AuthServer control port (control mode)", "5555");
+    opt("clients",     "simulated participants", "100");
+    opt("rooms",       "rooms, participants are spread evenly", "10");
+    opt("threads",     "worker threads", QString::number(qMax(1, QThread::idealThreadCount())));
+    opt("ramp",        "seconds over which participants join", "5");
+    opt("warmup",      "seconds after ramp excluded from stats", "5");
+    opt("duration",    "measured seconds", "60");
+    opt("cam-fps",     "camera fps per participant, 0 = off", "15");
+    opt("cam-size",    "camera frame size", "320x240");
+    opt("cam-quality", "camera JPEG quality", "70");
+    opt("talkers",     "audio senders per room", "1");
+    opt("sharers",     "screen sharers per room", "1");
+    opt("screen-fps",  "screen share fps", "2");
+    opt("screen-size", "screen share frame size", "1280x720");
+    opt("screen-quality", "screen JPEG quality", "60");
+    opt("annotators",  "annotating participants per room", "1");
+    opt("annot-hz",    "annotation events per second per annotator", "10");
+    opt("server-pid",  "server pid for CPU/RSS; 0 = find process named 'server'", "0");
+    opt("room-prefix", "room id prefix", "lg");
+    opt("json",        "write machine-readable results to file", "");
+    opt("role",        "control mode account role, expert lists all orders", "expert");
+    opt("keyword",     "control mode get_orders keyword, empty = no search", "");
+    opt("depth",       "control mode requests in flight per connection", "1");
+    opt("order-percent", "control mode share of get_orders, the rest is login", "50");
+    opt("order-limit", "control mode get_orders page size", "200");
+    opt("seed-orders", "control mode orders each client creates before measuring", "0");
+    p.addOption(QCommandLineOption("no-udp", "TCP only (audio falls back to TCP, no screen share)"));
+    p.process(app);
+
+    o->mode       = p.value("mode");
+    o->host       = p.value("host");
+    o->port       = quint16(p.value("port").toUInt());
+    o->authPort   = quint16(p.value("auth-port").toUInt());
+    o->clients    = qMax(1, p.value("clients").toInt());
+    o->rooms      = qBound(1, p.value("rooms").toInt(), o->clients);
+    o->threads    = qBound(1, p.value("threads").toInt(), o->clients);
+    o->rampS      = qMax(0, p.value("ramp").toInt());
+    o->warmupS    = qMax(0, p.value("warmup").toInt());
+    o->durationS  = qMax(1, p.value("duration").toInt());
+    o->camFps     = qBound(0, p.value("cam-fps").toInt(), 60);
+    o->camSize    = parseSize(p.value("cam-size"));
+    o->camQuality = qBound(10, p.value("cam-quality").toInt(), 95);
+    o->talkers    = qMax(0, p.value("talkers").toInt());
+    o->sharers    = qMax(0, p.value("sharers").toInt());
+    o->screenFps  = qBound(0, p.value("screen-fps").toInt(), 30);
+    o->screenSize = parseSize(p.value("screen-size"));
+    o->screenQuality = qBound(10, p.value("screen-quality").toInt(), 95);
+    o->annotators = qMax(0, p.value("annotators").toInt());
+    o->annotHz    = qBound(0, p.value("annot-hz").toInt(), 200);
+    o->udp        = !p.isSet("no-udp");
+    o->serverPid  = p.value("server-pid").toLongLong();
+    o->roomPrefix = p.value("room-prefix");
+    o->jsonPath   = p.value("json");
+    o->role       = p.value("role");
+    o->keyword    = p.value("keyword");
+    o->depth      = qBound(1, p.value("depth").toInt(), 256);
+    o->orderPercent = qBound(0, p.value("order-percent").toInt(), 100);
+    o->orderLimit = qBound(1, p.value("order-limit").toInt(), 1000);
+    o->seedOrders = qMax(0, p.value("seed-orders").toInt());
+
+    if (o->mode != QLatin1String("media") && o->mode != QLatin1String("control")) {
+        qCritical() << "[loadgen] --mode must be media or control";
+        return false;
+    }
+    if (o->mode == QLatin1String("control")) {
+        if (o->authPort == 0 || (o->role != QLatin1String("expert") && o->role != QLatin1String("factory"))) {
+            qCritical() << "[loadgen] bad auth port or role";
+            return false;
+        }
+        return true;
+    }
+    if (o->port == 0 || (o->camFps > 0 && o->camSize.isEmpty()) || (o->screenFps > 0 && o->screenSize.isEmpty())) {
+        qCritical() << "[loadgen] bad port or frame size";
+        return false;
+    }
+    return true;
+}
+
+// unitMs：直方图一个单位是多少毫秒（控制口按 0.1ms 记）
+QJsonObject latencyJson(const LatencyHist& h, double unitMs = 1.0)
+{
+    auto pct = [&h, unitMs](double q) { const int v = h.percentile(q); return v < 0 ? -1.0 : v * unitMs; };
+    return QJsonObject{
+        {"count", double(h.count())},
+        {"mean",  h.mean() * unitMs},
+        {"p50",   pct(0.50)},
+        {"p90",   pct(0.90)},
+        {"p99",   pct(0.99)},
+        {"p999",  pct(0.999)},
+        {"max",   double(h.max()) * unitMs}
+    };
+}
+
+QJsonObject procJson(const ProcSampler& s)
+{
+    if (!s.isValid()) return QJsonObject{{"available", false}};
+    return QJsonObject{
+        {"available",  true},
+        {"pid",        double(s.pid())},
+        {"cpu_avg",    s.cpuAvg()},
+        {"cpu_max",    s.cpuMax()},
+        {"rss_max_kb", double(s.rssMaxKb())}
+    };
+}
+
+QJsonObject buildReport(const Options& o, const SimStats& st, const ProcSampler& srv, const ProcSampler& self)
+{
+    QJsonObject media;
+    for (int m = 0; m < kMediaCount; ++m) {
+        media.insert(mediaName(Media(m)), QJsonObject{
+            {"tx_msgs",    double(st.txMsgs[m])},
+            {"tx_bytes",   double(st.txBytes[m])},
+            {"tx_dropped", double(st.txDropped[m])},
+            {"rx_msgs",    double(st.rxMsgs[m])},
+            {"rx_bytes",   double(st.rxBytes[m])},
+            {"rx_per_s",   double(st.rxMsgs[m]) / o.durationS},
+            {"expected",   double(st.loss[m].expected())},
+            {"received",   double(st.loss[m].received())},
+            {"loss",       st.loss[m].lossRate()},
+            {"latency_ms", latencyJson(st.lat[m])}
+        });
+    }
+    return QJsonObject{
+        {"config", QJsonObject{
+            {"host", o.host}, {"port", o.port}, {"clients", o.clients}, {"rooms", o.rooms},
+            {"threads", o.threads}, {"duration_s", o.durationS}, {"warmup_s", o.warmupS},
+            {"cam_fps", o.camFps}, {"cam_size", QStringLiteral("%1x%2").arg(o.camSize.width()).arg(o.camSize.height())},
+            {"talkers", o.talkers}, {"sharers", o.sharers}, {"screen_fps", o.screenFps},
+            {"annotators", o.annotators}, {"annot_hz", o.annotHz}, {"udp", o.udp}
+        }},
+        {"join_ms",       latencyJson(st.join)},
+        {"join_failures", st.joinFailures},
+        {"disconnects",   st.disconnects},
+        {"media",         media},
+        {"server",        procJson(srv)},
+        {"loadgen",       procJson(self)}
+    };
+}
+
+QJsonObject buildControlReport(const Options& o, const AuthStats& st, const ProcSampler& srv, const ProcSampler& self)
+{
+    QJsonObject ops;
+    for (int i = 0; i < kAuthOpCount; ++i) {
+        ops.insert(authOpName(AuthOp(i)), QJsonObject{
+            {"ok",         double(st.ok[i])},
+            {"failed",     double(st.failed[i])},
+            {"per_s",      double(st.ok[i]) / o.durationS},
+            {"latency_ms", latencyJson(st.lat[i], 0.1)}
+        });
+    }
+    return QJsonObject{
+        {"config", QJsonObject{
+            {"mode", o.mode}, {"host", o.host}, {"auth_port", o.authPort}, {"clients", o.clients},
+            {"threads", o.threads}, {"duration_s", o.durationS}, {"warmup_s", o.warmupS},
+            {"role", o.role}, {"keyword", o.keyword}, {"depth", o.depth},
+            {"order_percent", o.orderPercent}, {"order_limit", o.orderLimit}, {"seed_orders", o.seedOrders}
+        }},
+        {"connect_failures", st.connectFailures},
+        {"disconnects",      st.disconnects},
+        {"ops",              ops},
+        {"server",           procJson(srv)},
+        {"loadgen",          procJson(self)}
+    };
+}
+
+void printProc(QTextStream& out, const QJsonObject& r)
+{
+    for (const char* who : {"server", "loadgen"}) {
+        const QJsonObject p = r.value(who).toObject();
+        out << who << ": ";
+        if (!p.value("available").toBool()) { out << "n/a\n"; continue; }
+        out << "pid=" << qint64(p.value("pid").toDouble())
+            << " cpu_avg=" << QString::number(p.value("cpu_avg").toDouble(), 'f', 1) << "%"
+            << " cpu_max=" << QString::number(p.value("cpu_max").toDouble(), 'f', 1) << "%"
+            << " rss_max=" << qint64(p.value("rss_max_kb").toDouble()) / 1024 << "MB\n";
+    }
+}
+
+void printControlReport(const QJsonObject& r)
+{
+    QTextStream out(stdout);
+    out << "\n==== loadgen report (control) ====\n";
+    const QJsonObject cfg = r.value("config").toObject();
+    out << "clients=" << cfg.value("clients").toInt() << " depth=" << cfg.value("depth").toInt()
+        << " duration=" << cfg.value("duration_s").toInt() << "s"
+        << " connect_failures=" << r.value("connect_failures").toInt()
+        << " disconnects=" << r.value("disconnects").toInt() << "\n";
+    out << qSetFieldWidth(11) << left << "op" << "ok" << "failed" << "ok/s"
+        << "p50ms" << "p90ms" << "p99ms" << "p99.9ms" << "maxms" << qSetFieldWidth(0) << "\n";
+    const QJsonObject ops = r.value("ops").toObject();
+    for (int i = 0; i < kAuthOpCount; ++i) {
+        const QJsonObject e = ops.value(authOpName(AuthOp(i))).toObject();
+        const QJsonObject l = e.value("latency_ms").toObject();
+        auto ms = [&l](const char* k) { return QString::number(l.value(k).toDouble(), 'f', 1); };
+        out << qSetFieldWidth(11) << left << authOpName(AuthOp(i))
+            << qint64(e.value("ok").toDouble()) << qint64(e.value("failed").toDouble())
+            << QString::number(e.value("per_s").toDouble(), 'f', 1)
+            << ms("p50") << ms("p90") << ms("p99") << ms("p999") << ms("max")
+            << qSetFieldWidth(0) << "\n";
+    }
+    printProc(out, r);
+    out.flush();
+}
+
+void printReport(const QJsonObject& r)
+{
+    QTextStream out(stdout);
+    out << "\n==== loadgen report ====\n";
+    const QJsonObject cfg = r.value("config").toObject();
+    out << "clients=" << cfg.value("clients").toInt() << " rooms=" << cfg.value("rooms").toInt()
+        << " duration=" << cfg.value("duration_s").toInt() << "s"
+        << " join_failures=" << r.value("join_failures").toInt()
+        << " disconnects=" << r.value("disconnects").toInt()
+        << " join_p99=" << r.value("join_ms").toObject().value("p99").toInt() << "ms\n";
+    out << qSetFieldWidth(10) << left << "media" << "tx" << "rx/s" << "loss%"
+        << "p50" << "p90" << "p99" << "p99.9" << "max" << qSetFieldWidth(0) << "\n";
+    const QJsonObject media = r.value("media").toObject();
+    for (int m = 0; m < kMediaCount; ++m) {
+        const QJsonObject e = media.value(mediaName(Media(m))).toObject();
+        if (e.value("tx_msgs").toDouble() == 0 && e.value("rx_msgs").toDouble() == 0) continue;
+        const QJsonObject l = e.value("latency_ms").toObject();
+        out << qSetFieldWidth(10) << left << mediaName(Media(m))
+            << qint64(e.value("tx_msgs").toDouble())
+            << QString::number(e.value("rx_per_s").toDouble(), 'f', 1)
+            << QString::number(e.value("loss").toDouble() * 100.0, 'f', 2)
+            << l.value("p50").toInt() << l.value("p90").toInt() << l.value("p99").toInt()
+            << l.value("p999").toInt() << qint64(l.value("max").toDouble())
+            << qSetFieldWidth(0) << "\n";
+    }
+    printProc(out, r);
+    out.flush();
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("loadgen"));
+
+    Options o;
+    if (!parseOptions(app, &o)) return 2;
+
+    const bool control = o.mode == QLatin1String("control");
+    const SynthMedia media = SynthMedia::build(!control && o.camFps > 0 ? o.camSize : QSize(),
+                                               !control && o.screenFps > 0 ? o.screenSize : QSize(),
+                                               o.camQuality, o.screenQuality);
+    auto avgBytes = [](const QVector<QByteArray>& v) {
+        qint64 n = 0;
+        for (const QByteArray& b : v) n += b.size();
+        return v.isEmpty() ? 0 : n / v.size();
+    };
+    if (!control)
+        qInfo() << "[loadgen] camera jpeg avg" << avgBytes(media.camJpeg) << "bytes,"
+                << "screen jpeg avg" << avgBytes(media.screenJpeg) << "bytes";
+
+    ProcSampler self(QCoreApplication::applicationPid());
+    const qint64 srvPid = o.serverPid > 0 ? o.serverPid : ProcSampler::findByName(QStringLiteral("server"));
+    ProcSampler srv(srvPid);
+    if (!srv.isValid())
+        qWarning() << "[loadgen] server process not found, CPU/RSS not sampled (use --server-pid)";
+
+    // 工作线程：客户端在各自线程里创建、收发，统计最后一次性取回
+    LiveCounters live;
+    QVector<QThread*> threads;
+    QVector<QObject*> workers;
+    for (int t = 0; t < o.threads; ++t) {
+        auto* th = new QThread;
+        th->setObjectName(QStringLiteral("loadgen-%1").arg(t));
+        auto* w = new QObject;
+        w->moveToThread(th);
+        QObject::connect(th, &QThread::finished, w, &QObject::deleteLater);
+        th->start();
+        threads.push_back(th);
+        workers.push_back(w);
+    }
+
+    const qint64 t0 = QDateTime::currentMSecsSinceEpoch();
+    const qint64 measureFrom = t0 + qint64(o.rampS + o.warmupS) * 1000;
+    const int rampMs = o.rampS * 1000;
+
+    QVector<SimClient*> clients;
+    QVector<AuthSimClient*> authClients;
+    for (int i = 0; control && i < o.clients; ++i) {
+        AuthSimClient::Config cfg;
+        cfg.host = o.host;
+        cfg.port = o.authPort;
+        cfg.user = QStringLiteral("%1-u%2").arg(o.roomPrefix).arg(i);
+        cfg.role = o.role;
+        cfg.keyword = o.keyword;
+        cfg.depth = o.depth;
+        cfg.orderPercent = o.orderPercent;
+        cfg.orderLimit = o.orderLimit;
+        cfg.seedOrders = o.seedOrders;
+        cfg.measureFromMs = measureFrom;
+
+        QObject* w = workers.at(i % o.threads);
+        const int delay = o.clients > 1 ? int(qint64(rampMs) * i / o.clients) : 0;
+        AuthSimClient* c = nullptr;
+        QMetaObject::invokeMethod(w, [&c, cfg, &live, w, delay] {
+            c = new AuthSimClient(cfg, &live, w);
+            AuthSimClient* ac = c;
+            QTimer::singleShot(delay, ac, [ac] { ac->start(); });
+        }, Qt::BlockingQueuedConnection);
+        authClients.push_back(c);
+    }
+    for (int i = 0; !control && i < o.clients; ++i) {
+        // 轮流分房间：入房过程中各房间人数一起涨；每个房间里前几个人承担发言/共享/标注
+        const int room = i % o.rooms;
+        const int rank = i / o.rooms;
+        SimClient::Config cfg;
+        cfg.host = o.host;
+        cfg.port = o.port;
+        cfg.room = QStringLiteral("%1-%2").arg(o.roomPrefix).arg(room);
+        cfg.user = QStringLiteral("%1-u%2").arg(o.roomPrefix).arg(i);
+        cfg.camFps = o.camFps;
+        cfg.talker = rank < o.talkers;
+        cfg.sharer = rank < o.sharers;
+        cfg.screenFps = o.screenFps;
+        cfg.annotator = rank < o.annotators;
+        cfg.annotHz = o.annotHz;
+        cfg.udp = o.udp;
+        cfg.measureFromMs = measureFrom;
+
+        QObject* w = workers.at(i % o.threads);
+        const int delay = o.clients > 1 ? int(qint64(rampMs) * i / o.clients) : 0;
+        SimClient* c = nullptr;
+        QMetaObject::invokeMethod(w, [&c, cfg, &media, &live, w, delay] {
+            c = new SimClient(cfg, &media, &live, w);
+            SimClient* sc = c;
+            QTimer::singleShot(delay, sc, [sc] { sc->start(); });
+        }, Qt::BlockingQueuedConnection);
+        clients.push_back(c);
+    }
+
+    // 进度：每 5 秒一行
+    QTimer progress;
+    progress.setInterval(kProgressMs);
+    QObject::connect(&progress, &QTimer::timeout, [&] {
+        srv.sample();
+        self.sample();
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if (control) {
+            qInfo().noquote() << QStringLiteral("[loadgen] t=%1s %2 connected=%3 ready=%4 req=%5 rep=%6 srv_cpu=%7% srv_rss=%8MB self_cpu=%9%")
+                .arg((now - t0) / 1000)
+                .arg(now < measureFrom ? QStringLiteral("warmup") : QStringLiteral("measure"))
+                .arg(live.connected.load()).arg(live.joined.load())
+                .arg(live.txMsgs.load()).arg(live.rxMsgs.load())
+                .arg(srv.cpuPercent(), 0, 'f', 1).arg(srv.rssKb() / 1024)
+                .arg(self.cpuPercent(), 0, 'f', 1);
+            return;
+        }
+        qInfo().noquote() << QStringLiteral("[loadgen] t=%1s %2 connected=%3 joined=%4 udp=%5 tx=%6 rx=%7 srv_cpu=%8% srv_rss=%9MB self_cpu=%10%")
+            .arg((now - t0) / 1000)
+            .arg(now < measureFrom ? QStringLiteral("warmup") : QStringLiteral("measure"))
+            .arg(live.connected.load()).arg(live.joined.load()).arg(live.udpReady.load())
+            .arg(live.txMsgs.load()).arg(live.rxMsgs.load())
+            .arg(srv.cpuPercent(), 0, 'f', 1).arg(srv.rssKb() / 1024)
+            .arg(self.cpuPercent(), 0, 'f', 1);
+    });
+    progress.start();
+
+    // 测量开始时重置峰值，预热期的启动开销不计入
+    QTimer::singleShot(int(measureFrom - t0), [&] {
+        srv.sample();
+        self.sample();
+        srv.resetPeak();
+        self.resetPeak();
+        qInfo() << "[loadgen] measuring for" << o.durationS << "s";
+    });
+
+    QJsonObject report;
+    QTimer::singleShot(int(measureFrom - t0) + o.durationS * 1000, [&] {
+        srv.sample();
+        self.sample();
+        for (SimClient* c : clients)
+            QMetaObject::invokeMethod(c, [c] { c->stopSending(); }, Qt::QueuedConnection);
+        for (AuthSimClient* c : authClients)
+            QMetaObject::invokeMethod(c, [c] { c->stopSending(); }, Qt::QueuedConnection);
+
+        QTimer::singleShot(kDrainMs, [&] {
+            progress.stop();
+            if (control) {
+                AuthStats total;
+                for (AuthSimClient* c : authClients) {
+                    AuthStats s;
+                    QMetaObject::invokeMethod(c, [c, &s] { s = c->stats(); }, Qt::BlockingQueuedConnection);
+                    total.merge(s);
+                }
+                report = buildControlReport(o, total, srv, self);
+                printControlReport(report);
+            } else {
+                SimStats total;
+                for (SimClient* c : clients) {
+                    SimStats s;
+                    QMetaObject::invokeMethod(c, [c, &s] { s = c->stats(); }, Qt::BlockingQueuedConnection);
+                    total.merge(s);
+                }
+                report = buildReport(o, total, srv, self);
+                printReport(report);
+            }
+            if (!o.jsonPath.isEmpty()) {
+                QFile f(o.jsonPath);
+                if (f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+                    f.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+                else
+                    qWarning() << "[loadgen] cannot write" << o.jsonPath;
+            }
+            app.quit();
+        });
+    });
+
+    const int rc = app.exec();
+    for (QThread* th : threads) {
+        th->quit();
+        th->wait();
+        delete th;
+    }
+    return rc;
+}
@@ -0,0 +1,295 @@
+#include "simclient.h"
+#include "annot.h"
+
+namespace {
+const int kAudioFrameMs     = 20;
+const int kStrokeUpdates    = 20;       // 每笔 begin + 20 次 update + end
+const int kPointsPerUpdate  = 4;
+const int kJoinTimeoutMs    = 10000;
+const int kAudioLevelDbov   = 20;       // 按正常说话电平上报，主讲人选择会放行
+const QString kMixSender    = QStringLiteral("__mix__");
+}
+
+SimClient::SimClient(const Config& cfg, const SynthMedia* media, LiveCounters* live, QObject* parent)
+    : QObject(parent), cfg_(cfg), media_(media), live_(live)
+{
+    connect(&sock_, &QTcpSocket::connected, this, &SimClient::onConnected);
+    connect(&sock_, &QTcpSocket::readyRead, this, &SimClient::onReadyRead);
+    connect(&sock_, &QTcpSocket::disconnected, this, &SimClient::onDisconnected);
+    connect(&sock_, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
+            [this](QAbstractSocket::SocketError) {
+        qWarning() << "[loadgen]" << cfg_.user << "socket error:" << sock_.errorString();
+    });
+
+    connect(&udp_, &UdpMediaClient::udpStateChanged, this, &SimClient::onUdpState);
+    connect(&udp_, &UdpMediaClient::udpAudioFrame, this, &SimClient::onUdpAudio);
+    connect(&udp_, &UdpMediaClient::udpScreenFrame, this, &SimClient::onUdpScreen);
+
+    audioTimer_.setTimerType(Qt::PreciseTimer);
+    connect(&camTimer_, &QTimer::timeout, this, &SimClient::sendCamera);
+    connect(&audioTimer_, &QTimer::timeout, this, &SimClient::sendAudio);
+    connect(&annotTimer_, &QTimer::timeout, this, &SimClient::sendAnnot);
+    connect(&screenTimer_, &QTimer::timeout, this, &SimClient::sendScreen);
+}
+
+void SimClient::start()
+{
+    joinTimer_.start();
+    sock_.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    sock_.connectToHost(cfg_.host, cfg_.port);
+    QTimer::singleShot(kJoinTimeoutMs, this, [this] {
+        if (joined_) return;
+        ++stats_.joinFailures;
+        qWarning() << "[loadgen]" << cfg_.user << "join timeout";
+    });
+}
+
+void SimClient::stopSending()
+{
+    sending_ = false;
+    camTimer_.stop();
+    audioTimer_.stop();
+    annotTimer_.stop();
+    screenTimer_.stop();
+}
+
+void SimClient::onConnected()
+{
+    live_->connected.ref();
+    sendTcp(Media::Count, MSG_JOIN_WORKORDER, QJsonObject{{"roomId", cfg_.room}, {"user", cfg_.user}});
+    if (cfg_.udp) {
+        udp_.configureServer(cfg_.host, quint16(cfg_.port + 1));
+        udp_.setIdentity(cfg_.room, cfg_.user);
+    }
+}
+
+void SimClient::onDisconnected()
+{
+    live_->connected.deref();
+    if (joined_) live_->joined.deref();
+    ++stats_.disconnects;
+    joined_ = false;
+    stopSending();
+    udp_.stop();
+}
+
+void SimClient::onUdpState(bool ok)
+{
+    if (udpOk_ == ok) return;
+    udpOk_ = ok;
+    if (ok) live_->udpReady.ref();
+    else    live_->udpReady.deref();
+}
+
+void SimClient::onReadyRead()
+{
+    rxBuf_.append(sock_.readAll());
+    QVector<Packet> pkts;
+    if (!drainPackets(rxBuf_, pkts)) return;
+    for (const Packet& p : pkts) handlePacket(p);
+}
+
+void SimClient::handlePacket(const Packet& p)
+{
+    switch (p.type) {
+    case MSG_SERVER_EVENT:
+        if (!joined_ && p.json.value("message").toString() == QLatin1String("joined")) {
+            joined_ = true;
+            live_->joined.ref();
+            stats_.join.add(joinTimer_.elapsed());
+            startTraffic();
+        } else if (p.json.value("code").toInt() >= 400) {
+            qWarning() << "[loadgen]" << cfg_.user << "server error:" << p.json;
+        }
+        break;
+
+    case MSG_VIDEO_FRAME:
+        if (p.json.value("media").toString("camera") != QLatin1String("camera")) break;
+        record(Media::Camera, p.json.value("sender").toString(),
+               quint32(p.json.value("seq").toDouble()), p.json.value("ts").toVariant().toLongLong(), p.bin.size());
+        break;
+
+    case MSG_AUDIO_FRAME:
+    {
+        const QString sender = p.json.value("sender").toString();
+        record(sender == kMixSender ? Media::AudioMix : Media::Audio, sender,
+               quint32(p.json.value("seq").toInt()), p.json.value("ts").toVariant().toLongLong(), p.bin.size());
+        break;
+    }
+
+    case MSG_ANNOT:
+        record(Media::Annot, p.json.value("sender").toString(),
+               quint32(p.json.value("seq").toDouble()), p.json.value("ts").toVariant().toLongLong(), p.bin.size());
+        break;
+
+    default:
+        break;  // 成员列表、层级通知等不统计
+    }
+}
+
+// 入房后按角色启动各路发送；首帧随机错开，避免几百个客户端同一毫秒发
+void SimClient::startTraffic()
+{
+    if (!sending_) return;
+    auto* rng = QRandomGenerator::global();
+    auto kick = [this, rng](QTimer& t, int intervalMs, void (SimClient::*fn)()) {
+        t.setInterval(intervalMs);
+        QTimer::singleShot(int(rng->bounded(intervalMs)), this, [this, &t, fn] {
+            if (!sending_) return;
+            (this->*fn)();
+            t.start();
+        });
+    };
+    if (cfg_.camFps > 0 && !media_->camJpeg.isEmpty())
+        kick(camTimer_, 1000 / cfg_.camFps, &SimClient::sendCamera);
+    if (cfg_.talker)
+        kick(audioTimer_, kAudioFrameMs, &SimClient::sendAudio);
+    if (cfg_.annotator && cfg_.annotHz > 0)
+        kick(annotTimer_, qMax(1, 1000 / cfg_.annotHz), &SimClient::sendAnnot);
+    if (cfg_.sharer && cfg_.screenFps > 0 && !media_->screenJpeg.isEmpty())
+        kick(screenTimer_, 1000 / cfg_.screenFps, &SimClient::sendScreen);
+}
+
+void SimClient::sendTcp(Media m, quint16 type, const QJsonObject& j, const QByteArray& bin)
+{
+    const QByteArray pkt = buildPacket(type, j, bin);
+    sock_.write(pkt);
+    if (m != Media::Count) countTx(m, pkt.size());
+}
+
+// 计数只算测量窗口内的，和收端口径一致；进度计数不限
+void SimClient::countTx(Media m, int bytes)
+{
+    live_->txMsgs.ref();
+    if (QDateTime::currentMSecsSinceEpoch() < cfg_.measureFromMs) return;
+    ++stats_.txMsgs[int(m)];
+    stats_.txBytes[int(m)] += bytes;
+}
+
+void SimClient::sendCamera()
+{
+    if (sock_.bytesToWrite() > cfg_.maxTxQueue) {
+        ++stats_.txDropped[int(Media::Camera)];
+        return;
+    }
+    const quint32 seq = camSeq_++;
+    QJsonObject meta{
+        {"roomId", cfg_.room},
+        {"sender", cfg_.user},
+        {"media",  "camera"},
+        {"layer",  0},
+        {"seq",    double(seq)},
+        {"ts",     QDateTime::currentMSecsSinceEpoch()},
+        {"w",      media_->camSize.width()},
+        {"h",      media_->camSize.height()}
+    };
+    sendTcp(Media::Camera, MSG_VIDEO_FRAME, meta, media_->camJpeg.at(int(seq % quint32(media_->camJpeg.size()))));
+}
+
+// 与 AudioChat::onTxReady 一致：UDP 优先，不可用时 TCP 兜底
+void SimClient::sendAudio()
+{
+    const quint32 seq = audioSeq_++;
+    const qint64 ts = QDateTime::currentMSecsSinceEpoch();
+    const QByteArray payload = media_->audioFrame(seq);
+    if (cfg_.udp && udp_.sendAudio(QStringLiteral("mulaw"), SynthMedia::kAudioRate, seq, ts, payload,
+                                    kAudioLevelDbov, true)) {
+        countTx(Media::Audio, payload.size());
+        return;
+    }
+    QJsonObject j{
+        {"roomId", cfg_.room},
+        {"sender", cfg_.user},
+        {"codec",  "mulaw"},
+        {"sr",     SynthMedia::kAudioRate},
+        {"ch",     1},
+        {"seq",    static_cast<int>(seq)},
+        {"ts",     ts},
+        {"lvl",    kAudioLevelDbov},
+        {"vad",    true}
+    };
+    sendTcp(Media::Audio, MSG_AUDIO_FRAME, j, payload);
+}
+
+// 在自己的画面上画笔：begin 一个点，之后每次 update 带 kPointsPerUpdate 个点（q16v 编码），最后 end
+void SimClient::sendAnnot()
+{
+    auto* rng = QRandomGenerator::global();
+    QJsonObject ev{
+        {"roomId", cfg_.room},
+        {"sender", cfg_.user},
+        {"target", cfg_.user},
+        {"id",     QStringLiteral("%1-%2").arg(cfg_.user).arg(strokeNo_)},
+        {"seq",    double(annotSeq_++)},
+        {"ts",     QDateTime::currentMSecsSinceEpoch()}
+    };
+    QByteArray bin;
+    if (strokeStep_ < 0) {
+        pen_ = QPointF(0.2 + 0.6 * rng->generateDouble(), 0.2 + 0.6 * rng->generateDouble());
+        ev["op"] = "begin";
+        ev["tool"] = "pen";
+        ev["color"] = "#FF0000";
+        ev["width"] = 3;
+        ev["enc"] = "q16v";
+        bin = AnnotModel::encodePoints({ pen_ });
+        strokeStep_ = 0;
+    } else if (strokeStep_ < kStrokeUpdates) {
+        QVector<QPointF> pts;
+        for (int i = 0; i < kPointsPerUpdate; ++i) {
+            pen_ += QPointF((rng->generateDouble() - 0.5) * 0.01, (rng->generateDouble() - 0.5) * 0.01);
+            pen_ = QPointF(qBound(0.0, pen_.x(), 1.0), qBound(0.0, pen_.y(), 1.0));
+            pts.push_back(pen_);
+        }
+        ev["op"] = "update";
+        ev["enc"] = "q16v";
+        bin = AnnotModel::encodePoints(pts);
+        ++strokeStep_;
+    } else {
+        ev["op"] = "end";
+        strokeStep_ = -1;
+        ++strokeNo_;
+    }
+    sendTcp(Media::Annot, MSG_ANNOT, ev, bin);
+}
+
+void SimClient::sendScreen()
+{
+    if (!udpOk_) {
+        ++stats_.txDropped[int(Media::Screen)];
+        return;
+    }
+    const quint32 seq = screenSeq_++;
+    const QByteArray jpeg = SynthMedia::tagSeq(media_->screenJpeg.at(int(seq % quint32(media_->screenJpeg.size()))), seq);
+    udp_.sendScreenJpeg(jpeg, media_->screenSize.width(), media_->screenSize.height(),
+                        QDateTime::currentMSecsSinceEpoch());
+    countTx(Media::Screen, jpeg.size());
+}
+
+void SimClient::onUdpAudio(const QString& sender, const QString& codec, int sr, quint32 seq, qint64 ts, QByteArray payload)
+{
+    Q_UNUSED(codec);
+    Q_UNUSED(sr);
+    record(sender == kMixSender ? Media::AudioMix : Media::Audio, sender, seq, ts, payload.size());
+}
+
+void SimClient::onUdpScreen(const QString& sender, QByteArray jpeg, int w, int h, qint64 ts)
+{
+    Q_UNUSED(w);
+    Q_UNUSED(h);
+    quint32 seq = 0;
+    if (!SynthMedia::readSeq(jpeg, &seq)) return;   // 不是压测发的帧
+    record(Media::Screen, sender, seq, ts, jpeg.size());
+}
+
+// 混音流的 ts 是服务器出帧时刻：同机跑时是服务器到客户端的时延，跨机要求时钟同步
+void SimClient::record(Media m, const QString& sender, quint32 seq, qint64 ts, int bytes)
+{
+    if (sender.isEmpty() || sender == cfg_.user) return;
+    live_->rxMsgs.ref();
+    // 只统计预热结束后发出的帧
+    if (ts < cfg_.measureFromMs) return;
+    ++stats_.rxMsgs[int(m)];
+    stats_.rxBytes[int(m)] += bytes;
+    stats_.lat[int(m)].add(QDateTime::currentMSecsSinceEpoch() - ts);
+    stats_.loss[int(m)].onSeq(sender, seq);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <QtCore>
+#include <QtNetwork>
+#include "protocol.h"
+#include "udpmedia.h"
+#include "loadstats.h"
+#include "synthmedia.h"
+
+// 一个模拟参会者：TCP 连 RoomHub、MSG_JOIN_WORKORDER 入房，UDP 走 UdpMediaClient（和真实客户端同一份代码）
+// 发送按角色和速率：摄像头 JPEG（TCP，0 层）、µ-law 语音（UDP，不可用时 TCP 兜底）、
+// 标注笔画（TCP，begin/update/end）、屏幕共享（UDP 分片）
+// 收到的每帧按 ts 算端到端时延、按序号算丢包，只在 measureFromMs 之后计入
+// 对象必须在它所属的工作线程里创建和使用
+class SimClient : public QObject {
+    Q_OBJECT
+public:
+    struct Config {
+        QString host;
+        quint16 port = 9000;        // RoomHub；UDP 端口 = port + 1
+        QString room;
+        QString user;
+        int  camFps = 0;            // 0 不发
+        bool talker = false;
+        bool sharer = false;
+        int  screenFps = 0;
+        bool annotator = false;
+        int  annotHz = 0;           // 每秒标注事件数
+        bool udp = true;
+        int  maxTxQueue = 4 << 20;  // TCP 待发超过此值时丢摄像头/屏幕帧，和真实客户端的拥塞退让一致
+        qint64 measureFromMs = 0;
+    };
+
+    SimClient(const Config& cfg, const SynthMedia* media, LiveCounters* live, QObject* parent = nullptr);
+
+    void start();
+    void stopSending();
+    SimStats stats() const { return stats_; }
+
+private:
+    void onConnected();
+    void onReadyRead();
+    void onDisconnected();
+    void onUdpState(bool ok);
+    void handlePacket(const Packet& p);
+    void startTraffic();
+
+    void sendCamera();
+    void sendAudio();
+    void sendAnnot();
+    void sendScreen();
+    void sendTcp(Media m, quint16 type, const QJsonObject& j, const QByteArray& bin = QByteArray());
+    void countTx(Media m, int bytes);
+
+    void onUdpAudio(const QString& sender, const QString& codec, int sr, quint32 seq, qint64 ts, QByteArray payload);
+    void onUdpScreen(const QString& sender, QByteArray jpeg, int w, int h, qint64 ts);
+    void record(Media m, const QString& sender, quint32 seq, qint64 ts, int bytes);
+
+    Config cfg_;
+    const SynthMedia* media_;
+    LiveCounters* live_;
+    SimStats stats_;
+
+    QTcpSocket sock_;
+    QByteArray rxBuf_;
+    UdpMediaClient udp_;
+    QElapsedTimer joinTimer_;
+    bool joined_ = false;
+    bool udpOk_ = false;
+    bool sending_ = true;
+
+    QTimer camTimer_;
+    QTimer audioTimer_;
+    QTimer annotTimer_;
+    QTimer screenTimer_;
+    quint32 camSeq_ = 0;
+    quint32 audioSeq_ = 0;
+    quint32 annotSeq_ = 0;
+    quint32 screenSeq_ = 0;
+
+    // 当前标注笔画
+    int     strokeNo_ = 0;
+    int     strokeStep_ = -1;      // -1 = 下一事件是 begin
+    QPointF pen_;
+};
@@ -0,0 +1,124 @@
+#include "synthmedia.h"
+#include "audiodsp.h"
+#include <cmath>
+
+namespace {
+const quint32 kSeed        = 20240601;  // 固定种子，每次压测的输入一致
+const int     kCamNoise    = 10;        // 摄像头噪声幅度，决定 JPEG 大小
+const double  kToneHz      = 220.0;
+const double  kToneAmp     = 3000.0;    // 约 -20dBov，和真实说话电平相当
+const char    kSeqTag[2]   = {'L', 'G'};
+
+QByteArray toJpeg(const QImage& img, int quality)
+{
+    QByteArray out;
+    QBuffer buf(&out);
+    buf.open(QIODevice::WriteOnly);
+    img.save(&buf, "JPEG", quality);
+    return out;
+}
+
+QImage makeCamFrame(const QSize& size, int i, QRandomGenerator& rng)
+{
+    QImage img(size, QImage::Format_RGB32);
+    const int w = size.width(), h = size.height();
+    for (int y = 0; y < h; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
+        for (int x = 0; x < w; ++x) {
+            const int n = int(rng.bounded(2 * kCamNoise + 1)) - kCamNoise;
+            const int r = qBound(0, 60 + x * 120 / w + n, 255);
+            const int g = qBound(0, 80 + y * 100 / h + n, 255);
+            const int b = qBound(0, 110 + n, 255);
+            line[x] = qRgb(r, g, b);
+        }
+    }
+    // 画面中间一块随帧移动的“人脸”
+    QPainter p(&img);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(220, 180, 150));
+    const double phase = 2.0 * M_PI * i / SynthMedia::kCamFrames;
+    const QPointF c(w / 2.0 + std::sin(phase) * w / 10.0, h / 2.0 + std::cos(phase) * h / 20.0);
+    p.drawEllipse(c, w / 6.0, h / 4.0);
+    return img;
+}
+
+QImage makeScreenFrame(const QSize& size, int i, QRandomGenerator& rng)
+{
+    QImage img(size, QImage::Format_RGB32);
+    img.fill(Qt::white);
+    QPainter p(&img);
+    p.setPen(Qt::NoPen);
+    // 标题栏 + 若干行长短不一的“文字”
+    p.fillRect(0, 0, size.width(), 28, QColor(45, 45, 48));
+    const int lineH = 18;
+    for (int y = 40 + (i % 2) * lineH; y + lineH < size.height(); y += lineH) {
+        int x = 16;
+        while (x < size.width() - 40) {
+            const int word = 12 + int(rng.bounded(60));
+            p.fillRect(x, y + 4, word, 9, QColor(30, 30, 30 + int(rng.bounded(120))));
+            x += word + 8;
+            if (rng.bounded(12) == 0) break;
+        }
+    }
+    return img;
+}
+}
+
+SynthMedia SynthMedia::build(const QSize& cam, const QSize& screen, int camQuality, int screenQuality)
+{
+    SynthMedia m;
+    QRandomGenerator rng(kSeed);
+
+    m.camSize = cam;
+    if (!cam.isEmpty()) {
+        for (int i = 0; i < kCamFrames; ++i)
+            m.camJpeg.push_back(toJpeg(makeCamFrame(cam, i, rng), camQuality));
+    }
+    m.screenSize = screen;
+    if (!screen.isEmpty()) {
+        for (int i = 0; i < kScreenFrames; ++i)
+            m.screenJpeg.push_back(toJpeg(makeScreenFrame(screen, i, rng), screenQuality));
+    }
+
+    QVector<qint16> pcm(kAudioRate);
+    for (int i = 0; i < kAudioRate; ++i) {
+        const double t = double(i) / kAudioRate;
+        const double env = 0.6 + 0.4 * std::sin(2.0 * M_PI * 4.0 * t);
+        const double noise = (rng.generateDouble() - 0.5) * 400.0;
+        pcm[i] = qint16(qBound(-32768.0, kToneAmp * env * std::sin(2.0 * M_PI * kToneHz * t) + noise, 32767.0));
+    }
+    m.ulaw.resize(kAudioRate);
+    AudioDsp::encodeUlaw(pcm.constData(), reinterpret_cast<quint8*>(m.ulaw.data()), kAudioRate);
+    return m;
+}
+
+QByteArray SynthMedia::audioFrame(quint32 seq) const
+{
+    const int frames = ulaw.size() / kAudioFrameBytes;
+    if (frames <= 0) return QByteArray(kAudioFrameBytes, char(0xFF));    // µ-law 静音
+    return ulaw.mid(int(seq % quint32(frames)) * kAudioFrameBytes, kAudioFrameBytes);
+}
+
+// SOI 之后插入 FF FE <len=8> 'L' 'G' <seq 大端 4 字节>
+QByteArray SynthMedia::tagSeq(const QByteArray& jpeg, quint32 seq)
+{
+    if (jpeg.size() < 2) return jpeg;
+    QByteArray seg;
+    seg.reserve(10);
+    seg.append(char(0xFF)).append(char(0xFE)).append(char(0)).append(char(8));
+    seg.append(kSeqTag, 2);
+    seg.append(char(seq >> 24)).append(char(seq >> 16)).append(char(seq >> 8)).append(char(seq));
+    QByteArray out = jpeg;
+    out.insert(2, seg);
+    return out;
+}
+
+bool SynthMedia::readSeq(const QByteArray& jpeg, quint32* seq)
+{
+    if (jpeg.size() < 12) return false;
+    const uchar* p = reinterpret_cast<const uchar*>(jpeg.constData());
+    if (p[2] != 0xFF || p[3] != 0xFE || p[6] != quint8(kSeqTag[0]) || p[7] != quint8(kSeqTag[1])) return false;
+    *seq = (quint32(p[8]) << 24) | (quint32(p[9]) << 16) | (quint32(p[10]) << 8) | quint32(p[11]);
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <QtCore>
+#include <QtGui>
+
+// 压测用的合成媒体，启动时生成一次，各线程只读共享
+// - 摄像头：噪声 + 渐变 + 移动色块的真实 JPEG，若干帧轮流发，大小有起伏，接近实拍
+// - 屏幕：白底“文字行”色块的 JPEG，压缩率接近文档/代码类共享
+// - 语音：1 秒 4Hz 包络的带噪音调，8kHz µ-law，按 20ms 帧切片循环
+// JPEG 里插一个 COM 段携带序号（标准允许，解码器会忽略），UDP 屏幕帧靠它统计丢包
+struct SynthMedia {
+    static const int kCamFrames    = 16;
+    static const int kScreenFrames = 4;
+    static const int kAudioRate    = 8000;
+    static const int kAudioFrameBytes = kAudioRate * 20 / 1000;
+
+    QVector<QByteArray> camJpeg;
+    QSize camSize;
+    QVector<QByteArray> screenJpeg;
+    QSize screenSize;
+    QByteArray ulaw;
+
+    static SynthMedia build(const QSize& cam, const QSize& screen, int camQuality, int screenQuality);
+
+    QByteArray audioFrame(quint32 seq) const;
+
+    static QByteArray tagSeq(const QByteArray& jpeg, quint32 seq);
+    static bool readSeq(const QByteArray& jpeg, quint32* seq);
+};
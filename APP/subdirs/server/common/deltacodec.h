@@ -0,0 +1,21 @@
+#pragma once
+#include <QtCore>
+#include <QImage>
+
+// 屏幕共享增量帧 DS01（客户端与服务器 common 各一份，内容相同）
+// BigEndian：u32 magic='DS01', u16 rectCount, [u16 x, u16 y, u16 w, u16 h, u32 compLen, compData]...
+// compData 是 Format_RGB32 区域像素逐行拼接后 qCompress 得到
+// 编码在 ScreenShare，解码在 MainWindow（显示）和 RecorderRoom（录制）
+namespace DeltaCodec {
+
+const quint32 kMagic    = 0x44533031;   // 'DS01'
+const int     kMaxRects = 120;          // 合并后超过这么多块就不值得发增量
+
+// prev/curr 均为 RGB32；尺寸不同或变化块太多返回空（调用方改发关键帧），无变化返回只有头的空增量
+QByteArray encode(const QImage& prev, const QImage& curr, int block, int level = 6);
+
+// 把增量写进 back（RGB32，尺寸与发送端一致）；头或块头损坏返回 false，之前的块已写入；
+// 单块解压失败或越界只跳过该块
+bool applyInto(QImage& back, const QByteArray& blob);
+
+}
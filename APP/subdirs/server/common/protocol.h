@@ -25,6 +25,8 @@ enum MsgType : quint16 {
     MSG_CONTROL          = 50,  // 控制/状态，如 {kind:"video", state:"on/off"}
 
     MSG_SERVER_EVENT     = 90,  // 服务器事件，如房间成员列表
+    MSG_ECHO             = 91,  // 服务器原样回给发送者，用于测 RTT
+    MSG_VIDEO_LAYER      = 92,  // 接收端订阅摄像头层级 {prefs:{sender:layer}}，0 为最清晰
     MSG_FILE             = 60,  // 文件/图片传输（bin 载荷）
         MSG_DEVICE_CONTROL   = 100, // 设备控制广播
 };
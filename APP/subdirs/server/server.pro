@@ -12,18 +12,30 @@ SOURCES += \
     src/main.cpp \
     src/roomhub.cpp \
     src/udprelay.cpp \
+    src/audiomixer.cpp \
+    src/speakerselector.cpp \
     src/udpmedia_client.cpp \
     src/recorder.cpp \
+    src/dbpool.cpp \
+    src/order_search.cpp \
     common/protocol.cpp \
-    common/annot.cpp
+    common/annot.cpp \
+    common/audiodsp.cpp \
+    common/deltacodec.cpp
 
 HEADERS += \
     src/roomhub.h \
     src/udprelay.h \
+    src/audiomixer.h \
+    src/speakerselector.h \
     src/udpmedia_client.h \
     src/recorder.h \
+    src/dbpool.h \
+    src/order_search.h \
     common/protocol.h \
-    common/annot.h
+    common/annot.h \
+    common/audiodsp.h \
+    common/deltacodec.h
 
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,153 @@
+#include "audiomixer.h"
+#include "audiodsp.h"
+#include <cstring>
+
+namespace {
+const int kPrebufferFrames = 2;     // 发送端从静默恢复时先攒两帧，吸收一点上行抖动
+const int kMaxQueueFrames  = 5;     // 超过就丢最旧的，服务器这一跳最多压 100ms
+
+QByteArray encodeUlaw(const qint16* pcm, int n)
+{
+    QByteArray out(n, Qt::Uninitialized);
+    AudioDsp::encodeUlaw(pcm, reinterpret_cast<quint8*>(out.data()), n);
+    return out;
+}
+}
+
+AudioMixer::AudioMixer(QObject* parent) : QObject(parent)
+{
+    bool ok = false;
+    const int n = qEnvironmentVariableIntValue("RTM_AUDIO_MIX_MIN", &ok);
+    if (ok) setMinMembers(n);
+
+    timer_.setTimerType(Qt::PreciseTimer);
+    timer_.setInterval(kFrameMs);
+    connect(&timer_, &QTimer::timeout, this, &AudioMixer::tick);
+}
+
+const QString& AudioMixer::mixSender()
+{
+    static const QString s = QStringLiteral("__mix__");
+    return s;
+}
+
+bool AudioMixer::setMembers(const QString& roomId, const QStringList& members)
+{
+    auto it = rooms_.find(roomId);
+    const bool on = it != rooms_.end();
+    // 开关留一人回差，避免有人在门限附近进出时来回切：>= min 开，开着时 < min-1 才关
+    // 门限为 1 时回差会让空房间也算“要混”，房间和定时器永远不释放，所以另外要求有人
+    const bool want = minMembers_ > 0 && !members.isEmpty()
+                   && members.size() >= (on ? minMembers_ - 1 : minMembers_);
+    if (!want) {
+        if (!on) return false;
+        rooms_.erase(it);
+        if (rooms_.isEmpty()) timer_.stop();
+        qInfo() << "[mixer] room" << roomId << "off, members=" << members.size();
+        return true;
+    }
+
+    if (!on) {
+        it = rooms_.insert(roomId, Room());
+        qInfo() << "[mixer] room" << roomId << "on, members=" << members.size();
+    }
+    it->members = members;
+    for (auto s = it->sources.begin(); s != it->sources.end(); ) {
+        if (!members.contains(s.key())) s = it->sources.erase(s);
+        else ++s;
+    }
+    for (auto s = it->seq.begin(); s != it->seq.end(); ) {
+        if (!members.contains(s.key())) s = it->seq.erase(s);
+        else ++s;
+    }
+    if (!timer_.isActive()) timer_.start();
+    return !on;
+}
+
+bool AudioMixer::push(const QString& roomId, const QString& sender, const QString& codec,
+                      int sr, quint32 seq, const QByteArray& payload)
+{
+    auto it = rooms_.find(roomId);
+    if (it == rooms_.end() || sender.isEmpty() || !it->members.contains(sender)) return false;
+
+    Source& s = it->sources[sender];
+    // TCP/UDP 切换时同一帧可能两条路都到
+    if (s.hasSeq && qint32(seq - s.lastSeq) <= 0) return true;
+
+    QVector<qint16> pcm;
+    if (!decode(codec, sr, payload, pcm)) return false;
+    s.lastSeq = seq;
+    s.hasSeq = true;
+    s.frames.enqueue(pcm);
+    while (s.frames.size() > kMaxQueueFrames) s.frames.dequeue();
+    return true;
+}
+
+bool AudioMixer::decode(const QString& codec, int sr, const QByteArray& payload, QVector<qint16>& out)
+{
+    out.resize(kFrameSamples);
+    if (codec == QLatin1String("mulaw")) {
+        if (sr != kSampleRate || payload.size() != kFrameSamples) return false;
+        AudioDsp::decodeUlaw(reinterpret_cast<const quint8*>(payload.constData()), out.data(), kFrameSamples);
+        return true;
+    }
+    if (codec == QLatin1String("pcm16")) {
+        const qint16* s = reinterpret_cast<const qint16*>(payload.constData());
+        if (sr == kSampleRate && payload.size() == kFrameSamples * 2) {
+            std::memcpy(out.data(), s, size_t(payload.size()));
+            return true;
+        }
+        // 16kHz 旧版 pcm16：两点平均降到 8kHz
+        if (sr == kSampleRate * 2 && payload.size() == kFrameSamples * 4) {
+            for (int i = 0; i < kFrameSamples; ++i) out[i] = qint16((int(s[2 * i]) + s[2 * i + 1]) / 2);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 每 20ms：各发送端取一帧累加成总和；说话的人收到“总和减自己”，其余人共用同一份编码
+void AudioMixer::tick()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<QPair<QString, QVector<qint16>>> active;
+
+    for (auto rit = rooms_.begin(); rit != rooms_.end(); ++rit) {
+        Room& room = rit.value();
+        active.clear();
+        acc_.fill(0, kFrameSamples);
+        for (auto sit = room.sources.begin(); sit != room.sources.end(); ++sit) {
+            Source& s = sit.value();
+            if (!s.primed && s.frames.size() < kPrebufferFrames) continue;
+            if (s.frames.isEmpty()) { s.primed = false; continue; }
+            s.primed = true;
+            active.push_back(qMakePair(sit.key(), s.frames.dequeue()));
+            AudioDsp::accumulate(acc_.data(), active.last().second.constData(), kFrameSamples);
+        }
+        if (active.isEmpty()) continue;     // 没人说话不发，客户端抖动缓冲按静音处理
+
+        pcm_.resize(kFrameSamples);
+        QByteArray shared;
+        for (const QString& m : room.members) {
+            const QVector<qint16>* own = nullptr;
+            for (const auto& a : active) {
+                if (a.first == m) { own = &a.second; break; }
+            }
+            if (own && active.size() == 1) continue;    // 只有自己在说
+
+            QByteArray payload;
+            if (own) {
+                AudioDsp::mixMinus(acc_.constData(), own->constData(), pcm_.data(), kFrameSamples);
+                payload = encodeUlaw(pcm_.constData(), kFrameSamples);
+            } else {
+                if (shared.isEmpty()) {
+                    AudioDsp::mixMinus(acc_.constData(), nullptr, pcm_.data(), kFrameSamples);
+                    shared = encodeUlaw(pcm_.constData(), kFrameSamples);
+                }
+                payload = shared;
+            }
+            // 每个接收端各自连续编号，客户端不会把别人说话的间隙当成丢包
+            emit mixed(rit.key(), m, room.seq[m]++, now, payload);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <QtCore>
+
+// 服务器端混音（MCU 模式）
+// 房间人数达到门限后开启：各发送端的 µ-law/PCM 帧在这里解码，每 20ms 合成一路总和，
+// 每个接收端收到“总和减去自己”的一路 µ-law（发送者 "__mix__"），下行和客户端混音开销不再随人数增长
+// 累加/相减/µ-law 用 common/audiodsp 的内核
+// - 门限默认 kDefaultMinMembers，环境变量 RTM_AUDIO_MIX_MIN 覆盖，0 表示关闭
+// - 人数达到门限 min 时开；开着时降到 min-1 仍保持，降到 min-2 才关（一人回差）；空房间总是关
+// - 服务器不带 Opus，混音房间里客户端收到 audio_mix 通知后改发 µ-law；解不了的帧直接丢
+class AudioMixer : public QObject {
+    Q_OBJECT
+public:
+    static const int kSampleRate   = 8000;
+    static const int kFrameMs      = 20;
+    static const int kFrameSamples = kSampleRate * kFrameMs / 1000;
+    static const int kDefaultMinMembers = 6;
+
+    explicit AudioMixer(QObject* parent = nullptr);
+
+    void setMinMembers(int n) { minMembers_ = qMax(0, n); }
+    int  minMembers() const { return minMembers_; }
+
+    // 房间成员变化时调用；返回混音开关是否变化
+    bool setMembers(const QString& roomId, const QStringList& members);
+    bool isMixing(const QString& roomId) const { return rooms_.contains(roomId); }
+
+    // 收到一帧；房间没开混音或解不了返回 false
+    bool push(const QString& roomId, const QString& sender, const QString& codec,
+              int sr, quint32 seq, const QByteArray& payload);
+
+    static const QString& mixSender();
+
+    // 混一个 20ms 节拍；平时由内部定时器驱动，公开给基准测试直接调用
+    void tick();
+
+signals:
+    // 发给 roomId 里 user 的一帧混音（µ-law，8kHz）
+    void mixed(const QString& roomId, const QString& user, quint32 seq, qint64 ts, const QByteArray& payload);
+
+private:
+    struct Source {
+        QQueue<QVector<qint16>> frames;
+        quint32 lastSeq = 0;
+        bool hasSeq  = false;
+        bool primed  = false;       // 队列空过之后要先攒够 kPrebufferFrames 再出
+    };
+    struct Room {
+        QStringList members;
+        QHash<QString, Source> sources;
+        QHash<QString, quint32> seq;    // 接收端 -> 下行序号
+    };
+
+    static bool decode(const QString& codec, int sr, const QByteArray& payload, QVector<qint16>& out);
+
+    QHash<QString, Room> rooms_;    // 只存开着混音的房间
+    int minMembers_ = kDefaultMinMembers;
+    QTimer timer_;
+
+    // tick 里复用，避免每帧分配
+    QVector<qint32> acc_;
+    QVector<qint16> pcm_;
+};
@@ -0,0 +1,142 @@
+#include "dbpool.h"
+#include <QSqlError>
+#include <QDebug>
+
+// ========== DbConn ==========
+DbConn::DbConn(const QString& connName) : name_(connName) {}
+
+DbConn::~DbConn()
+{
+    // 语句必须先于连接释放
+    qDeleteAll(cache_);
+    cache_.clear();
+    {
+        QSqlDatabase d = QSqlDatabase::database(name_, false);
+        if (d.isOpen()) d.close();
+    }
+    QSqlDatabase::removeDatabase(name_);
+}
+
+bool DbConn::open(const QString& file)
+{
+    QSqlDatabase d = QSqlDatabase::addDatabase("QSQLITE", name_);
+    d.setDatabaseName(file);
+    if (!d.open()) {
+        qCritical() << "[db]" << name_ << "open failed:" << d.lastError().text();
+        return false;
+    }
+    DbPool::applyPragmas(d);
+    return true;
+}
+
+QSqlQuery& DbConn::prepared(const QString& sql)
+{
+    auto it = cache_.find(sql);
+    if (it != cache_.end()) {
+        it.value()->finish();
+        return *it.value();
+    }
+    auto* q = new QSqlQuery(db());
+    if (!q->prepare(sql)) {
+        qWarning() << "[db]" << name_ << "prepare failed:" << q->lastError().text() << sql;
+    }
+    cache_.insert(sql, q);
+    return *q;
+}
+
+bool DbConn::exec(const QString& sql)
+{
+    QSqlQuery q(db());
+    if (!q.exec(sql)) {
+        qWarning() << "[db]" << name_ << "exec failed:" << q.lastError().text() << sql;
+        return false;
+    }
+    return true;
+}
+
+// ========== DbPool ==========
+DbPool::DbPool(QObject* parent) : QObject(parent) {}
+
+DbPool::~DbPool() { stop(); }
+
+void DbPool::applyPragmas(QSqlDatabase db)
+{
+    QSqlQuery q(db);
+    // WAL：读写互不阻塞；NORMAL：只在 checkpoint 时 fsync
+    q.exec("PRAGMA journal_mode=WAL");
+    q.exec("PRAGMA synchronous=NORMAL");
+    q.exec("PRAGMA busy_timeout=5000");
+    q.exec("PRAGMA temp_store=MEMORY");
+}
+
+bool DbPool::columnExists(QSqlDatabase db, const QString& table, const QString& column)
+{
+    QSqlQuery q(db);
+    if (!q.exec(QString("PRAGMA table_info(%1)").arg(table))) return false;
+    while (q.next()) {
+        if (q.value(1).toString() == column) return true;
+    }
+    return false;
+}
+
+bool DbPool::start(const QString& file, int workers)
+{
+    if (!workers_.isEmpty()) return true;
+    file_ = file;
+    if (workers <= 0) workers = qBound(2, QThread::idealThreadCount(), 4);
+
+    for (int i = 0; i < workers; ++i) {
+        auto* w = new Worker;
+        w->thread = new QThread;
+        w->thread->setObjectName(QString("db-worker-%1").arg(i));
+        w->ctx = new QObject;
+        w->ctx->moveToThread(w->thread);
+        w->thread->start();
+
+        // 连接在工作线程内创建，失败时该线程上的任务返回数据库错误
+        const QString name = w->thread->objectName();
+        QMetaObject::invokeMethod(w->ctx, [w, name, file]{
+            auto* c = new DbConn(name);
+            c->open(file);
+            w->conn = c;
+        }, Qt::BlockingQueuedConnection);
+        workers_.push_back(w);
+    }
+    qInfo() << "[db] pool started; workers=" << workers << "file=" << file;
+    return true;
+}
+
+void DbPool::stop()
+{
+    for (Worker* w : workers_) {
+        QMetaObject::invokeMethod(w->ctx, [w]{
+            delete w->conn;
+            w->conn = nullptr;
+        }, Qt::BlockingQueuedConnection);
+        w->thread->quit();
+        w->thread->wait();
+        delete w->ctx;
+        delete w->thread;
+        delete w;
+    }
+    workers_.clear();
+}
+
+void DbPool::submit(uint shard, Job job, QObject* receiver, Done done)
+{
+    if (workers_.isEmpty()) {
+        if (done) done(QJsonObject{{"ok", false}, {"msg", "数据库错误"}});
+        return;
+    }
+    Worker* w = workers_.at(int(shard % uint(workers_.size())));
+    QPointer<QObject> guard(receiver);
+    QMetaObject::invokeMethod(w->ctx, [this, w, job, guard, done]{
+        QJsonObject reply = w->conn && w->conn->db().isOpen()
+                ? job(*w->conn)
+                : QJsonObject{{"ok", false}, {"msg", "数据库错误"}};
+        // 回到池所在线程再检查 receiver 是否还活着
+        QMetaObject::invokeMethod(this, [guard, done, reply]{
+            if (guard && done) done(reply);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <QtCore>
+#include <QtSql>
+#include <functional>
+
+// 单个工作线程独占的 SQLite 连接 + 预编译语句缓存
+// 只能在创建它的线程里使用（QSqlDatabase 的线程约束）
+class DbConn {
+public:
+    explicit DbConn(const QString& connName);
+    ~DbConn();
+
+    bool open(const QString& file);
+    QSqlDatabase db() const { return QSqlDatabase::database(name_, false); }
+
+    // 取缓存的预编译语句：首次 prepare，之后复用（已 finish，可直接 addBindValue/exec）
+    QSqlQuery& prepared(const QString& sql);
+
+    // 一次性语句（DDL / PRAGMA）
+    bool exec(const QString& sql);
+
+private:
+    QString name_;
+    QHash<QString, QSqlQuery*> cache_;
+};
+
+// SQLite 工作线程池：每线程一个连接，WAL + synchronous=NORMAL
+// 同一 shard 的任务按提交顺序在同一线程执行，完成回调回到池所在线程
+class DbPool : public QObject {
+    Q_OBJECT
+public:
+    using Job  = std::function<QJsonObject(DbConn&)>;
+    using Done = std::function<void(const QJsonObject&)>;
+
+    explicit DbPool(QObject* parent=nullptr);
+    ~DbPool();
+
+    bool start(const QString& file, int workers = 0);
+    void stop();
+    int  size() const { return workers_.size(); }
+
+    // receiver 被销毁时丢弃回调；shard 取模后选线程
+    void submit(uint shard, Job job, QObject* receiver, Done done);
+
+    // 对任一连接统一设置的 PRAGMA（主线程默认连接也复用）
+    static void applyPragmas(QSqlDatabase db);
+    // 迁移用：表里是否已有该列
+    static bool columnExists(QSqlDatabase db, const QString& table, const QString& column);
+
+private:
+    struct Worker {
+        QThread* thread = nullptr;
+        QObject* ctx = nullptr;     // 生活在工作线程，承载排队任务
+        DbConn*  conn = nullptr;    // 在工作线程内惰性打开
+    };
+    QVector<Worker*> workers_;
+    QString file_;
+};
@@ -2,6 +2,8 @@
 #include "roomhub.h"
 #include "udprelay.h"
 #include "recorder.h"
+#include "dbpool.h"
+#include "order_search.h"
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QSqlDatabase>
@@ -14,6 +16,7 @@
 #include <QDebug>
 #include <QTime>
 #include <QDateTime>
+#include <QRandomGenerator>
 
 static const quint16 Port = 5555;
 static const char* DB_FILE = "users.db";
@@ -80,20 +83,465 @@ static void ensureOrdersTable()
            " status TEXT,"
            " factory_user TEXT"
            ")");
+
+    // 变更序号：每次写操作全局 +1，行上记录最后一次修改时的序号；删除留墓碑
+    if (!DbPool::columnExists(QSqlDatabase::database(), "orders", "version")) {
+        if (!q.exec("ALTER TABLE orders ADD COLUMN version INTEGER NOT NULL DEFAULT 0")) {
+            qWarning() << "Add orders.version failed:" << q.lastError().text();
+        }
+    }
+    q.exec("CREATE INDEX IF NOT EXISTS idx_orders_version ON orders(version)");
+    q.exec("CREATE TABLE IF NOT EXISTS order_tombstones ("
+           " id INTEGER PRIMARY KEY,"
+           " version INTEGER NOT NULL,"
+           " factory_user TEXT"
+           ")");
+    // 墓碑记下工单归属，增量里的 removed 和活动行用同一个作用域；旧墓碑没有归属，只有看全部的角色能收到
+    if (!DbPool::columnExists(QSqlDatabase::database(), "order_tombstones", "factory_user")) {
+        if (!q.exec("ALTER TABLE order_tombstones ADD COLUMN factory_user TEXT")) {
+            qWarning() << "Add order_tombstones.factory_user failed:" << q.lastError().text();
+        }
+    }
+    q.exec("CREATE INDEX IF NOT EXISTS idx_order_tombstones_version ON order_tombstones(version)");
+    q.exec("CREATE TABLE IF NOT EXISTS order_meta ( k TEXT PRIMARY KEY, v INTEGER NOT NULL )");
+    q.exec("INSERT OR IGNORE INTO order_meta(k, v) VALUES('orders_version', 0)");
 }
 
-static int generateRandomOrderId() {
-    QSqlQuery q;
+static QJsonObject makeReply(bool ok, const QString &msg) {
+    return QJsonObject{{"ok", ok}, {"msg", msg}};
+}
+
+// ---------------- 以下在 DB 工作线程执行，只能使用传入的连接 ----------------
+
+static qint64 currentOrdersVersion(DbConn& c) {
+    QSqlQuery& q = c.prepared("SELECT v FROM order_meta WHERE k='orders_version'");
+    if (!q.exec() || !q.next()) return 0;
+    return q.value(0).toLongLong();
+}
+
+// 须在写事务内、作为第一条语句调用：UPDATE 先拿写锁，多个工作线程之间序号不会重复，
+// 之后同一事务里的读也都看到最新提交；失败返回 -1 并填 err
+static qint64 bumpOrdersVersion(DbConn& c, QString* err) {
+    QSqlQuery& q = c.prepared("UPDATE order_meta SET v=v+1 WHERE k='orders_version'");
+    if (!q.exec()) {
+        *err = q.lastError().text();
+        return -1;
+    }
+    return currentOrdersVersion(c);
+}
+
+static QJsonObject orderToJson(const QSqlQuery& q) {
+    QJsonObject o;
+    o["id"] = q.value(0).toInt();
+    o["title"] = q.value(1).toString();
+    o["desc"] = q.value(2).toString();
+    o["status"] = q.value(3).toString();
+    o["factory_user"] = q.value(4).toString();
+    return o;
+}
+
+static QJsonObject versionReply(qint64 version) {
+    QJsonObject rep = makeReply(true, "ok");
+    rep["version"] = double(version);
+    return rep;
+}
+
+// 须在 bumpOrdersVersion 之后调用：持有写锁时查重，插入前其他工作线程拿不到同一个号
+static int generateRandomOrderId(DbConn& c) {
+    QSqlQuery& q = c.prepared("SELECT 1 FROM orders WHERE id=?");
     for (int i = 0; i < 100; ++i) {
-        int id = 1000 + qrand() % 9000;
-        q.prepare("SELECT 1 FROM orders WHERE id=?");
+        int id = QRandomGenerator::global()->bounded(1000, 10000);
         q.addBindValue(id);
         q.exec();
-        if (!q.next()) return id;
+        const bool taken = q.next();
+        q.finish();
+        if (!taken) return id;
     }
     return -1;
 }
 
+static bool existsInAny(DbConn& c, const QString &username) {
+    QSqlQuery& q = c.prepared("SELECT 1 FROM expert_users WHERE username=? "
+                              "UNION ALL SELECT 1 FROM factory_users WHERE username=? LIMIT 1");
+    q.addBindValue(username);
+    q.addBindValue(username);
+    if (!q.exec()) return false;
+    return q.next();
+}
+
+static QJsonObject doRegister(DbConn& c, const QString &user, const QString &role, const QString &pass) {
+    if (existsInAny(c, user)) {
+        return makeReply(false, "用户已存在");
+    }
+    QSqlQuery& q = c.prepared(role == "expert"
+                              ? "INSERT INTO expert_users(username, password) VALUES(?, ?)"
+                              : "INSERT INTO factory_users(username, password) VALUES(?, ?)");
+    q.addBindValue(user);
+    q.addBindValue(hashPass(pass));
+    if (!q.exec()) {
+        qWarning() << "Insert failed:" << q.lastError().text();
+        return makeReply(false, "数据库错误");
+    }
+    return makeReply(true, "ok");
+}
+
+static QJsonObject doLogin(DbConn& c, const QString &user, const QString &role, const QString &pass) {
+    QSqlQuery& q = c.prepared(role == "expert"
+                              ? "SELECT 1 FROM expert_users WHERE username=? AND password=? LIMIT 1"
+                              : "SELECT 1 FROM factory_users WHERE username=? AND password=? LIMIT 1");
+    q.addBindValue(user);
+    q.addBindValue(hashPass(pass));
+    if (!q.exec()) {
+        return makeReply(false, "数据库错误");
+    }
+    if (q.next()) return makeReply(true, "ok");
+    return makeReply(false, "账号或密码不正确");
+}
+
+static QJsonObject handleRequest(DbConn& c, const QJsonObject &req) {
+    const QString action = req.value("action").toString();
+    if (action == "register" || action == "login") {
+        const QString role = req.value("role").toString();
+        const QString username = req.value("username").toString().trimmed();
+        const QString password = req.value("password").toString();
+
+        if (role != "expert" && role != "factory") {
+            return makeReply(false, "invalid role");
+        }
+        if (username.isEmpty() || password.isEmpty()) {
+            return makeReply(false, "账号或密码为空");
+        }
+
+        if (action == "register") {
+            return doRegister(c, username, role, password);
+        } else if (action == "login") {
+            return doLogin(c, username, role, password);
+        } else {
+            return makeReply(false, "unknown action");
+        }
+    }
+    if (action == "new_order") {
+        QString title = req.value("title").toString();
+        QString desc = req.value("desc").toString();
+        QString factory_user = req.value("factory_user").toString();
+        QSqlDatabase db = c.db();
+        db.transaction();
+        QString err;
+        const qint64 ver = bumpOrdersVersion(c, &err);
+        if (ver < 0) {
+            db.rollback();
+            return makeReply(false, err);
+        }
+        const int id = generateRandomOrderId(c);
+        if (id < 0) {
+            db.rollback();
+            return makeReply(false, "无法分配工单号");
+        }
+        QSqlQuery& q = c.prepared("INSERT INTO orders (id, title, desc, status, factory_user, version) VALUES (?, ?, ?, ?, ?, ?)");
+        q.addBindValue(id);
+        q.addBindValue(title);
+        q.addBindValue(desc);
+        q.addBindValue("待处理");
+        q.addBindValue(factory_user);
+        q.addBindValue(ver);
+        if (!q.exec()) {
+            err = q.lastError().text();
+            db.rollback();
+            return makeReply(false, err);
+        }
+        // 工单号可能复用：清掉旧墓碑，免得增量同时出现“变更”和“删除”
+        QSqlQuery& qt = c.prepared("DELETE FROM order_tombstones WHERE id=?");
+        qt.addBindValue(id);
+        qt.exec();
+        OrderSearch::indexOrder(c, id, title, desc);
+        db.commit();
+        return versionReply(ver);
+    } else if (action == "get_orders") {
+        QString role = req.value("role").toString();
+        QString username = req.value("username").toString();
+        QString keyword = req.value("keyword").toString();
+        QString status = req.value("status").toString();
+        // 分页：按 id 游标（after_id），limit=0 时整表返回（兼容旧客户端）
+        const qint64 afterId = qint64(req.value("after_id").toDouble());
+        const int limit = qBound(0, req.value("limit").toInt(), 1000);
+        // 增量：只取 version > since_version 的行，并给出需移除的 id
+        const bool delta = req.contains("since_version");
+        const qint64 since = qint64(req.value("since_version").toDouble());
+
+        QString scope = " WHERE 1=1";
+        QVariantList scopeBinds;
+        if (role == "factory" && !username.isEmpty()) {
+            scope += " AND factory_user=?";
+            scopeBinds << username;
+        }
+        QString where = scope;
+        QVariantList binds = scopeBinds;
+        // 有 FTS 时走倒排索引；短的拉丁/数字片段按子串 LIKE 补充过滤（前缀索引找不到词中间）
+        // 没有 FTS 或关键词里没有可检索的词元（纯标点/符号）时整串 LIKE，和旧行为一致
+        const bool useFts = OrderSearch::available();
+        QStringList likeTerms;
+        const QString match = useFts ? OrderSearch::buildMatch(keyword, &likeTerms) : QString();
+        if (!keyword.isEmpty()) {
+            if (!useFts || (match.isEmpty() && likeTerms.isEmpty())) {
+                likeTerms = QStringList{keyword};
+            } else if (!match.isEmpty()) {
+                where += " AND id IN (SELECT rowid FROM orders_fts WHERE orders_fts MATCH ?)";
+                binds << match;
+            }
+            for (const QString& t : qAsConst(likeTerms)) {
+                where += " AND (title LIKE ? OR desc LIKE ?)";
+                const QString like = "%" + t + "%";
+                binds << like << like;
+            }
+        }
+        if (!status.isEmpty() && status != "全部") {
+            where += " AND status=?";
+            binds << status;
+        }
+        if (delta) {
+            where += " AND version>?";
+            binds << since;
+        } else if (afterId > 0) {
+            where += " AND id>?";
+            binds << afterId;
+        }
+        QString sql = "SELECT id, title, desc, status, factory_user FROM orders" + where + " ORDER BY id";
+        const bool paged = !delta && limit > 0;
+        if (paged) {
+            sql += " LIMIT ?";
+            binds << limit + 1;   // 多取一行判断 has_more
+        }
+
+        // 读事务：版本号与结果出自同一快照
+        QSqlDatabase db = c.db();
+        db.transaction();
+        const qint64 version = currentOrdersVersion(c);
+
+        // 过滤组合有限，按 SQL 文本缓存预编译语句
+        QSqlQuery& q = c.prepared(sql);
+        for (const QVariant& v : binds) q.addBindValue(v);
+        if (!q.exec()) {
+            const QString err = q.lastError().text();
+            db.commit();
+            return makeReply(false, err);
+        }
+        QJsonArray arr;
+        QSet<int> changed;
+        bool hasMore = false;
+        int lastId = 0;
+        while (q.next()) {
+            if (paged && arr.size() >= limit) { hasMore = true; break; }
+            QJsonObject o = orderToJson(q);
+            lastId = o.value("id").toInt();
+            changed.insert(lastId);
+            arr.append(o);
+        }
+        q.finish();
+
+        QJsonObject rep;
+        rep["ok"] = true;
+        rep["orders"] = arr;
+        rep["version"] = double(version);
+        if (paged) {
+            rep["has_more"] = hasMore;
+            rep["next_after_id"] = lastId;
+        }
+        if (delta) {
+            // 作用域内改过、但已不满足筛选条件的行，以及已删除的行
+            QJsonArray removed;
+            QSqlQuery& qa = c.prepared("SELECT id FROM orders" + scope + " AND version>?");
+            for (const QVariant& v : scopeBinds) qa.addBindValue(v);
+            qa.addBindValue(since);
+            if (qa.exec()) {
+                while (qa.next()) {
+                    const int id = qa.value(0).toInt();
+                    if (!changed.contains(id)) removed.append(id);
+                }
+            }
+            QSqlQuery& qt = c.prepared("SELECT id FROM order_tombstones" + scope + " AND version>?");
+            for (const QVariant& v : scopeBinds) qt.addBindValue(v);
+            qt.addBindValue(since);
+            if (qt.exec()) {
+                while (qt.next()) removed.append(qt.value(0).toInt());
+            }
+            rep["removed"] = removed;
+        }
+        db.commit();
+        return rep;
+    } else if (action == "update_order") {
+        int id = req.value("id").toInt();
+        QString status = req.value("status").toString();
+        QSqlDatabase db = c.db();
+        db.transaction();
+        QString err;
+        const qint64 ver = bumpOrdersVersion(c, &err);
+        if (ver < 0) {
+            db.rollback();
+            return makeReply(false, err);
+        }
+        QSqlQuery& q = c.prepared("UPDATE orders SET status=?, version=? WHERE id=?");
+        q.addBindValue(status);
+        q.addBindValue(ver);
+        q.addBindValue(id);
+        if (!q.exec()) {
+            err = q.lastError().text();
+            db.rollback();
+            return makeReply(false, err);
+        }
+        db.commit();
+        return versionReply(ver);
+    } else if (action == "delete_order") {
+        int id = req.value("id").toInt();
+        QString username = req.value("username").toString();
+        QSqlQuery& q = c.prepared("SELECT 1 FROM orders WHERE id=? AND factory_user=?");
+        q.addBindValue(id);
+        q.addBindValue(username);
+        const bool owned = q.exec() && q.next();
+        q.finish();
+        if (!owned) {
+            return makeReply(false, "只能销毁自己创建的工单");
+        }
+        QSqlDatabase db = c.db();
+        db.transaction();
+        QString err;
+        const qint64 ver = bumpOrdersVersion(c, &err);
+        if (ver < 0) {
+            db.rollback();
+            return makeReply(false, err);
+        }
+        QSqlQuery& qd = c.prepared("DELETE FROM orders WHERE id=?");
+        qd.addBindValue(id);
+        if (!qd.exec()) {
+            err = qd.lastError().text();
+            db.rollback();
+            return makeReply(false, err);
+        }
+        QSqlQuery& qt = c.prepared("INSERT OR REPLACE INTO order_tombstones(id, version, factory_user) VALUES(?, ?, ?)");
+        qt.addBindValue(id);
+        qt.addBindValue(ver);
+        qt.addBindValue(username);
+        qt.exec();
+        OrderSearch::removeOrder(c, id);
+        db.commit();
+        return versionReply(ver);
+    } else if (action == "subscribe_orders") {
+        // 订阅本身只回当前版本；推送由网络层在写成功后发出
+        return versionReply(currentOrdersVersion(c));
+    } else if (action == "get_recordings") {
+        QString roomId = req.value("room_id").toString();
+        QString sql = "SELECT id, order_id, room_id, started_at, ended_at, title FROM recordings";
+        if (!roomId.isEmpty()) sql += " WHERE room_id=?";
+        QSqlQuery& q = c.prepared(sql);
+        if (!roomId.isEmpty()) q.addBindValue(roomId);
+        if (!q.exec()) return makeReply(false, q.lastError().text());
+        QJsonArray items;
+        while (q.next()) {
+            QJsonObject o;
+            o["id"] = q.value(0).toInt();
+            o["order_id"] = q.value(1).toString();
+            o["room_id"] = q.value(2).toString();
+            o["started_at"] = QJsonValue::fromVariant(q.value(3));
+            o["ended_at"] = QJsonValue::fromVariant(q.value(4));
+            o["title"] = q.value(5).toString();
+            items.append(o);
+        }
+        QJsonObject rep; rep["ok"] = true; rep["items"] = items; return rep;
+    } else if (action == "get_recording_files") {
+        int recordingId = req.value("recording_id").toInt();
+        QString roomId = req.value("room_id").toString();
+        QString sql = "SELECT f.id, f.recording_id, f.user, f.file_path, f.kind, "
+                      "f.thumb_path, f.index_path, f.duration_ms "
+                      "FROM recording_files f JOIN recordings r ON f.recording_id=r.id";
+        QString where;
+        if (recordingId > 0) {
+            where = " WHERE f.recording_id=?";
+        } else if (!roomId.isEmpty()) {
+            where = " WHERE r.room_id=?";
+        }
+        QSqlQuery& q = c.prepared(sql + where);
+        if (recordingId > 0) q.addBindValue(recordingId);
+        else if (!roomId.isEmpty()) q.addBindValue(roomId);
+
+        if (!q.exec()) return makeReply(false, q.lastError().text());
+
+        QJsonArray files;
+        while (q.next()) {
+            QJsonObject o;
+            o["id"] = q.value(0).toInt();
+            o["recording_id"] = q.value(1).toInt();
+            o["user"] = q.value(2).toString();
+            o["file_path"] = q.value(3).toString();
+            o["kind"] = q.value(4).toString();
+            // 预览：雪碧图 + 关键帧索引（旧录制为空）
+            if (!q.value(5).isNull()) o["thumb_path"] = q.value(5).toString();
+            if (!q.value(6).isNull()) o["index_path"] = q.value(6).toString();
+            if (!q.value(7).isNull()) o["duration_ms"] = QJsonValue::fromVariant(q.value(7));
+            files.append(o);
+        }
+        QJsonObject rep; rep["ok"] = true; rep["files"] = files; return rep;
+    } else if (action == "get_recording_library") {
+        // 录制 + 文件一次联表返回，每行一个文件；新录制在前，游标为 (recording_id, file_id)
+        const QString roomId = req.value("room_id").toString();
+        const qint64 fromMs = qint64(req.value("from_ms").toDouble());
+        const qint64 toMs = qint64(req.value("to_ms").toDouble());
+        const int limit = qBound(1, req.value("limit").toInt(100), 500);
+        const int afterRec = req.value("after_rec_id").toInt();
+        const int afterFile = req.value("after_file_id").toInt();
+
+        QString sql = "SELECT r.id, r.room_id, r.title, r.started_at, r.ended_at, "
+                      "f.id, f.user, f.file_path, f.kind, f.thumb_path, f.index_path, f.duration_ms "
+                      "FROM recordings r JOIN recording_files f ON f.recording_id=r.id WHERE 1=1";
+        QVariantList binds;
+        if (!roomId.isEmpty()) { sql += " AND r.room_id=?"; binds << roomId; }
+        if (fromMs > 0) { sql += " AND r.started_at>=?"; binds << fromMs; }
+        if (toMs > 0) { sql += " AND r.started_at<?"; binds << toMs; }
+        if (afterRec > 0) {
+            sql += " AND (r.id<? OR (r.id=? AND f.id>?))";
+            binds << afterRec << afterRec << afterFile;
+        }
+        sql += " ORDER BY r.id DESC, f.id ASC LIMIT ?";
+        binds << limit + 1;
+
+        QSqlQuery& q = c.prepared(sql);
+        for (const QVariant& v : binds) q.addBindValue(v);
+        if (!q.exec()) return makeReply(false, q.lastError().text());
+
+        QJsonArray rows;
+        bool hasMore = false;
+        int lastRec = 0, lastFile = 0;
+        while (q.next()) {
+            if (rows.size() >= limit) { hasMore = true; break; }
+            QJsonObject o;
+            lastRec = q.value(0).toInt();
+            lastFile = q.value(5).toInt();
+            o["recording_id"] = lastRec;
+            o["room_id"] = q.value(1).toString();
+            o["title"] = q.value(2).toString();
+            o["started_at"] = QJsonValue::fromVariant(q.value(3));
+            o["ended_at"] = QJsonValue::fromVariant(q.value(4));
+            o["file_id"] = lastFile;
+            o["user"] = q.value(6).toString();
+            o["file_path"] = q.value(7).toString();
+            o["kind"] = q.value(8).toString();
+            if (!q.value(9).isNull()) o["thumb_path"] = q.value(9).toString();
+            if (!q.value(10).isNull()) o["index_path"] = q.value(10).toString();
+            if (!q.value(11).isNull()) o["duration_ms"] = QJsonValue::fromVariant(q.value(11));
+            rows.append(o);
+        }
+        q.finish();
+        QJsonObject rep;
+        rep["ok"] = true;
+        rep["rows"] = rows;
+        rep["has_more"] = hasMore;
+        rep["next_after_rec_id"] = lastRec;
+        rep["next_after_file_id"] = lastFile;
+        return rep;
+    }
+    return makeReply(false, "unknown action");
+}
+
+// ---------------- 网络层（主线程） ----------------
+
 class AuthServer : public QObject {
     Q_OBJECT
 public:
@@ -102,6 +550,10 @@ public:
     bool start() {
         if (!initDb()) return false;
         ensureOrdersTable();
+        OrderSearch::ensureSchema();
+
+        // 请求在 DB 线程池执行，主线程只做收发，媒体转发不再被 fsync 卡住
+        if (!m_pool.start(DB_FILE)) return false;
 
         m_server = new QTcpServer(this);
         connect(m_server, &QTcpServer::newConnection, this, &AuthServer::onNewConnection);
@@ -117,27 +569,60 @@ private slots:
     void onNewConnection() {
         while (m_server->hasPendingConnections()) {
             QTcpSocket *sock = m_server->nextPendingConnection();
-            connect(sock, &QTcpSocket::readyRead, this, [this, sock](){
+            // 不带 rid 的旧客户端：同一连接固定到同一 DB 线程，应答顺序与请求顺序一致
+            // 带 rid 的读请求按 rid 匹配应答，可分散到各线程并发执行；
+            // 写请求总走本连接固定的线程，同一客户端的写按发出顺序生效
+            const uint shard = m_nextShard++;
+            connect(sock, &QTcpSocket::readyRead, this, [this, sock, shard](){
                 while (sock->canReadLine()) {
                     QByteArray line = sock->readLine().trimmed();
                     if (line.isEmpty()) continue;
                     QJsonParseError pe{};
                     QJsonDocument doc = QJsonDocument::fromJson(line, &pe);
-                    QJsonObject reply;
-                    if (pe.error != QJsonParseError::NoError || !doc.isObject()) {
-                        reply = makeReply(false, "bad json");
-                    } else {
-                        reply = handle(doc.object());
-                    }
-                    QByteArray out = QJsonDocument(reply).toJson(QJsonDocument::Compact) + "\n";
-                    sock->write(out);
-                    sock->flush();
+                    const bool bad = pe.error != QJsonParseError::NoError || !doc.isObject();
+                    const QJsonObject req = bad ? QJsonObject{} : doc.object();
+                    const QString action = req.value("action").toString();
+                    const QJsonValue rid = req.value("rid");
+                    m_pool.submit(rid.isUndefined() || isWriteAction(action) ? shard : m_nextShard++,
+                        [bad, req](DbConn& c){
+                            return bad ? makeReply(false, "bad json") : handleRequest(c, req);
+                        },
+                        sock,
+                        [this, sock, action, rid](QJsonObject reply){
+                            if (!rid.isUndefined()) reply["rid"] = rid;
+                            QByteArray out = QJsonDocument(reply).toJson(QJsonDocument::Compact) + "\n";
+                            sock->write(out);
+                            sock->flush();
+                            if (!reply.value("ok").toBool()) return;
+                            if (action == "subscribe_orders") {
+                                m_orderSubscribers.insert(sock);
+                            } else if (action == "new_order" || action == "update_order" || action == "delete_order") {
+                                notifyOrdersChanged(qint64(reply.value("version").toDouble()));
+                            }
+                        });
                 }
             });
+            connect(sock, &QObject::destroyed, this, [this, sock](){ m_orderSubscribers.remove(sock); });
             connect(sock, &QTcpSocket::disconnected, sock, &QTcpSocket::deleteLater);
         }
     }
 
+private:
+    static bool isWriteAction(const QString& action) {
+        return action == "register" || action == "new_order"
+            || action == "update_order" || action == "delete_order";
+    }
+
+    // 工单变更推送：订阅连接上收到一行事件，客户端再按 since_version 拉增量
+    void notifyOrdersChanged(qint64 version) {
+        if (m_orderSubscribers.isEmpty()) return;
+        QJsonObject ev{{"event", "orders_changed"}, {"version", double(version)}};
+        const QByteArray line = QJsonDocument(ev).toJson(QJsonDocument::Compact) + "\n";
+        for (QTcpSocket* s : qAsConst(m_orderSubscribers)) {
+            if (s->state() == QAbstractSocket::ConnectedState) s->write(line);
+        }
+    }
+
 private:
     bool initDb() {
         QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
@@ -146,6 +631,8 @@ private:
             qCritical() << "Open DB failed:" << db.lastError().text();
             return false;
         }
+        // 主线程连接（建表/迁移/录制入库）与工作线程一致使用 WAL
+        DbPool::applyPragmas(db);
         QSqlQuery q;
         if (!q.exec("CREATE TABLE IF NOT EXISTS expert_users ( username TEXT PRIMARY KEY, password TEXT NOT NULL );")) {
             qCritical() << "Create expert_users failed:" << q.lastError().text();
@@ -161,211 +648,11 @@ private:
         return true;
     }
 
-    bool existsInAny(const QString &username) {
-        QSqlQuery q;
-        q.prepare("SELECT 1 FROM expert_users WHERE username=? "
-                  "UNION ALL SELECT 1 FROM factory_users WHERE username=? LIMIT 1");
-        q.addBindValue(username);
-        q.addBindValue(username);
-        if (!q.exec()) return false;
-        return q.next();
-    }
-
-    QJsonObject handle(const QJsonObject &req) {
-        const QString action = req.value("action").toString();
-        if (action == "register" || action == "login") {
-            const QString role = req.value("role").toString();
-            const QString username = req.value("username").toString().trimmed();
-            const QString password = req.value("password").toString();
-
-            if (role != "expert" && role != "factory") {
-                return makeReply(false, "invalid role");
-            }
-            if (username.isEmpty() || password.isEmpty()) {
-                return makeReply(false, "账号或密码为空");
-            }
-
-            if (action == "register") {
-                return doRegister(username, role, password);
-            } else if (action == "login") {
-                return doLogin(username, role, password);
-            } else {
-                return makeReply(false, "unknown action");
-            }
-        }
-        if (action == "new_order") {
-            QString title = req.value("title").toString();
-            QString desc = req.value("desc").toString();
-            QString factory_user = req.value("factory_user").toString();
-            int id = generateRandomOrderId();
-            if (id < 0) return makeReply(false, "无法分配工单号");
-            QSqlQuery q;
-            q.prepare("INSERT INTO orders (id, title, desc, status, factory_user) VALUES (?, ?, ?, ?, ?)");
-            q.addBindValue(id);
-            q.addBindValue(title);
-            q.addBindValue(desc);
-            q.addBindValue("待处理");
-            q.addBindValue(factory_user);
-            if (q.exec()) return makeReply(true, "ok");
-            else return makeReply(false, q.lastError().text());
-        } else if (action == "get_orders") {
-            QString role = req.value("role").toString();
-            QString username = req.value("username").toString();
-            QString keyword = req.value("keyword").toString();
-            QString status = req.value("status").toString();
-            QString sql = "SELECT id, title, desc, status, factory_user FROM orders WHERE 1=1";
-            if (role == "factory" && !username.isEmpty()) {
-                sql += " AND factory_user=?";
-            }
-            if (!keyword.isEmpty()) {
-                sql += " AND (title LIKE ? OR desc LIKE ?)";
-            }
-            if (!status.isEmpty() && status != "全部") {
-                sql += " AND status=?";
-            }
-            QSqlQuery q;
-            q.prepare(sql);
-            if (role == "factory" && !username.isEmpty()) q.addBindValue(username);
-            if (!keyword.isEmpty()) {
-                QString like = "%" + keyword + "%";
-                q.addBindValue(like);
-                q.addBindValue(like);
-            }
-            if (!status.isEmpty() && status != "全部") {
-                q.addBindValue(status);
-            }
-            q.exec();
-            QJsonArray arr;
-            while (q.next()) {
-                QJsonObject o;
-                o["id"] = q.value(0).toInt();
-                o["title"] = q.value(1).toString();
-                o["desc"] = q.value(2).toString();
-                o["status"] = q.value(3).toString();
-                o["factory_user"] = q.value(4).toString();
-                arr.append(o);
-            }
-            QJsonObject rep;
-            rep["ok"] = true;
-            rep["orders"] = arr;
-            return rep;
-        } else if (action == "update_order") {
-            int id = req.value("id").toInt();
-            QString status = req.value("status").toString();
-            QSqlQuery q;
-            q.prepare("UPDATE orders SET status=? WHERE id=?");
-            q.addBindValue(status);
-            q.addBindValue(id);
-            if (q.exec()) return makeReply(true, "ok");
-            else return makeReply(false, q.lastError().text());
-        } else if (action == "delete_order") {
-            int id = req.value("id").toInt();
-            QString username = req.value("username").toString();
-            QSqlQuery q;
-            q.prepare("SELECT 1 FROM orders WHERE id=? AND factory_user=?");
-            q.addBindValue(id);
-            q.addBindValue(username);
-            if (!q.exec() || !q.next()) {
-                return makeReply(false, "只能销毁自己创建的工单");
-            }
-            q.prepare("DELETE FROM orders WHERE id=?");
-            q.addBindValue(id);
-            if (q.exec()) return makeReply(true, "ok");
-            else return makeReply(false, q.lastError().text());
-        } else if (action == "get_recordings") {
-            QString roomId = req.value("room_id").toString();
-            QString sql = "SELECT id, order_id, room_id, started_at, ended_at, title FROM recordings";
-            if (!roomId.isEmpty()) sql += " WHERE room_id=?";
-            QSqlQuery q;
-            if (!roomId.isEmpty()) { q.prepare(sql); q.addBindValue(roomId); }
-            else { q.prepare(sql); }
-            if (!q.exec()) return makeReply(false, q.lastError().text());
-            QJsonArray items;
-            while (q.next()) {
-                QJsonObject o;
-                o["id"] = q.value(0).toInt();
-                o["order_id"] = q.value(1).toString();
-                o["room_id"] = q.value(2).toString();
-                o["started_at"] = QJsonValue::fromVariant(q.value(3));
-                o["ended_at"] = QJsonValue::fromVariant(q.value(4));
-                o["title"] = q.value(5).toString();
-                items.append(o);
-            }
-            QJsonObject rep; rep["ok"] = true; rep["items"] = items; return rep;
-        } else if (action == "get_recording_files") {
-            int recordingId = req.value("recording_id").toInt();
-            QString roomId = req.value("room_id").toString();
-            QString sql = "SELECT f.id, f.recording_id, f.user, f.file_path, f.kind "
-                          "FROM recording_files f JOIN recordings r ON f.recording_id=r.id";
-            QString where;
-            if (recordingId > 0) {
-                where = " WHERE f.recording_id=?";
-            } else if (!roomId.isEmpty()) {
-                where = " WHERE r.room_id=?";
-            }
-            QSqlQuery q;
-            q.prepare(sql + where);
-            if (recordingId > 0) q.addBindValue(recordingId);
-            else if (!roomId.isEmpty()) q.addBindValue(roomId);
-
-            if (!q.exec()) return makeReply(false, q.lastError().text());
-
-            QJsonArray files;
-            while (q.next()) {
-                QJsonObject o;
-                o["id"] = q.value(0).toInt();
-                o["recording_id"] = q.value(1).toInt();
-                o["user"] = q.value(2).toString();
-                o["file_path"] = q.value(3).toString();
-                o["kind"] = q.value(4).toString();
-                files.append(o);
-            }
-            QJsonObject rep; rep["ok"] = true; rep["files"] = files; return rep;
-        }
-        return makeReply(false, "unknown action");
-    }
-
-    QJsonObject doRegister(const QString &user, const QString &role, const QString &pass) {
-        if (existsInAny(user)) {
-            return makeReply(false, "用户已存在");
-        }
-        QSqlQuery q;
-        if (role == "expert") {
-            q.prepare("INSERT INTO expert_users(username, password) VALUES(?, ?)");
-        } else {
-            q.prepare("INSERT INTO factory_users(username, password) VALUES(?, ?)");
-        }
-        q.addBindValue(user);
-        q.addBindValue(hashPass(pass));
-        if (!q.exec()) {
-            qWarning() << "Insert failed:" << q.lastError().text();
-            return makeReply(false, "数据库错误");
-        }
-        return makeReply(true, "ok");
-    }
-
-    QJsonObject doLogin(const QString &user, const QString &role, const QString &pass) {
-        QSqlQuery q;
-        if (role == "expert") {
-            q.prepare("SELECT 1 FROM expert_users WHERE username=? AND password=? LIMIT 1");
-        } else {
-            q.prepare("SELECT 1 FROM factory_users WHERE username=? AND password=? LIMIT 1");
-        }
-        q.addBindValue(user);
-        q.addBindValue(hashPass(pass));
-        if (!q.exec()) {
-            return makeReply(false, "数据库错误");
-        }
-        if (q.next()) return makeReply(true, "ok");
-        return makeReply(false, "账号或密码不正确");
-    }
-
-    static QJsonObject makeReply(bool ok, const QString &msg) {
-        return QJsonObject{{"ok", ok}, {"msg", msg}};
-    }
-
 private:
     QTcpServer *m_server = nullptr;
+    DbPool m_pool;
+    uint m_nextShard = 0;
+    QSet<QTcpSocket*> m_orderSubscribers;
 };
 
 #include "main.moc"
@@ -401,6 +688,10 @@ int main(int argc, char** argv)
     if (!udp.start(udpPort)) {
         return 1;
     }
+    // 大房间语音在服务器混音（RTM_AUDIO_MIX_MIN 设人数门限，0 关闭）
+    udp.setAudioMixer(hub.audioMixer());
+    udp.setSpeakerSelector(hub.speakerSelector());
+    hub.setUdpRelay(&udp);
 
     // 录制服务
     RecorderService recorder;
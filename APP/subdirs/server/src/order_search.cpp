@@ -0,0 +1,152 @@
+#include "order_search.h"
+#include "dbpool.h"
+#include <QSqlError>
+#include <QDebug>
+
+namespace {
+
+QAtomicInt g_ftsOk(0);
+
+bool isCjk(uint c)
+{
+    return (c >= 0x3040 && c <= 0x30FF)     // 假名
+        || (c >= 0x3400 && c <= 0x4DBF)     // 扩展 A
+        || (c >= 0x4E00 && c <= 0x9FFF)     // 基本区
+        || (c >= 0xAC00 && c <= 0xD7AF)     // 谚文
+        || (c >= 0xF900 && c <= 0xFAFF)     // 兼容表意
+        || (c >= 0x20000 && c <= 0x2FA1F);  // 扩展 B 之后
+}
+
+bool isWordChar(uint c)
+{
+    return QChar::isLetterOrNumber(c) && !isCjk(c);
+}
+
+QString quoted(const QString& s)
+{
+    QString t = s;
+    t.replace('"', "\"\"");
+    return '"' + t + '"';
+}
+
+} // namespace
+
+namespace OrderSearch {
+
+bool available() { return g_ftsOk.loadAcquire() != 0; }
+
+QString segment(const QString& text)
+{
+    QString out;
+    out.reserve(text.size() * 2);
+    const QVector<uint> ucs = text.toUcs4();
+    for (uint c : ucs) {
+        if (isCjk(c)) {
+            out += ' ';
+            out += QString::fromUcs4(&c, 1);
+            out += ' ';
+        } else {
+            out += QString::fromUcs4(&c, 1);
+        }
+    }
+    return out.simplified();
+}
+
+QString buildMatch(const QString& keyword, QStringList* likeTerms)
+{
+    QStringList terms;
+    QStringList cjk;      // 当前 CJK 连续段
+    QString word;         // 当前拉丁/数字段
+
+    auto flushCjk = [&]{
+        if (!cjk.isEmpty()) { terms << quoted(cjk.join(' ')); cjk.clear(); }
+    };
+    auto flushWord = [&]{
+        if (word.size() >= kPrefixMinLen) terms << quoted(word) + '*';
+        else if (!word.isEmpty()) likeTerms->append(word);
+        word.clear();
+    };
+
+    const QVector<uint> ucs = keyword.toUcs4();
+    for (uint c : ucs) {
+        if (isCjk(c)) {
+            flushWord();
+            cjk << QString::fromUcs4(&c, 1);
+        } else if (isWordChar(c)) {
+            flushCjk();
+            word += QString::fromUcs4(&c, 1);
+        } else {
+            flushCjk();
+            flushWord();
+        }
+    }
+    flushCjk();
+    flushWord();
+    return terms.join(' ');
+}
+
+bool ensureSchema()
+{
+    QSqlQuery q;
+    // 过滤列的二级索引：专家按状态筛，工厂按 (自己, 状态) 筛
+    q.exec("CREATE INDEX IF NOT EXISTS idx_orders_status ON orders(status)");
+    q.exec("CREATE INDEX IF NOT EXISTS idx_orders_factory_status ON orders(factory_user, status)");
+
+    if (!q.exec("CREATE VIRTUAL TABLE IF NOT EXISTS orders_fts USING fts5(title, desc, tokenize='unicode61')")) {
+        qWarning() << "[orders] FTS5 unavailable, falling back to LIKE:" << q.lastError().text();
+        g_ftsOk.storeRelease(0);
+        return false;
+    }
+
+    // 索引与主表行数不一致（首次启用/异常退出）时整体重建
+    qint64 nOrders = 0, nFts = 0;
+    if (q.exec("SELECT COUNT(*) FROM orders") && q.next()) nOrders = q.value(0).toLongLong();
+    if (q.exec("SELECT COUNT(*) FROM orders_fts") && q.next()) nFts = q.value(0).toLongLong();
+    if (nOrders != nFts) {
+        QSqlDatabase db = QSqlDatabase::database();
+        db.transaction();
+        q.exec("DELETE FROM orders_fts");
+        QSqlQuery sel, ins;
+        ins.prepare("INSERT INTO orders_fts(rowid, title, desc) VALUES(?, ?, ?)");
+        sel.setForwardOnly(true);
+        sel.exec("SELECT id, title, desc FROM orders");
+        while (sel.next()) {
+            ins.addBindValue(sel.value(0).toInt());
+            ins.addBindValue(segment(sel.value(1).toString()));
+            ins.addBindValue(segment(sel.value(2).toString()));
+            ins.exec();
+        }
+        db.commit();
+        qInfo() << "[orders] FTS index rebuilt; rows=" << nOrders;
+    }
+    g_ftsOk.storeRelease(1);
+    return true;
+}
+
+bool indexOrder(DbConn& c, int id, const QString& title, const QString& desc)
+{
+    if (!available()) return true;
+    QSqlQuery& q = c.prepared("INSERT OR REPLACE INTO orders_fts(rowid, title, desc) VALUES(?, ?, ?)");
+    q.addBindValue(id);
+    q.addBindValue(segment(title));
+    q.addBindValue(segment(desc));
+    if (!q.exec()) {
+        qWarning() << "[orders] fts insert failed:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool removeOrder(DbConn& c, int id)
+{
+    if (!available()) return true;
+    QSqlQuery& q = c.prepared("DELETE FROM orders_fts WHERE rowid=?");
+    q.addBindValue(id);
+    if (!q.exec()) {
+        qWarning() << "[orders] fts delete failed:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <QtCore>
+#include <QtSql>
+
+class DbConn;
+
+// 工单全文检索：FTS5 虚表 orders_fts(title, desc)，rowid = orders.id
+// unicode61 不切中文，入库/查询前在应用侧把每个 CJK 字符拆成独立词元
+namespace OrderSearch {
+
+// 主线程默认连接上建表/索引并回填；返回 FTS5 是否可用
+bool ensureSchema();
+bool available();
+
+// "机器人test" -> "机 器 人 test"
+QString segment(const QString& text);
+
+// 用户关键词 -> MATCH 表达式：CJK 连续段为短语，拉丁/数字段为词前缀，整体 AND
+// 词前缀找不到词中间的片段（"pump" 匹配 "pumps"，"123" 匹配不到 "A0123"），
+// 所以短于 kPrefixMinLen 的拉丁/数字段不进 MATCH，放进 likeTerms 由调用方按子串 LIKE 过滤
+// MATCH 和 likeTerms 都为空（关键词只有标点/符号）时调用方应按整串 LIKE，不能跳过过滤
+const int kPrefixMinLen = 4;
+QString buildMatch(const QString& keyword, QStringList* likeTerms);
+
+// 与 orders 的增删放在同一事务里调用
+bool indexOrder(DbConn& c, int id, const QString& title, const QString& desc);
+bool removeOrder(DbConn& c, int id);
+
+}
@@ -1,4 +1,6 @@
 #include "recorder.h"
+#include "deltacodec.h"
+#include "dbpool.h"
 #include <QImageReader>
 #include <QImageWriter>
 #include <QBuffer>
@@ -8,12 +10,46 @@
 #include <QSqlError>
 #include <QStandardPaths>
 #include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QDebug>
 
 // 可调整参数
 static const int kOutFps = 12;
 static const int kJpegQ  = 80;
 
+// 预览产物参数：固定 GOP 让关键帧时间可预测；缩略图拼成雪碧图
+static const int   kKeyIntSec      = 2;            // 每 2 秒一个关键帧
+static const int   kThumbSec       = 5;            // 初始缩略图间隔
+static const QSize kThumbSize(160, 90);
+static const int   kSpriteCols     = 10;
+static const int   kMaxThumbs      = 100;          // 10x10，写满后抽稀
+static const int   kSpriteJpegQ    = 70;
+
+static void ensureColumn(const QString& table, const QString& column, const QString& decl)
+{
+    if (DbPool::columnExists(QSqlDatabase::database(), table, column)) return;
+    QSqlQuery q;
+    if (!q.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, decl))) {
+        qWarning() << "[rec] add column failed:" << table << column << q.lastError();
+    }
+}
+
+static void ensureRecordingTables()
+{
+    QSqlQuery q;
+    q.exec("CREATE TABLE IF NOT EXISTS recordings (id INTEGER PRIMARY KEY AUTOINCREMENT, order_id TEXT, room_id TEXT, started_at INTEGER, ended_at INTEGER, title TEXT)");
+    q.exec("CREATE TABLE IF NOT EXISTS recording_files (id INTEGER PRIMARY KEY AUTOINCREMENT, recording_id INTEGER, user TEXT, file_path TEXT, kind TEXT)");
+    // 预览元数据（旧库自动补列）
+    ensureColumn("recording_files", "thumb_path", "TEXT");
+    ensureColumn("recording_files", "index_path", "TEXT");
+    ensureColumn("recording_files", "duration_ms", "INTEGER");
+    // 知识库分页查询：按房间/时间过滤录制，再按 recording_id 取文件
+    q.exec("CREATE INDEX IF NOT EXISTS idx_recordings_room ON recordings(room_id, id)");
+    q.exec("CREATE INDEX IF NOT EXISTS idx_recordings_started ON recordings(started_at)");
+    q.exec("CREATE INDEX IF NOT EXISTS idx_recording_files_rec ON recording_files(recording_id, id)");
+}
+
 QString RecorderStream::findFfmpegExecutable()
 {
     const QByteArray envPath = qgetenv("FFMPEG_PATH");
@@ -72,6 +108,9 @@ void RecorderStream::start()
     active_ = true;
     ffmpegStarted_ = false;
     writtenFrames_ = 0;
+    thumbs_.clear();
+    thumbEveryFrames_ = qMax(1, fps_ * kThumbSec);
+    nextThumbFrame_ = 0;
     timer_.start();
     qInfo() << "[rec]" << roomId_ << user_ << "armed recorder; waiting first frame to start ffmpeg...";
 }
@@ -84,6 +123,7 @@ void RecorderStream::stop()
         ff_.closeWriteChannel();
         ff_.waitForFinished(5000);
         qInfo() << "[rec]" << roomId_ << user_ << "stopped; frames=" << writtenFrames_ << "out=" << outPath_;
+        writePreviewArtifacts();
     } else {
         qInfo() << "[rec]" << roomId_ << user_ << "stopped before any frame arrived; no file written.";
         QFile f(outPath_);
@@ -111,6 +151,9 @@ void RecorderStream::ensureFfmpegStarted()
          << "-r" << QString::number(fps_)
          << "-i" << "pipe:0"
          << "-c:v" << "libx264"
+         << "-g" << QString::number(fps_ * kKeyIntSec)
+         << "-keyint_min" << QString::number(fps_ * kKeyIntSec)
+         << "-sc_threshold" << "0"
          << "-pix_fmt" << "yuv420p"
          << "-movflags" << "+faststart"
          << outPath_;
@@ -171,9 +214,117 @@ void RecorderStream::onTick()
         p.end();
     }
 
+    captureThumbIfDue(frame);
     writeFrame(frame);
 }
 
+void RecorderStream::captureThumbIfDue(const QImage& frame)
+{
+    if (writtenFrames_ < nextThumbFrame_) return;
+
+    if (thumbs_.size() >= kMaxThumbs) {
+        // 写满：保留偶数位，间隔翻倍，雪碧图尺寸保持不变
+        QVector<QImage> kept;
+        kept.reserve(kMaxThumbs / 2 + 1);
+        for (int i = 0; i < thumbs_.size(); i += 2) kept.push_back(thumbs_[i]);
+        thumbs_.swap(kept);
+        thumbEveryFrames_ *= 2;
+        nextThumbFrame_ = thumbs_.size() * thumbEveryFrames_;
+        if (writtenFrames_ < nextThumbFrame_) return;
+    }
+
+    thumbs_.push_back(frame.scaled(kThumbSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    nextThumbFrame_ += thumbEveryFrames_;
+}
+
+QString RecorderStream::spritePathFor(const QString& mp4Path)
+{
+    QString base = mp4Path;
+    if (base.endsWith(".mp4", Qt::CaseInsensitive)) base.chop(4);
+    return base + ".sprite.jpg";
+}
+
+QString RecorderStream::indexPathFor(const QString& mp4Path)
+{
+    QString base = mp4Path;
+    if (base.endsWith(".mp4", Qt::CaseInsensitive)) base.chop(4);
+    return base + ".index.json";
+}
+
+// 索引格式（JSON）：
+// { video, fps, frames, duration_ms,
+//   keyframes: [{frame, t_ms}...],                       // 由固定 GOP 推导
+//   sprite: { file, cols, rows, tile_w, tile_h, count, interval_ms, thumbs:[t_ms...] } }
+void RecorderStream::writePreviewArtifacts()
+{
+    if (writtenFrames_ <= 0 || !QFileInfo::exists(outPath_)) return;
+
+    const int fps = qMax(1, fps_);
+    const int gop = fps * kKeyIntSec;
+    const qint64 durationMs = qint64(writtenFrames_) * 1000 / fps;
+
+    QJsonArray keyframes;
+    for (int f = 0; f < writtenFrames_; f += gop) {
+        keyframes.append(QJsonObject{{"frame", f}, {"t_ms", qint64(f) * 1000 / fps}});
+    }
+
+    QJsonObject index{
+        {"video", QFileInfo(outPath_).fileName()},
+        {"fps", fps},
+        {"frames", writtenFrames_},
+        {"duration_ms", durationMs},
+        {"keyframes", keyframes}
+    };
+
+    if (!thumbs_.isEmpty()) {
+        const int count = thumbs_.size();
+        const int cols  = qMin(kSpriteCols, count);
+        const int rows  = (count + cols - 1) / cols;
+        QImage sprite(cols * kThumbSize.width(), rows * kThumbSize.height(), QImage::Format_RGB32);
+        sprite.fill(Qt::black);
+        QPainter p(&sprite);
+        QJsonArray times;
+        for (int i = 0; i < count; ++i) {
+            const QImage& t = thumbs_[i];
+            const QRect cell((i % cols) * kThumbSize.width(), (i / cols) * kThumbSize.height(),
+                             kThumbSize.width(), kThumbSize.height());
+            p.drawImage(QPoint(cell.x() + (cell.width() - t.width()) / 2,
+                               cell.y() + (cell.height() - t.height()) / 2), t);
+            times.append(qint64(i) * thumbEveryFrames_ * 1000 / fps);
+        }
+        p.end();
+
+        const QString spritePath = spritePathFor(outPath_);
+        QImageWriter w(spritePath, "jpeg");
+        w.setQuality(kSpriteJpegQ);
+        if (w.write(sprite)) {
+            index["sprite"] = QJsonObject{
+                {"file", QFileInfo(spritePath).fileName()},
+                {"cols", cols},
+                {"rows", rows},
+                {"tile_w", kThumbSize.width()},
+                {"tile_h", kThumbSize.height()},
+                {"count", count},
+                {"interval_ms", qint64(thumbEveryFrames_) * 1000 / fps},
+                {"thumbs", times}
+            };
+        } else {
+            qWarning() << "[rec] sprite write failed:" << spritePath << w.errorString();
+        }
+    }
+
+    QFile f(indexPathFor(outPath_));
+    if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        f.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+        f.close();
+        qInfo() << "[rec]" << roomId_ << user_ << "preview index written; thumbs=" << thumbs_.size()
+                << "keyframes=" << keyframes.size();
+    } else {
+        qWarning() << "[rec] index write failed:" << f.fileName();
+    }
+    thumbs_.clear();
+}
+
 QImage RecorderStream::compose(const QImage& cam, const QImage& scr, const QSize& target)
 {
     QImage out(target, QImage::Format_RGB32);
@@ -320,7 +471,7 @@ void RecorderRoom::onTcpPacket(const Packet& p)
             streams_[sender]->onCameraFrame(img);
         }
     } else if (p.type == MSG_ANNOT) {
-        handleAnnot(p.json);
+        handleAnnot(p.json, p.bin);
     }
 }
 
@@ -332,9 +483,7 @@ void RecorderRoom::finalizeAndClose()
     }
     streams_.clear();
 
-    QSqlQuery q;
-    q.exec("CREATE TABLE IF NOT EXISTS recordings (id INTEGER PRIMARY KEY AUTOINCREMENT, order_id TEXT, room_id TEXT, started_at INTEGER, ended_at INTEGER, title TEXT)");
-    q.exec("CREATE TABLE IF NOT EXISTS recording_files (id INTEGER PRIMARY KEY AUTOINCREMENT, recording_id INTEGER, user TEXT, file_path TEXT, kind TEXT)");
+    ensureRecordingTables();
 
     QSqlQuery qi;
     qi.prepare("INSERT INTO recordings(order_id, room_id, started_at, ended_at, title) VALUES(?, ?, ?, ?, ?)");
@@ -353,13 +502,27 @@ void RecorderRoom::finalizeAndClose()
     QDir dir(outDir_);
     const QStringList files = dir.entryList(QStringList() << "*.mp4", QDir::Files);
     for (const QString& f : files) {
+        const QString path = dir.filePath(f);
+        const QString sprite = RecorderStream::spritePathFor(path);
+        const QString index  = RecorderStream::indexPathFor(path);
+        QVariant durationMs(QVariant::LongLong);
+        QFile fi(index);
+        if (fi.open(QIODevice::ReadOnly)) {
+            const QJsonObject j = QJsonDocument::fromJson(fi.readAll()).object();
+            if (j.contains("duration_ms")) durationMs = j.value("duration_ms").toVariant();
+        }
+
         QSqlQuery qf;
-        qf.prepare("INSERT INTO recording_files(recording_id, user, file_path, kind) VALUES(?, ?, ?, ?)");
+        qf.prepare("INSERT INTO recording_files(recording_id, user, file_path, kind, thumb_path, index_path, duration_ms)"
+                   " VALUES(?, ?, ?, ?, ?, ?, ?)");
         qf.addBindValue(recId);
         QString u = f; u.chop(4); u = u.mid(u.indexOf('_')+1);
         qf.addBindValue(u);
-        qf.addBindValue(dir.filePath(f));
+        qf.addBindValue(path);
         qf.addBindValue("video");
+        qf.addBindValue(QFileInfo::exists(sprite) ? QVariant(sprite) : QVariant(QVariant::String));
+        qf.addBindValue(QFileInfo::exists(index)  ? QVariant(index)  : QVariant(QVariant::String));
+        qf.addBindValue(durationMs);
         if (!qf.exec()) qWarning() << "[rec] insert file failed:" << qf.lastError();
     }
 }
@@ -375,7 +538,7 @@ void RecorderRoom::ensureStream(const QString& user)
     streams_.insert(user, st);
 }
 
-void RecorderRoom::handleAnnot(const QJsonObject& j)
+void RecorderRoom::handleAnnot(const QJsonObject& j, const QByteArray& bin)
 {
     if (j.value("roomId").toString() != roomId_) return;
     QString target = j.value("target").toString();
@@ -384,7 +547,7 @@ void RecorderRoom::handleAnnot(const QJsonObject& j)
     if (target.isEmpty()) return;
     auto* m = annotByUser_.value(target, nullptr);
     if (!m) { m = new AnnotModel(); annotByUser_.insert(target, m); }
-    m->applyEvent(j);
+    m->applyEvent(j, bin);
 }
 
 QImage RecorderRoom::parseDeltaIntoBack(const QString& sender, const QByteArray& blob, int w, int h)
@@ -394,24 +557,7 @@ QImage RecorderRoom::parseDeltaIntoBack(const QString& sender, const QByteArray&
         back = QImage(w, h, QImage::Format_RGB32);
         back.fill(Qt::black);
     }
-    QDataStream ds(blob); ds.setByteOrder(QDataStream::BigEndian);
-    quint32 magic=0; quint16 rectCount=0; ds >> magic >> rectCount;
-    if (magic != 0x44533031) return QImage();
-    for (int i = 0; i < rectCount; ++i) {
-        quint16 x=0,y=0,rw=0,rh=0; quint32 clen=0;
-        ds >> x >> y >> rw >> rh >> clen;
-        if (ds.status()!=QDataStream::Ok) return QImage();
-        if (int(ds.device()->bytesAvailable()) < int(clen)) return QImage();
-        QByteArray comp; comp.resize(int(clen));
-        ds.readRawData(comp.data(), clen);
-        QByteArray raw = qUncompress(comp);
-        if (raw.size() != int(rw) * int(rh) * 4) continue;
-        const char* src = raw.constData();
-        for (int row = 0; row < rh; ++row) {
-            uchar* dst = back.scanLine(y + row) + x * 4;
-            memcpy(dst, src + row * rw * 4, rw * 4);
-        }
-    }
+    if (!DeltaCodec::applyInto(back, blob)) return QImage();
     return back;
 }
 
@@ -428,9 +574,7 @@ void RecorderService::init(quint16 udpPort, const QString& kbRoot)
 
 void RecorderService::ensureTables()
 {
-    QSqlQuery q;
-    q.exec("CREATE TABLE IF NOT EXISTS recordings (id INTEGER PRIMARY KEY AUTOINCREMENT, order_id TEXT, room_id TEXT, started_at INTEGER, ended_at INTEGER, title TEXT)");
-    q.exec("CREATE TABLE IF NOT EXISTS recording_files (id INTEGER PRIMARY KEY AUTOINCREMENT, recording_id INTEGER, user TEXT, file_path TEXT, kind TEXT)");
+    ensureRecordingTables();
 }
 
 void RecorderService::onServerEventMembers(const QString& roomId, const QStringList& members)
@@ -25,6 +25,10 @@ public:
     bool isActive() const { return active_; }
     QString outputPath() const { return outPath_; }
 
+    // 预览产物：与 mp4 同目录同名，<base>.sprite.jpg / <base>.index.json
+    static QString spritePathFor(const QString& mp4Path);
+    static QString indexPathFor(const QString& mp4Path);
+
 private slots:
     void onTick();
 
@@ -34,6 +38,10 @@ private:
     void ensureFfmpegStarted();
     static QString findFfmpegExecutable();
 
+    // 缩略图采样与预览产物（雪碧图 + 关键帧/时间戳索引）
+    void captureThumbIfDue(const QImage& frame);
+    void writePreviewArtifacts();
+
     QString roomId_;
     QString user_;
     QString outDir_;
@@ -48,6 +56,10 @@ private:
     int  writtenFrames_{0};
     AnnotModel* annot_{nullptr};
     QSize baseSize_{1280,720};
+
+    QVector<QImage> thumbs_;       // 按 thumbEveryFrames_ 间隔采样
+    int  thumbEveryFrames_{0};     // 写满后间隔翻倍并抽稀
+    int  nextThumbFrame_{0};
 };
 
 class RecorderRoom : public QObject {
@@ -64,7 +76,7 @@ public:
 
 private:
     void ensureStream(const QString& user);
-    void handleAnnot(const QJsonObject& j);
+    void handleAnnot(const QJsonObject& j, const QByteArray& bin);
     QImage parseDeltaIntoBack(const QString& sender, const QByteArray& blob, int w, int h);
 
     QString roomId_;
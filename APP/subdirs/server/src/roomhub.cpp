@@ -1,7 +1,13 @@
 #include "roomhub.h"
 #include "recorder.h"
+#include "udprelay.h"
 
-RoomHub::RoomHub(QObject* parent) : QObject(parent) {}
+#include <algorithm>
+
+RoomHub::RoomHub(QObject* parent) : QObject(parent) {
+    connect(&mixer_, &AudioMixer::mixed, this, &RoomHub::onMixedAudio);
+    connect(&speakers_, &SpeakerSelector::activeChanged, this, &RoomHub::onActiveSpeakers);
+}
 
 bool RoomHub::start(quint16 port) {
     connect(&server_, &QTcpServer::newConnection, this, &RoomHub::onNewConnection);
@@ -42,6 +48,8 @@ void RoomHub::onDisconnected() {
     }
 
     clients_.erase(it);
+    if (!oldRoom.isEmpty()) updateAudioMix(oldRoom);
+    if (!oldRoom.isEmpty()) updateRoomLayerDemand(oldRoom);
     sock->deleteLater();
     delete c;
 }
@@ -77,6 +85,18 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
 
         sendRoomMembersTo(c->sock, roomId, "snapshot", c->user);
         broadcastRoomMembers(roomId, "join", c->user);
+        updateRoomLayerDemand(roomId);
+        // 已经在混音的房间，新成员单独补一条通知
+        if (!updateAudioMix(roomId) && mixer_.isMixing(roomId))
+            c->sock->write(audioMixEvent(roomId));
+        return;
+    }
+
+    // 测时延：立即原样回给发送者，不进房间广播
+    if (p.type == MSG_ECHO) {
+        QJsonObject j = p.json;
+        j["srv_ts"] = QDateTime::currentMSecsSinceEpoch();
+        c->sock->write(buildPacket(MSG_ECHO, j));
         return;
     }
 
@@ -86,8 +106,43 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
         return;
     }
 
-    // 录制服务同步 TCP 包（视频帧、标注等）
-    if (recorder_) recorder_->onPacketTCP(c->roomId, p);
+    // 接收端按画面大小订阅各发送者的层级，只在服务器内生效不转发
+    if (p.type == MSG_VIDEO_LAYER) {
+        c->layerPref.clear();
+        const QJsonObject prefs = p.json.value("prefs").toObject();
+        for (auto it = prefs.begin(); it != prefs.end(); ++it)
+            c->layerPref.insert(it.key(), qBound(0, it.value().toInt(), kLayerCount - 1));
+        updateRoomLayerDemand(c->roomId);
+        return;
+    }
+
+    // 接收质量回报只有被评估的发送者需要，点对点转给 to，不在房间广播也不录制
+    if (p.type == MSG_CONTROL && p.json.value("kind").toString() == QLatin1String("rx_report")) {
+        sendToMember(c->roomId, p.json.value("to").toString(), buildPacket(p.type, p.json, p.bin));
+        return;
+    }
+
+    const bool isCamera = p.type == MSG_VIDEO_FRAME
+                       && p.json.value("media").toString("camera") == "camera";
+    const int layer = isCamera ? qBound(0, p.json.value("layer").toInt(0), kLayerCount - 1) : 0;
+
+    // 录制服务同步 TCP 包（视频帧、标注等）；摄像头只录最清晰的 0 层
+    if (recorder_ && layer == 0) recorder_->onPacketTCP(c->roomId, p);
+
+    // 带电平的语音只转发当前主讲人的（不在前 N 的直接丢）
+    if (p.type == MSG_AUDIO_FRAME && p.json.contains("lvl")
+        && !speakers_.admit(c->roomId, c->user, p.json.value("lvl").toInt(127), p.json.value("vad").toBool(true))) {
+        return;
+    }
+
+    // 混音房间：语音进混音器，不再广播原始流
+    if (p.type == MSG_AUDIO_FRAME && mixer_.isMixing(c->roomId)) {
+        mixer_.push(c->roomId, c->user,
+                    p.json.value("codec").toString("mulaw").toLower(),
+                    p.json.value("sr").toInt(AudioMixer::kSampleRate),
+                    quint32(p.json.value("seq").toInt()), p.bin);
+        return;
+    }
 
     if (p.type == MSG_TEXT ||
         p.type == MSG_DEVICE_DATA ||
@@ -105,6 +160,7 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
                     << "room=" << c->roomId
                     << "sender=" << sender
                     << "media=" << media
+                    << "layer=" << layer
                     << "bytes=" << p.bin.size();
         } else if (p.type == MSG_DEVICE_CONTROL) {
             qInfo() << "[hub][device_control]"
@@ -115,6 +171,10 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
         }
 
         QByteArray raw = buildPacket(p.type, p.json, p.bin);
+        if (isCamera) {
+            forwardCameraFrame(c, raw, layer);
+            return;
+        }
         const bool isVideo = (p.type == MSG_VIDEO_FRAME);
         broadcastToRoom(c->roomId, raw, c->sock, isVideo);
         return;
@@ -125,8 +185,9 @@ void RoomHub::handlePacket(ClientCtx* c, const Packet& p) {
 }
 
 void RoomHub::joinRoom(ClientCtx* c, const QString& roomId) {
-    if (!c->roomId.isEmpty()) {
-        auto range = rooms_.equal_range(c->roomId);
+    const QString oldRoom = c->roomId;
+    if (!oldRoom.isEmpty()) {
+        auto range = rooms_.equal_range(oldRoom);
         for (auto i = range.first; i != range.second; ) {
             if (i.value() == c->sock) i = rooms_.erase(i);
             else ++i;
@@ -134,6 +195,15 @@ void RoomHub::joinRoom(ClientCtx* c, const QString& roomId) {
     }
     c->roomId = roomId;
     rooms_.insert(roomId, c->sock);
+
+    // 分层订阅按房间生效，换房间后重来
+    c->layerPref.clear();
+    c->layersAnnounced.clear();
+    std::fill(std::begin(c->layerSeenMs), std::end(c->layerSeenMs), 0);
+    if (!oldRoom.isEmpty() && oldRoom != roomId) {
+        updateRoomLayerDemand(oldRoom);
+        updateAudioMix(oldRoom);
+    }
 }
 
 void RoomHub::broadcastToRoom(const QString& roomId,
@@ -151,6 +221,119 @@ void RoomHub::broadcastToRoom(const QString& roomId,
     }
 }
 
+void RoomHub::sendToMember(const QString& roomId, const QString& user, const QByteArray& packet) {
+    auto range = rooms_.equal_range(roomId);
+    for (auto i = range.first; i != range.second; ++i) {
+        const ClientCtx* rc = clients_.value(i.value(), nullptr);
+        if (rc && rc->user == user) i.value()->write(packet);
+    }
+}
+
+// 每个接收端只收一层：取它想要的层，发送端没在产出时退到更清晰的可用层
+void RoomHub::forwardCameraFrame(ClientCtx* from, const QByteArray& packet, int layer) {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    from->layerSeenMs[layer] = now;
+
+    auto range = rooms_.equal_range(from->roomId);
+    for (auto i = range.first; i != range.second; ++i) {
+        QTcpSocket* s = i.value();
+        if (s == from->sock) continue;
+        const ClientCtx* rc = clients_.value(s, nullptr);
+        if (!rc) continue;
+        if (pickLayer(from, rc->layerPref.value(from->user, 0), now) != layer) continue;
+        if (s->bytesToWrite() > kBacklogDropThreshold) continue;
+        s->write(packet);
+    }
+}
+
+int RoomHub::pickLayer(const ClientCtx* from, int want, qint64 now) const {
+    for (int l = want; l > 0; --l) {
+        if (now - from->layerSeenMs[l] < kLayerStaleMs) return l;
+    }
+    return 0;
+}
+
+// 告诉发送端哪些层有人要；0 层始终需要（录制、老客户端）
+void RoomHub::updateLayerDemand(ClientCtx* from) {
+    if (!from || from->user.isEmpty()) return;
+    QSet<int> want{0};
+    auto range = rooms_.equal_range(from->roomId);
+    for (auto i = range.first; i != range.second; ++i) {
+        if (i.value() == from->sock) continue;
+        if (const ClientCtx* rc = clients_.value(i.value(), nullptr))
+            want.insert(rc->layerPref.value(from->user, 0));
+    }
+    QList<int> layers = want.values();
+    std::sort(layers.begin(), layers.end());
+    if (layers == from->layersAnnounced) return;
+    from->layersAnnounced = layers;
+
+    QJsonArray arr;
+    for (int l : layers) arr.append(l);
+    QJsonObject j{{"code", 0},
+                  {"kind", "layers"},
+                  {"roomId", from->roomId},
+                  {"layers", arr},
+                  {"ts", QDateTime::currentMSecsSinceEpoch()}};
+    from->sock->write(buildPacket(MSG_SERVER_EVENT, j));
+}
+
+void RoomHub::updateRoomLayerDemand(const QString& roomId) {
+    auto range = rooms_.equal_range(roomId);
+    for (auto i = range.first; i != range.second; ++i)
+        updateLayerDemand(clients_.value(i.value(), nullptr));
+}
+
+// 成员变化：清掉走了的主讲人；按当前人数开关房间混音，有变化时通知房间内所有人
+bool RoomHub::updateAudioMix(const QString& roomId) {
+    const QStringList members = listMembers(roomId);
+    speakers_.setMembers(roomId, members);
+    if (!mixer_.setMembers(roomId, members)) return false;
+    broadcastToRoom(roomId, audioMixEvent(roomId), nullptr, false);
+    return true;
+}
+
+QByteArray RoomHub::audioMixEvent(const QString& roomId) const {
+    QJsonObject j{{"code", 0},
+                  {"kind", "audio_mix"},
+                  {"roomId", roomId},
+                  {"on", mixer_.isMixing(roomId)},
+                  {"sender", AudioMixer::mixSender()},
+                  {"ts", QDateTime::currentMSecsSinceEpoch()}};
+    return buildPacket(MSG_SERVER_EVENT, j);
+}
+
+// 主讲人变化：客户端据此高亮发言者、自动切主画面
+void RoomHub::onActiveSpeakers(const QString& roomId, const QStringList& speakers) {
+    QJsonObject j{{"code", 0},
+                  {"kind", "active_speaker"},
+                  {"roomId", roomId},
+                  {"speakers", QJsonArray::fromStringList(speakers)},
+                  {"ts", QDateTime::currentMSecsSinceEpoch()}};
+    broadcastToRoom(roomId, buildPacket(MSG_SERVER_EVENT, j), nullptr, false);
+}
+
+// 混音结果：UDP 在线走中继，否则走该成员的 TCP 连接
+void RoomHub::onMixedAudio(const QString& roomId, const QString& user,
+                           quint32 seq, qint64 ts, const QByteArray& payload) {
+    if (udp_ && udp_->sendMixedAudio(roomId, user, seq, ts, payload)) return;
+
+    auto range = rooms_.equal_range(roomId);
+    for (auto i = range.first; i != range.second; ++i) {
+        const ClientCtx* rc = clients_.value(i.value(), nullptr);
+        if (!rc || rc->user != user) continue;
+        QJsonObject j{{"roomId", roomId},
+                      {"sender", AudioMixer::mixSender()},
+                      {"codec",  "mulaw"},
+                      {"sr",     AudioMixer::kSampleRate},
+                      {"ch",     1},
+                      {"seq",    static_cast<int>(seq)},
+                      {"ts",     ts}};
+        rc->sock->write(buildPacket(MSG_AUDIO_FRAME, j, payload));
+        return;
+    }
+}
+
 QStringList RoomHub::listMembers(const QString& roomId) const {
     QStringList members;
     auto range = rooms_.equal_range(roomId);
@@ -2,14 +2,22 @@
 #include <QtCore>
 #include <QtNetwork>
 #include "protocol.h"
+#include "audiomixer.h"
+#include "speakerselector.h"
 
 class RecorderService; // 前向声明
+class UdpRelay;
 
 struct ClientCtx {
     QTcpSocket* sock = nullptr;
     QString user;
     QString roomId;
     QByteArray buffer;
+
+    // 摄像头分层（simulcast）
+    QHash<QString, int> layerPref;          // 作为接收端：发送者 -> 想要的层，缺省 0
+    qint64 layerSeenMs[3] = {0, 0, 0};      // 作为发送端：各层最近一次到达
+    QList<int> layersAnnounced;             // 作为发送端：上次通知它要产出的层
 };
 
 class RoomHub : public QObject {
@@ -21,10 +29,19 @@ public:
     // 注入录制服务
     void setRecorder(RecorderService* r) { recorder_ = r; }
 
+    // 服务器混音：UDP 中继把混音房间的语音交给 audioMixer()，混音结果优先经中继下发
+    void setUdpRelay(UdpRelay* u) { udp_ = u; }
+    AudioMixer* audioMixer() { return &mixer_; }
+    // 主讲人选择：TCP/UDP 两条路的语音都先过它
+    SpeakerSelector* speakerSelector() { return &speakers_; }
+
 private slots:
     void onNewConnection();
     void onReadyRead();
     void onDisconnected();
+    void onMixedAudio(const QString& roomId, const QString& user,
+                      quint32 seq, qint64 ts, const QByteArray& payload);
+    void onActiveSpeakers(const QString& roomId, const QStringList& speakers);
 
 private:
     QTcpServer server_;
@@ -32,6 +49,8 @@ private:
     QMultiHash<QString, QTcpSocket*> rooms_; // roomId -> sockets
 
     static constexpr qint64 kBacklogDropThreshold = 3 * 1024 * 1024; // 3MB
+    static constexpr int    kLayerCount = 3;
+    static constexpr qint64 kLayerStaleMs = 2000;   // 超过这么久没收到的层视为发送端已停产
 
     void handlePacket(ClientCtx* c, const Packet& p);
     void joinRoom(ClientCtx* c, const QString& roomId);
@@ -40,9 +59,21 @@ private:
                          QTcpSocket* except = nullptr,
                          bool dropVideoIfBacklog = false);
 
+    void sendToMember(const QString& roomId, const QString& user, const QByteArray& packet);
+    void forwardCameraFrame(ClientCtx* from, const QByteArray& packet, int layer);
+    int  pickLayer(const ClientCtx* from, int want, qint64 now) const;
+    void updateLayerDemand(ClientCtx* from);
+    void updateRoomLayerDemand(const QString& roomId);
+
+    bool updateAudioMix(const QString& roomId);
+    QByteArray audioMixEvent(const QString& roomId) const;
+
     QStringList listMembers(const QString& roomId) const;
     void broadcastRoomMembers(const QString& roomId, const QString& event, const QString& whoChanged);
     void sendRoomMembersTo(QTcpSocket* target, const QString& roomId, const QString& event, const QString& whoChanged);
 
     RecorderService* recorder_{nullptr};
+    UdpRelay* udp_{nullptr};
+    AudioMixer mixer_;
+    SpeakerSelector speakers_;
 };
@@ -0,0 +1,124 @@
+#include "speakerselector.h"
+#include <algorithm>
+
+namespace {
+const double kSmooth           = 0.15;   // 电平滑动平均系数（每帧）
+const double kSwapMarginDb     = 6.0;
+const double kDominantMarginDb = 3.0;    // 主讲人换人也留回差，避免两人对话时来回跳
+const qint64 kMinHoldMs        = 1000;
+const qint64 kReleaseMs        = 1500;
+const int    kRefreshMs        = 250;
+}
+
+SpeakerSelector::SpeakerSelector(QObject* parent) : QObject(parent)
+{
+    bool ok = false;
+    const int n = qEnvironmentVariableIntValue("RTM_MAX_SPEAKERS", &ok);
+    if (ok) setMaxSpeakers(n);
+
+    timer_.setInterval(kRefreshMs);
+    connect(&timer_, &QTimer::timeout, this, &SpeakerSelector::refresh);
+    timer_.start();
+}
+
+QStringList SpeakerSelector::active(const QString& roomId) const
+{
+    auto it = rooms_.constFind(roomId);
+    return it == rooms_.constEnd() ? QStringList() : it->announced;
+}
+
+bool SpeakerSelector::admit(const QString& roomId, const QString& sender, int levelDbov, bool voiced)
+{
+    if (sender.isEmpty()) return false;
+    auto it = rooms_.find(roomId);
+    if (it == rooms_.end() || !it->members.contains(sender)) return false;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    Room& room = it.value();
+    Speaker& sp = room.speakers[sender];
+    if (voiced) {
+        const double loud = 127 - qBound(0, levelDbov, 127);
+        sp.loud = sp.lastVoiceMs == 0 ? loud : sp.loud + (loud - sp.loud) * kSmooth;
+        sp.lastVoiceMs = now;
+    }
+
+    if (room.active.contains(sender)) return true;
+    // 舒适噪声帧不抢位置
+    if (!voiced) return false;
+
+    if (room.active.size() < maxSpeakers_) {
+        sp.sinceMs = now;
+        room.active << sender;
+        announce(roomId, room);
+        return true;
+    }
+
+    int weakest = -1;
+    double weakestLoud = 0.0;
+    for (int i = 0; i < room.active.size(); ++i) {
+        const Speaker& a = room.speakers[room.active[i]];
+        if (now - a.sinceMs < kMinHoldMs) continue;
+        if (weakest < 0 || a.loud < weakestLoud) { weakest = i; weakestLoud = a.loud; }
+    }
+    if (weakest < 0 || sp.loud < weakestLoud + kSwapMarginDb) return false;
+
+    room.active[weakest] = sender;
+    sp.sinceMs = now;
+    announce(roomId, room);
+    return true;
+}
+
+void SpeakerSelector::setMembers(const QString& roomId, const QStringList& members)
+{
+    if (members.isEmpty()) { rooms_.remove(roomId); return; }
+    auto it = rooms_.find(roomId);
+    if (it == rooms_.end()) it = rooms_.insert(roomId, Room());
+    it->members = members;
+
+    for (auto s = it->speakers.begin(); s != it->speakers.end(); ) {
+        if (!members.contains(s.key())) s = it->speakers.erase(s);
+        else ++s;
+    }
+    const int before = it->active.size();
+    it->active.erase(std::remove_if(it->active.begin(), it->active.end(),
+                                    [&](const QString& u) { return !members.contains(u); }),
+                     it->active.end());
+    if (it->active.size() != before) announce(roomId, it.value());
+}
+
+// 定时让出长时间没说话的位置，并重排主讲人
+void SpeakerSelector::refresh()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = rooms_.begin(); it != rooms_.end(); ++it) {
+        Room& room = it.value();
+        room.active.erase(std::remove_if(room.active.begin(), room.active.end(),
+                                         [&](const QString& u) {
+                                             return now - room.speakers.value(u).lastVoiceMs > kReleaseMs;
+                                         }),
+                          room.active.end());
+        announce(it.key(), room);
+    }
+}
+
+void SpeakerSelector::announce(const QString& roomId, Room& room)
+{
+    QStringList sorted = room.active;
+    std::stable_sort(sorted.begin(), sorted.end(), [&](const QString& a, const QString& b) {
+        return room.speakers.value(a).loud > room.speakers.value(b).loud;
+    });
+    // 现任主讲人没被明显盖过就留在第一位
+    if (!sorted.isEmpty() && !room.announced.isEmpty()) {
+        const QString cur = room.announced.first();
+        const int idx = sorted.indexOf(cur);
+        if (idx > 0 && room.speakers.value(sorted.first()).loud < room.speakers.value(cur).loud + kDominantMarginDb)
+            sorted.move(idx, 0);
+    }
+
+    // 只在集合或主讲人变化时通知；其余名次变化不打扰客户端
+    const bool sameFirst = sorted.value(0) == room.announced.value(0);
+    const bool sameSet = sorted.size() == room.announced.size()
+                      && std::is_permutation(sorted.cbegin(), sorted.cend(), room.announced.cbegin());
+    if (sameFirst && sameSet) return;
+    room.announced = sorted;
+    emit activeChanged(roomId, sorted);
+}
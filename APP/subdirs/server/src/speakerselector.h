@@ -0,0 +1,48 @@
+#pragma once
+#include <QtCore>
+
+// 主讲人选择：房间内只转发最活跃的前 N 路语音
+// 客户端每帧带电平（-dBov）和 VAD 标记；按语音帧电平的滑动平均排序，
+// 空位直接补，满员时新人要比最弱的一路响出 kSwapMarginDb 且对方已讲满 kMinHoldMs 才替换，
+// 超过 kReleaseMs 没有语音帧的让出位置。不带电平的旧客户端不参与选择，照常转发
+// 集合或排第一的主讲人变化时发 activeChanged（第一个为主讲）
+// 只认 setMembers 登记过的房间和成员，其余帧一律不转发（伪造/迟到的 UDP 包不占位置、也不会重建已删的房间）
+class SpeakerSelector : public QObject {
+    Q_OBJECT
+public:
+    static const int kDefaultMaxSpeakers = 3;
+
+    explicit SpeakerSelector(QObject* parent = nullptr);
+
+    void setMaxSpeakers(int n) { maxSpeakers_ = qMax(1, n); }
+    int  maxSpeakers() const { return maxSpeakers_; }
+
+    // 一帧带电平的语音（或舒适噪声）；返回是否转发，房间或成员没登记时返回 false
+    bool admit(const QString& roomId, const QString& sender, int levelDbov, bool voiced);
+    // 房间成员变化时调用；空列表删除房间
+    void setMembers(const QString& roomId, const QStringList& members);
+    QStringList active(const QString& roomId) const;
+
+signals:
+    void activeChanged(const QString& roomId, const QStringList& speakers);
+
+private:
+    struct Speaker {
+        double loud = 0.0;          // 127 - 电平 的滑动平均，越大越响
+        qint64 lastVoiceMs = 0;
+        qint64 sinceMs = 0;         // 进入 active 的时刻
+    };
+    struct Room {
+        QStringList members;
+        QHash<QString, Speaker> speakers;
+        QStringList active;
+        QStringList announced;
+    };
+
+    void refresh();
+    void announce(const QString& roomId, Room& room);
+
+    QHash<QString, Room> rooms_;
+    int maxSpeakers_ = kDefaultMaxSpeakers;
+    QTimer timer_;
+};
@@ -1,4 +1,6 @@
 #include "udprelay.h"
+#include "audiomixer.h"
+#include "speakerselector.h"
 
 UdpRelay::UdpRelay(QObject* parent) : QObject(parent)
 {
@@ -19,10 +21,10 @@ bool UdpRelay::start(quint16 port)
     return true;
 }
 
-bool UdpRelay::parseHeader(QDataStream& ds, quint8& ver, quint8& type)
+bool UdpRelay::parseHeader(QDataStream& ds, quint8& ver, quint8& type, quint16& reserved)
 {
     ds.setByteOrder(QDataStream::BigEndian);
-    quint32 magic=0; quint16 reserved=0;
+    quint32 magic=0;
     ds >> magic >> ver >> type >> reserved;
     if (ds.status()!=QDataStream::Ok) return false;
     if (magic != kMagic) return false;
@@ -30,8 +32,33 @@ bool UdpRelay::parseHeader(QDataStream& ds, quint8& ver, quint8& type)
     return true;
 }
 
+void UdpRelay::forwardToRoom(const QString& room, const QByteArray& d, const QHostAddress& from, quint16 port)
+{
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    auto it = rooms_.find(room);
+    if (it == rooms_.end()) return;
+    for (auto pit = it->begin(); pit != it->end(); ++pit) {
+        const Peer& peer = pit.value();
+        if (now - peer.lastSeen > kPeerTimeoutMs) continue;
+        if (peer.addr == from && peer.port == port) continue;
+        sock_.writeDatagram(d, peer.addr, peer.port);
+    }
+}
+
+bool UdpRelay::isPeer(const QString& room, const QString& user, const QHostAddress& from, quint16 port) const
+{
+    auto it = rooms_.constFind(room);
+    if (it == rooms_.constEnd()) return false;
+    auto pit = it->constFind(user);
+    return pit != it->constEnd() && pit->addr == from && pit->port == port;
+}
+
 void UdpRelay::onReadyRead()
 {
+    // 语音单独一条道：读到即转发；视频分片先攒着，本轮读完再发，避免大帧分片挡在语音前面
+    struct Deferred { QString room; QByteArray d; QHostAddress from; quint16 port; };
+    QVector<Deferred> video;
+
     while (sock_.hasPendingDatagrams()) {
         QByteArray d;
         d.resize(int(sock_.pendingDatagramSize()));
@@ -39,8 +66,8 @@ void UdpRelay::onReadyRead()
         sock_.readDatagram(d.data(), d.size(), &from, &port);
 
         QDataStream ds(d);
-        quint8 ver=0, type=0;
-        if (!parseHeader(ds, ver, type)) continue;
+        quint8 ver=0, type=0; quint16 reserved=0;
+        if (!parseHeader(ds, ver, type, reserved)) continue;
 
         if (type == 1) {
             // register
@@ -50,24 +77,66 @@ void UdpRelay::onReadyRead()
             auto& m = rooms_[room];
             Peer p; p.addr = from; p.port = port; p.lastSeen = QDateTime::currentMSecsSinceEpoch();
             m.insert(user, p);
+
+            // 回执：客户端据此判断 UDP 通路可用（不通时语音留在 TCP）
+            QByteArray ack;
+            QDataStream as(&ack, QIODevice::WriteOnly);
+            as.setByteOrder(QDataStream::BigEndian);
+            as << (quint32)kMagic << (quint8)2 << (quint8)4 << (quint16)0;
+            as << room << user;
+            sock_.writeDatagram(ack, from, port);
         } else if (type == 2) {
             // video chunk - 转发给房间内其他用户
             QString room, sender;
             ds >> room >> sender;
             if (ds.status()!=QDataStream::Ok) continue;
-
-            const auto now = QDateTime::currentMSecsSinceEpoch();
-            auto it = rooms_.find(room);
-            if (it != rooms_.end()) {
-                for (auto pit = it->begin(); pit != it->end(); ++pit) {
-                    const Peer& peer = pit.value();
-                    if (now - peer.lastSeen > 10000) continue;
-                    if (peer.addr == from && peer.port == port) continue;
-                    sock_.writeDatagram(d, peer.addr, peer.port);
-                }
+            video.push_back({room, d, from, port});
+        } else if (type == 3) {
+            // audio frame - 不排队，立即转发
+            QString room, sender;
+            ds >> room >> sender;
+            if (ds.status()!=QDataStream::Ok) continue;
+            // 只认本地址上注册过的发送者：伪造或换了端口的包不进主讲人选择/混音，也不转发
+            if (!isPeer(room, sender, from, port)) continue;
+            if (speakers_ && (reserved & kAudioLevelPresent)
+                && !speakers_->admit(room, sender, reserved & 0x7F, (reserved & kAudioVoiced) != 0)) {
+                continue;
             }
+            if (mixer_ && mixer_->isMixing(room)) {
+                quint32 seq=0; quint64 ts=0; quint8 codec=0; quint16 sr=0, len=0;
+                ds >> seq >> ts >> codec >> sr >> len;
+                if (ds.status()!=QDataStream::Ok) continue;
+                QByteArray payload(len, Qt::Uninitialized);
+                if (ds.readRawData(payload.data(), len) != len) continue;
+                static const char* const kCodecs[] = {"mulaw", "opus", "pcm16", "cn"};
+                if (codec < 4) mixer_->push(room, sender, QLatin1String(kCodecs[codec]), sr, seq, payload);
+                continue;
+            }
+            forwardToRoom(room, d, from, port);
         }
     }
+
+    for (const Deferred& v : video) forwardToRoom(v.room, v.d, v.from, v.port);
+}
+
+bool UdpRelay::sendMixedAudio(const QString& room, const QString& user,
+                              quint32 seq, qint64 ts, const QByteArray& payload)
+{
+    auto it = rooms_.constFind(room);
+    if (it == rooms_.constEnd()) return false;
+    auto pit = it->constFind(user);
+    if (pit == it->constEnd()) return false;
+    if (QDateTime::currentMSecsSinceEpoch() - pit->lastSeen > kPeerTimeoutMs) return false;
+
+    QByteArray d;
+    QDataStream ds(&d, QIODevice::WriteOnly);
+    ds.setByteOrder(QDataStream::BigEndian);
+    ds << (quint32)kMagic << (quint8)2 << (quint8)3 << (quint16)0;
+    ds << room << AudioMixer::mixSender();
+    ds << seq << (quint64)ts << (quint8)0 /*mulaw*/ << (quint16)AudioMixer::kSampleRate
+       << (quint16)payload.size();
+    ds.writeRawData(payload.constData(), payload.size());
+    return sock_.writeDatagram(d, pit->addr, pit->port) == d.size();
 }
 
 void UdpRelay::onCleanup()
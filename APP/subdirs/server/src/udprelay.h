@@ -2,6 +2,9 @@
 #include <QtCore>
 #include <QtNetwork>
 
+class AudioMixer;
+class SpeakerSelector;
+
 class UdpRelay : public QObject {
     Q_OBJECT
 public:
@@ -10,6 +13,14 @@ public:
     bool start(quint16 port);
     quint16 port() const { return port_; }
 
+    // 混音房间的语音交给混音器，不再逐个转发
+    void setAudioMixer(AudioMixer* m) { mixer_ = m; }
+    // 带电平的语音先过主讲人选择，不在前 N 的不转发
+    void setSpeakerSelector(SpeakerSelector* s) { speakers_ = s; }
+    // 向 UDP 在线的成员发一帧混音；对方没注册或已超时返回 false，由调用方走 TCP
+    bool sendMixedAudio(const QString& room, const QString& user,
+                        quint32 seq, qint64 ts, const QByteArray& payload);
+
 private slots:
     void onReadyRead();
     void onCleanup();
@@ -25,9 +36,16 @@ private:
     QUdpSocket sock_;
     quint16 port_{0};
     QTimer cleanup_;
+    AudioMixer* mixer_{nullptr};
+    SpeakerSelector* speakers_{nullptr};
 
-    // 统一的头部解析：三个参数（引用）
-    static bool parseHeader(QDataStream& ds, quint8& ver, quint8& type);
+    // 统一的头部解析：ver/type/reserved（引用）；语音包的 reserved 携带电平
+    static bool parseHeader(QDataStream& ds, quint8& ver, quint8& type, quint16& reserved);
+    void forwardToRoom(const QString& room, const QByteArray& d, const QHostAddress& from, quint16 port);
+    bool isPeer(const QString& room, const QString& user, const QHostAddress& from, quint16 port) const;
 
     static constexpr quint32 kMagic = 0x55444D31; // 'UDM1'
+    static constexpr qint64  kPeerTimeoutMs = 10000;
+    static constexpr quint16 kAudioLevelPresent = 0x8000;
+    static constexpr quint16 kAudioVoiced       = 0x0080;
 };